@@ -90,8 +90,10 @@ unsigned vlc_CPU_raw(void);
 
 #  ifdef __AVX2__
 #   define vlc_CPU_AVX2() (1)
+#   define VLC_AVX2
 #  else
 #   define vlc_CPU_AVX2() ((vlc_CPU() & VLC_CPU_AVX2) != 0)
+#   define VLC_AVX2 __attribute__ ((__target__ ("avx2")))
 #  endif
 
 # elif defined (__ppc__) || defined (__ppc64__) || defined (__powerpc__)
@@ -31,6 +31,20 @@ extern "C" {
 /** Executor type (opaque) */
 typedef struct vlc_executor vlc_executor_t;
 
+/**
+ * Priority class of a runnable.
+ *
+ * Pending runnables of a higher class are always started before pending
+ * runnables of a lower class. Within a class, runnables are started roughly
+ * in submission order.
+ */
+enum vlc_executor_priority
+{
+    VLC_EXECUTOR_PRIORITY_LOW, /**< background bulk work */
+    VLC_EXECUTOR_PRIORITY_NORMAL, /**< default */
+    VLC_EXECUTOR_PRIORITY_HIGH, /**< work requested interactively */
+};
+
 /**
  * A Runnable encapsulates a task to be run from an executor thread.
  */
@@ -60,6 +74,8 @@ struct vlc_runnable {
 
     /* Private data used by the vlc_executor_t (do not touch) */
     struct vlc_list node;
+    void *queue;
+    enum vlc_executor_priority priority;
 };
 
 /**
@@ -139,12 +155,30 @@ vlc_executor_Delete(vlc_executor_t *executor);
  *
  * For simplicity, it is discouraged to submit a runnable previously submitted.
  *
+ * The runnable is submitted with the \ref VLC_EXECUTOR_PRIORITY_NORMAL
+ * priority class, see vlc_executor_SubmitWithPriority().
+ *
  * \param executor the executor
  * \param runnable the task to run
  */
 VLC_API void
 vlc_executor_Submit(vlc_executor_t *executor, struct vlc_runnable *runnable);
 
+/**
+ * Submit a runnable for execution with a given priority class.
+ *
+ * This is the same as vlc_executor_Submit(), except that the runnable is
+ * started before any pending runnable of a lower priority class.
+ *
+ * \param executor the executor
+ * \param runnable the task to run
+ * \param priority the priority class
+ */
+VLC_API void
+vlc_executor_SubmitWithPriority(vlc_executor_t *executor,
+                                struct vlc_runnable *runnable,
+                                enum vlc_executor_priority priority);
+
 /**
  * Cancel a runnable previously submitted.
  *
@@ -235,8 +235,45 @@ struct filter_t
 
     /** Private structure for the owner of the filter */
     filter_owner_t      owner;
+
+    /** Set by the owner if vlc_filter_RunSlices() may process the slices
+     * on other threads, in parallel with the filter thread */
+    bool                b_allow_slices;
 };
 
+/**
+ * Slice processing callback.
+ *
+ * \param filter the filter
+ * \param opaque data passed to vlc_filter_RunSlices()
+ * \param first first row of the slice
+ * \param last row following the last row of the slice
+ */
+typedef void (*vlc_filter_slice_cb)(filter_t *filter, void *opaque,
+                                    unsigned first, unsigned last);
+
+/**
+ * Processes rows in slices, possibly in parallel.
+ *
+ * The range of rows [0, rows) is split into disjoint slices whose boundaries
+ * are multiple of \p align, and the callback is invoked once per slice. If
+ * the owner of the filter allows it (see filter_t::b_allow_slices), slices
+ * are processed by the shared filter threads as well as by the calling
+ * thread. Otherwise, or if there is not enough rows to split, the callback
+ * is invoked once with the whole range on the calling thread.
+ *
+ * This function returns when all the slices have been processed.
+ *
+ * \param filter the filter
+ * \param rows number of rows to process
+ * \param align slice boundaries alignment in rows (e.g. 2 for 4:2:0 chroma)
+ * \param cb slice processing callback
+ * \param opaque data for the callback
+ */
+VLC_API void vlc_filter_RunSlices(filter_t *filter, unsigned rows,
+                                  unsigned align, vlc_filter_slice_cb cb,
+                                  void *opaque);
+
 VLC_API module_t *vlc_filter_LoadModule(filter_t *, const char *cap,
                                         const char *name, bool strict);
 VLC_API void vlc_filter_UnloadModule(filter_t *);
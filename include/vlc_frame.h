@@ -852,6 +852,100 @@ static inline size_t vlc_fifo_Count (vlc_fifo_t *fifo)
     return depth;
 }
 
+/**
+ * @}
+ * \defgroup frame_spsc_fifo Single-producer single-consumer frame FIFO
+ * Lock-free bounded frame queue
+ *
+ * This queue is a ring buffer of frame pointers that can be used instead of
+ * a \ref block_fifo when exactly one thread queues frames and exactly one
+ * other thread dequeues them. Neither side takes a lock. In exchange, the
+ * queue has a fixed capacity and does not provide any mean to wait: the
+ * owner must provide its own signaling.
+ *
+ * Functions flagged "producer" must only be called from the producer thread,
+ * and functions flagged "consumer" from the consumer thread.
+ * @{
+ */
+
+typedef struct vlc_spsc_fifo vlc_spsc_fifo_t;
+
+/**
+ * Creates a single-producer single-consumer FIFO.
+ *
+ * @param capacity maximum number of queued frames
+ *                 (rounded up to a power of two)
+ * @return the FIFO or NULL on memory error
+ */
+VLC_API vlc_spsc_fifo_t *vlc_spsc_fifo_New(size_t capacity)
+VLC_USED VLC_MALLOC;
+
+/**
+ * Deletes a FIFO created by vlc_spsc_fifo_New().
+ *
+ * @note Any queued frames are also released.
+ * @warning Neither the producer nor the consumer may use the FIFO anymore.
+ */
+VLC_API void vlc_spsc_fifo_Delete(vlc_spsc_fifo_t *);
+
+/**
+ * Queues a linked-list of frames (producer).
+ *
+ * Either all frames of the list are queued, or none is.
+ *
+ * @param fifo the FIFO
+ * @param frame the head of the list of frames
+ * @retval true if the frames were queued
+ * @retval false if the FIFO is too full (the caller keeps the frames)
+ */
+VLC_API bool vlc_spsc_fifo_Push(vlc_spsc_fifo_t *fifo, vlc_frame_t *frame)
+VLC_USED;
+
+/**
+ * Dequeues the first frame, if any (consumer).
+ *
+ * @return the first frame in the FIFO or NULL if the FIFO is empty
+ */
+VLC_API vlc_frame_t *vlc_spsc_fifo_Pop(vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Marks the current end of the FIFO (producer).
+ *
+ * The mark can be passed to vlc_spsc_fifo_DequeueUntil() by the consumer to
+ * dequeue every frame queued before this call, without affecting frames
+ * queued afterward. This is typically used to flush the FIFO.
+ */
+VLC_API size_t vlc_spsc_fifo_Mark(vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Dequeues all frames up to a mark (consumer).
+ *
+ * @param fifo the FIFO
+ * @param mark a value returned by vlc_spsc_fifo_Mark()
+ * @return a linked-list of dequeued frames (possibly NULL)
+ */
+VLC_API vlc_frame_t *vlc_spsc_fifo_DequeueUntil(vlc_spsc_fifo_t *fifo,
+                                                size_t mark) VLC_USED;
+
+/**
+ * Counts frames in a FIFO.
+ *
+ * This function can be called from any thread. The value is only a snapshot
+ * if the producer or the consumer is running concurrently.
+ */
+VLC_API size_t vlc_spsc_fifo_GetCount(const vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Counts bytes in a FIFO.
+ *
+ * This function can be called from any thread. The value is only a snapshot
+ * if the producer or the consumer is running concurrently.
+ *
+ * @note Zero bytes does not necessarily mean that the FIFO is empty since
+ * a frame could contain zero bytes.
+ */
+VLC_API size_t vlc_spsc_fifo_GetBytes(const vlc_spsc_fifo_t *) VLC_USED;
+
 /** @} */
 
 /** @} */
@@ -550,6 +550,10 @@ struct input_stats_t
     /* Aout */
     uint64_t i_played_abuffers;
     uint64_t i_lost_abuffers;
+
+    /* Frame allocator (process-wide) */
+    uint64_t i_frame_allocs;
+    uint64_t i_frame_heap_allocs;
 };
 
 /**
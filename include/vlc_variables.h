@@ -211,6 +211,120 @@ VLC_API int var_Get(vlc_object_t *obj, const char *name, vlc_value_t *valp);
 VLC_API int var_SetChecked( vlc_object_t *, const char *, int, vlc_value_t );
 VLC_API int var_GetChecked( vlc_object_t *, const char *, int, vlc_value_t * );
 
+/**
+ * \defgroup var_handle Variable name handles
+ *
+ * Variables that are accessed frequently, e.g. once per picture, can be
+ * looked up by handle rather than by name, to skip hashing the name.
+ * @{
+ */
+
+/**
+ * Interned variable name.
+ */
+typedef struct vlc_var_name vlc_var_name_t;
+
+/**
+ * Looks up the handle of a variable name.
+ *
+ * A handle designates a variable name, not a variable. It can be used with
+ * any object holding a variable of that name, and remains valid even if the
+ * variable is destroyed.
+ *
+ * \note Handles are never freed. This should only be used with a bounded
+ * set of names, typically string literals.
+ *
+ * \param name Variable name
+ * \return a handle (cannot be NULL)
+ */
+VLC_API const vlc_var_name_t *var_Lookup(const char *name) VLC_USED;
+
+VLC_API int var_SetCheckedByHandle(vlc_object_t *, const vlc_var_name_t *,
+                                   int, vlc_value_t);
+VLC_API int var_GetCheckedByHandle(vlc_object_t *, const vlc_var_name_t *,
+                                   int, vlc_value_t *);
+
+/**
+ * Sets the value of an integer variable by name handle.
+ */
+static inline int var_SetIntegerByHandle(vlc_object_t *obj,
+                                         const vlc_var_name_t *name,
+                                         int64_t i)
+{
+    vlc_value_t val;
+    val.i_int = i;
+    return var_SetCheckedByHandle(obj, name, VLC_VAR_INTEGER, val);
+}
+
+/**
+ * Sets the value of a boolean variable by name handle.
+ */
+static inline int var_SetBoolByHandle(vlc_object_t *obj,
+                                      const vlc_var_name_t *name, bool b)
+{
+    vlc_value_t val;
+    val.b_bool = b;
+    return var_SetCheckedByHandle(obj, name, VLC_VAR_BOOL, val);
+}
+
+/**
+ * Sets the value of a float variable by name handle.
+ */
+static inline int var_SetFloatByHandle(vlc_object_t *obj,
+                                       const vlc_var_name_t *name, float f)
+{
+    vlc_value_t val;
+    val.f_float = f;
+    return var_SetCheckedByHandle(obj, name, VLC_VAR_FLOAT, val);
+}
+
+/**
+ * Gets the value of an integer variable by name handle.
+ *
+ * \return the value, or 0 if the variable does not exist
+ */
+VLC_USED
+static inline int64_t var_GetIntegerByHandle(vlc_object_t *obj,
+                                             const vlc_var_name_t *name)
+{
+    vlc_value_t val;
+    if (!var_GetCheckedByHandle(obj, name, VLC_VAR_INTEGER, &val))
+        return val.i_int;
+    return 0;
+}
+
+/**
+ * Gets the value of a boolean variable by name handle.
+ *
+ * \return the value, or false if the variable does not exist
+ */
+VLC_USED
+static inline bool var_GetBoolByHandle(vlc_object_t *obj,
+                                       const vlc_var_name_t *name)
+{
+    vlc_value_t val;
+    if (!var_GetCheckedByHandle(obj, name, VLC_VAR_BOOL, &val))
+        return val.b_bool;
+    return false;
+}
+
+/**
+ * Gets the value of a float variable by name handle.
+ *
+ * \return the value, or 0 if the variable does not exist
+ */
+VLC_USED
+static inline float var_GetFloatByHandle(vlc_object_t *obj,
+                                         const vlc_var_name_t *name)
+{
+    vlc_value_t val;
+    if (!var_GetCheckedByHandle(obj, name, VLC_VAR_FLOAT, &val))
+        return val.f_float;
+    return 0.f;
+}
+
+/** @} */
+
 /**
  * Perform an atomic read-modify-write of a variable.
  *
@@ -807,6 +921,16 @@ VLC_API int var_LocationParse(vlc_object_t *obj, const char *mrl, const char *pr
 #define var_Get(a,b,c) var_Get(VLC_OBJECT(a), b, c)
 #define var_SetChecked(o,n,t,v) var_SetChecked(VLC_OBJECT(o), n, t, v)
 #define var_GetChecked(o,n,t,v) var_GetChecked(VLC_OBJECT(o), n, t, v)
+#define var_SetCheckedByHandle(o,n,t,v) \
+    var_SetCheckedByHandle(VLC_OBJECT(o), n, t, v)
+#define var_GetCheckedByHandle(o,n,t,v) \
+    var_GetCheckedByHandle(VLC_OBJECT(o), n, t, v)
+#define var_SetIntegerByHandle(o,n,i) var_SetIntegerByHandle(VLC_OBJECT(o), n, i)
+#define var_SetBoolByHandle(o,n,b) var_SetBoolByHandle(VLC_OBJECT(o), n, b)
+#define var_SetFloatByHandle(o,n,f) var_SetFloatByHandle(VLC_OBJECT(o), n, f)
+#define var_GetIntegerByHandle(o,n) var_GetIntegerByHandle(VLC_OBJECT(o), n)
+#define var_GetBoolByHandle(o,n) var_GetBoolByHandle(VLC_OBJECT(o), n)
+#define var_GetFloatByHandle(o,n) var_GetFloatByHandle(VLC_OBJECT(o), n)
 
 #define var_AddCallback(a,b,c,d) var_AddCallback(VLC_OBJECT(a), b, c, d)
 #define var_DelCallback(a,b,c,d) var_DelCallback(VLC_OBJECT(a), b, c, d)
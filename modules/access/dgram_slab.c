@@ -0,0 +1,305 @@
+/*****************************************************************************
+ * dgram_slab.c: batched datagram reception into recycled blocks
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_block.h>
+#include <vlc_network.h>
+#include "dgram_slab.h"
+
+#ifndef MSG_TRUNC
+# define MSG_TRUNC 0
+#endif
+
+#if defined(SO_TIMESTAMPNS) || defined(SO_TIMESTAMP)
+# define DGRAM_CMSG_SIZE CMSG_SPACE(sizeof (struct timespec))
+#endif
+
+struct vlc_dgram_slot
+{
+    block_t block;
+    struct vlc_dgram_slab *slab;
+};
+
+struct vlc_dgram_slab
+{
+    vlc_atomic_rc_t rc;
+    vlc_mutex_t lock;
+    size_t mru;
+    unsigned batch;
+    unsigned free_count;
+    struct vlc_dgram_slot **free;
+    struct vlc_dgram_slot *slots;
+    unsigned char *buffers;
+};
+
+static void vlc_dgram_slab_Destroy(struct vlc_dgram_slab *slab)
+{
+    free(slab->buffers);
+    free(slab->slots);
+    free(slab->free);
+    free(slab);
+}
+
+void vlc_dgram_slab_Release(struct vlc_dgram_slab *slab)
+{
+    if (vlc_atomic_rc_dec(&slab->rc))
+        vlc_dgram_slab_Destroy(slab);
+}
+
+static void vlc_dgram_slot_Release(block_t *block)
+{
+    struct vlc_dgram_slot *slot =
+        container_of(block, struct vlc_dgram_slot, block);
+    struct vlc_dgram_slab *slab = slot->slab;
+
+    vlc_mutex_lock(&slab->lock);
+    slab->free[slab->free_count++] = slot;
+    vlc_mutex_unlock(&slab->lock);
+    vlc_dgram_slab_Release(slab);
+}
+
+static const struct vlc_block_callbacks vlc_dgram_slot_cbs = {
+    vlc_dgram_slot_Release,
+};
+
+struct vlc_dgram_slab *vlc_dgram_slab_New(unsigned count, size_t mru,
+                                          unsigned batch)
+{
+    assert(count > 0);
+    assert(batch > 0 && batch <= VLC_DGRAM_BATCH_MAX);
+
+    struct vlc_dgram_slab *slab = malloc(sizeof (*slab));
+    if (unlikely(slab == NULL))
+        return NULL;
+
+    /* Buffers are allocated but not touched here: only the pages that
+     * received datagrams actually get written to end up being resident. */
+    slab->free = vlc_alloc(count, sizeof (*slab->free));
+    slab->slots = vlc_alloc(count, sizeof (*slab->slots));
+    slab->buffers = vlc_alloc(count, mru);
+    if (unlikely(slab->free == NULL || slab->slots == NULL
+              || slab->buffers == NULL)) {
+        vlc_dgram_slab_Destroy(slab);
+        return NULL;
+    }
+
+    vlc_atomic_rc_init(&slab->rc);
+    vlc_mutex_init(&slab->lock);
+    slab->mru = mru;
+#ifdef HAVE_RECVMMSG
+    slab->batch = batch;
+#else
+    slab->batch = 1;
+#endif
+    slab->free_count = count;
+
+    for (unsigned i = 0; i < count; i++) {
+        slab->slots[i].slab = slab;
+        slab->free[i] = &slab->slots[i];
+    }
+    return slab;
+}
+
+static block_t *vlc_dgram_slab_Get(struct vlc_dgram_slab *slab,
+                                   struct vlc_dgram_slot *slot)
+{
+    size_t offset = (slot - slab->slots) * slab->mru;
+
+    vlc_atomic_rc_inc(&slab->rc);
+    return block_Init(&slot->block, &vlc_dgram_slot_cbs,
+                      slab->buffers + offset, slab->mru);
+}
+
+#ifdef DGRAM_CMSG_SIZE
+int vlc_dgram_EnableTimestamps(int fd)
+{
+    const int on = 1;
+
+# ifdef SO_TIMESTAMPNS
+    if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof (on)) == 0)
+        return 0;
+# endif
+# ifdef SO_TIMESTAMP
+    if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof (on)) == 0)
+        return 0;
+# endif
+    return -1;
+}
+
+/**
+ * Extracts the kernel timestamp of a received datagram.
+ *
+ * Timestamps are expressed in wall clock time. They are converted to
+ * the monotonic VLC clock using the current time of both clocks.
+ */
+static vlc_tick_t vlc_dgram_GetTimestamp(struct msghdr *hdr,
+                                         vlc_tick_t now, vlc_tick_t wallnow)
+{
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(hdr);
+         cm != NULL;
+         cm = CMSG_NXTHDR(hdr, cm)) {
+        vlc_tick_t ts;
+
+        if (cm->cmsg_level != SOL_SOCKET)
+            continue;
+
+        switch (cm->cmsg_type) {
+# ifdef SCM_TIMESTAMPNS
+            case SCM_TIMESTAMPNS: {
+                struct timespec tv;
+
+                memcpy(&tv, CMSG_DATA(cm), sizeof (tv));
+                ts = vlc_tick_from_timespec(&tv);
+                break;
+            }
+# endif
+# ifdef SCM_TIMESTAMP
+            case SCM_TIMESTAMP: {
+                struct timeval tv;
+
+                memcpy(&tv, CMSG_DATA(cm), sizeof (tv));
+                ts = vlc_tick_from_timeval(&tv);
+                break;
+            }
+# endif
+            default:
+                continue;
+        }
+
+        ts = now - (wallnow - ts);
+        return (ts < now) ? ts : now;
+    }
+    return VLC_TICK_INVALID;
+}
+#else
+int vlc_dgram_EnableTimestamps(int fd)
+{
+    (void) fd;
+    errno = ENOSYS;
+    return -1;
+}
+#endif
+
+block_t *vlc_dgram_slab_Recv(struct vlc_dgram_slab *slab, int fd)
+{
+    block_t *blocks[VLC_DGRAM_BATCH_MAX];
+    struct iovec iov[VLC_DGRAM_BATCH_MAX];
+    unsigned count = 0;
+
+    vlc_mutex_lock(&slab->lock);
+    while (count < slab->batch && slab->free_count > 0) {
+        struct vlc_dgram_slot *slot = slab->free[--slab->free_count];
+
+        blocks[count++] = vlc_dgram_slab_Get(slab, slot);
+    }
+    vlc_mutex_unlock(&slab->lock);
+
+    if (count == 0) {
+        /* All buffers are held downstream: fall back to the heap */
+        blocks[0] = block_Alloc(slab->mru);
+        if (unlikely(blocks[0] == NULL))
+            return NULL;
+        count = 1;
+    }
+
+#ifdef DGRAM_CMSG_SIZE
+    union {
+        char buf[DGRAM_CMSG_SIZE];
+        struct cmsghdr align;
+    } cmsg[VLC_DGRAM_BATCH_MAX];
+#endif
+#ifdef HAVE_RECVMMSG
+    struct mmsghdr msgs[VLC_DGRAM_BATCH_MAX];
+#else
+    struct {
+        struct msghdr msg_hdr;
+        unsigned msg_len;
+    } msgs[1];
+#endif
+
+    for (unsigned i = 0; i < count; i++) {
+        struct msghdr *hdr = &msgs[i].msg_hdr;
+
+        iov[i].iov_base = blocks[i]->p_buffer;
+        iov[i].iov_len = blocks[i]->i_buffer;
+        memset(hdr, 0, sizeof (*hdr));
+        hdr->msg_iov = &iov[i];
+        hdr->msg_iovlen = 1;
+#ifdef DGRAM_CMSG_SIZE
+        hdr->msg_control = cmsg[i].buf;
+        hdr->msg_controllen = sizeof (cmsg[i].buf);
+#endif
+    }
+
+#ifdef HAVE_RECVMMSG
+    int val = recvmmsg(fd, msgs, count, MSG_WAITFORONE, NULL);
+#else
+    ssize_t len = recvmsg(fd, &msgs[0].msg_hdr, 0);
+    int val = (len >= 0) ? 1 : -1;
+
+    if (len >= 0)
+        msgs[0].msg_len = len;
+#endif
+    int errval = errno;
+    block_t *chain = NULL, **pp = &chain;
+
+    if (val > 0) {
+#ifdef DGRAM_CMSG_SIZE
+        struct timespec wallnow;
+        vlc_tick_t now = vlc_tick_now();
+
+        timespec_get(&wallnow, TIME_UTC);
+#endif
+        for (int i = 0; i < val; i++) {
+            block_t *block = blocks[i];
+            struct msghdr *hdr = &msgs[i].msg_hdr;
+
+            if (hdr->msg_flags & MSG_TRUNC)
+                block->i_flags |= BLOCK_FLAG_CORRUPTED;
+            else
+                block->i_buffer = msgs[i].msg_len;
+#ifdef DGRAM_CMSG_SIZE
+            block->i_pts = vlc_dgram_GetTimestamp(hdr, now,
+                                              vlc_tick_from_timespec(&wallnow));
+#endif
+            *pp = block;
+            pp = &block->p_next;
+        }
+    } else
+        val = 0;
+
+    /* Give back unused buffers */
+    for (unsigned i = val; i < count; i++)
+        block_Release(blocks[i]);
+
+    errno = errval;
+    return chain;
+}
@@ -0,0 +1,88 @@
+/*****************************************************************************
+ * dgram_slab.h: batched datagram reception into recycled blocks
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_DGRAM_SLAB_H
+# define VLC_DGRAM_SLAB_H
+
+/**
+ * \defgroup dgram_slab Datagram slab
+ * \ingroup access
+ *
+ * Receives several datagrams per system call (with recvmmsg() where
+ * available) into a fixed set of pre-allocated blocks. Blocks are returned
+ * to the slab when released instead of being freed, so that steady-state
+ * reception does not allocate memory.
+ *
+ * @{
+ */
+
+/** Maximum number of datagrams received with a single system call */
+#define VLC_DGRAM_BATCH_MAX 64
+
+struct vlc_dgram_slab;
+
+/**
+ * Creates a datagram slab.
+ *
+ * \param count number of receive buffers (blocks) in the slab
+ * \param mru size of each receive buffer (bytes)
+ * \param batch maximum number of datagrams per system call
+ * (between 1 and \ref VLC_DGRAM_BATCH_MAX)
+ * \return a slab or NULL on memory error
+ */
+struct vlc_dgram_slab *vlc_dgram_slab_New(unsigned count, size_t mru,
+                                          unsigned batch);
+
+/**
+ * Releases a datagram slab.
+ *
+ * The memory is actually freed when all blocks received from the slab have
+ * been released as well.
+ */
+void vlc_dgram_slab_Release(struct vlc_dgram_slab *slab);
+
+/**
+ * Receives one or more datagrams.
+ *
+ * This function waits for at least one datagram, then dequeues as many
+ * pending datagrams as possible without waiting further.
+ *
+ * Truncated datagrams are flagged with \ref BLOCK_FLAG_CORRUPTED. If kernel
+ * timestamps were enabled on the socket with vlc_dgram_EnableTimestamps(),
+ * the block PTS is set to the reception time (in vlc_tick_now() time base).
+ *
+ * If all slab buffers are in use, a block is allocated from the heap.
+ *
+ * \param fd datagram socket
+ * \return a chain of received blocks, or NULL on error (errno is set)
+ */
+block_t *vlc_dgram_slab_Recv(struct vlc_dgram_slab *slab, int fd);
+
+/**
+ * Requests kernel reception timestamps on a socket.
+ *
+ * \retval 0 on success
+ * \retval -1 if not supported (errno is set)
+ */
+int vlc_dgram_EnableTimestamps(int fd);
+
+/** @} */
+
+#endif
@@ -23,8 +23,12 @@
 #endif
 
 #include <assert.h>
+#include <errno.h>
 #include <vlc_common.h>
+#include <vlc_list.h>
 #include <vlc_network.h>
+#include <vlc_strings.h>
+#include <vlc_threads.h>
 #include <vlc_tls.h>
 #include <vlc_url.h>
 #include "transport.h"
@@ -96,50 +100,283 @@ static char *vlc_http_proxy_find(const char *hostname, unsigned port,
 }
 
 
+/** Maximum number of pooled connections to a same server */
+#define VLC_HTTP_MAX_CONNS_PER_HOST 4
+/** Delay after which an unused pooled connection is closed */
+#define VLC_HTTP_IDLE_TIMEOUT VLC_TICK_FROM_SEC(30)
+
+/**
+ * Pooled connection.
+ *
+ * Connections are keyed by the origin server they were established for, even
+ * if they go through a proxy: the proxy only depends on the origin.
+ */
+struct vlc_http_mgr_conn
+{
+    struct vlc_http_conn *conn;
+    char *host;
+    unsigned port;
+    bool https;
+    bool http2;
+    bool pooled; /**< Whether the connection is still in the pool */
+    unsigned refs; /**< Pool reference, plus one per stream being opened */
+    vlc_tick_t last_use; /**< Last time a stream was opened */
+    struct vlc_list node;
+};
+
 struct vlc_http_mgr
 {
     struct vlc_logger *logger;
     vlc_object_t *obj;
     vlc_tls_client_t *creds;
     struct vlc_http_cookie_jar_t *jar;
-    struct vlc_http_conn *conn;
+    vlc_mutex_t lock; /**< Protects the pool, shared between threads */
+    struct vlc_list conns; /**< Pooled connections, most recently used first */
+    unsigned opened;
+    unsigned reused;
 };
 
-static struct vlc_http_conn *vlc_http_mgr_find(struct vlc_http_mgr *mgr,
-                                               const char *host, unsigned port)
+static unsigned vlc_http_default_port(bool https, unsigned port)
+{
+    if (port != 0)
+        return port;
+    return https ? 443 : 80;
+}
+
+static bool vlc_http_mgr_match(const struct vlc_http_mgr_conn *entry,
+                               bool https, const char *host, unsigned port)
+{
+    return entry->https == https
+        && entry->port == vlc_http_default_port(https, port)
+        && vlc_ascii_strcasecmp(entry->host, host) == 0;
+}
+
+static void vlc_http_mgr_unref(struct vlc_http_mgr_conn *entry)
 {
-    (void) host; (void) port;
-    return mgr->conn;
+    assert(entry->refs > 0);
+    if (--entry->refs > 0)
+        return;
+
+    assert(!entry->pooled);
+    vlc_http_conn_release(entry->conn);
+    free(entry->host);
+    free(entry);
 }
 
+/**
+ * Removes a connection from the pool.
+ *
+ * The connection is closed once the streams being opened on it, if any, are
+ * (see vlc_http_mgr_open()).
+ */
 static void vlc_http_mgr_release(struct vlc_http_mgr *mgr,
-                                 struct vlc_http_conn *conn)
+                                 struct vlc_http_mgr_conn *entry)
+{
+    (void) mgr;
+    assert(entry->pooled);
+    vlc_list_remove(&entry->node);
+    entry->pooled = false;
+    vlc_http_mgr_unref(entry);
+}
+
+/**
+ * Removes a connection from the pool, if it is still there.
+ *
+ * Another thread may have closed the connection in the mean time.
+ */
+static void vlc_http_mgr_forget(struct vlc_http_mgr *mgr,
+                                struct vlc_http_conn *conn)
+{
+    struct vlc_http_mgr_conn *entry;
+
+    vlc_mutex_lock(&mgr->lock);
+    vlc_list_foreach(entry, &mgr->conns, node)
+        if (entry->conn == conn)
+        {
+            vlc_http_mgr_release(mgr, entry);
+            break;
+        }
+    vlc_mutex_unlock(&mgr->lock);
+}
+
+/**
+ * Closes the connections that were not used for too long.
+ *
+ * A stream may still be active on such a connection (e.g. a long download
+ * over HTTP/1). The connection is then only closed at the end of the stream.
+ */
+static void vlc_http_mgr_expire(struct vlc_http_mgr *mgr)
+{
+    const vlc_tick_t deadline = vlc_tick_now() - VLC_HTTP_IDLE_TIMEOUT;
+    struct vlc_http_mgr_conn *entry;
+
+    vlc_list_foreach(entry, &mgr->conns, node)
+        if (entry->last_use < deadline)
+        {
+            vlc_http_dbg(mgr->logger, "closing idle connection to %s:%u",
+                         entry->host, entry->port);
+            vlc_http_mgr_release(mgr, entry);
+        }
+}
+
+/**
+ * Adds a new connection to the pool.
+ *
+ * A new HTTP/2 connection replaces the other connections to the same server,
+ * since it can carry all the requests. Otherwise, if there are already too
+ * many connections to the server, the least recently used one is closed.
+ */
+static void vlc_http_mgr_add(struct vlc_http_mgr *mgr,
+                             struct vlc_http_conn *conn, bool https,
+                             const char *host, unsigned port, bool http2)
 {
-    assert(mgr->conn == conn);
-    mgr->conn = NULL;
+    struct vlc_http_mgr_conn *entry, *oldest = NULL;
+    unsigned count = 0;
+
+    vlc_mutex_lock(&mgr->lock);
+    mgr->opened++;
+
+    vlc_list_foreach(entry, &mgr->conns, node)
+        if (vlc_http_mgr_match(entry, https, host, port))
+        {
+            if (http2)
+                vlc_http_mgr_release(mgr, entry);
+            else
+            {
+                oldest = entry;
+                count++;
+            }
+        }
+
+    if (count >= VLC_HTTP_MAX_CONNS_PER_HOST)
+        vlc_http_mgr_release(mgr, oldest);
+
+    entry = malloc(sizeof (*entry));
+    if (unlikely(entry == NULL))
+        goto error;
+
+    entry->host = strdup(host);
+    if (unlikely(entry->host == NULL))
+    {
+        free(entry);
+        goto error;
+    }
 
+    entry->conn = conn;
+    entry->port = vlc_http_default_port(https, port);
+    entry->https = https;
+    entry->http2 = http2;
+    entry->pooled = true;
+    entry->refs = 1;
+    entry->last_use = vlc_tick_now();
+    vlc_list_prepend(&entry->node, &mgr->conns);
+    vlc_mutex_unlock(&mgr->lock);
+    return;
+
+error:
+    vlc_mutex_unlock(&mgr->lock);
+    /* Not pooled: the connection is closed at the end of the stream. */
     vlc_http_conn_release(conn);
 }
 
+/**
+ * Opens a stream on a pooled connection to the server, if any.
+ *
+ * HTTP/2 connections are multiplexed, so they can be reused while other
+ * streams are active. Busy HTTP/1 connections are skipped.
+ *
+ * The candidate connections are referenced under the pool lock, but the
+ * requests are sent without it (HTTP/1 writes them synchronously), so that
+ * a slow socket does not delay the requests of the other threads.
+ */
 static
-struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
+struct vlc_http_stream *vlc_http_mgr_open(struct vlc_http_mgr *mgr,
+                                          bool https, const char *host,
+                                          unsigned port,
+                                          const struct vlc_http_msg *req,
+                                          bool payload,
+                                          struct vlc_http_conn **restrict connp)
+{
+    struct vlc_http_mgr_conn *entry, *cands[VLC_HTTP_MAX_CONNS_PER_HOST];
+    struct vlc_http_stream *stream = NULL;
+    bool failed[VLC_HTTP_MAX_CONNS_PER_HOST];
+    unsigned count = 0, i;
+
+    vlc_mutex_lock(&mgr->lock);
+    vlc_http_mgr_expire(mgr);
+
+    vlc_list_foreach(entry, &mgr->conns, node)
+        if (vlc_http_mgr_match(entry, https, host, port)
+         && count < ARRAY_SIZE(cands))
+        {
+            entry->refs++;
+            cands[count++] = entry;
+        }
+    vlc_mutex_unlock(&mgr->lock);
+
+    for (i = 0; i < count; i++)
+    {
+        entry = cands[i];
+        stream = vlc_http_stream_open(entry->conn, req, payload);
+        if (stream != NULL)
+            break;
+
+        /* Get rid of closing or reset connection */
+        failed[i] = entry->http2 || errno != EBUSY;
+    }
+
+    vlc_mutex_lock(&mgr->lock);
+    for (unsigned j = 0; j < count; j++)
+    {
+        entry = cands[j];
+
+        if (j == i)
+        {   /* Used: keep the connection in the pool as the most recent */
+            entry->last_use = vlc_tick_now();
+            if (entry->pooled)
+            {
+                vlc_list_remove(&entry->node);
+                vlc_list_prepend(&entry->node, &mgr->conns);
+            }
+            *connp = entry->conn;
+        }
+        else if (j < i && failed[j] && entry->pooled)
+            vlc_http_mgr_release(mgr, entry);
+
+        vlc_http_mgr_unref(entry);
+    }
+    vlc_mutex_unlock(&mgr->lock);
+    return stream;
+}
+
+/**
+ * Sends a request over a pooled connection to the server, if any.
+ *
+ * The response is waited for without holding the pool lock, so that a slow
+ * server does not delay the requests of the other threads.
+ */
+static
+struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr, bool https,
                                         const char *host, unsigned port,
                                         const struct vlc_http_msg *req,
                                         bool payload)
 {
-    struct vlc_http_conn *conn = vlc_http_mgr_find(mgr, host, port);
-    if (conn == NULL)
-        return NULL;
+    struct vlc_http_stream *stream;
+    struct vlc_http_conn *conn;
 
-    struct vlc_http_stream *stream = vlc_http_stream_open(conn, req, payload);
-    if (stream != NULL)
+    while ((stream = vlc_http_mgr_open(mgr, https, host, port, req, payload,
+                                       &conn)) != NULL)
     {
         struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
         if (m != NULL)
+        {
+            vlc_mutex_lock(&mgr->lock);
+            mgr->reused++;
+            vlc_mutex_unlock(&mgr->lock);
             return m;
+        }
+        vlc_http_mgr_forget(mgr, conn);
     }
-    /* Get rid of closing or reset connection */
-    vlc_http_mgr_release(mgr, conn);
     return NULL;
 }
 
@@ -148,18 +385,22 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
                                               const struct vlc_http_msg *req,
                                               bool idempotent, bool payload)
 {
+    vlc_tls_client_t *creds;
     vlc_tls_t *tls;
     bool http2 = true;
 
-    if (mgr->creds == NULL && mgr->conn != NULL)
-        return NULL; /* switch from HTTP to HTTPS not implemented */
-
+    vlc_mutex_lock(&mgr->lock);
     if (mgr->creds == NULL)
     {   /* First TLS connection: load x509 credentials */
+        /* The credentials are shared by all the TLS sessions of the manager,
+         * so that the TLS provider can resume sessions. */
         mgr->creds = vlc_tls_ClientCreate(mgr->obj);
-        if (mgr->creds == NULL)
-            return NULL;
     }
+    creds = mgr->creds;
+    vlc_mutex_unlock(&mgr->lock);
+
+    if (creds == NULL)
+        return NULL;
 
     if (idempotent)
     {   /* If the request is idempotent, try to reuse an existing connection.
@@ -167,8 +408,8 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
          * the nonidempotent request was processed if the connection fails
          * before the response is received.
          */
-        struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req,
-                                                       payload);
+        struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, true, host, port,
+                                                       req, payload);
         if (resp != NULL)
             return resp; /* existing connection reused */
     }
@@ -176,12 +417,12 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
     char *proxy = vlc_http_proxy_find(host, port, true);
     if (proxy != NULL)
     {
-        tls = vlc_https_connect_proxy(mgr->creds, mgr->creds,
-                                      host, port, &http2, proxy);
+        tls = vlc_https_connect_proxy(creds, creds, host, port, &http2,
+                                      proxy);
         free(proxy);
     }
     else
-        tls = vlc_https_connect(mgr->creds, host, port, &http2);
+        tls = vlc_https_connect(creds, host, port, &http2);
 
     if (tls == NULL)
         return NULL;
@@ -206,11 +447,19 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    if (mgr->conn != NULL)
-        vlc_http_mgr_release(mgr, mgr->conn);
+    struct vlc_http_stream *stream = vlc_http_stream_open(conn, req, payload);
+    struct vlc_http_msg *resp = NULL;
 
-    mgr->conn = conn;
-    return vlc_http_mgr_reuse(mgr, host, port, req, payload);
+    if (stream != NULL)
+        resp = vlc_http_msg_get_initial(stream);
+    if (resp == NULL)
+    {
+        vlc_http_conn_release(conn);
+        return NULL;
+    }
+
+    vlc_http_mgr_add(mgr, conn, true, host, port, http2);
+    return resp;
 }
 
 static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
@@ -218,13 +467,10 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
                                              const struct vlc_http_msg *req,
                                              bool idempotent, bool payload)
 {
-    if (mgr->creds != NULL && mgr->conn != NULL)
-        return NULL; /* switch from HTTPS to HTTP not implemented */
-
     if (idempotent)
     {
-        struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req,
-                                                       payload);
+        struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, false, host, port,
+                                                       req, payload);
         if (resp != NULL)
             return resp;
     }
@@ -263,10 +509,7 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    if (mgr->conn != NULL)
-        vlc_http_mgr_release(mgr, mgr->conn);
-
-    mgr->conn = conn;
+    vlc_http_mgr_add(mgr, conn, false, host, port, false);
     return resp;
 }
 
@@ -298,14 +541,23 @@ struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
     mgr->obj = obj;
     mgr->creds = NULL;
     mgr->jar = jar;
-    mgr->conn = NULL;
+    vlc_mutex_init(&mgr->lock);
+    vlc_list_init(&mgr->conns);
+    mgr->opened = 0;
+    mgr->reused = 0;
     return mgr;
 }
 
 void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
 {
-    if (mgr->conn != NULL)
-        vlc_http_mgr_release(mgr, mgr->conn);
+    struct vlc_http_mgr_conn *entry;
+
+    if (mgr->opened > 0)
+        vlc_http_dbg(mgr->logger, "%u connection(s) opened, %u reused",
+                     mgr->opened, mgr->reused);
+
+    vlc_list_foreach(entry, &mgr->conns, node)
+        vlc_http_mgr_release(mgr, entry);
     if (mgr->creds != NULL)
         vlc_tls_ClientDelete(mgr->creds);
     free(mgr);
@@ -61,6 +61,8 @@ struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *);
  * Creates an HTTP connection manager
  *
  * Allocates an HTTP client connections manager.
+ * The manager can be shared between threads, so that their requests to a
+ * same server reuse the same connections.
  *
  * @param obj parent VLC object
  * @param jar HTTP cookies jar (NULL to disable cookies)
@@ -0,0 +1,343 @@
+/*****************************************************************************
+ * connmgr_test.c: HTTP connection manager tests
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#undef NDEBUG
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_network.h>
+#include <vlc_threads.h>
+#include <vlc_tls.h>
+#include "transport.h"
+#include "conn.h"
+#include "connmgr.h"
+#include "message.h"
+
+const char vlc_module_name[] = "test_http_connmgr";
+
+/*
+ * Fake connections: HTTP/1 ones carry one stream at a time, HTTP/2 ones any
+ * number of streams.
+ */
+struct test_conn
+{
+    struct vlc_http_conn conn;
+    bool https;
+    bool http2;
+    bool busy;
+    bool dead;
+    bool released;
+};
+
+static struct test_conn conns[16];
+static unsigned conn_count = 0;
+static bool http2 = false;
+static vlc_tick_t now = VLC_TICK_0;
+static struct test_conn *last_conn = NULL;
+static struct vlc_http_stream stream;
+static vlc_tls_t tls;
+static void (*open_hook)(void) = NULL;
+
+static struct vlc_http_stream *conn_stream_open(struct vlc_http_conn *c,
+                                                const struct vlc_http_msg *req,
+                                                bool has_data)
+{
+    struct test_conn *conn = container_of(c, struct test_conn, conn);
+
+    assert(!conn->released);
+    (void) req; (void) has_data;
+
+    if (conn->dead || conn->busy)
+    {
+        errno = conn->dead ? ENOTCONN : EBUSY;
+        return NULL;
+    }
+    if (!conn->http2)
+        conn->busy = true;
+    if (open_hook != NULL)
+    {   /* Another thread uses the manager while the request is sent */
+        void (*hook)(void) = open_hook;
+
+        open_hook = NULL;
+        hook();
+    }
+    last_conn = conn;
+    return &stream;
+}
+
+static void conn_release(struct vlc_http_conn *c)
+{
+    struct test_conn *conn = container_of(c, struct test_conn, conn);
+
+    assert(!conn->released);
+    conn->released = true;
+}
+
+static const struct vlc_http_conn_cbs conn_callbacks =
+{
+    conn_stream_open,
+    conn_release,
+};
+
+static struct vlc_http_conn *conn_create(bool https, bool two)
+{
+    assert(conn_count < ARRAY_SIZE(conns));
+
+    struct test_conn *conn = &conns[conn_count++];
+
+    conn->conn.cbs = &conn_callbacks;
+    conn->conn.tls = NULL;
+    conn->https = https;
+    conn->http2 = two;
+    conn->busy = false;
+    conn->dead = false;
+    conn->released = false;
+    return &conn->conn;
+}
+
+/* Sends a request, and returns the index of the connection that carried it */
+static unsigned request(struct vlc_http_mgr *mgr, bool https, const char *host,
+                        unsigned port, bool idempotent)
+{
+    struct vlc_http_msg *m = vlc_http_mgr_request(mgr, https, host, port, NULL,
+                                                  idempotent, false);
+    assert(m != NULL);
+
+    /* The fake response is the connection */
+    struct test_conn *conn = (struct test_conn *)m;
+    assert(!conn->released);
+    assert(conn->https == https);
+    return conn - conns;
+}
+
+static struct vlc_http_mgr *hook_mgr;
+static unsigned hook_conn;
+
+/* Replaces the connections to the server with an HTTP/2 one */
+static void replace_conn(void)
+{
+    http2 = true;
+    assert(conns[request(hook_mgr, true, "d.example", 0, true)].http2);
+    assert(!conns[hook_conn].released);
+}
+
+int main(void)
+{
+    vlc_object_t obj = { .logger = NULL };
+    struct vlc_http_mgr *mgr = vlc_http_mgr_create(&obj, NULL);
+    unsigned a, b, c, d, e;
+
+    assert(mgr != NULL);
+
+    /* Sequential requests to a server reuse the connection */
+    a = request(mgr, false, "a.example", 0, true);
+    conns[a].busy = false;
+    assert(request(mgr, false, "a.example", 80, true) == a);
+    conns[a].busy = false;
+    assert(request(mgr, false, "A.EXAMPLE", 0, true) == a);
+    conns[a].busy = false;
+    assert(conn_count == 1);
+
+    /* Another server does not close the first connection */
+    b = request(mgr, false, "b.example", 0, true);
+    conns[b].busy = false;
+    assert(b != a);
+    assert(request(mgr, false, "a.example", 0, true) == a);
+    conns[a].busy = false;
+    assert(request(mgr, false, "b.example", 0, true) == b);
+    conns[b].busy = false;
+    assert(request(mgr, false, "a.example", 8080, true) != a);
+    assert(conn_count == 3);
+    assert(!conns[a].released && !conns[b].released);
+    conns[2].busy = false;
+
+    /* HTTPS connections share the pool with plain HTTP ones */
+    http2 = true;
+    c = request(mgr, true, "a.example", 0, true);
+    assert(conns[c].https && conns[c].http2);
+    /* HTTP/2 streams are multiplexed */
+    assert(request(mgr, true, "a.example", 443, true) == c);
+    assert(request(mgr, true, "a.example", 0, true) == c);
+    assert(request(mgr, false, "a.example", 0, true) == a);
+    conns[a].busy = false;
+    assert(conn_count == 4);
+
+    /* A busy HTTP/1 connection is not reused, but kept for later */
+    assert(request(mgr, false, "b.example", 0, true) == b);
+    d = request(mgr, false, "b.example", 0, true);
+    assert(d != b);
+    assert(!conns[b].released);
+    conns[b].busy = false;
+    assert(request(mgr, false, "b.example", 0, true) == b);
+    conns[d].busy = false;
+
+    /* Nor is a failed one */
+    conns[d].dead = true;
+    e = request(mgr, false, "b.example", 0, true);
+    assert(e != b && e != d);
+    assert(conns[d].released && !conns[b].released);
+    conns[b].busy = false;
+    conns[e].busy = false;
+    b = e;
+
+    /* Nonidempotent requests use new connections, within limits */
+    http2 = false;
+    d = conn_count;
+    for (unsigned i = 0; i < 5; i++)
+    {
+        assert(request(mgr, true, "c.example", 0, false) == d + i);
+        conns[d + i].busy = false;
+    }
+    assert(conns[d].released);
+    for (unsigned i = 1; i < 5; i++)
+        assert(!conns[d + i].released);
+
+    /* A new HTTP/2 connection replaces the HTTP/1 ones */
+    http2 = true;
+    c = request(mgr, true, "c.example", 0, false);
+    for (unsigned i = 1; i < 5; i++)
+        assert(conns[d + i].released);
+    assert(request(mgr, true, "c.example", 0, true) == c);
+
+    /* A connection removed from the pool while a request is sent on it is
+     * only released afterwards */
+    http2 = false;
+    e = request(mgr, true, "d.example", 0, true);
+    conns[e].busy = false;
+    hook_mgr = mgr;
+    hook_conn = e;
+    open_hook = replace_conn;
+    assert(vlc_http_mgr_request(mgr, true, "d.example", 0, NULL, true, false)
+           == (struct vlc_http_msg *)&conns[e]);
+    assert(conns[e].released);
+
+    /* Idle connections are closed */
+    now += VLC_TICK_FROM_SEC(20);
+    assert(request(mgr, false, "a.example", 0, true) == a);
+    conns[a].busy = false;
+    now += VLC_TICK_FROM_SEC(20);
+    assert(request(mgr, false, "a.example", 0, true) == a);
+    conns[a].busy = false;
+    assert(conns[b].released && conns[c].released);
+
+    vlc_http_mgr_destroy(mgr);
+
+    for (unsigned i = 0; i < conn_count; i++)
+        assert(conns[i].released);
+
+    return 0;
+}
+
+/* Callbacks for the connection manager */
+struct vlc_http_msg *vlc_http_msg_get_initial(struct vlc_http_stream *s)
+{
+    assert(s == &stream);
+    assert(last_conn != NULL);
+    return (struct vlc_http_msg *)last_conn;
+}
+
+vlc_tick_t vlc_tick_now(void)
+{
+    return now;
+}
+
+bool vlc_http_port_blocked(unsigned port)
+{
+    (void) port;
+    return false;
+}
+
+char *vlc_getProxyUrl(const char *url)
+{
+    (void) url;
+    return NULL;
+}
+
+vlc_tls_client_t *vlc_tls_ClientCreate(vlc_object_t *obj)
+{
+    (void) obj;
+    return (vlc_tls_client_t *)&tls;
+}
+
+void vlc_tls_ClientDelete(vlc_tls_client_t *creds)
+{
+    assert(creds == (vlc_tls_client_t *)&tls);
+}
+
+vlc_tls_t *vlc_tls_SocketOpenTLS(vlc_tls_client_t *creds, const char *name,
+                                 unsigned port, const char *service,
+                                 const char *const *alpn, char **alp)
+{
+    assert(creds == (vlc_tls_client_t *)&tls);
+    assert(port == 443);
+    (void) name; (void) service; (void) alpn;
+
+    *alp = http2 ? strdup("h2") : NULL;
+    return &tls;
+}
+
+vlc_tls_t *vlc_https_connect_proxy(void *ctx, vlc_tls_client_t *creds,
+                                   const char *hostname, unsigned port,
+                                   bool *restrict two, const char *proxy)
+{
+    (void) ctx; (void) creds; (void) hostname; (void) port; (void) two;
+    (void) proxy;
+    vlc_assert_unreachable();
+}
+
+struct vlc_http_conn *vlc_h2_conn_create(void *ctx, struct vlc_tls *t)
+{
+    assert(t == &tls);
+    (void) ctx;
+    return conn_create(true, true);
+}
+
+struct vlc_http_conn *vlc_h1_conn_create(void *ctx, struct vlc_tls *t,
+                                         bool proxy)
+{
+    assert(t == &tls);
+    assert(!proxy);
+    (void) ctx;
+    return conn_create(true, false);
+}
+
+struct vlc_http_stream *vlc_h1_request(void *ctx, const char *hostname,
+                                       unsigned port, bool proxy,
+                                       const struct vlc_http_msg *req,
+                                       bool idempotent, bool has_data,
+                                       struct vlc_http_conn **restrict connp)
+{
+    struct vlc_http_conn *conn = conn_create(false, false);
+
+    assert(!proxy);
+    assert(port != 0);
+    (void) ctx; (void) hostname; (void) idempotent;
+
+    *connp = conn;
+    return vlc_http_stream_open(conn, req, has_data);
+}
@@ -113,6 +113,7 @@ struct vlc_h1_conn
     struct vlc_http_stream stream;
     uintmax_t content_length;
     bool connection_close;
+    vlc_mutex_t lock; /**< Protects active and released */
     bool active;
     bool released;
     bool proxy;
@@ -146,25 +147,48 @@ static struct vlc_http_stream *vlc_h1_stream_open(struct vlc_http_conn *c,
     struct vlc_h1_conn *conn = container_of(c, struct vlc_h1_conn, conn);
     size_t len;
     ssize_t val;
+    bool destroy;
 
+    /* The previous stream may be closed from another thread. */
+    vlc_mutex_lock(&conn->lock);
     if (conn->active || conn->conn.tls == NULL)
+    {
+        errno = conn->active ? EBUSY : ENOTCONN;
+        vlc_mutex_unlock(&conn->lock);
         return NULL;
+    }
+    conn->active = true;
+    vlc_mutex_unlock(&conn->lock);
 
     char *payload = vlc_http_msg_format(req, &len, conn->proxy, has_data);
     if (unlikely(payload == NULL))
-        return NULL;
+        goto error;
 
     vlc_http_dbg(CO(conn), "outgoing request:\n%.*s", (int)len, payload);
     val = vlc_tls_Write(conn->conn.tls, payload, len);
     free(payload);
 
     if (val < (ssize_t)len)
-        return vlc_h1_stream_fatal(conn);
+    {
+        vlc_h1_stream_fatal(conn);
+        errno = ECONNRESET;
+        goto error;
+    }
 
-    conn->active = true;
     conn->content_length = 0;
     conn->connection_close = false;
     return &conn->stream;
+
+error:
+    vlc_mutex_lock(&conn->lock);
+    conn->active = false;
+    destroy = conn->released;
+    vlc_mutex_unlock(&conn->lock);
+
+    /* The connection may have been released while the request was sent */
+    if (destroy)
+        vlc_h1_conn_destroy(conn);
+    return NULL;
 }
 
 static struct vlc_http_msg *vlc_h1_stream_wait(struct vlc_http_stream *stream)
@@ -287,6 +311,7 @@ static block_t *vlc_h1_stream_read(struct vlc_http_stream *stream)
 static void vlc_h1_stream_close(struct vlc_http_stream *stream, bool abort)
 {
     struct vlc_h1_conn *conn = vlc_h1_stream_conn(stream);
+    bool destroy;
 
     assert(conn->active);
 
@@ -302,9 +327,12 @@ static void vlc_h1_stream_close(struct vlc_http_stream *stream, bool abort)
         /* Shut the underlying connection down and prevent reuse. */
         vlc_h1_stream_fatal(conn);
 
+    vlc_mutex_lock(&conn->lock);
     conn->active = false;
+    destroy = conn->released;
+    vlc_mutex_unlock(&conn->lock);
 
-    if (conn->released)
+    if (destroy)
         vlc_h1_conn_destroy(conn);
 }
 
@@ -332,11 +360,15 @@ static void vlc_h1_conn_destroy(struct vlc_h1_conn *conn)
 static void vlc_h1_conn_release(struct vlc_http_conn *c)
 {
     struct vlc_h1_conn *conn = container_of(c, struct vlc_h1_conn, conn);
+    bool destroy;
 
+    vlc_mutex_lock(&conn->lock);
     assert(!conn->released);
     conn->released = true;
+    destroy = !conn->active;
+    vlc_mutex_unlock(&conn->lock);
 
-    if (!conn->active)
+    if (destroy)
         vlc_h1_conn_destroy(conn);
 }
 
@@ -355,6 +387,7 @@ struct vlc_http_conn *vlc_h1_conn_create(void *ctx, vlc_tls_t *tls, bool proxy)
     conn->conn.cbs = &vlc_h1_conn_callbacks;
     conn->conn.tls = tls;
     conn->stream.cbs = &vlc_h1_stream_callbacks;
+    vlc_mutex_init(&conn->lock);
     conn->active = false;
     conn->released = false;
     conn->proxy = proxy;
@@ -29,9 +29,11 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_block.h>
 #include <vlc_network.h>
 #include <vlc_poll.h>
 #include "vlc_dtls.h"
+#include "../dgram_slab.h"
 
 #ifndef MSG_TRUNC
 #define MSG_TRUNC 0
@@ -90,11 +92,20 @@ static ssize_t vlc_datagram_Send(struct vlc_dtls *dgs,
     return vlc_sendmsg(fd, &msg, 0);
 }
 
+static block_t *vlc_datagram_RecvBlocks(struct vlc_dtls *dgs,
+                                        struct vlc_dgram_slab *slab)
+{
+    int fd = container_of(dgs, struct vlc_dgram_sock, s)->fd;
+
+    return vlc_dgram_slab_Recv(slab, fd);
+}
+
 static const struct vlc_dtls_operations vlc_datagram_ops = {
     vlc_datagram_Close,
     vlc_datagram_GetPollFD,
     vlc_datagram_Recv,
     vlc_datagram_Send,
+    vlc_datagram_RecvBlocks,
 };
 
 struct vlc_dtls *vlc_datagram_CreateFD(int fd)
@@ -146,6 +157,7 @@ static const struct vlc_dtls_operations vlc_dccp_ops = {
     vlc_datagram_GetPollFD,
     vlc_dccp_Recv,
     vlc_datagram_Send,
+    NULL,
 };
 
 struct vlc_dtls *vlc_dccp_CreateFD(int fd)
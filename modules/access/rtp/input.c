@@ -42,6 +42,7 @@
 #include <vlc_demux.h>
 #include <vlc_block.h>
 #include "vlc_dtls.h"
+#include "../dgram_slab.h"
 
 #include "rtp.h"
 #ifdef HAVE_SRTP
@@ -50,6 +51,48 @@
 #include "input.h"
 
 #define DEFAULT_MRU (1500u - (20 + 8))
+/* Receive buffers for batched reception. Packets stay queued in the
+ * de-jitter buffer for a while, so this is much more than one batch. */
+#define DEFAULT_SLAB_SIZE 1024
+
+/**
+ * Sets up batched reception into recycled buffers, if enabled.
+ */
+void rtp_input_setup_batch(vlc_object_t *obj, rtp_input_sys_t *sys)
+{
+    unsigned batch = var_InheritInteger(obj, "rtp-batch");
+    bool timestamps = var_InheritBool(obj, "rtp-timestamps");
+
+    sys->slab = NULL;
+
+    if (batch <= 1 && !timestamps)
+        return;
+    if (!vlc_dtls_CanRecvBlocks(sys->rtp_sock)) {
+        msg_Dbg(obj, "batched reception not supported on this transport");
+        return;
+    }
+
+    if (timestamps) {
+        short events = POLLIN;
+        int fd = vlc_dtls_GetPollFD(sys->rtp_sock, &events);
+
+        if (vlc_dgram_EnableTimestamps(fd))
+            msg_Warn(obj, "kernel timestamps not supported: %s",
+                     vlc_strerror_c(errno));
+    }
+
+    if (batch > VLC_DGRAM_BATCH_MAX)
+        batch = VLC_DGRAM_BATCH_MAX;
+    if (batch < 1)
+        batch = 1;
+    sys->slab = vlc_dgram_slab_New(DEFAULT_SLAB_SIZE, DEFAULT_MRU, batch);
+}
+
+void rtp_input_cleanup_batch(rtp_input_sys_t *sys)
+{
+    if (sys->slab != NULL)
+        vlc_dgram_slab_Release(sys->slab);
+}
 
 /**
  * Processes a packet received from the RTP socket.
@@ -123,7 +166,30 @@ void *rtp_dgram_thread (void *opaque)
         if (n == 0)
             goto dequeue;
 
-        if (ufd[0].revents)
+        if (ufd[0].revents && sys->input_sys.slab != NULL)
+        {
+            block_t *block = vlc_dtls_RecvBlocks(rtp_sock,
+                                                 sys->input_sys.slab);
+            if (block == NULL)
+                vlc_warning (sys->logger, "RTP network error: %s",
+                             vlc_strerror_c(errno));
+
+            while (block != NULL)
+            {
+                block_t *next = block->p_next;
+
+                block->p_next = NULL;
+                if (block->i_flags & BLOCK_FLAG_CORRUPTED)
+                    vlc_error (sys->logger, "packet truncated (MRU was %u)",
+                               DEFAULT_MRU);
+                rtp_process (sys->logger, &sys->input_sys, sys->session,
+                             block);
+                block = next;
+            }
+
+            n--;
+        }
+        else if (ufd[0].revents)
         {
             block_t *block = block_Alloc(DEFAULT_MRU);
             if (unlikely(block == NULL))
@@ -28,6 +28,7 @@ typedef struct
 #endif
     struct vlc_dtls *rtp_sock;
     struct vlc_dtls *rtcp_sock;
+    struct vlc_dgram_slab *slab;
 } rtp_input_sys_t;
 
 /* Global data */
@@ -38,3 +39,6 @@ typedef struct
     vlc_thread_t  thread;
     rtp_input_sys_t input_sys;
 } rtp_sys_t;
+
+void rtp_input_setup_batch(vlc_object_t *obj, rtp_input_sys_t *sys);
+void rtp_input_cleanup_batch(rtp_input_sys_t *sys);
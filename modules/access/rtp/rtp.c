@@ -270,6 +270,7 @@ static void Close (vlc_object_t *obj)
 
     vlc_cancel(p_sys->thread);
     vlc_join(p_sys->thread, NULL);
+    rtp_input_cleanup_batch(&p_sys->input_sys);
 #ifdef HAVE_SRTP
     if (p_sys->input_sys.srtp)
         srtp_destroy (p_sys->input_sys.srtp);
@@ -437,7 +438,10 @@ static int OpenSDP(vlc_object_t *obj)
     if (err > 0 && module_exists("live555")) /* Bail out to live555 */
         goto error;
 
+    rtp_input_setup_batch(obj, &sys->input_sys);
+
     if (vlc_clone(&sys->thread, rtp_dgram_thread, sys)) {
+        rtp_input_cleanup_batch(&sys->input_sys);
         rtp_session_destroy(obj->logger, sys->session);
         goto error;
     }
@@ -606,8 +610,13 @@ static int OpenURL(vlc_object_t *obj)
     }
 #endif
 
+    rtp_input_setup_batch(obj, &p_sys->input_sys);
+
     if (vlc_clone (&p_sys->thread, rtp_dgram_thread, p_sys))
+    {
+        rtp_input_cleanup_batch(&p_sys->input_sys);
         goto error;
+    }
     return VLC_SUCCESS;
 
 error:
@@ -657,6 +666,17 @@ error:
     "RTP packets will be discarded if they are too far behind (i.e. in the " \
     "past) by this many packets from the last received packet." )
 
+#define RTP_BATCH_TEXT N_("RTP packets per system call")
+#define RTP_BATCH_LONGTEXT N_( \
+    "Maximum number of RTP packets received with a single system call " \
+    "into recycled buffers. 1 receives packets one at a time." )
+
+#define RTP_TIMESTAMPS_TEXT N_("Use kernel reception timestamps")
+#define RTP_TIMESTAMPS_LONGTEXT N_( \
+    "Time packets as they were received by the operating system, rather " \
+    "than when they are processed. This keeps jitter estimates accurate " \
+    "when packets are received in batches." )
+
 /*
  * Module descriptor
  */
@@ -694,6 +714,10 @@ vlc_module_begin()
     add_integer("rtp-max-misorder", RTP_MAX_MISORDER_DEFAULT, RTP_MAX_MISORDER_TEXT,
                 RTP_MAX_MISORDER_LONGTEXT)
         change_integer_range (0, 32767)
+    add_integer("rtp-batch", 1, RTP_BATCH_TEXT, RTP_BATCH_LONGTEXT)
+        change_integer_range (1, 64)
+    add_bool("rtp-timestamps", false, RTP_TIMESTAMPS_TEXT,
+             RTP_TIMESTAMPS_LONGTEXT)
     add_obsolete_string("rtp-dynamic-pt") /* since 4.0.0 */
 
     /*add_shortcut ("sctp")*/
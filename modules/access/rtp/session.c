@@ -238,7 +238,9 @@ rtp_queue (struct vlc_logger *logger, rtp_session_t *session, block_t *block)
         block->i_buffer -= padding;
     }
 
-    vlc_tick_t     now = vlc_tick_now ();
+    /* Use the kernel reception time if the socket provided it */
+    vlc_tick_t     now = (block->i_pts != VLC_TICK_INVALID) ? block->i_pts
+                                                            : vlc_tick_now ();
     rtp_source_t  *src  = NULL;
     const uint16_t seq  = rtp_seq (block);
     const uint32_t ssrc = GetDWBE (block->p_buffer + 8);
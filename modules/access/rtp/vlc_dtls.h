@@ -22,6 +22,7 @@
 # define VLC_DATAGRAM_SOCKET_H
 
 struct iovec;
+struct vlc_dgram_slab;
 
 /**
  * Datagram socket
@@ -37,6 +38,8 @@ struct vlc_dtls_operations {
     ssize_t (*readv)(struct vlc_dtls *, struct iovec *iov, unsigned len,
                      bool *restrict truncated);
     ssize_t (*writev)(struct vlc_dtls *, const struct iovec *iov, unsigned len);
+    /* Optional batched reception, see vlc_dgram_slab_Recv() */
+    block_t *(*recv_blocks)(struct vlc_dtls *, struct vlc_dgram_slab *);
 };
 
 static inline void vlc_dtls_Close(struct vlc_dtls *dgs)
@@ -57,6 +60,17 @@ static inline ssize_t vlc_dtls_Recv(struct vlc_dtls *dgs, void *buf, size_t len,
     return dgs->ops->readv(dgs, &iov, 1, truncated);
 }
 
+static inline bool vlc_dtls_CanRecvBlocks(const struct vlc_dtls *dgs)
+{
+    return dgs->ops->recv_blocks != NULL;
+}
+
+static inline block_t *vlc_dtls_RecvBlocks(struct vlc_dtls *dgs,
+                                           struct vlc_dgram_slab *slab)
+{
+    return dgs->ops->recv_blocks(dgs, slab);
+}
+
 static inline ssize_t vlc_dtls_Send(struct vlc_dtls *dgs, const void *buf,
                                    size_t len)
 {
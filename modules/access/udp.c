@@ -47,16 +47,23 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#include "dgram_slab.h"
 
 /* Buffer can be max theoretical datagram content minus anticipated MTU.
  * IPv6 headers are larger than IPv4, ignore IPv6 jumbograms.
  */
 #define MRU 65507u
 
+/* Receive buffers per batched socket */
+#define SLAB_SIZE 256
+
 typedef struct {
     int fd;
     int timeout;
 
+    struct vlc_dgram_slab *slab;
+    block_t *pending;
+
     size_t length;
     char *offset;
     char buf[MRU];
@@ -132,6 +139,43 @@ static ssize_t Read(stream_t *access, void *buf, size_t len)
     return val;
 }
 
+static block_t *BlockBatch(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (sys->pending == NULL) {
+        struct pollfd ufd[1];
+
+        ufd[0].fd = sys->fd;
+        ufd[0].events = POLLIN;
+
+        switch (vlc_poll_i11e(ufd, 1, sys->timeout)) {
+            case 0:
+                msg_Err(access, "receive time-out");
+                *eof = true;
+                /* fall through */
+            case -1:
+                return NULL;
+        }
+
+        sys->pending = vlc_dgram_slab_Recv(sys->slab, sys->fd);
+        if (sys->pending == NULL)
+            return NULL;
+    }
+
+    block_t *block = sys->pending;
+
+    sys->pending = block->p_next;
+    block->p_next = NULL;
+
+    if (block->i_buffer == 0) {
+        /* empty payload does *not* mean EOF here */
+        block_Release(block);
+        return NULL;
+    }
+    return block;
+}
+
 /*****************************************************************************
  * Open: open the socket
  *****************************************************************************/
@@ -217,6 +261,23 @@ static int Open( vlc_object_t *p_this )
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+    sys->slab = NULL;
+    sys->pending = NULL;
+
+    unsigned batch = var_InheritInteger( p_access, "udp-batch" );
+    if( batch > 1 )
+    {
+        if( batch > VLC_DGRAM_BATCH_MAX )
+            batch = VLC_DGRAM_BATCH_MAX;
+
+        sys->slab = vlc_dgram_slab_New( SLAB_SIZE, MRU, batch );
+        if( sys->slab != NULL )
+        {
+            p_access->pf_read = NULL;
+            p_access->pf_block = BlockBatch;
+        }
+    }
+
     return VLC_SUCCESS;
 }
 
@@ -228,10 +289,19 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t*)p_this;
     access_sys_t *sys = p_access->p_sys;
 
+    if( sys->slab != NULL )
+    {
+        block_ChainRelease( sys->pending );
+        vlc_dgram_slab_Release( sys->slab );
+    }
     net_Close( sys->fd );
 }
 
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
+#define BATCH_TEXT N_("Datagrams per system call")
+#define BATCH_LONGTEXT N_("Maximum number of datagrams received with a " \
+    "single system call into recycled buffers. 1 receives datagrams one " \
+    "at a time.")
 
 vlc_module_begin()
     set_shortname(N_("UDP"))
@@ -240,6 +310,8 @@ vlc_module_begin()
 
     add_obsolete_integer("udp-buffer") /* since 3.0.0 */
     add_integer("udp-timeout", -1, TIMEOUT_TEXT, NULL)
+    add_integer_with_range("udp-batch", 1, 1, VLC_DGRAM_BATCH_MAX,
+                           BATCH_TEXT, BATCH_LONGTEXT)
 
     set_capability("access", 0)
     add_shortcut("udp", "udpstream", "udp4", "udp6")
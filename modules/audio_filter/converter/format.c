@@ -38,6 +38,12 @@
 #include <vlc_aout.h>
 #include <vlc_block.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+#ifdef CAN_COMPILE_AVX2
+# include <immintrin.h>
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -83,6 +89,218 @@ static int Open(vlc_object_t *object)
 }
 
 
+/*
+ * SIMD kernels for the conversions between FL32 and S16N/S32N.
+ * They give the same results as the scalar code below, and return the
+ * number of samples converted; the caller finishes the tail.
+ */
+#ifdef CAN_COMPILE_AVX2
+VLC_AVX2
+static size_t AVX2_S16toFl32(float *dst, const int16_t *src, size_t count)
+{
+    const __m256i bias = _mm256_set1_epi32(0x43c00000);
+    const __m256 off = _mm256_set1_ps(384.f);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i v0 = _mm256_cvtepi16_epi32(
+            _mm_loadu_si128((const __m128i *)&src[i]));
+        __m256i v1 = _mm256_cvtepi16_epi32(
+            _mm_loadu_si128((const __m128i *)&src[i + 8]));
+
+        v0 = _mm256_add_epi32(v0, bias);
+        v1 = _mm256_add_epi32(v1, bias);
+        _mm256_storeu_ps(&dst[i], _mm256_sub_ps(_mm256_castsi256_ps(v0), off));
+        _mm256_storeu_ps(&dst[i + 8],
+                         _mm256_sub_ps(_mm256_castsi256_ps(v1), off));
+    }
+    return i;
+}
+
+/* In place: the stores never overtake the loads */
+VLC_AVX2
+static size_t AVX2_Fl32toS16(int16_t *dst, const float *src, size_t count)
+{
+    const __m256 off = _mm256_set1_ps(384.f);
+    const __m256i max = _mm256_set1_epi32(0x43c07fff);
+    const __m256i min = _mm256_set1_epi32(0x43bf8000);
+    const __m256i bias = _mm256_set1_epi32(0x43c00000);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i v0 = _mm256_castps_si256(
+            _mm256_add_ps(_mm256_loadu_ps(&src[i]), off));
+        __m256i v1 = _mm256_castps_si256(
+            _mm256_add_ps(_mm256_loadu_ps(&src[i + 8]), off));
+
+        v0 = _mm256_sub_epi32(_mm256_max_epi32(_mm256_min_epi32(v0, max), min),
+                              bias);
+        v1 = _mm256_sub_epi32(_mm256_max_epi32(_mm256_min_epi32(v1, max), min),
+                              bias);
+        v0 = _mm256_permute4x64_epi64(_mm256_packs_epi32(v0, v1),
+                                      _MM_SHUFFLE(3,1,2,0));
+        _mm256_storeu_si256((__m256i *)&dst[i], v0);
+    }
+    return i;
+}
+
+VLC_AVX2
+static size_t AVX2_Fl32toS32(int32_t *dst, const float *src, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(-((float)INT32_MIN));
+    const __m256 half = _mm256_set1_ps(.5f), mhalf = _mm256_set1_ps(-.5f);
+    const __m256 lo = _mm256_set1_ps((float)INT32_MIN);
+    const __m256i imax = _mm256_set1_epi32(INT32_MAX);
+    const __m256i imin = _mm256_set1_epi32(INT32_MIN);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 s = _mm256_mul_ps(_mm256_loadu_ps(&src[i]), scale);
+        /* lroundf(): truncate, then round half away from zero */
+        __m256i v = _mm256_cvttps_epi32(s);
+        __m256 frac = _mm256_sub_ps(s, _mm256_cvtepi32_ps(v));
+
+        v = _mm256_sub_epi32(v, _mm256_castps_si256(
+                _mm256_cmp_ps(frac, half, _CMP_GE_OQ)));
+        v = _mm256_add_epi32(v, _mm256_castps_si256(
+                _mm256_cmp_ps(frac, mhalf, _CMP_LE_OQ)));
+        v = _mm256_blendv_epi8(v, imax, _mm256_castps_si256(
+                _mm256_cmp_ps(s, scale, _CMP_GE_OQ)));
+        v = _mm256_blendv_epi8(v, imin, _mm256_castps_si256(
+                _mm256_cmp_ps(s, lo, _CMP_LE_OQ)));
+        _mm256_storeu_si256((__m256i *)&dst[i], v);
+    }
+    return i;
+}
+
+VLC_AVX2
+static size_t AVX2_S32toFl32(float *dst, const int32_t *src, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(1.f / -((float)INT32_MIN));
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)&src[i]);
+        _mm256_storeu_ps(&dst[i], _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    return i;
+}
+#endif
+
+#ifdef __SSE2__
+static size_t SSE2_S16toFl32(float *dst, const int16_t *src, size_t count)
+{
+    const __m128i bias = _mm_set1_epi32(0x43c00000);
+    const __m128 off = _mm_set1_ps(384.f);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)&src[i]);
+        __m128i v0 = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i v1 = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        v0 = _mm_add_epi32(v0, bias);
+        v1 = _mm_add_epi32(v1, bias);
+        _mm_storeu_ps(&dst[i], _mm_sub_ps(_mm_castsi128_ps(v0), off));
+        _mm_storeu_ps(&dst[i + 4], _mm_sub_ps(_mm_castsi128_ps(v1), off));
+    }
+    return i;
+}
+
+static inline __m128i SSE2_Clamp(__m128i v, __m128i min, __m128i max)
+{
+    __m128i gt = _mm_cmpgt_epi32(v, max);
+    v = _mm_or_si128(_mm_andnot_si128(gt, v), _mm_and_si128(gt, max));
+
+    __m128i lt = _mm_cmplt_epi32(v, min);
+    return _mm_or_si128(_mm_andnot_si128(lt, v), _mm_and_si128(lt, min));
+}
+
+static size_t SSE2_Fl32toS16(int16_t *dst, const float *src, size_t count)
+{
+    const __m128 off = _mm_set1_ps(384.f);
+    const __m128i max = _mm_set1_epi32(0x43c07fff);
+    const __m128i min = _mm_set1_epi32(0x43bf8000);
+    const __m128i bias = _mm_set1_epi32(0x43c00000);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v0 = _mm_castps_si128(_mm_add_ps(_mm_loadu_ps(&src[i]), off));
+        __m128i v1 = _mm_castps_si128(_mm_add_ps(_mm_loadu_ps(&src[i + 4]),
+                                                 off));
+
+        v0 = _mm_sub_epi32(SSE2_Clamp(v0, min, max), bias);
+        v1 = _mm_sub_epi32(SSE2_Clamp(v1, min, max), bias);
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packs_epi32(v0, v1));
+    }
+    return i;
+}
+
+static size_t SSE2_Fl32toS32(int32_t *dst, const float *src, size_t count)
+{
+    const __m128 scale = _mm_set1_ps(-((float)INT32_MIN));
+    const __m128 half = _mm_set1_ps(.5f), mhalf = _mm_set1_ps(-.5f);
+    const __m128 lo = _mm_set1_ps((float)INT32_MIN);
+    const __m128i imax = _mm_set1_epi32(INT32_MAX);
+    const __m128i imin = _mm_set1_epi32(INT32_MIN);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 s = _mm_mul_ps(_mm_loadu_ps(&src[i]), scale);
+        /* lroundf(): truncate, then round half away from zero */
+        __m128i v = _mm_cvttps_epi32(s);
+        __m128 frac = _mm_sub_ps(s, _mm_cvtepi32_ps(v));
+
+        v = _mm_sub_epi32(v, _mm_castps_si128(_mm_cmpge_ps(frac, half)));
+        v = _mm_add_epi32(v, _mm_castps_si128(_mm_cmple_ps(frac, mhalf)));
+
+        __m128i over = _mm_castps_si128(_mm_cmpge_ps(s, scale));
+        v = _mm_or_si128(_mm_andnot_si128(over, v), _mm_and_si128(over, imax));
+
+        __m128i under = _mm_castps_si128(_mm_cmple_ps(s, lo));
+        v = _mm_or_si128(_mm_andnot_si128(under, v),
+                         _mm_and_si128(under, imin));
+        _mm_storeu_si128((__m128i *)&dst[i], v);
+    }
+    return i;
+}
+
+static size_t SSE2_S32toFl32(float *dst, const int32_t *src, size_t count)
+{
+    const __m128 scale = _mm_set1_ps(1.f / -((float)INT32_MIN));
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)&src[i]);
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+    return i;
+}
+#endif
+
+#if defined(CAN_COMPILE_AVX2) && defined(__SSE2__)
+# define VECTOR_CONVERT(name, dst, src, count) \
+    (vlc_CPU_AVX2() ? AVX2_##name(dst, src, count) \
+                    : SSE2_##name(dst, src, count))
+#elif defined(CAN_COMPILE_AVX2)
+# define VECTOR_CONVERT(name, dst, src, count) \
+    (vlc_CPU_AVX2() ? AVX2_##name(dst, src, count) : 0)
+#elif defined(__SSE2__)
+# define VECTOR_CONVERT(name, dst, src, count) \
+    SSE2_##name(dst, src, count)
+#else
+# define VECTOR_CONVERT(name, dst, src, count) ((void)(dst), (size_t)0)
+#endif
+
+
 /*** from U8 ***/
 static block_t *U8toS16(filter_t *filter, block_t *bsrc)
 {
@@ -175,7 +393,11 @@ static block_t *S16toFl32(filter_t *filter, block_t *bsrc)
     block_CopyProperties(bdst, bsrc);
     int16_t *src = (int16_t *)bsrc->p_buffer;
     float   *dst = (float *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 2; i--;)
+    size_t count = bsrc->i_buffer / 2;
+    size_t done = VECTOR_CONVERT(S16toFl32, dst, src, count);
+    src += done;
+    dst += done;
+    for (size_t i = count - done; i--;)
 #if 0
         /* Slow version */
         *dst++ = (float)*src++ / 32768.f;
@@ -255,7 +477,11 @@ static block_t *Fl32toS16(filter_t *filter, block_t *b)
     VLC_UNUSED(filter);
     float   *src = (float *)b->p_buffer;
     int16_t *dst = (int16_t *)src;
-    for (int i = b->i_buffer / 4; i--;) {
+    size_t count = b->i_buffer / 4;
+    size_t done = VECTOR_CONVERT(Fl32toS16, dst, src, count);
+    src += done;
+    dst += done;
+    for (size_t i = count - done; i--;) {
 #if 0
         /* Slow version. */
         if (*src >= 1.0) *dst = 32767;
@@ -282,7 +508,11 @@ static block_t *Fl32toS32(filter_t *filter, block_t *b)
 {
     float   *src = (float *)b->p_buffer;
     int32_t *dst = (int32_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
+    size_t count = b->i_buffer / 4;
+    size_t done = VECTOR_CONVERT(Fl32toS32, dst, src, count);
+    src += done;
+    dst += done;
+    for (size_t i = count - done; i--;)
     {
         float s = *(src++) * -((float)INT32_MIN);
         if (s >= ((float)INT32_MAX))
@@ -345,7 +575,11 @@ static block_t *S32toFl32(filter_t *filter, block_t *b)
     VLC_UNUSED(filter);
     int32_t *src = (int32_t*)b->p_buffer;
     float   *dst = (float *)src;
-    for (int i = b->i_buffer / 4; i--;)
+    size_t count = b->i_buffer / 4;
+    size_t done = VECTOR_CONVERT(S32toFl32, dst, src, count);
+    src += done;
+    dst += done;
+    for (size_t i = count - done; i--;)
         *dst++ = (float)(*src++) / -((float)INT32_MIN);
     return b;
 }
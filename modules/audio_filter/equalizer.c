@@ -40,7 +40,6 @@
 #include "equalizer_presets.h"
 
 /* TODO:
- *  - optimize a bit (you can hardly do slower ;)
  *  - add tables for more bands (15 and 32 would be cool), maybe with auto coeffs
  *    computation (not too hard once the Q is found).
  *  - support for external preset
@@ -99,30 +98,54 @@ vlc_module_end ()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+
+/* The bands are independent of each other: they are filtered EQZ_LANES at a
+ * time, with the coefficients and the states stored band-wise in vectors.
+ * Padding lanes have null coefficients and gain. */
+#if defined __has_attribute
+#  if __has_attribute(__vector_size__)
+#    define EQZ_LANES 4
+typedef float eqz_vec_t __attribute__((__vector_size__(16)));
+#  endif
+#endif
+#ifndef EQZ_LANES
+#  define EQZ_LANES 1
+typedef float eqz_vec_t;
+#endif
+#define EQZ_VECS ((EQZ_BANDS_MAX + EQZ_LANES - 1) / EQZ_LANES)
+
+typedef union
+{
+    eqz_vec_t v;
+    float f[EQZ_LANES];
+} eqz_lanes_t;
+
 typedef struct
 {
     /* Filter static config */
     int i_band;
-    float *f_alpha;
-    float *f_beta;
-    float *f_gamma;
+    eqz_lanes_t alpha[EQZ_VECS];
+    eqz_lanes_t beta[EQZ_VECS];
+    eqz_lanes_t gamma[EQZ_VECS];
 
     /* Filter dyn config */
-    float *f_amp;   /* Per band amp */
+    eqz_lanes_t amp[EQZ_VECS];  /* Per band amp */
     float f_gamp;   /* Global preamp */
     bool b_2eqz;
 
     /* Filter state */
     float x[32][2];
-    float y[32][128][2];
+    eqz_lanes_t y[32][2][EQZ_VECS];
 
     /* Second filter state */
     float x2[32][2];
-    float y2[32][128][2];
+    eqz_lanes_t y2[32][2][EQZ_VECS];
 
     vlc_mutex_t lock;
 } filter_sys_t;
 
+#define EQZ_BAND(lanes, i) ((lanes)[(i) / EQZ_LANES].f[(i) % EQZ_LANES])
+
 static block_t *DoWork( filter_t *, block_t * );
 
 #define EQZ_IN_FACTOR (0.25f)
@@ -149,14 +172,15 @@ static int Open( vlc_object_t *p_this )
     filter_t     *p_filter = (filter_t *)p_this;
 
     /* Allocate structure */
-    filter_sys_t *p_sys = p_filter->p_sys = malloc( sizeof( *p_sys ) );
+    filter_sys_t *p_sys = p_filter->p_sys =
+        aligned_alloc( _Alignof( filter_sys_t ), sizeof( *p_sys ) );
     if( !p_sys )
         return VLC_ENOMEM;
 
     vlc_mutex_init( &p_sys->lock );
     if( EqzInit( p_filter, p_filter->fmt_in.audio.i_rate ) != VLC_SUCCESS )
     {
-        free( p_sys );
+        aligned_free( p_sys );
         return VLC_EGENERIC;
     }
 
@@ -180,7 +204,7 @@ static void Close( filter_t *p_filter )
     filter_sys_t *p_sys = p_filter->p_sys;
 
     EqzClean( p_filter );
-    free( p_sys );
+    aligned_free( p_sys );
 }
 
 /*****************************************************************************
@@ -280,57 +304,35 @@ static int EqzInit( filter_t *p_filter, int i_rate )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     eqz_config_t cfg;
-    int i, ch;
+    int i;
     vlc_value_t val1, val2, val3;
     vlc_object_t *p_aout = vlc_object_parent(p_filter);
-    int i_ret = VLC_ENOMEM;
 
     bool b_vlcFreqs = var_InheritBool( p_aout, "equalizer-vlcfreqs" );
     EqzCoeffs( i_rate, 1.0f, b_vlcFreqs, &cfg );
 
-    /* Create the static filter config */
+    /* Create the static filter config, the padding lanes stay null */
+    memset( p_sys->alpha, 0, sizeof( p_sys->alpha ) );
+    memset( p_sys->beta, 0, sizeof( p_sys->beta ) );
+    memset( p_sys->gamma, 0, sizeof( p_sys->gamma ) );
     p_sys->i_band = cfg.i_band;
-    p_sys->f_alpha = vlc_alloc( p_sys->i_band, sizeof(float) );
-    p_sys->f_beta  = vlc_alloc( p_sys->i_band, sizeof(float) );
-    p_sys->f_gamma = vlc_alloc( p_sys->i_band, sizeof(float) );
-    if( !p_sys->f_alpha || !p_sys->f_beta || !p_sys->f_gamma )
-        goto error;
-
     for( i = 0; i < p_sys->i_band; i++ )
     {
-        p_sys->f_alpha[i] = cfg.band[i].f_alpha;
-        p_sys->f_beta[i]  = cfg.band[i].f_beta;
-        p_sys->f_gamma[i] = cfg.band[i].f_gamma;
+        EQZ_BAND( p_sys->alpha, i ) = cfg.band[i].f_alpha;
+        EQZ_BAND( p_sys->beta, i )  = cfg.band[i].f_beta;
+        EQZ_BAND( p_sys->gamma, i ) = cfg.band[i].f_gamma;
     }
 
     /* Filter dyn config */
     p_sys->b_2eqz = false;
     p_sys->f_gamp = 1.0f;
-    p_sys->f_amp  = vlc_alloc( p_sys->i_band, sizeof(float) );
-    if( !p_sys->f_amp )
-        goto error;
-
-    for( i = 0; i < p_sys->i_band; i++ )
-    {
-        p_sys->f_amp[i] = 0.0f;
-    }
+    memset( p_sys->amp, 0, sizeof( p_sys->amp ) );
 
     /* Filter state */
-    for( ch = 0; ch < 32; ch++ )
-    {
-        p_sys->x[ch][0]  =
-        p_sys->x[ch][1]  =
-        p_sys->x2[ch][0] =
-        p_sys->x2[ch][1] = 0.0f;
-
-        for( i = 0; i < p_sys->i_band; i++ )
-        {
-            p_sys->y[ch][i][0]  =
-            p_sys->y[ch][i][1]  =
-            p_sys->y2[ch][i][0] =
-            p_sys->y2[ch][i][1] = 0.0f;
-        }
-    }
+    memset( p_sys->x, 0, sizeof( p_sys->x ) );
+    memset( p_sys->y, 0, sizeof( p_sys->y ) );
+    memset( p_sys->x2, 0, sizeof( p_sys->x2 ) );
+    memset( p_sys->y2, 0, sizeof( p_sys->y2 ) );
 
     var_Create( p_aout, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
     var_Create( p_aout, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
@@ -356,9 +358,7 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     {
         msg_Err(p_filter, "No preset selected");
         free( val2.psz_string );
-        free( p_sys->f_amp );
-        i_ret = VLC_EGENERIC;
-        goto error;
+        return VLC_EGENERIC;
     }
     free( val2.psz_string );
 
@@ -373,77 +373,129 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     for( i = 0; i < p_sys->i_band; i++ )
     {
         msg_Dbg( p_filter, "   %.2f Hz -> factor:%f alpha:%f beta:%f gamma:%f",
-                 cfg.band[i].f_frequency, p_sys->f_amp[i],
-                 p_sys->f_alpha[i], p_sys->f_beta[i], p_sys->f_gamma[i]);
+                 cfg.band[i].f_frequency, EQZ_BAND( p_sys->amp, i ),
+                 cfg.band[i].f_alpha, cfg.band[i].f_beta,
+                 cfg.band[i].f_gamma );
     }
     return VLC_SUCCESS;
-
-error:
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
-    return i_ret;
 }
 
-static void EqzFilter( filter_t *p_filter, float *out, float *in,
-                       int i_samples, int i_channels )
+/* Filters one channel of a buffer; the state is kept in locals meanwhile */
+static void EqzChannel( const filter_sys_t *p_sys, float *out,
+                        const float *in, int i_samples, int i_channels,
+                        float xs[2], eqz_lanes_t ys[2][EQZ_VECS],
+                        float *xs2, eqz_lanes_t (*ys2)[EQZ_VECS] )
 {
-    filter_sys_t *p_sys = p_filter->p_sys;
-    int i, ch, j;
+    eqz_vec_t y0[EQZ_VECS], y1[EQZ_VECS], y20[EQZ_VECS], y21[EQZ_VECS];
+    float x0 = xs[0], x1 = xs[1], x20 = 0.f, x21 = 0.f;
+    const float f_gamp = p_sys->f_gamp;
 
-    vlc_mutex_lock( &p_sys->lock );
-    for( i = 0; i < i_samples; i++ )
+    for( int j = 0; j < EQZ_VECS; j++ )
+    {
+        y0[j] = ys[0][j].v;
+        y1[j] = ys[1][j].v;
+    }
+    if( xs2 != NULL )
     {
-        for( ch = 0; ch < i_channels; ch++ )
+        x20 = xs2[0];
+        x21 = xs2[1];
+        for( int j = 0; j < EQZ_VECS; j++ )
         {
-            const float x = in[ch];
-            float o = 0.0f;
+            y20[j] = ys2[0][j].v;
+            y21[j] = ys2[1][j].v;
+        }
+    }
 
-            for( j = 0; j < p_sys->i_band; j++ )
-            {
-                float y = p_sys->f_alpha[j] * ( x - p_sys->x[ch][1] ) +
-                          p_sys->f_gamma[j] * p_sys->y[ch][j][0] -
-                          p_sys->f_beta[j]  * p_sys->y[ch][j][1];
+    for( int i = 0; i < i_samples; i++ )
+    {
+        const float x = in[i * i_channels];
+        eqz_lanes_t o = { .v = { 0 } };
 
-                p_sys->y[ch][j][1] = p_sys->y[ch][j][0];
-                p_sys->y[ch][j][0] = y;
+        for( int j = 0; j < EQZ_VECS; j++ )
+        {
+            eqz_vec_t y = p_sys->alpha[j].v * ( x - x1 ) +
+                          p_sys->gamma[j].v * y0[j] -
+                          p_sys->beta[j].v  * y1[j];
 
-                o += y * p_sys->f_amp[j];
-            }
-            p_sys->x[ch][1] = p_sys->x[ch][0];
-            p_sys->x[ch][0] = x;
+            y1[j] = y0[j];
+            y0[j] = y;
+            o.v += y * p_sys->amp[j].v;
+        }
+        x1 = x0;
+        x0 = x;
 
-            /* Second filter */
-            if( p_sys->b_2eqz )
-            {
-                const float x2 = EQZ_IN_FACTOR * x + o;
-                o = 0.0f;
-                for( j = 0; j < p_sys->i_band; j++ )
-                {
-                    float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[ch][1] ) +
-                              p_sys->f_gamma[j] * p_sys->y2[ch][j][0] -
-                              p_sys->f_beta[j]  * p_sys->y2[ch][j][1];
-
-                    p_sys->y2[ch][j][1] = p_sys->y2[ch][j][0];
-                    p_sys->y2[ch][j][0] = y;
-
-                    o += y * p_sys->f_amp[j];
-                }
-                p_sys->x2[ch][1] = p_sys->x2[ch][0];
-                p_sys->x2[ch][0] = x2;
-
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * x2 + o );
-            }
-            else
+        float f_o = 0.f;
+        for( int k = 0; k < EQZ_LANES; k++ )
+            f_o += o.f[k];
+
+        /* Second filter */
+        if( xs2 != NULL )
+        {
+            const float x2 = EQZ_IN_FACTOR * x + f_o;
+
+            o.v = (eqz_vec_t){ 0 };
+            for( int j = 0; j < EQZ_VECS; j++ )
             {
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * x + o );
+                eqz_vec_t y = p_sys->alpha[j].v * ( x2 - x21 ) +
+                              p_sys->gamma[j].v * y20[j] -
+                              p_sys->beta[j].v  * y21[j];
+
+                y21[j] = y20[j];
+                y20[j] = y;
+                o.v += y * p_sys->amp[j].v;
             }
+            x21 = x20;
+            x20 = x2;
+
+            f_o = 0.f;
+            for( int k = 0; k < EQZ_LANES; k++ )
+                f_o += o.f[k];
+
+            /* We add source PCM + filtered PCM */
+            out[i * i_channels] = f_gamp * f_gamp *( EQZ_IN_FACTOR * x2 + f_o );
         }
+        else
+        {
+            /* We add source PCM + filtered PCM */
+            out[i * i_channels] = f_gamp *( EQZ_IN_FACTOR * x + f_o );
+        }
+    }
 
-        in  += i_channels;
-        out += i_channels;
+    xs[0] = x0;
+    xs[1] = x1;
+    for( int j = 0; j < EQZ_VECS; j++ )
+    {
+        ys[0][j].v = y0[j];
+        ys[1][j].v = y1[j];
+    }
+    if( xs2 != NULL )
+    {
+        xs2[0] = x20;
+        xs2[1] = x21;
+        for( int j = 0; j < EQZ_VECS; j++ )
+        {
+            ys2[0][j].v = y20[j];
+            ys2[1][j].v = y21[j];
+        }
+    }
+}
+
+static void EqzFilter( filter_t *p_filter, float *out, float *in,
+                       int i_samples, int i_channels )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock );
+    /* The channels are filtered one after the other over the whole buffer */
+    for( int ch = 0; ch < i_channels; ch++ )
+    {
+        if( p_sys->b_2eqz )
+            EqzChannel( p_sys, &out[ch], &in[ch], i_samples, i_channels,
+                        p_sys->x[ch], p_sys->y[ch],
+                        p_sys->x2[ch], p_sys->y2[ch] );
+        else
+            EqzChannel( p_sys, &out[ch], &in[ch], i_samples, i_channels,
+                        p_sys->x[ch], p_sys->y[ch], NULL, NULL );
     }
     vlc_mutex_unlock( &p_sys->lock );
 }
@@ -457,12 +509,6 @@ static void EqzClean( filter_t *p_filter )
     var_DelCallback( p_aout, "equalizer-preset", PresetCallback, p_sys );
     var_DelCallback( p_aout, "equalizer-preamp", PreampCallback, p_sys );
     var_DelCallback( p_aout, "equalizer-2pass", TwoPassCallback, p_sys );
-
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
-
-    free( p_sys->f_amp );
 }
 
 
@@ -551,14 +597,15 @@ static int BandsCallback( vlc_object_t *p_this, char const *psz_cmd,
         if( next == p || isnan( f ) )
             break; /* no conversion */
 
-        p_sys->f_amp[i++] = EqzConvertdB( f );
+        EQZ_BAND( p_sys->amp, i ) = EqzConvertdB( f );
+        i++;
 
         if( *next == '\0' )
             break; /* end of line */
         p = &next[1];
     }
-    while( i < p_sys->i_band )
-        p_sys->f_amp[i++] = EqzConvertdB( 0.f );
+    for( ; i < p_sys->i_band; i++ )
+        EQZ_BAND( p_sys->amp, i ) = EqzConvertdB( 0.f );
     vlc_mutex_unlock( &p_sys->lock );
     return VLC_SUCCESS;
 }
@@ -29,6 +29,7 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
 #include <math.h>
 
 #include <vlc_common.h>
@@ -43,8 +44,6 @@ static int  Open ( vlc_object_t * );
 static void Close( filter_t * );
 static void CalcPeakEQCoeffs( float, float, float, float, float * );
 static void CalcShelfEQCoeffs( float, float, float, int, float, float * );
-static void ProcessEQ( const float *, float *, float *, unsigned, unsigned,
-                       const float *, unsigned );
 static block_t *DoWork( filter_t *, block_t * );
 
 vlc_module_begin ()
@@ -81,6 +80,32 @@ vlc_module_end ()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+
+/* The filters are cascaded, but the channels are independent: they are
+ * processed PEQ_LANES at a time, one per lane of a vector. */
+#if defined __has_attribute
+#  if __has_attribute(__vector_size__)
+#    define PEQ_LANES 4
+typedef float peq_vec_t __attribute__((__vector_size__(16)));
+#  endif
+#endif
+#ifndef PEQ_LANES
+#  define PEQ_LANES 1
+typedef float peq_vec_t;
+#endif
+
+typedef union
+{
+    peq_vec_t v;
+    float f[PEQ_LANES];
+} peq_lanes_t;
+
+#define PEQ_FILTERS 5
+#define PEQ_CHUNK   256 /* samples gathered at a time */
+
+static void ProcessEQ( const float *, float *, peq_lanes_t *, unsigned,
+                       unsigned, const float *, unsigned );
+
 typedef struct
 {
     /* Filter static config */
@@ -90,9 +115,9 @@ typedef struct
     float   f_f3, f_Q3, f_gain3;
     float   f_highf, f_highgain;
     /* Filter computed coeffs */
-    float   coeffs[5*5];
+    float   coeffs[5*PEQ_FILTERS];
     /* State */
-    float  *p_state;
+    peq_lanes_t *p_state;
 } filter_sys_t;
 
 
@@ -149,8 +174,17 @@ static int Open( vlc_object_t *p_this )
                       i_samplerate, p_sys->coeffs+3*5);
     CalcShelfEQCoeffs(p_sys->f_highf, 1, p_sys->f_highgain, 0,
                       i_samplerate, p_sys->coeffs+4*5);
-    p_sys->p_state = (float*)calloc( p_filter->fmt_in.audio.i_channels*5*4,
-                                     sizeof(float) );
+
+    /* 4 values per filter for each group of channels */
+    size_t i_state = ( p_filter->fmt_in.audio.i_channels + PEQ_LANES - 1 )
+                   / PEQ_LANES * PEQ_FILTERS * 4 * sizeof(peq_lanes_t);
+    p_sys->p_state = aligned_alloc( _Alignof(peq_lanes_t), i_state );
+    if( !p_sys->p_state )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    memset( p_sys->p_state, 0, i_state );
 
     return VLC_SUCCESS;
 }
@@ -158,7 +192,7 @@ static int Open( vlc_object_t *p_this )
 static void Close( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    free( p_sys->p_state );
+    aligned_free( p_sys->p_state );
     free( p_sys );
 }
 
@@ -173,7 +207,7 @@ static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
     ProcessEQ( (float*)p_in_buf->p_buffer, (float*)p_in_buf->p_buffer,
                p_sys->p_state,
                p_filter->fmt_in.audio.i_channels, p_in_buf->i_nb_samples,
-               p_sys->coeffs, 5 );
+               p_sys->coeffs, PEQ_FILTERS );
     return p_in_buf;
 }
 
@@ -281,45 +315,88 @@ static void CalcShelfEQCoeffs( float f0, float slope, float gainDB, int high,
 /*
   src is assumed to be interleaved
   dest is assumed to be interleaved
-  size of state is 4*channels*eqCount
+  size of state is 4*eqCount per group of PEQ_LANES channels
   samples is not premultiplied by channels
   size of coeffs is 5*eqCount
 */
-void ProcessEQ( const float *src, float *dest, float *state,
-                unsigned channels, unsigned samples, const float *coeffs,
-                unsigned eqCount )
+static void ProcessEQ( const float *src, float *dest, peq_lanes_t *state,
+                       unsigned channels, unsigned samples,
+                       const float *coeffs, unsigned eqCount )
 {
-    unsigned i, chn, eq;
-    float   b0, b1, b2, a1, a2;
-    float   x, y = 0;
-    const float *src1 = src;
-    float *dest1 = dest;
+    peq_vec_t cv[PEQ_FILTERS * 5];
+
+    assert(eqCount <= PEQ_FILTERS);
+    for (unsigned k = 0; k < eqCount * 5; k++)
+        cv[k] = (peq_vec_t){ 0 } + coeffs[k];
 
-    for (i = 0; i < samples; i++)
+    for (unsigned chn = 0; chn < channels; chn += PEQ_LANES)
     {
-        float *state1 = state;
-        for (chn = 0; chn < channels; chn++)
+        const unsigned lanes = __MIN(channels - chn, PEQ_LANES);
+        peq_vec_t st[PEQ_FILTERS][4];
+
+        /* The state stays in locals for the whole buffer */
+        for (unsigned eq = 0; eq < eqCount; eq++)
+            for (unsigned k = 0; k < 4; k++)
+                st[eq][k] = state[eq * 4 + k].v;
+
+        for (unsigned base = 0; base < samples; base += PEQ_CHUNK)
         {
-            const float *coeffs1 = coeffs;
-            x = *src1++;
-            /* Direct form 1 IIRs */
-            for (eq = 0; eq < eqCount; eq++)
+            const unsigned count = __MIN(samples - base, PEQ_CHUNK);
+            peq_lanes_t buf[PEQ_CHUNK];
+
+            /* Gather the channels of the group into vectors, in advance
+             * rather than sample per sample in the chain of the filters */
+            for (unsigned i = 0; i < count; i++)
+            {
+                const float *in = &src[(base + i) * channels + chn];
+                unsigned k = 0;
+
+                for (; k < lanes; k++)
+                    buf[i].f[k] = in[k];
+                for (; k < PEQ_LANES; k++)
+                    buf[i].f[k] = 0.f;
+            }
+
+            for (unsigned i = 0; i < count; i++)
+            {
+                const peq_vec_t *coeffs1 = cv;
+                peq_vec_t x = buf[i].v;
+
+                /* Direct form 1 IIRs */
+                for (unsigned eq = 0; eq < eqCount; eq++)
+                {
+                    const peq_vec_t b0 = coeffs1[0];
+                    const peq_vec_t b1 = coeffs1[1];
+                    const peq_vec_t b2 = coeffs1[2];
+                    const peq_vec_t a1 = coeffs1[3];
+                    const peq_vec_t a2 = coeffs1[4];
+                    coeffs1 += 5;
+
+                    /* The input comes last: it is the end of the chain of
+                     * dependencies through the cascade */
+                    peq_vec_t y = st[eq][0]*b1 + st[eq][1]*b2
+                                - st[eq][2]*a1 - st[eq][3]*a2 + x*b0;
+                    st[eq][1] = st[eq][0];
+                    st[eq][0] = x;
+                    st[eq][3] = st[eq][2];
+                    st[eq][2] = y;
+                    x = y;
+                }
+                buf[i].v = x;
+            }
+
+            for (unsigned i = 0; i < count; i++)
             {
-                b0 = coeffs1[0];
-                b1 = coeffs1[1];
-                b2 = coeffs1[2];
-                a1 = coeffs1[3];
-                a2 = coeffs1[4];
-                coeffs1 += 5;
-                y = x*b0 + state1[0]*b1 + state1[1]*b2 - state1[2]*a1 - state1[3]*a2;
-                state1[1] = state1[0];
-                state1[0] = x;
-                state1[3] = state1[2];
-                state1[2] = y;
-                x = y;
-                state1 += 4;
+                float *out = &dest[(base + i) * channels + chn];
+
+                for (unsigned k = 0; k < lanes; k++)
+                    out[k] = buf[i].f[k];
             }
-            *dest1++ = y;
         }
+
+        for (unsigned eq = 0; eq < eqCount; eq++)
+            for (unsigned k = 0; k < 4; k++)
+                state[eq * 4 + k].v = st[eq][k];
+        state += eqCount * 4;
     }
 }
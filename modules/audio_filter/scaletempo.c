@@ -32,10 +32,17 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 #include <vlc_modules.h>
+#include <vlc_cpu.h>
 
+#include <math.h>
 #include <stdatomic.h>
 #include <string.h> /* for memset */
 #include <limits.h> /* form INT_MIN */
+#ifdef CAN_COMPILE_AVX2
+# include <immintrin.h>
+#elif defined(__SSE__)
+# include <xmmintrin.h>
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -88,6 +95,10 @@ vlc_module_end ()
  * for the best overlap position.  Scaletempo uses a statistical cross correlation
  * (roughly a dot-product).  Scaletempo consumes most of its CPU cycles here.
  *
+ * The correlation is computed with one SIMD dot-product per search position,
+ * or, when the search window is large enough for it to be cheaper, for all
+ * the positions at once with a FFT.
+ *
  * NOTE:
  * sample: a single audio sample for one channel
  * frame: a single set of samples, one for each channel
@@ -128,6 +139,14 @@ typedef struct
     void     *buf_pre_corr;
     void     *table_window;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
+    float   (*dot_product)( const float *, const float *, unsigned );
+    /* FFT cross correlation */
+    unsigned  fft_size;
+    float    *fft_re;
+    float    *fft_im;
+    float    *fft_cos;  /* twiddle factors, stage by stage */
+    float    *fft_sin;
+    unsigned *fft_rev;  /* bit reversal permutation */
 #ifdef PITCH_SHIFTER
     /* pitch */
     filter_t * resampler;
@@ -135,6 +154,87 @@ typedef struct
 #endif
 } filter_sys_t;
 
+/*****************************************************************************
+ * dot_product: correlation of the overlap with one search position
+ *****************************************************************************/
+static float dot_product_c( const float *a, const float *b, unsigned n )
+{
+    float sum = 0;
+    for( unsigned i = 0; i < n; i++ )
+        sum += a[i] * b[i];
+    return sum;
+}
+
+#ifdef CAN_COMPILE_AVX2
+VLC_AVX2
+static float dot_product_avx2( const float *a, const float *b, unsigned n )
+{
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+    __m256 s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+    unsigned i = 0;
+
+    /* Independent sums, to hide the latency of the additions */
+    for( ; i + 32 <= n; i += 32 )
+    {
+        s0 = _mm256_add_ps( s0, _mm256_mul_ps( _mm256_loadu_ps( a + i ),
+                                               _mm256_loadu_ps( b + i ) ) );
+        s1 = _mm256_add_ps( s1, _mm256_mul_ps( _mm256_loadu_ps( a + i + 8 ),
+                                               _mm256_loadu_ps( b + i + 8 ) ) );
+        s2 = _mm256_add_ps( s2, _mm256_mul_ps( _mm256_loadu_ps( a + i + 16 ),
+                                               _mm256_loadu_ps( b + i + 16 ) ) );
+        s3 = _mm256_add_ps( s3, _mm256_mul_ps( _mm256_loadu_ps( a + i + 24 ),
+                                               _mm256_loadu_ps( b + i + 24 ) ) );
+    }
+    for( ; i + 8 <= n; i += 8 )
+        s0 = _mm256_add_ps( s0, _mm256_mul_ps( _mm256_loadu_ps( a + i ),
+                                               _mm256_loadu_ps( b + i ) ) );
+
+    s0 = _mm256_add_ps( _mm256_add_ps( s0, s1 ), _mm256_add_ps( s2, s3 ) );
+    __m128 s = _mm_add_ps( _mm256_castps256_ps128( s0 ),
+                           _mm256_extractf128_ps( s0, 1 ) );
+    s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+    s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+
+    float sum = _mm_cvtss_f32( s );
+    for( ; i < n; i++ )
+        sum += a[i] * b[i];
+    return sum;
+}
+#endif
+
+#ifdef __SSE__
+static float dot_product_sse( const float *a, const float *b, unsigned n )
+{
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    __m128 s2 = _mm_setzero_ps(), s3 = _mm_setzero_ps();
+    unsigned i = 0;
+
+    for( ; i + 16 <= n; i += 16 )
+    {
+        s0 = _mm_add_ps( s0, _mm_mul_ps( _mm_loadu_ps( a + i ),
+                                         _mm_loadu_ps( b + i ) ) );
+        s1 = _mm_add_ps( s1, _mm_mul_ps( _mm_loadu_ps( a + i + 4 ),
+                                         _mm_loadu_ps( b + i + 4 ) ) );
+        s2 = _mm_add_ps( s2, _mm_mul_ps( _mm_loadu_ps( a + i + 8 ),
+                                         _mm_loadu_ps( b + i + 8 ) ) );
+        s3 = _mm_add_ps( s3, _mm_mul_ps( _mm_loadu_ps( a + i + 12 ),
+                                         _mm_loadu_ps( b + i + 12 ) ) );
+    }
+    for( ; i + 4 <= n; i += 4 )
+        s0 = _mm_add_ps( s0, _mm_mul_ps( _mm_loadu_ps( a + i ),
+                                         _mm_loadu_ps( b + i ) ) );
+
+    s0 = _mm_add_ps( _mm_add_ps( s0, s1 ), _mm_add_ps( s2, s3 ) );
+    s0 = _mm_add_ps( s0, _mm_movehl_ps( s0, s0 ) );
+    s0 = _mm_add_ss( s0, _mm_shuffle_ps( s0, s0, 1 ) );
+
+    float sum = _mm_cvtss_f32( s0 );
+    for( ; i < n; i++ )
+        sum += a[i] * b[i];
+    return sum;
+}
+#endif
+
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
@@ -145,23 +245,19 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     float best_corr = INT_MIN;
     unsigned best_off = 0;
     unsigned i, off;
+    const unsigned samples_corr = p->samples_overlap - p->samples_per_frame;
 
     pw  = p->table_window;
     po  = p->buf_overlap;
     po += p->samples_per_frame;
     ppc = p->buf_pre_corr;
-    for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-      *ppc++ = *pw++ * *po++;
+    for( i = 0; i < samples_corr; i++ ) {
+      ppc[i] = pw[i] * po[i];
     }
 
     search_start = (float *)p->buf_queue + p->samples_per_frame;
     for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
+      float corr = p->dot_product( ppc, search_start, samples_corr );
       if( corr > best_corr ) {
         best_corr = corr;
         best_off  = off;
@@ -172,6 +268,149 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     return best_off * p->bytes_per_frame;
 }
 
+/*****************************************************************************
+ * fft_transform: in-place radix-2 FFT of a split complex buffer
+ *****************************************************************************/
+static void fft_transform( const filter_sys_t *p, float *re, float *im )
+{
+    const unsigned n = p->fft_size;
+
+    for( unsigned i = 0; i < n; i++ ) {
+        unsigned j = p->fft_rev[i];
+        if( i < j ) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for( unsigned half = 1; half < n; half *= 2 ) {
+        const float *wr = p->fft_cos + half - 1;
+        const float *wi = p->fft_sin + half - 1;
+
+        for( unsigned i = 0; i < n; i += 2 * half ) {
+            float *re0 = re + i, *im0 = im + i;
+            float *re1 = re0 + half, *im1 = im0 + half;
+
+            for( unsigned k = 0; k < half; k++ ) {
+                float tr = re1[k] * wr[k] - im1[k] * wi[k];
+                float ti = re1[k] * wi[k] + im1[k] * wr[k];
+                re1[k] = re0[k] - tr;
+                im1[k] = im0[k] - ti;
+                re0[k] += tr;
+                im0[k] += ti;
+            }
+        }
+    }
+}
+
+/*****************************************************************************
+ * best_overlap_offset_fft: correlate all the search positions at once
+ *****************************************************************************/
+static unsigned best_overlap_offset_fft( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    const unsigned n = p->fft_size;
+    const unsigned samples_corr = p->samples_overlap - p->samples_per_frame;
+    const unsigned samples_search =
+        ( p->frames_search - 1 ) * p->samples_per_frame + samples_corr;
+    const float *pw = p->table_window;
+    const float *po = (float *)p->buf_overlap + p->samples_per_frame;
+    float *re = p->fft_re, *im = p->fft_im;
+    float best_corr = INT_MIN;
+    unsigned best_off = 0;
+
+    /* Both real sequences are transformed at once: the windowed overlap
+     * as the real part, the search window as the imaginary part. They are
+     * separated afterwards by subtraction, so they must be of the same
+     * magnitude: the window is normalized. */
+    const float frames_overlap = p->samples_overlap / p->samples_per_frame;
+    const float norm = 4.f / ( frames_overlap * frames_overlap );
+
+    for( unsigned i = 0; i < samples_corr; i++ )
+        re[i] = norm * pw[i] * po[i];
+    memset( re + samples_corr, 0, ( n - samples_corr ) * sizeof (*re) );
+    memcpy( im, (float *)p->buf_queue + p->samples_per_frame,
+            samples_search * sizeof (*im) );
+    memset( im + samples_search, 0, ( n - samples_search ) * sizeof (*im) );
+
+    fft_transform( p, re, im );
+
+    /* Separate the two spectra, A and B, and compute the spectrum of the
+     * correlation conj(A).B. It is stored conjugated, so that the forward
+     * transform gives back the (real) correlation, scaled by 4n. */
+    for( unsigned k = 0; k <= n / 2; k++ ) {
+        unsigned nk = ( n - k ) & ( n - 1 );
+        float ar = re[k] + re[nk], ai = im[k] - im[nk];
+        float br = im[k] + im[nk], bi = re[nk] - re[k];
+        float cr = ar * br + ai * bi;
+        float ci = ar * bi - ai * br;
+
+        re[k]  = cr; im[k]  = -ci;
+        re[nk] = cr; im[nk] = ci;
+    }
+
+    fft_transform( p, re, im );
+
+    for( unsigned off = 0; off < p->frames_search; off++ ) {
+      float corr = re[off * p->samples_per_frame];
+      if( corr > best_corr ) {
+        best_corr = corr;
+        best_off  = off;
+      }
+    }
+
+    return best_off * p->bytes_per_frame;
+}
+
+/*****************************************************************************
+ * init_fft: prepare the FFT correlation if it is cheaper than the direct one
+ *****************************************************************************/
+/* Cost of the FFT per n.log2(n), in multiply-adds of the direct correlation */
+#define SCALETEMPO_FFT_COST 48
+
+static int init_fft( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    const unsigned samples_corr = p->samples_overlap - p->samples_per_frame;
+    const unsigned samples_search =
+        ( p->frames_search - 1 ) * p->samples_per_frame + samples_corr;
+    unsigned n = 1, log2n = 0;
+
+    while( n < samples_search ) {
+        n *= 2;
+        log2n++;
+    }
+
+    /* Two transforms against one dot-product per search position */
+    if( (uint64_t)p->frames_search * samples_corr
+        <= (uint64_t)SCALETEMPO_FFT_COST * n * log2n )
+        return VLC_SUCCESS;
+
+    p->fft_re  = vlc_alloc( n, sizeof (float) );
+    p->fft_im  = vlc_alloc( n, sizeof (float) );
+    p->fft_cos = vlc_alloc( n, sizeof (float) );
+    p->fft_sin = vlc_alloc( n, sizeof (float) );
+    p->fft_rev = vlc_alloc( n, sizeof (unsigned) );
+    if( !p->fft_re || !p->fft_im || !p->fft_cos || !p->fft_sin || !p->fft_rev )
+        return VLC_ENOMEM;
+
+    for( unsigned i = 0; i < n; i++ ) {
+        unsigned rev = 0;
+        for( unsigned b = 0; b < log2n; b++ )
+            rev |= ( ( i >> b ) & 1 ) << ( log2n - 1 - b );
+        p->fft_rev[i] = rev;
+    }
+    for( unsigned half = 1; half < n; half *= 2 )
+        for( unsigned k = 0; k < half; k++ ) {
+            p->fft_cos[half - 1 + k] = cos( M_PI * k / half );
+            p->fft_sin[half - 1 + k] = -sin( M_PI * k / half );
+        }
+
+    p->fft_size = n;
+    p->best_overlap_offset = best_overlap_offset_fft;
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * output_overlap: blend end of previous stride with beginning of current stride
  *****************************************************************************/
@@ -351,6 +590,8 @@ static int reinit_buffers( filter_t *p_filter )
                 *pw++ = v;
         }
         p->best_overlap_offset = best_overlap_offset_float;
+        if( init_fft( p_filter ) != VLC_SUCCESS )
+            return VLC_ENOMEM;
     }
 
     unsigned new_size = ( p->frames_search + frames_stride + frames_overlap ) * p->bytes_per_frame;
@@ -380,7 +621,7 @@ static int reinit_buffers( filter_t *p_filter )
     p->frames_stride_scaled = p->bytes_stride_scaled / p->bytes_per_frame;
 
     msg_Dbg( VLC_OBJECT(p_filter),
-             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search, %i queue, %s mode",
+             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search, %i queue, %s mode, %s correlation",
              p->scale,
              p->frames_stride_scaled,
              (int)( p->bytes_stride / p->bytes_per_frame ),
@@ -388,7 +629,8 @@ static int reinit_buffers( filter_t *p_filter )
              (int)( p->bytes_overlap / p->bytes_per_frame ),
              p->frames_search,
              (int)( p->bytes_queue_max / p->bytes_per_frame ),
-             "fl32");
+             "fl32",
+             p->best_overlap_offset == best_overlap_offset_fft ? "fft" : "direct");
 
     return VLC_SUCCESS;
 }
@@ -429,10 +671,23 @@ static int Open( vlc_object_t *p_this )
     p_sys->table_blend    = NULL;
     p_sys->buf_pre_corr   = NULL;
     p_sys->table_window   = NULL;
+    p_sys->fft_re         = NULL;
+    p_sys->fft_im         = NULL;
+    p_sys->fft_cos        = NULL;
+    p_sys->fft_sin        = NULL;
+    p_sys->fft_rev        = NULL;
     p_sys->bytes_overlap  = 0;
     p_sys->bytes_queued   = 0;
     p_sys->bytes_to_slide = 0;
     p_sys->frames_stride_error = 0;
+    p_sys->dot_product    = dot_product_c;
+#ifdef __SSE__
+    p_sys->dot_product    = dot_product_sse;
+#endif
+#ifdef CAN_COMPILE_AVX2
+    if( vlc_CPU_AVX2() )
+        p_sys->dot_product = dot_product_avx2;
+#endif
 
     if( reinit_buffers( p_filter ) != VLC_SUCCESS )
     {
@@ -531,6 +786,11 @@ static void Close( filter_t *p_filter )
     free( p_sys->table_blend );
     free( p_sys->buf_pre_corr );
     free( p_sys->table_window );
+    free( p_sys->fft_re );
+    free( p_sys->fft_im );
+    free( p_sys->fft_cos );
+    free( p_sys->fft_sin );
+    free( p_sys->fft_rev );
     free( p_sys );
 }
 
@@ -33,6 +33,12 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_aout_volume.h>
+#include <vlc_cpu.h>
+#ifdef CAN_COMPILE_AVX2
+# include <immintrin.h>
+#elif defined(__SSE__)
+# include <xmmintrin.h>
+#endif
 
 /*****************************************************************************
  * Local prototypes
@@ -49,6 +55,51 @@ vlc_module_begin ()
     set_callback( Create )
 vlc_module_end ()
 
+#ifdef CAN_COMPILE_AVX2
+VLC_AVX2
+static float *AVX2_Amplify( float *p, size_t count, float f_multiplier )
+{
+    const __m256 mult = _mm256_set1_ps( f_multiplier );
+
+    for( ; count >= 32; count -= 32, p += 32 )
+    {
+        __m256 v0 = _mm256_loadu_ps( p );
+        __m256 v1 = _mm256_loadu_ps( p + 8 );
+        __m256 v2 = _mm256_loadu_ps( p + 16 );
+        __m256 v3 = _mm256_loadu_ps( p + 24 );
+        _mm256_storeu_ps( p,      _mm256_mul_ps( v0, mult ) );
+        _mm256_storeu_ps( p + 8,  _mm256_mul_ps( v1, mult ) );
+        _mm256_storeu_ps( p + 16, _mm256_mul_ps( v2, mult ) );
+        _mm256_storeu_ps( p + 24, _mm256_mul_ps( v3, mult ) );
+    }
+    for( ; count >= 8; count -= 8, p += 8 )
+        _mm256_storeu_ps( p, _mm256_mul_ps( _mm256_loadu_ps( p ), mult ) );
+    return p;
+}
+#endif
+
+#ifdef __SSE__
+static float *SSE_Amplify( float *p, size_t count, float f_multiplier )
+{
+    const __m128 mult = _mm_set1_ps( f_multiplier );
+
+    for( ; count >= 16; count -= 16, p += 16 )
+    {
+        __m128 v0 = _mm_loadu_ps( p );
+        __m128 v1 = _mm_loadu_ps( p + 4 );
+        __m128 v2 = _mm_loadu_ps( p + 8 );
+        __m128 v3 = _mm_loadu_ps( p + 12 );
+        _mm_storeu_ps( p,      _mm_mul_ps( v0, mult ) );
+        _mm_storeu_ps( p + 4,  _mm_mul_ps( v1, mult ) );
+        _mm_storeu_ps( p + 8,  _mm_mul_ps( v2, mult ) );
+        _mm_storeu_ps( p + 12, _mm_mul_ps( v3, mult ) );
+    }
+    for( ; count >= 4; count -= 4, p += 4 )
+        _mm_storeu_ps( p, _mm_mul_ps( _mm_loadu_ps( p ), mult ) );
+    return p;
+}
+#endif
+
 /**
  * Mixes a new output buffer
  */
@@ -59,7 +110,18 @@ static void FilterFL32( audio_volume_t *p_volume, block_t *p_buffer,
         return; /* nothing to do */
 
     float *p = (float *)p_buffer->p_buffer;
-    for( size_t i = p_buffer->i_buffer / sizeof(*p); i > 0; i-- )
+    float *end = p + p_buffer->i_buffer / sizeof(*p);
+
+    /* The products are the same as the scalar ones, only the tail is left */
+#ifdef CAN_COMPILE_AVX2
+    if( vlc_CPU_AVX2() )
+        p = AVX2_Amplify( p, end - p, f_multiplier );
+#endif
+#ifdef __SSE__
+    p = SSE_Amplify( p, end - p, f_multiplier );
+#endif
+
+    while( p < end )
         *(p++) *= f_multiplier;
 
     (void) p_volume;
@@ -934,6 +934,14 @@ static int Statistics(struct cli_client *cl, const char *const *args,
                    item->p_stats->i_lost_abuffers);
         cli_printf(cl, "|");
 
+        /* Frames */
+        cli_printf(cl, "%s", _("+-[Frame Allocator]"));
+        cli_printf(cl, _("| frames allocated :    %5"PRIi64),
+                   item->p_stats->i_frame_allocs);
+        cli_printf(cl, _("| heap allocations :    %5"PRIi64),
+                   item->p_stats->i_frame_heap_allocs);
+        cli_printf(cl, "|");
+
         vlc_mutex_unlock(&item->lock);
         cli_printf(cl,  "+----[ end of statistical info ]" );
     }
@@ -24,6 +24,7 @@
 
 #include "SegmentTracker.hpp"
 #include "SharedResources.hpp"
+#include "http/HTTPConnectionManager.h"
 #include "playlist/BasePlaylist.hpp"
 #include "playlist/BaseRepresentation.h"
 #include "playlist/BaseAdaptationSet.h"
@@ -291,6 +292,18 @@ SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
             if(temp.isValid())
                 pos = temp;
         }
+
+        /* Resume at the live delay when running too late */
+        if(pos.init_sent && pos.index_sent)
+        {
+            const vlc_tick_t maxdelay = bufferingLogic->getMaxLiveDelay(pos.rep->getPlaylist());
+            if(maxdelay && pos.rep->getMinAheadTime(pos.number) > maxdelay)
+            {
+                uint64_t number = bufferingLogic->getStartSegmentNumber(pos.rep);
+                if(number != std::numeric_limits<uint64_t>::max() && number > pos.number)
+                    pos.number = number;
+            }
+        }
     }
 
     bool b_gap = true;
@@ -349,6 +362,11 @@ ChunkInterface * SegmentTracker::getNextChunk(bool switch_allowed)
     if(!adaptationSet || !next.isValid())
         return nullptr;
 
+    /* A prefetched chunk might switch representation */
+    if(!switch_allowed && !chunkssequence.empty() &&
+       chunkssequence.front().pos.rep != current.rep)
+        resetChunksSequence();
+
     if(chunkssequence.empty())
     {
         ChunkEntry chunk = prepareChunk(switch_allowed, next);
@@ -436,8 +454,20 @@ ChunkInterface * SegmentTracker::getNextChunk(bool switch_allowed)
                                chunk.starttime, chunk.duration, chunk.displaytime));
 
     if(!b_gap)
+    {
         ++next;
 
+        /* Request the next segment while this one is read */
+        if(chunkssequence.empty() && resources->getConnManager()->canPrefetch())
+        {
+            ChunkEntry ahead = prepareChunk(switch_allowed, next);
+            if(ahead.isValid())
+                chunkssequence.push_back(ahead);
+            else
+                delete ahead.chunk;
+        }
+    }
+
     return returnedChunk;
 }
 
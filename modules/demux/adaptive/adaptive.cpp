@@ -84,6 +84,11 @@ static void Close   (vlc_object_t *);
 #define ADAPT_LOWLATENCY_TEXT N_("Low latency")
 #define ADAPT_LOWLATENCY_LONGTEXT N_("Overrides low latency parameters")
 
+#define ADAPT_DOWNLOADS_TEXT N_("Concurrent segment downloads")
+#define ADAPT_DOWNLOADS_LONGTEXT N_("Maximum number of segments downloaded " \
+    "at the same time. With more than one, the next segment of each stream " \
+    "is requested ahead.")
+
 static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::LogicType::Default,
                                 AbstractAdaptationLogic::LogicType::Predictive,
@@ -143,6 +148,8 @@ vlc_module_begin ()
                      ADAPT_MAXBUFFER_TEXT, nullptr )
         add_integer( "adaptive-lowlatency", -1, ADAPT_LOWLATENCY_TEXT, ADAPT_LOWLATENCY_LONGTEXT )
             change_integer_list(rgi_latency, ppsz_latency)
+        add_integer_with_range( "adaptive-downloads", 1, 1, 8,
+                                ADAPT_DOWNLOADS_TEXT, ADAPT_DOWNLOADS_LONGTEXT )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
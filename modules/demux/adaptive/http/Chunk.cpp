@@ -277,6 +277,25 @@ void HTTPChunkSource::setIdentifier(const std::string &s, const BytesRange &r)
     storeid =  makeStorageID(s, r);
 }
 
+/* Playlists and keys hold the playback, and init or index segments a
+ * representation switch: they are sent ahead of the media data sharing
+ * the connection. */
+static unsigned getUrgency(ChunkType type)
+{
+    switch(type)
+    {
+        case ChunkType::Key:
+        case ChunkType::Playlist:
+            return DEFAULT_URGENCY - 2;
+        case ChunkType::Init:
+        case ChunkType::Index:
+            return DEFAULT_URGENCY - 1;
+        case ChunkType::Segment:
+        default:
+            return DEFAULT_URGENCY;
+    }
+}
+
 bool HTTPChunkSource::prepare()
 {
     if(prepared)
@@ -299,7 +318,8 @@ bool HTTPChunkSource::prepare()
                 break;
         }
 
-        requeststatus = connection->request(connparams.getPath(), bytesRange);
+        requeststatus = connection->request(connparams.getPath(), bytesRange,
+                                            getUrgency(type));
         if(requeststatus != RequestStatus::Success)
         {
             if(requeststatus == RequestStatus::Redirection)
@@ -336,7 +356,8 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     HTTPChunkSource(url, manager, sourceid, type, range, access),
     p_head     (nullptr),
     pp_tail    (&p_head),
-    buffered     (0)
+    buffered     (0),
+    downloadTime (0)
 {
     done = false;
     eof = false;
@@ -384,8 +405,12 @@ void HTTPChunkBufferedSource::release()
     avail.signal();
 }
 
-void HTTPChunkBufferedSource::bufferize(size_t readsize)
+void HTTPChunkBufferedSource::bufferize(size_t readsize, unsigned shares)
 {
+    /* With concurrent downloads, each one is only accounted for its share of
+     * the elapsed time, so that the rate estimates are of the whole link. */
+    const vlc_tick_t stepStartTime = vlc_tick_now();
+
     {
         mutex_locker locker {lock};
         if(!prepare())
@@ -403,6 +428,10 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
             readsize = contentLength - buffered;
     }
 
+    /* Segments still being produced are transferred chunked, without a
+     * length, and are made available as their chunks arrive */
+    const bool b_partial = !contentLength && type == ChunkType::Segment;
+
     block_t *p_block = block_Alloc(readsize);
     if(!p_block)
     {
@@ -417,7 +446,8 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         vlc_tick_t latency;
     } rate = {0,0,0};
 
-    ssize_t ret = connection->read(p_block->p_buffer, readsize);
+    ssize_t ret = b_partial ? connection->readPartial(p_block->p_buffer, readsize)
+                            : connection->read(p_block->p_buffer, readsize);
     if(ret <= 0)
     {
         block_Release(p_block);
@@ -425,14 +455,26 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         mutex_locker locker {lock};
         done = true;
         downloadEndTime = vlc_tick_now();
+        downloadTime += (downloadEndTime - stepStartTime) / shares;
         rate.size = buffered;
-        rate.time = downloadEndTime - requestStartTime;
+        rate.time = downloadTime;
         rate.latency = responseTime - requestStartTime;
         avail.signal();
     }
     else
     {
         p_block->i_buffer = (size_t) ret;
+        /* Don't keep a mostly empty buffer for each received chunk */
+        if((size_t) ret < readsize / 2)
+        {
+            block_t *p_fit = block_Alloc(ret);
+            if(p_fit)
+            {
+                memcpy(p_fit->p_buffer, p_block->p_buffer, ret);
+                block_Release(p_block);
+                p_block = p_fit;
+            }
+        }
         mutex_locker locker {lock};
         buffered += p_block->i_buffer;
         block_ChainLastAppend(&pp_tail, p_block);
@@ -441,12 +483,14 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
             p_read = p_block;
             inblockreadoffset = 0;
         }
-        if((size_t) ret < readsize)
+        downloadTime += (vlc_tick_now() - stepStartTime) / shares;
+        if((!b_partial && (size_t) ret < readsize) ||
+           (contentLength && buffered >= contentLength))
         {
             done = true;
             downloadEndTime = vlc_tick_now();
             rate.size = buffered;
-            rate.time = downloadEndTime - requestStartTime;
+            rate.time = downloadTime;
             rate.latency = responseTime - requestStartTime;
         }
         avail.signal();
@@ -171,7 +171,7 @@ namespace adaptive
                 HTTPChunkBufferedSource(const std::string &url, AbstractConnectionManager *,
                                         const ID &, ChunkType, const BytesRange &,
                                         bool = false);
-                void               bufferize(size_t);
+                void               bufferize(size_t, unsigned = 1);
                 bool               isDone() const;
                 void               hold();
                 void               release();
@@ -182,6 +182,7 @@ namespace adaptive
                 const block_t      *p_read;
                 size_t              inblockreadoffset;
                 size_t              buffered; /* read cache size */
+                vlc_tick_t          downloadTime; /* share of the concurrent downloads time */
                 bool                done;
                 bool                eof;
                 vlc::threads::condition_variable avail;
@@ -25,34 +25,39 @@
 
 #include <vlc_threads.h>
 
-#include <atomic>
+#include <algorithm>
 
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::Transfer::Transfer(HTTPChunkBufferedSource *source_)
+{
+    source = source_;
+    cancel = false;
+}
+
+Downloader::Downloader(unsigned maxtransfers_)
 {
     killed = false;
-    thread_handle_valid = false;
-    current = nullptr;
-    cancel_current = false;
+    maxtransfers = maxtransfers_ ? maxtransfers_ : 1;
 }
 
 bool Downloader::start()
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread, static_cast<void *>(this)))
+    while(threads.size() < maxtransfers)
     {
-        return false;
+        vlc_thread_t thread_handle;
+        if(vlc_clone(&thread_handle, downloaderThread, static_cast<void *>(this)))
+            break;
+        threads.push_back(thread_handle);
     }
-    thread_handle_valid = true;
-    return true;
+    return !threads.empty();
 }
 
 Downloader::~Downloader()
 {
     kill();
 
-    if(thread_handle_valid)
+    for(vlc_thread_t thread_handle : threads)
         vlc_join(thread_handle, nullptr);
 }
 
@@ -60,7 +65,7 @@ void Downloader::kill()
 {
     vlc::threads::mutex_locker locker {lock};
     killed = true;
-    wait_cond.signal();
+    wait_cond.broadcast();
 }
 
 void Downloader::schedule(HTTPChunkBufferedSource *source)
@@ -74,9 +79,13 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc::threads::mutex_locker locker {lock};
-    while (current == source)
+    for(;;)
     {
-        cancel_current = true;
+        auto it = std::find_if(transfers.begin(), transfers.end(),
+                               [source](const Transfer &t) { return t.source == source; });
+        if(it == transfers.end())
+            break;
+        it->cancel = true;
         updated_cond.wait(lock);
     }
 
@@ -95,33 +104,64 @@ void * Downloader::downloaderThread(void *opaque)
     return nullptr;
 }
 
-void Downloader::Run()
+/* Takes the oldest queued source of the stream with the fewest transfers,
+ * so that the prefetched segments of a stream do not delay the others. */
+std::list<Downloader::Transfer>::iterator Downloader::getNextTransfer()
 {
-    while(1)
+    auto next = chunks.end();
+    size_t nextcount = 0;
+
+    for(auto it = chunks.begin(); it != chunks.end(); ++it)
     {
-        lock.lock();
+        const ID &id = (*it)->sourceid;
+        size_t count = std::count_if(transfers.begin(), transfers.end(),
+                                     [&id](const Transfer &t) { return t.source->sourceid == id; });
+        if(next == chunks.end() || count < nextcount)
+        {
+            next = it;
+            nextcount = count;
+            if(count == 0)
+                break;
+        }
+    }
 
-        while(chunks.empty() && !killed)
-            wait_cond.wait(lock);
+    if(next == chunks.end())
+        return transfers.end();
+
+    HTTPChunkBufferedSource *source = *next;
+    chunks.erase(next);
+    return transfers.insert(transfers.end(), Transfer(source));
+}
 
-        if(killed)
+void Downloader::Run()
+{
+    lock.lock();
+    while(!killed)
+    {
+        auto transfer = getNextTransfer();
+        if(transfer == transfers.end())
         {
-            lock.unlock();
-            break;
+            wait_cond.wait(lock);
+            continue;
         }
 
-        current = chunks.front();
-        lock.unlock();
-        current->bufferize(HTTPChunkSource::CHUNK_SIZE);
-        lock.lock();
-        if(current->isDone() || cancel_current)
+        HTTPChunkBufferedSource *source = transfer->source;
+        do
         {
-            chunks.pop_front();
-            current->release();
-        }
-        cancel_current = false;
-        current = nullptr;
-        updated_cond.signal();
-        lock.unlock();
+            /* The bandwidth is shared with the other transfers */
+            const unsigned shares = transfers.size();
+            lock.unlock();
+            source->bufferize(HTTPChunkSource::CHUNK_SIZE, shares);
+            lock.lock();
+        } while(!source->isDone() && !transfer->cancel && !killed);
+
+        const bool cancelled = transfer->cancel;
+        transfers.erase(transfer);
+        if(source->isDone() || cancelled)
+            source->release();
+        else
+            chunks.push_front(source);
+        updated_cond.broadcast();
     }
+    lock.unlock();
 }
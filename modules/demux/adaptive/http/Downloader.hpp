@@ -26,6 +26,7 @@
 #include <vlc_threads.h>
 #include <vlc_cxx_helpers.hpp>
 #include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -36,25 +37,32 @@ namespace adaptive
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(unsigned = 1);
                 ~Downloader();
                 bool start();
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
 
             private:
+                class Transfer
+                {
+                    public:
+                        Transfer(HTTPChunkBufferedSource *);
+                        HTTPChunkBufferedSource *source;
+                        bool cancel;
+                };
                 static void * downloaderThread(void *);
                 void Run();
                 void kill();
-                vlc_thread_t thread_handle;
+                std::list<Transfer>::iterator getNextTransfer();
+                std::vector<vlc_thread_t> threads;
+                unsigned     maxtransfers;
                 vlc::threads::mutex lock;
                 vlc::threads::condition_variable wait_cond;
                 vlc::threads::condition_variable updated_cond;
-                bool         thread_handle_valid;
                 bool         killed;
-                bool         cancel_current;
                 std::list<HTTPChunkBufferedSource *> chunks;
-                HTTPChunkBufferedSource *current;
+                std::list<Transfer> transfers;
         };
 
     }
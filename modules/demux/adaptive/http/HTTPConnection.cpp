@@ -63,6 +63,11 @@ bool AbstractConnection::prepare(const ConnectionParams &params_)
     return true;
 }
 
+ssize_t AbstractConnection::readPartial(void *p_buffer, size_t len)
+{
+    return read(p_buffer, len);
+}
+
 size_t AbstractConnection::getContentLength() const
 {
     return contentLength;
@@ -88,17 +93,14 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
      friend class LibVLCHTTPConnection;
 
      public:
-        LibVLCHTTPSource(vlc_object_t *p_object, struct vlc_http_cookie_jar_t *jar)
+        LibVLCHTTPSource(struct vlc_http_mgr *mgr)
         {
-            http_mgr = vlc_http_mgr_create(p_object, jar);
+            http_mgr = mgr;
             http_res = nullptr;
             totalRead = 0;
+            urgency = DEFAULT_URGENCY;
         }
-        virtual ~LibVLCHTTPSource()
-        {
-            if(http_mgr)
-                vlc_http_mgr_destroy(http_mgr);
-        }
+        virtual ~LibVLCHTTPSource() = default;
         block_t *readNextBlock() override
         {
             if(http_res == nullptr)
@@ -132,6 +134,9 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
         {
             vlc_http_msg_add_header(req, "Accept-Encoding", "deflate, gzip");
             vlc_http_msg_add_header(req, "Cache-Control", "no-cache");
+            if(urgency != DEFAULT_URGENCY &&
+               vlc_http_msg_add_header(req, "Priority", "u=%u", urgency))
+                return -1;
             if(range.isValid())
             {
                 if(range.getEndByte() > 0)
@@ -187,11 +192,13 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
         size_t totalRead;
         struct vlc_http_mgr *http_mgr;
         BytesRange range;
+        unsigned urgency;
 
     public:
         struct vlc_http_resource *http_res;
         int create(const char *uri,const std::string &ua,
-                   const std::string &ref, const BytesRange &range)
+                   const std::string &ref, const BytesRange &range,
+                   unsigned urgency)
         {
             auto *tpl = static_cast<struct restuple *>(
                 std::malloc(sizeof(struct restuple)));
@@ -200,6 +207,7 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
 
             tpl->source = this;
             this->range = range;
+            this->urgency = urgency;
             if (vlc_http_res_init(&tpl->resource, &this->callbacks, http_mgr, uri,
                                   ua.empty() ? nullptr : ua.c_str(),
                                   ref.empty() ? nullptr : ref.c_str()))
@@ -239,10 +247,10 @@ const struct vlc_http_resource_cbs LibVLCHTTPSource::callbacks =
     LibVLCHTTPSource::validateresponse_handler,
 };
 
-LibVLCHTTPConnection::LibVLCHTTPConnection(vlc_object_t *p_object_, AuthStorage *auth)
+LibVLCHTTPConnection::LibVLCHTTPConnection(vlc_object_t *p_object_, struct vlc_http_mgr *mgr)
     : AbstractConnection( p_object_ )
 {
-    source = new adaptive::http::LibVLCHTTPSource(p_object_, auth->getJar());
+    source = new adaptive::http::LibVLCHTTPSource(mgr);
     sourceStream = new ChunksSourceStream(p_object, source);
     stream = nullptr;
     char *psz_useragent = var_InheritString(p_object_, "http-user-agent");
@@ -291,7 +299,8 @@ bool LibVLCHTTPConnection::canReuse(const ConnectionParams &params_) const
 }
 
 RequestStatus LibVLCHTTPConnection::request(const std::string &path,
-                                            const BytesRange &range)
+                                            const BytesRange &range,
+                                            unsigned urgency)
 {
     if(source->http_mgr == nullptr)
         return RequestStatus::GenericError;
@@ -307,7 +316,7 @@ RequestStatus LibVLCHTTPConnection::request(const std::string &path,
     else
         msg_Dbg(p_object, "Retrieving %s", params.getUrl().c_str());
 
-    if(source->create(params.getUrl().c_str(), useragent,referer, range))
+    if(source->create(params.getUrl().c_str(), useragent,referer, range, urgency))
         return RequestStatus::GenericError;
 
     struct vlc_credential crd;
@@ -424,6 +433,13 @@ ssize_t LibVLCHTTPConnection::read(void *p_buffer, size_t len)
     return read;
 }
 
+ssize_t LibVLCHTTPConnection::readPartial(void *p_buffer, size_t len)
+{
+    ssize_t read = vlc_stream_ReadPartial(stream, p_buffer, len);
+    bytesRead = source->totalRead;
+    return read;
+}
+
 void LibVLCHTTPConnection::setUsed( bool b )
 {
     available = !b;
@@ -465,7 +481,8 @@ bool StreamUrlConnection::canReuse(const ConnectionParams &params_) const
 }
 
 RequestStatus StreamUrlConnection::request(const std::string &path,
-                                           const BytesRange &range)
+                                           const BytesRange &range,
+                                           unsigned)
 {
     reset();
 
@@ -550,6 +567,13 @@ LibVLCHTTPConnectionFactory::LibVLCHTTPConnectionFactory( AuthStorage *auth )
     : AbstractConnectionFactory()
 {
     authStorage = auth;
+    http_mgr = nullptr;
+}
+
+LibVLCHTTPConnectionFactory::~LibVLCHTTPConnectionFactory()
+{
+    if(http_mgr)
+        vlc_http_mgr_destroy(http_mgr);
 }
 
 AbstractConnection * LibVLCHTTPConnectionFactory::createConnection(vlc_object_t *p_object,
@@ -558,7 +582,13 @@ AbstractConnection * LibVLCHTTPConnectionFactory::createConnection(vlc_object_t
     if((params.getScheme() != "http" && params.getScheme() != "https") ||
        params.getHostname().empty())
         return nullptr;
-    return new LibVLCHTTPConnection(p_object, authStorage);
+    if(!http_mgr)
+    {
+        http_mgr = vlc_http_mgr_create(p_object, authStorage->getJar());
+        if(!http_mgr)
+            return nullptr;
+    }
+    return new LibVLCHTTPConnection(p_object, http_mgr);
 }
 
 StreamUrlConnectionFactory::StreamUrlConnectionFactory()
@@ -30,6 +30,8 @@
 #include <vlc_common.h>
 #include <string>
 
+struct vlc_http_mgr;
+
 namespace adaptive
 {
     class ChunksSourceStream;
@@ -39,6 +41,8 @@ namespace adaptive
         class AuthStorage;
 
         constexpr unsigned MAX_REDIRECTS = 3;
+        /* RFC 9218 urgency of the requests, from 0 (highest) to 7 */
+        constexpr unsigned DEFAULT_URGENCY = 3;
 
         class AbstractConnection
         {
@@ -50,8 +54,11 @@ namespace adaptive
                 virtual bool    canReuse     (const ConnectionParams &) const = 0;
 
                 virtual RequestStatus request(const std::string& path,
-                                              const BytesRange & = BytesRange()) = 0;
+                                              const BytesRange & = BytesRange(),
+                                              unsigned = DEFAULT_URGENCY) = 0;
                 virtual ssize_t read        (void *p_buffer, size_t len) = 0;
+                /* Returns as soon as some data is there, 0 at the end */
+                virtual ssize_t readPartial (void *p_buffer, size_t len);
 
                 virtual size_t  getContentLength() const;
                 virtual size_t  getBytesRead() const;
@@ -75,12 +82,14 @@ namespace adaptive
        class LibVLCHTTPConnection : public AbstractConnection
        {
             public:
-               LibVLCHTTPConnection(vlc_object_t *, AuthStorage *);
+               LibVLCHTTPConnection(vlc_object_t *, struct vlc_http_mgr *);
                virtual ~LibVLCHTTPConnection();
                bool    canReuse     (const ConnectionParams &) const override;
                RequestStatus request(const std::string& path,
-                                     const BytesRange & = BytesRange()) override;
+                                     const BytesRange & = BytesRange(),
+                                     unsigned = DEFAULT_URGENCY) override;
                ssize_t read         (void *p_buffer, size_t len) override;
+               ssize_t readPartial  (void *p_buffer, size_t len) override;
                void    setUsed      ( bool ) override;
 
             private:
@@ -101,7 +110,8 @@ namespace adaptive
                 bool    canReuse     (const ConnectionParams &) const override;
 
                 RequestStatus request(const std::string& path,
-                                      const BytesRange & = BytesRange()) override;
+                                      const BytesRange & = BytesRange(),
+                                      unsigned = DEFAULT_URGENCY) override;
                 ssize_t read        (void *p_buffer, size_t len) override;
 
                 void    setUsed( bool ) override;
@@ -119,14 +129,18 @@ namespace adaptive
                virtual AbstractConnection * createConnection(vlc_object_t *, const ConnectionParams &) = 0;
        };
 
+       /* All the connections share the same HTTP connections manager, so that
+        * the requests to a server are multiplexed over a single HTTP/2
+        * connection, or spread over a few persistent HTTP/1 ones. */
        class LibVLCHTTPConnectionFactory : public AbstractConnectionFactory
        {
            public:
                LibVLCHTTPConnectionFactory( AuthStorage * );
-               virtual ~LibVLCHTTPConnectionFactory() = default;
+               virtual ~LibVLCHTTPConnectionFactory();
                AbstractConnection * createConnection(vlc_object_t *, const ConnectionParams &) override;
            private:
                AuthStorage *authStorage;
+               struct vlc_http_mgr *http_mgr;
        };
 
        class StreamUrlConnectionFactory : public AbstractConnectionFactory
@@ -49,9 +49,16 @@ AbstractConnectionManager::~AbstractConnectionManager()
 
 }
 
+bool AbstractConnectionManager::canPrefetch() const
+{
+    return false;
+}
+
 void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid, size_t size,
                                                    vlc_tick_t time, vlc_tick_t latency)
 {
+    /* Concurrent downloads report from their own threads */
+    vlc::threads::mutex_locker locker {rateLock};
     if(rateObserver)
     {
         BwDebug(msg_Dbg(p_object,
@@ -77,7 +84,10 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_)
       localAllowed(false)
 {
     vlc_mutex_init(&lock);
-    downloader = new Downloader();
+    maxDownloads = var_InheritInteger(p_object, "adaptive-downloads");
+    if(maxDownloads == 0)
+        maxDownloads = 1;
+    downloader = new Downloader(maxDownloads);
     downloaderhp = new Downloader();
     downloader->start();
     downloaderhp->start();
@@ -267,6 +277,11 @@ void HTTPConnectionManager::cancel(AbstractChunkSource *source)
         getDownloadQueue(src)->cancel(src);
 }
 
+bool HTTPConnectionManager::canPrefetch() const
+{
+    return maxDownloads > 1;
+}
+
 void HTTPConnectionManager::setLocalConnectionsAllowed()
 {
     localAllowed = true;
@@ -30,6 +30,7 @@
 
 #include <vlc_common.h>
 #include <vlc_threads.h>
+#include <vlc_cxx_helpers.hpp>
 
 #include <vector>
 #include <list>
@@ -61,6 +62,7 @@ namespace adaptive
 
                 virtual void start(AbstractChunkSource *) = 0;
                 virtual void cancel(AbstractChunkSource *) = 0;
+                virtual bool canPrefetch() const;
 
                 virtual void updateDownloadRate(const ID &, size_t,
                                                 vlc_tick_t, vlc_tick_t) override;
@@ -72,6 +74,7 @@ namespace adaptive
 
             private:
                 IDownloadRateObserver                              *rateObserver;
+                vlc::threads::mutex                                 rateLock;
         };
 
         class HTTPConnectionManager : public AbstractConnectionManager
@@ -89,6 +92,7 @@ namespace adaptive
 
                 void start(AbstractChunkSource *)  override;
                 void cancel(AbstractChunkSource *)  override;
+                bool canPrefetch() const  override;
                 void         setLocalConnectionsAllowed();
                 void         addFactory(AbstractConnectionFactory *);
 
@@ -100,6 +104,7 @@ namespace adaptive
                 std::vector<AbstractConnection *>                   connectionPool;
                 std::list<AbstractConnectionFactory *>              factories;
                 bool                                                localAllowed;
+                unsigned                                            maxDownloads;
                 AbstractConnection * reuseConnection(ConnectionParams &);
                 Downloader * getDownloadQueue(const AbstractChunkSource *) const;
                 std::list<HTTPChunkBufferedSource *> cache;
@@ -128,7 +128,7 @@ vlc_tick_t DefaultBufferingLogic::getMaxBuffering(const BasePlaylist *p) const
 vlc_tick_t DefaultBufferingLogic::getLiveDelay(const BasePlaylist *p) const
 {
     if(isLowLatency(p))
-        return getMinBuffering(p);
+        return std::max(p->targetLatency.Get(), getMinBuffering(p));
     vlc_tick_t delay = userLiveDelay ? userLiveDelay
                                      : DEFAULT_LIVE_BUFFERING;
     if(p->suggestedPresentationDelay.Get())
@@ -140,6 +140,15 @@ vlc_tick_t DefaultBufferingLogic::getLiveDelay(const BasePlaylist *p) const
     return std::max(delay, getMinBuffering(p));
 }
 
+vlc_tick_t DefaultBufferingLogic::getMaxLiveDelay(const BasePlaylist *p) const
+{
+    /* The playback rate can't be raised to catch up: low latency playback
+     * falling that far behind jumps back to its live delay instead */
+    if(!p->isLive() || !isLowLatency(p))
+        return 0;
+    return getLiveDelay(p) * 2;
+}
+
 vlc_tick_t DefaultBufferingLogic::getStableBuffering(const BasePlaylist *p) const
 {
     vlc_tick_t min = getMinBuffering(p);
@@ -239,9 +248,11 @@ uint64_t DefaultBufferingLogic::getLiveStartSegmentNumber(BaseRepresentation *re
         stime_t scaledduration = mediaSegmentTemplate->inheritDuration();
         if(scaledduration)
         {
-            /* Compute playback offset and effective finished segment from wall time */
+            /* Compute playback offset and effective finished segment from wall time,
+             * segments being available availabilityTimeOffset earlier */
             vlc_tick_t now = vlc_tick_from_sec(time(nullptr));
-            vlc_tick_t playbacktime = now - i_buffering;
+            vlc_tick_t playbacktime = now + mediaSegmentTemplate->inheritAvailabilityTimeOffset()
+                                    - i_buffering;
             vlc_tick_t minavailtime = playlist->availabilityStartTime.Get() + rep->getPeriodStart();
             const uint64_t startnumber = mediaSegmentTemplate->inheritStartNumber();
             const Timescale timescale = mediaSegmentTemplate->inheritTimescale();
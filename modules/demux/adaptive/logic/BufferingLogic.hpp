@@ -47,6 +47,7 @@ namespace adaptive
                 virtual vlc_tick_t getMinBuffering(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getMaxBuffering(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getLiveDelay(const BasePlaylist *) const = 0;
+                virtual vlc_tick_t getMaxLiveDelay(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getStableBuffering(const BasePlaylist *) const = 0;
                 void setUserMinBuffering(vlc_tick_t);
                 void setUserMaxBuffering(vlc_tick_t);
@@ -73,6 +74,7 @@ namespace adaptive
                 vlc_tick_t getMinBuffering(const BasePlaylist *) const override;
                 vlc_tick_t getMaxBuffering(const BasePlaylist *) const override;
                 vlc_tick_t getLiveDelay(const BasePlaylist *) const override;
+                vlc_tick_t getMaxLiveDelay(const BasePlaylist *) const override;
                 vlc_tick_t getStableBuffering(const BasePlaylist *) const override;
                 static const unsigned SAFETY_BUFFERING_EDGE_OFFSET;
                 static const unsigned SAFETY_EXPURGING_OFFSET;
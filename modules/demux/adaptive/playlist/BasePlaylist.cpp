@@ -48,6 +48,7 @@ BasePlaylist::BasePlaylist (vlc_object_t *p_object_) :
     timeShiftBufferDepth.Set( 0 );
     suggestedPresentationDelay.Set( 0 );
     presentationStartOffset.Set( 0 );
+    targetLatency.Set( 0 );
     b_needsUpdates = true;
 }
 
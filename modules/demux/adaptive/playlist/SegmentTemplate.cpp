@@ -135,7 +135,10 @@ vlc_tick_t SegmentTemplate::getMinAheadTime(uint64_t number) const
     else
     {
         const Timescale timescale = inheritTimescale();
-        uint64_t current = getLiveTemplateNumber(vlc_tick_from_sec(time(nullptr)));
+        /* availabilityTimeOffset: segments can be requested before their
+         * end, and are then received while produced */
+        vlc_tick_t now = vlc_tick_from_sec(time(nullptr)) + inheritAvailabilityTimeOffset();
+        uint64_t current = getLiveTemplateNumber(now);
         stime_t i_length = (current - number) * inheritDuration();
         return timescale.ToTime(i_length);
     }
@@ -165,6 +165,10 @@ ssize_t ChunksSourceStream::Read(uint8_t *buf, size_t size)
             i_toread -= p_block->i_buffer;
             block_Release(p_block);
             p_block = nullptr;
+            /* Don't wait for the next block, which might still be in
+             * transfer, partial reads are fine with the stream layer */
+            if(i_copied)
+                break;
         }
     }
 
@@ -133,8 +133,10 @@ class DummyConnectionManager : public AbstractConnectionManager
         void recycleSource(AbstractChunkSource *) override {}
         void start(AbstractChunkSource *) override {}
         void cancel(AbstractChunkSource *) override {}
+        bool canPrefetch() const override { return prefetch; }
 
         std::map<std::string, std::vector<uint8_t>> data;
+        bool prefetch = false;
 };
 
 using mapentry = std::pair<std::string, std::vector<uint8_t>>;
@@ -643,6 +645,106 @@ static int SegmentTracker_check_switches(BaseAdaptationSet *adaptSet,
     return 0;
 }
 
+/****** check next segment prefetch ******/
+static int SegmentTracker_check_prefetch(BaseAdaptationSet *adaptSet,
+                                         DummyLogic *logic,
+                                         SegmentTracker *tracker,
+                                         SegmentTrackerListener &events)
+{
+    const stime_t START = 1337;
+    Timescale timescale(100);
+
+    ChunkInterface *currentChunk = nullptr;
+    try
+    {
+        DummyRepresentation *reps[2];
+        for(int j=0; j<2; j++)
+        {
+            reps[j] = new DummyRepresentation(adaptSet);
+            adaptSet->addRepresentation(reps[j]);
+            reps[j]->setID(ID(std::to_string(j)));
+
+            SegmentList *segmentList = nullptr;
+            try
+            {
+                segmentList = new SegmentList(reps[j]);
+                segmentList->addAttribute(new TimescaleAttr(timescale));
+                for(int i=0; i<5; i++)
+                {
+                    Segment *seg = new Segment(reps[j]);
+                    seg->setSequenceNumber(123 + i);
+                    seg->setDiscontinuitySequenceNumber(456);
+                    seg->startTime.Set(START + 100 * i);
+                    seg->duration.Set(100);
+                    seg->setSourceUrl("sample/aac");
+                    segmentList->addSegment(seg);
+                }
+            } catch (...) {
+                delete segmentList;
+                std::rethrow_exception(std::current_exception());
+            }
+            reps[j]->addAttribute(segmentList);
+        }
+
+        Expect(adaptSet->isSegmentAligned());
+
+        events.reset();
+        Expect(tracker->setStartPosition() == true);
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(events.representationchanged.next == reps[0]);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        /* the next segment was requested before the logic switched */
+        logic->repindex = 1;
+        events.reset();
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(events.occured(TrackerEvent::Type::RepresentationSwitch) == false);
+        Expect(events.segmentchanged.starttime == timescale.ToTime(START + 100 * 1) + VLC_TICK_0);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        events.reset();
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(events.occured(TrackerEvent::Type::RepresentationSwitch) == true);
+        Expect(events.representationchanged.next == reps[1]);
+        Expect(events.segmentchanged.starttime == timescale.ToTime(START + 100 * 2) + VLC_TICK_0);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        /* a prefetched switch is dropped if switching is no longer allowed */
+        logic->repindex = 0;
+        events.reset();
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(events.occured(TrackerEvent::Type::RepresentationSwitch) == false);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        events.reset();
+        currentChunk = tracker->getNextChunk(false);
+        Expect(currentChunk);
+        Expect(events.occured(TrackerEvent::Type::RepresentationSwitch) == false);
+        Expect(events.segmentchanged.starttime == timescale.ToTime(START + 100 * 4) + VLC_TICK_0);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        /* end of playlist, nothing left to prefetch */
+        events.reset();
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk == nullptr);
+
+    } catch( ... ) {
+        delete currentChunk;
+        return 1;
+    }
+
+    return 0;
+}
+
 /****** check position/alignment with segment translation ******/
 static int SegmentTracker_check_HLSseeks(BaseAdaptationSet *adaptSet,
                                          DummyLogic *logic,
@@ -733,7 +835,7 @@ static int SegmentTracker_check_HLSseeks(BaseAdaptationSet *adaptSet,
 
 typedef decltype(SegmentTracker_check_formats) testfunc;
 
-static int Prepare_test(testfunc func)
+static int Prepare_test(testfunc func, bool prefetch = false)
 {
     DummyConnectionManager *connManager = nullptr;
     try
@@ -741,6 +843,7 @@ static int Prepare_test(testfunc func)
         connManager = new DummyConnectionManager;
     } catch( ... ) { return 1; }
 
+    connManager->prefetch = prefetch;
     connManager->data.insert(mapentry("sample/aac", std::vector<uint8_t>({ 0xFF, 0xF1, 0, 0 })));
     connManager->data.insert(mapentry("sample/ac3", std::vector<uint8_t>({ 0x0b, 0x77, 0, 0, 0, 0 })));
     connManager->data.insert(mapentry("sample/aacinit", std::vector<uint8_t>({ 0xFF, 0xF1, 0, 0 })));
@@ -786,5 +889,6 @@ int SegmentTracker_test()
         Prepare_test(SegmentTracker_check_seeks) ||
         Prepare_test(SegmentTracker_check_switches) ||
         Prepare_test(SegmentTracker_check_HLSseeks) ||
+        Prepare_test(SegmentTracker_check_prefetch, true) ||
         0;
 }
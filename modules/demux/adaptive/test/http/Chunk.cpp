@@ -0,0 +1,210 @@
+/*****************************************************************************
+ *
+ *****************************************************************************
+ * Copyright (C) 2022 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../http/Chunk.h"
+#include "../../http/HTTPConnection.hpp"
+#include "../../http/HTTPConnectionManager.h"
+
+#include "../test.hpp"
+
+#include <vlc_block.h>
+
+#include <vector>
+#include <algorithm>
+
+using namespace adaptive;
+using namespace adaptive::http;
+
+/* Transfer delivered as a sequence of chunks, a partial read never
+ * returning more than the current one */
+class DummyConnection : public AbstractConnection
+{
+    public:
+        DummyConnection(const std::vector<size_t> &sizes, bool withlength)
+            : AbstractConnection(nullptr), chunks(sizes), chunk(0), offset(0),
+              total(0), b_length(withlength)
+        {
+            for(size_t sz : sizes)
+                total += sz;
+        }
+        virtual ~DummyConnection() = default;
+        bool canReuse(const ConnectionParams &) const override { return true; }
+        RequestStatus request(const std::string &, const BytesRange &, unsigned) override
+        {
+            contentLength = b_length ? total : 0;
+            return RequestStatus::Success;
+        }
+        ssize_t read(void *p_buffer, size_t len) override
+        {
+            size_t copied = 0;
+            while(copied < len)
+            {
+                ssize_t ret = readPartial((uint8_t *)p_buffer + copied, len - copied);
+                if(ret <= 0)
+                    break;
+                copied += ret;
+            }
+            return copied;
+        }
+        ssize_t readPartial(void *p_buffer, size_t len) override
+        {
+            if(chunk == chunks.size())
+                return 0;
+            size_t sz = std::min(chunks[chunk] - offset, len);
+            /* payload is the byte offset in the transfer */
+            for(size_t i = 0; i < sz; i++)
+                ((uint8_t *)p_buffer)[i] = (uint8_t)(bytesRead + i);
+            bytesRead += sz;
+            offset += sz;
+            if(offset == chunks[chunk])
+            {
+                ++chunk;
+                offset = 0;
+            }
+            return sz;
+        }
+        void setUsed(bool) override {}
+
+    private:
+        std::vector<size_t> chunks;
+        size_t chunk;
+        size_t offset;
+        size_t total;
+        bool b_length;
+};
+
+class DummyConnectionManager : public AbstractConnectionManager
+{
+    public:
+        DummyConnectionManager(AbstractConnection *c)
+            : AbstractConnectionManager(nullptr), connection(c) {}
+        virtual ~DummyConnectionManager() = default;
+        void closeAllConnections () override {}
+        AbstractConnection * getConnection(ConnectionParams &) override { return connection; }
+        AbstractChunkSource *makeSource(const std::string &, const ID &,
+                                        ChunkType, const BytesRange &) override { return nullptr; }
+        void recycleSource(AbstractChunkSource *) override {}
+        void start(AbstractChunkSource *) override {}
+        void cancel(AbstractChunkSource *) override {}
+
+    private:
+        AbstractConnection *connection;
+};
+
+class DummyBufferedSource : public HTTPChunkBufferedSource
+{
+    public:
+        DummyBufferedSource(AbstractConnectionManager *manager)
+            : HTTPChunkBufferedSource("http://localhost/seg.mp4", manager,
+                                      ID("0"), ChunkType::Segment, BytesRange()) {}
+        virtual ~DummyBufferedSource() = default;
+        using HTTPChunkBufferedSource::bufferize;
+        using HTTPChunkBufferedSource::isDone;
+};
+
+static bool CheckPayload(const block_t *p_block, size_t offset)
+{
+    for(size_t i = 0; i < p_block->i_buffer; i++)
+        if(p_block->p_buffer[i] != (uint8_t)(offset + i))
+            return false;
+    return true;
+}
+
+static int Chunk_check_chunked()
+{
+    const std::vector<size_t> sizes = { 100, 2000, 50 };
+    DummyConnection connection(sizes, false);
+    DummyConnectionManager manager(&connection);
+    block_t *p_block = nullptr;
+
+    try
+    {
+        DummyBufferedSource source(&manager);
+        size_t offset = 0;
+        /* each chunk is readable as soon as it is received */
+        for(size_t sz : sizes)
+        {
+            source.bufferize(HTTPChunkSource::CHUNK_SIZE);
+            Expect(!source.isDone());
+            p_block = source.readBlock();
+            Expect(p_block);
+            Expect(p_block->i_buffer == sz);
+            Expect(CheckPayload(p_block, offset));
+            offset += sz;
+            block_Release(p_block);
+            p_block = nullptr;
+        }
+
+        /* end of transfer */
+        source.bufferize(HTTPChunkSource::CHUNK_SIZE);
+        Expect(source.isDone());
+        Expect(source.hasMoreData());
+        p_block = source.readBlock();
+        Expect(p_block && p_block->i_buffer == 0);
+        block_Release(p_block);
+        p_block = nullptr;
+        Expect(!source.hasMoreData());
+        Expect(source.getBytesRead() == offset);
+    } catch(...) {
+        if(p_block)
+            block_Release(p_block);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int Chunk_check_length()
+{
+    /* a transfer with a length is read whole, whatever its chunks */
+    const std::vector<size_t> sizes = { 100, 2000, 50 };
+    DummyConnection connection(sizes, true);
+    DummyConnectionManager manager(&connection);
+    block_t *p_block = nullptr;
+
+    try
+    {
+        DummyBufferedSource source(&manager);
+        source.bufferize(HTTPChunkSource::CHUNK_SIZE);
+        Expect(source.isDone());
+        p_block = source.readBlock();
+        Expect(p_block);
+        Expect(p_block->i_buffer == 2150);
+        Expect(CheckPayload(p_block, 0));
+        block_Release(p_block);
+        p_block = nullptr;
+        Expect(!source.hasMoreData());
+    } catch(...) {
+        if(p_block)
+            block_Release(p_block);
+        return 1;
+    }
+
+    return 0;
+}
+
+int Chunk_test()
+{
+    return Chunk_check_chunked() ||
+           Chunk_check_length();
+}
@@ -144,7 +144,16 @@ int BufferingLogic_test()
         Expect(bufferinglogic.getMinBuffering(playlist) >= DefaultBufferingLogic::BUFFERING_LOWEST_LIMIT);
         Expect(bufferinglogic.getLiveDelay(playlist) >= DefaultBufferingLogic::BUFFERING_LOWEST_LIMIT);
 
+        /* ServiceDescription target latency */
+        playlist->targetLatency.Set(bufferinglogic.getMinBuffering(playlist) * 2);
+        Expect(bufferinglogic.getLiveDelay(playlist) == bufferinglogic.getMinBuffering(playlist) * 2);
+        playlist->targetLatency.Set(bufferinglogic.getMinBuffering(playlist) / 2);
+        Expect(bufferinglogic.getLiveDelay(playlist) == bufferinglogic.getMinBuffering(playlist));
+        playlist->targetLatency.Set(0);
+        Expect(bufferinglogic.getMaxLiveDelay(playlist) > bufferinglogic.getLiveDelay(playlist));
+
         playlist->b_lowlatency = false;
+        Expect(bufferinglogic.getMaxLiveDelay(playlist) == 0);
         Expect(bufferinglogic.getStartSegmentNumber(rep) == number);
 
         while(segmentList->getTotalLength() <
@@ -543,5 +543,110 @@ int M3U8Playlist_test()
         return 1;
     }
 
+    /* Manifest 6: low latency, parts replace the segments being produced */
+    const char manifest6[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:2\n"
+    "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=1.5\n"
+    "#EXT-X-PART-INF:PART-TARGET=0.5\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:2,\n"
+    "seg10.mp4\n"
+    "#EXT-X-PART:DURATION=0.5,URI=\"part11.0.mp4\"\n"
+    "#EXT-X-PART:DURATION=0.5,URI=\"part11.1.mp4\"\n"
+    "#EXT-X-PART:DURATION=0.5,URI=\"part11.2.mp4\"\n"
+    "#EXT-X-PART:DURATION=0.5,URI=\"part11.3.mp4\"\n"
+    "#EXTINF:2,\n"
+    "seg11.mp4\n"
+    "#EXT-X-PART:DURATION=0.5,URI=\"seg12.mp4\",BYTERANGE=\"1000@0\"\n"
+    "#EXT-X-PART:DURATION=0.5,URI=\"seg12.mp4\",BYTERANGE=\"2000\"\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"seg12.mp4\",BYTERANGE-START=3000\n";
+
+    m3u = ParseM3U8(obj, manifest6, sizeof(manifest6));
+    try
+    {
+        Expect(m3u);
+        Expect(m3u->isLive() == true);
+        Expect(m3u->isLowLatency() == true);
+        BaseRepresentation *rep = m3u->getFirstPeriod()->getAdaptationSets().front()->
+                                  getRepresentations().front();
+        Expect(rep->getProfile()->getStartSegmentNumber() == 10);
+
+        /* segment, then parts numbered after it */
+        const HLSSegment *seg = static_cast<HLSSegment *>(rep->getMediaSegment(10));
+        Expect(seg);
+        Expect(seg->getMediaSequenceNumber() == 10);
+        Expect(!seg->isPart());
+        for(uint64_t i = 0; i < 4; i++)
+        {
+            seg = static_cast<HLSSegment *>(rep->getMediaSegment(11 + i));
+            Expect(seg);
+            Expect(seg->getMediaSequenceNumber() == 11);
+            Expect(seg->getPartIndex() == i);
+        }
+
+        vlc_tick_t mediatime, duration;
+        Expect(rep->getPlaybackTimeDurationBySegmentNumber(12, &mediatime, &duration));
+        Expect(mediatime == vlc_tick_from_sec(2.5));
+        Expect(duration == vlc_tick_from_sec(0.5));
+
+        /* byte ranges of the segment being produced, the open ended hint is skipped */
+        seg = static_cast<HLSSegment *>(rep->getMediaSegment(15));
+        Expect(seg);
+        Expect(seg->getMediaSequenceNumber() == 12 && seg->getPartIndex() == 0);
+        Expect(seg->contains(999) && !seg->contains(1000));
+        seg = static_cast<HLSSegment *>(rep->getMediaSegment(16));
+        Expect(seg);
+        Expect(seg->getMediaSequenceNumber() == 12 && seg->getPartIndex() == 1);
+        Expect(seg->contains(1000) && seg->contains(2999) && !seg->contains(3000));
+        Expect(rep->getMediaSegment(17) == nullptr);
+
+        /* reload: new parts of the same resource, then a bounded hint */
+        const char manifest7[] =
+        "#EXTM3U\n"
+        "#EXT-X-TARGETDURATION:2\n"
+        "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=1.5\n"
+        "#EXT-X-PART-INF:PART-TARGET=0.5\n"
+        "#EXT-X-MEDIA-SEQUENCE:10\n"
+        "#EXTINF:2,\n"
+        "seg10.mp4\n"
+        "#EXT-X-PART:DURATION=0.5,URI=\"part11.0.mp4\"\n"
+        "#EXT-X-PART:DURATION=0.5,URI=\"part11.1.mp4\"\n"
+        "#EXT-X-PART:DURATION=0.5,URI=\"part11.2.mp4\"\n"
+        "#EXT-X-PART:DURATION=0.5,URI=\"part11.3.mp4\"\n"
+        "#EXTINF:2,\n"
+        "seg11.mp4\n"
+        "#EXT-X-PART:DURATION=0.5,URI=\"seg12.mp4\",BYTERANGE=\"1000@0\"\n"
+        "#EXT-X-PART:DURATION=0.5,URI=\"seg12.mp4\",BYTERANGE=\"2000\"\n"
+        "#EXT-X-PART:DURATION=0.5,URI=\"seg12.mp4\",BYTERANGE=\"1500\"\n"
+        "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"seg12.mp4\",BYTERANGE-START=4500,BYTERANGE-LENGTH=500\n";
+
+        stream_t *substream = vlc_stream_MemoryNew(obj, (uint8_t *)manifest7, sizeof(manifest7), true);
+        Expect(substream);
+        M3U8Parser parser(nullptr);
+        parser.appendSegmentsFromPlaylist(obj, static_cast<HLSRepresentation *>(rep), substream);
+        vlc_stream_Delete(substream);
+
+        /* every byte of seg12.mp4 belongs to a single unit */
+        const size_t ranges[][2] = { { 0, 999 }, { 1000, 2999 }, { 3000, 4499 }, { 4500, 4999 } };
+        for(uint64_t i = 0; i < 4; i++)
+        {
+            seg = static_cast<HLSSegment *>(rep->getMediaSegment(15 + i));
+            Expect(seg);
+            Expect(seg->getMediaSequenceNumber() == 12 && seg->getPartIndex() == i);
+            Expect(seg->contains(ranges[i][0]) && seg->contains(ranges[i][1]));
+            Expect(!seg->contains(ranges[i][1] + 1));
+            Expect(ranges[i][0] == 0 || !seg->contains(ranges[i][0] - 1));
+        }
+        Expect(rep->getMediaSegment(19) == nullptr);
+
+        delete m3u;
+    }
+    catch (...)
+    {
+        delete m3u;
+        return 1;
+    }
+
     return 0;
 }
@@ -49,6 +49,7 @@ int main()
     TEST(CommandsQueue) ||
     TEST(M3U8MasterPlaylist) ||
     TEST(M3U8Playlist) ||
-    TEST(SegmentTracker)
+    TEST(SegmentTracker) ||
+    TEST(Chunk)
     ;
 }
@@ -98,6 +98,7 @@ MPD * IsoffMainParser::parse()
     {
         parseMPDAttributes(mpd, root);
         parseProgramInformation(DOMHelper::getFirstChildElementByName(root, "ProgramInformation", getDASHNamespace()), mpd);
+        parseServiceDescription(DOMHelper::getFirstChildElementByName(root, "ServiceDescription", getDASHNamespace()), mpd);
         parseMPDBaseUrl(mpd, root);
         parsePeriods(mpd, root);
         mpd->addAttribute(new StartnumberAttr(1));
@@ -581,6 +582,21 @@ void IsoffMainParser::parseProgramInformation(Node * node, MPD *mpd)
     }
 }
 
+void IsoffMainParser::parseServiceDescription(Node * node, MPD *mpd)
+{
+    if(!node)
+        return;
+
+    /* Playback rate can't be controlled from here: only the target latency
+     * is used, as the live delay */
+    Node *latency = DOMHelper::getFirstChildElementByName(node, "Latency", getDASHNamespace());
+    if(latency && latency->hasAttribute("target"))
+    {
+        uint64_t target = Integer<uint64_t>(latency->getAttributeValue("target"));
+        mpd->targetLatency.Set(VLC_TICK_FROM_MS(target));
+    }
+}
+
 Profile IsoffMainParser::getProfile() const
 {
     Profile res(Profile::Name::Unknown);
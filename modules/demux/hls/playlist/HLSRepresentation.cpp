@@ -44,6 +44,10 @@ HLSRepresentation::HLSRepresentation  ( BaseAdaptationSet *set ) :
     updateFailureCount = 0;
     lastUpdateTime = 0;
     targetDuration = 0;
+    partTarget = 0;
+    b_blockingReload = false;
+    nextPartMediaSequence = 0;
+    nextPartIndex = 0;
     streamFormat = StreamFormat::Type::Unknown;
     channels = 0;
 }
@@ -67,6 +71,11 @@ bool HLSRepresentation::initialized() const
     return b_loaded;
 }
 
+bool HLSRepresentation::usesParts() const
+{
+    return partTarget != 0;
+}
+
 void HLSRepresentation::setPlaylistUrl(const std::string &uri)
 {
     playlistUrl = Url(uri);
@@ -136,6 +145,9 @@ bool HLSRepresentation::needsUpdate(uint64_t number) const
         vlc_tick_t duration = targetDuration
                             ? vlc_tick_from_sec(targetDuration)
                             : VLC_TICK_FROM_SEC(2);
+        /* Playlists are updated at each new part */
+        if(usesParts())
+            duration = partTarget;
         if(updateFailureCount)
             duration /= 2;
         if(elapsed < duration)
@@ -193,6 +205,9 @@ CodecDescription * HLSRepresentation::makeCodecDescription(const std::string &s)
 
 uint64_t HLSRepresentation::translateSegmentNumber(uint64_t num, const BaseRepresentation *from) const
 {
+    if(usesParts() || static_cast<const HLSRepresentation *>(from)->usesParts())
+        return translatePartNumber(num, from);
+
     if(targetDuration == static_cast<const HLSRepresentation *>(from)->targetDuration)
         return num;
 
@@ -255,3 +270,27 @@ uint64_t HLSRepresentation::translateSegmentNumber(uint64_t num, const BaseRepre
 
     return std::numeric_limits<uint64_t>::max();
 }
+
+uint64_t HLSRepresentation::translatePartNumber(uint64_t num, const BaseRepresentation *from) const
+{
+    /* Partial segments are numbered per playlist: match the media sequence
+     * and part instead, a full segment standing for its first part */
+    const HLSSegment *fromSeg = static_cast<const HLSSegment *>(from->getMediaSegment(num));
+    const SegmentList *segmentList = inheritSegmentList();
+    if(!fromSeg || !segmentList)
+        return std::numeric_limits<uint64_t>::max();
+
+    const uint64_t msn = fromSeg->getMediaSequenceNumber();
+    const unsigned part = fromSeg->isPart() ? fromSeg->getPartIndex() : 0;
+
+    for(const Segment *s : segmentList->getSegments())
+    {
+        const HLSSegment *seg = static_cast<const HLSSegment *>(s);
+        const unsigned segPart = seg->isPart() ? seg->getPartIndex() : 0;
+        if(seg->getMediaSequenceNumber() > msn ||
+           (seg->getMediaSequenceNumber() == msn && segPart >= part))
+            return seg->getSequenceNumber();
+    }
+
+    return std::numeric_limits<uint64_t>::max();
+}
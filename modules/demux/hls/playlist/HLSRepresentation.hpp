@@ -58,11 +58,21 @@ namespace hls
 
                 void setChannelsCount(unsigned);
 
+                bool usesParts() const;
+
             protected:
                 time_t targetDuration;
                 Url playlistUrl;
+                /* Low latency: partial segments target duration and next
+                 * part to wait for with a blocking playlist reload */
+                vlc_tick_t partTarget;
+                bool b_blockingReload;
+                uint64_t nextPartMediaSequence;
+                unsigned nextPartIndex;
 
             private:
+                uint64_t translatePartNumber(uint64_t, const BaseRepresentation *) const;
+
                 static const unsigned MAX_UPDATE_FAILED_UPDATE_COUNT = 3;
                 StreamFormat streamFormat;
                 bool b_live;
@@ -27,23 +27,40 @@
 
 using namespace hls::playlist;
 
-HLSSegment::HLSSegment( ICanonicalUrl *parent, uint64_t seq ) :
+HLSSegment::HLSSegment( ICanonicalUrl *parent, uint64_t seq, unsigned part ) :
     Segment( parent )
 {
     setSequenceNumber(seq);
+    mediaSequence = seq;
+    partIndex = part;
 }
 
 HLSSegment::~HLSSegment()
 {
 }
 
+uint64_t HLSSegment::getMediaSequenceNumber() const
+{
+    return mediaSequence;
+}
+
+unsigned HLSSegment::getPartIndex() const
+{
+    return partIndex;
+}
+
+bool HLSSegment::isPart() const
+{
+    return partIndex != NO_PART;
+}
+
 bool HLSSegment::prepareChunk(SharedResources *res, SegmentChunk *chunk, BaseRepresentation *rep)
 {
     if(encryption.method == CommonEncryption::Method::AES_128)
     {
         if (encryption.iv.size() != 16)
         {
-            uint64_t sequence = getSequenceNumber();
+            uint64_t sequence = mediaSequence;
             encryption.iv.clear();
             encryption.iv.resize(16);
             encryption.iv[15] = (sequence >> 0) & 0xff;
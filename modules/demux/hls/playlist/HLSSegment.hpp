@@ -23,6 +23,8 @@
 #include "../../adaptive/playlist/Segment.h"
 #include "../../adaptive/encryption/CommonEncryption.hpp"
 
+#include <climits>
+
 namespace hls
 {
     namespace playlist
@@ -36,12 +38,24 @@ namespace hls
             friend class M3U8Parser;
 
             public:
-                HLSSegment( ICanonicalUrl *parent, uint64_t sequence );
+                static constexpr unsigned NO_PART = UINT_MAX;
+
+                HLSSegment( ICanonicalUrl *parent, uint64_t sequence,
+                            unsigned part = NO_PART );
                 virtual ~HLSSegment();
+                uint64_t getMediaSequenceNumber() const;
+                unsigned getPartIndex() const;
+                bool isPart() const;
 
             protected:
                 bool prepareChunk(SharedResources *, SegmentChunk *,
                                   BaseRepresentation *) override;
+
+            private:
+                /* With low latency, the segment number no longer is the
+                 * media sequence, as partial segments are numbered too */
+                uint64_t mediaSequence;
+                unsigned partIndex;
         };
     }
 }
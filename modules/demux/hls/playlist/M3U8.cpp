@@ -32,6 +32,7 @@ M3U8::M3U8 (vlc_object_t *p_object) :
     BasePlaylist(p_object)
 {
     minUpdatePeriod.Set( VLC_TICK_FROM_SEC(5) );
+    lowLatency = false;
 }
 
 M3U8::~M3U8()
@@ -67,3 +68,12 @@ bool M3U8::isLive() const
     return b_live;
 }
 
+bool M3U8::isLowLatency() const
+{
+    return lowLatency;
+}
+
+void M3U8::setLowLatency(bool b)
+{
+    lowLatency = b;
+}
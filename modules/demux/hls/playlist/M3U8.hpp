@@ -36,6 +36,11 @@ namespace hls
                 virtual ~M3U8();
 
                 bool isLive() const override;
+                bool isLowLatency() const override;
+                void setLowLatency(bool);
+
+            private:
+                bool lowLatency;
         };
     }
 }
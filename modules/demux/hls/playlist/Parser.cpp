@@ -41,6 +41,7 @@
 #include <cstdio>
 #include <sstream>
 #include <array>
+#include <map>
 #include <unordered_map>
 #include <cctype>
 #include <algorithm>
@@ -225,18 +226,23 @@ void M3U8Parser::fillAdaptsetFromMediainfo(const AttributesTag *mediatag,
 
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, HLSRepresentation *rep)
 {
-    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, rep->getPlaylistUrl().toString());
+    std::string uri = rep->getPlaylistUrl().toString();
+    /* Low latency: the server holds the reload until the next part is there */
+    if(rep->b_blockingReload && rep->usesParts())
+    {
+        uri.append(uri.find('?') == std::string::npos ? "?" : "&");
+        uri.append("_HLS_msn=").append(std::to_string(rep->nextPartMediaSequence));
+        uri.append("&_HLS_part=").append(std::to_string(rep->nextPartIndex));
+    }
+
+    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, uri);
     if(p_block)
     {
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
         if(substream)
         {
-            std::list<Tag *> tagslist = parseEntries(substream);
+            appendSegmentsFromPlaylist(p_obj, rep, substream);
             vlc_stream_Delete(substream);
-
-            parseSegments(p_obj, rep, tagslist);
-
-            releaseTagsList(tagslist);
         }
         block_Release(p_block);
         return true;
@@ -244,6 +250,14 @@ bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, HLSRepresent
     return false;
 }
 
+void M3U8Parser::appendSegmentsFromPlaylist(vlc_object_t *p_obj, HLSRepresentation *rep,
+                                            stream_t *stream)
+{
+    std::list<Tag *> tagslist = parseEntries(stream);
+    parseSegments(p_obj, rep, tagslist);
+    releaseTagsList(tagslist);
+}
+
 static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
                             CommonEncryption &encryption)
 {
@@ -279,17 +293,94 @@ static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
     }
 }
 
-void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std::list<Tag *> &tagslist)
+/* Partial segments get numbers of their own: the units already known from the
+ * previous playlist keep theirs, and the new ones are numbered after them */
+static void renumberSegments(const SegmentList *previous, std::list<HLSSegment *> &units)
+{
+    if(units.empty())
+        return;
+
+    /* A full segment gets the number of the last known unit of its media sequence */
+    std::map<std::pair<uint64_t, unsigned>, uint64_t> known;
+    if(previous)
+    {
+        for(const Segment *s : previous->getSegments())
+        {
+            const HLSSegment *seg = static_cast<const HLSSegment *>(s);
+            known[{seg->getMediaSequenceNumber(), seg->getPartIndex()}] = seg->getSequenceNumber();
+            known[{seg->getMediaSequenceNumber(), HLSSegment::NO_PART}] = seg->getSequenceNumber();
+        }
+    }
+
+    if(known.empty())
+    {
+        uint64_t number = units.front()->getMediaSequenceNumber();
+        for(HLSSegment *unit : units)
+            unit->setSequenceNumber(number++);
+        return;
+    }
+
+    auto lookup = [&known](const HLSSegment *unit)
+    {
+        auto it = known.find({unit->getMediaSequenceNumber(), unit->getPartIndex()});
+        return it != known.end() ? it->second : std::numeric_limits<uint64_t>::max();
+    };
+
+    uint64_t number = previous->getSegments().back()->getSequenceNumber() + 1;
+    auto first = units.begin();
+    for(auto it = units.begin(); it != units.end(); ++it)
+    {
+        const uint64_t match = lookup(*it);
+        if(match != std::numeric_limits<uint64_t>::max())
+        {
+            first = it;
+            number = match;
+            break;
+        }
+    }
+
+    /* units older than the first known one */
+    uint64_t older = number;
+    for(auto it = std::make_reverse_iterator(first); it != units.rend(); ++it)
+        (*it)->setSequenceNumber(older ? --older : 0);
+
+    for(auto it = first; it != units.end(); ++it)
+    {
+        const uint64_t match = lookup(*it);
+        if(match != std::numeric_limits<uint64_t>::max() && match >= number)
+            number = match;
+        (*it)->setSequenceNumber(number++);
+    }
+}
+
+void M3U8Parser::parseSegments(vlc_object_t *p_obj, HLSRepresentation *rep, const std::list<Tag *> &tagslist)
 {
     bool b_pdt = tagslist.cend() != std::find_if(tagslist.cbegin(), tagslist.cend(),
                     [](const Tag *t){return t->getType() == SingleValueTag::EXTXPROGRAMDATETIME;});
     bool b_vod = tagslist.size() && tagslist.back()->getType() == SingleValueTag::EXTXENDLIST;
 
+    /* Low latency: the listed parts are played instead of the last segments */
+    vlc_tick_t partTarget = 0;
+    auto partinf = std::find_if(tagslist.cbegin(), tagslist.cend(),
+                    [](const Tag *t){return t->getType() == AttributesTag::EXTXPARTINF;});
+    if(!b_vod && partinf != tagslist.cend() &&
+       (!p_obj || var_InheritInteger(p_obj, "adaptive-lowlatency") != 0))
+    {
+        const Attribute *targetAttr = static_cast<const AttributesTag *>(*partinf)->getAttributeByName("PART-TARGET");
+        if(targetAttr)
+            partTarget = vlc_tick_from_sec(targetAttr->floatingPoint());
+    }
+    const bool b_parts = partTarget > 0;
+
     SegmentList *segmentList = new SegmentList(rep, !b_vod && !b_pdt);
     const Timescale timescale = rep->inheritTimescale();
 
     rep->b_loaded = true;
     rep->b_live = !b_vod;
+    rep->partTarget = partTarget;
+    rep->b_blockingReload = false;
+    if(b_parts)
+        static_cast<M3U8 *>(rep->getPlaylist())->setLowLatency(true);
 
     vlc_tick_t totalduration = 0;
     vlc_tick_t nzStartTime = 0;
@@ -301,9 +392,68 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
     const SingleValueTag *ctx_byterange = nullptr;
     CommonEncryption encryption;
     const ValuesListTag *ctx_extinf = nullptr;
+    std::list<const AttributesTag *> ctx_parts;
+    const AttributesTag *ctx_preloadhint = nullptr;
 
     std::list<HLSSegment *> segmentstoappend;
 
+    auto createSegment = [&](const std::string &uri, vlc_tick_t nzDuration,
+                             uint64_t msn, unsigned part)
+    {
+        HLSSegment *segment = new (std::nothrow) HLSSegment(rep, msn, part);
+        if(!segment)
+            return segment;
+
+        segment->setSourceUrl(uri);
+        segment->duration.Set(timescale.ToScaled(nzDuration));
+        segment->startTime.Set(timescale.ToScaled(nzStartTime));
+        nzStartTime += nzDuration;
+        totalduration += nzDuration;
+        if(absReferenceTime != VLC_TICK_INVALID)
+        {
+            segment->setDisplayTime(absReferenceTime);
+            absReferenceTime += nzDuration;
+        }
+
+        segmentstoappend.push_back(segment);
+
+        segment->setDiscontinuitySequenceNumber(discontinuitySequence);
+        segment->discontinuity = discontinuity;
+        discontinuity = false;
+
+        if(encryption.method != CommonEncryption::Method::None)
+            segment->setEncryption(encryption);
+        return segment;
+    };
+
+    /* Returns the number of parts of the segment */
+    auto createParts = [&](uint64_t msn)
+    {
+        unsigned index = 0;
+        std::size_t prevpartoffset = 0;
+        for(const AttributesTag *parttag : ctx_parts)
+        {
+            const Attribute *uriAttr = parttag->getAttributeByName("URI");
+            const Attribute *durAttr = parttag->getAttributeByName("DURATION");
+            const Attribute *byterangeAttr = parttag->getAttributeByName("BYTERANGE");
+            HLSSegment *part = nullptr;
+            if(uriAttr && durAttr)
+                part = createSegment(uriAttr->quotedString(),
+                                     vlc_tick_from_sec(durAttr->floatingPoint()), msn, index);
+            if(part && byterangeAttr)
+            {
+                std::pair<std::size_t,std::size_t> range = byterangeAttr->unescapeQuotes().getByteRange();
+                if(range.first == 0)
+                    range.first = prevpartoffset;
+                prevpartoffset = range.first + range.second;
+                part->setByteRange(range.first, prevpartoffset - 1);
+            }
+            index++;
+        }
+        ctx_parts.clear();
+        return index;
+    };
+
     std::list<Tag *>::const_iterator it;
     for(it = tagslist.begin(); it != tagslist.end(); ++it)
     {
@@ -330,15 +480,10 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
                 {
                     ctx_extinf = nullptr;
                     ctx_byterange = nullptr;
+                    ctx_parts.clear();
                     break;
                 }
 
-                HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber++);
-                if(!segment)
-                    break;
-
-                segment->setSourceUrl(uritag->getValue().value);
-
                 /* Need to use EXTXTARGETDURATION as default as some can't properly set segment one */
                 vlc_tick_t nzDuration = vlc_tick_from_sec(rep->targetDuration);
                 if(ctx_extinf)
@@ -348,33 +493,32 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
                         nzDuration = vlc_tick_from_sec(durAttribute->floatingPoint());
                     ctx_extinf = nullptr;
                 }
-                segment->duration.Set(timescale.ToScaled(nzDuration));
-                segment->startTime.Set(timescale.ToScaled(nzStartTime));
-                nzStartTime += nzDuration;
-                totalduration += nzDuration;
-                if(absReferenceTime != VLC_TICK_INVALID)
-                {
-                    segment->setDisplayTime(absReferenceTime);
-                    absReferenceTime += nzDuration;
-                }
 
-                segmentstoappend.push_back(segment);
-
-                if(ctx_byterange)
+                const SingleValueTag *byterange = ctx_byterange;
+                std::pair<std::size_t,std::size_t> range;
+                if(byterange)
                 {
-                    std::pair<std::size_t,std::size_t> range = ctx_byterange->getValue().getByteRange();
+                    range = byterange->getValue().getByteRange();
                     if(range.first == 0) /* first == size, second = offset */
                         range.first = prevbyterangeoffset;
                     prevbyterangeoffset = range.first + range.second;
-                    segment->setByteRange(range.first, prevbyterangeoffset - 1);
                     ctx_byterange = nullptr;
                 }
-                segment->setDiscontinuitySequenceNumber(discontinuitySequence);
-                segment->discontinuity = discontinuity;
-                discontinuity = false;
 
-                if(encryption.method != CommonEncryption::Method::None)
-                    segment->setEncryption(encryption);
+                /* Parts can't be decrypted separately, as the IV only
+                 * applies at the start of the segment */
+                if(b_parts && !ctx_parts.empty() &&
+                   encryption.method == CommonEncryption::Method::None)
+                {
+                    createParts(sequenceNumber++);
+                    break;
+                }
+                ctx_parts.clear();
+
+                HLSSegment *segment = createSegment(uritag->getValue().value, nzDuration,
+                                                    sequenceNumber++, HLSSegment::NO_PART);
+                if(segment && byterange)
+                    segment->setByteRange(range.first, prevbyterangeoffset - 1);
             }
             break;
 
@@ -446,11 +590,64 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
                 discontinuitySequence++;
                 break;
 
+            case AttributesTag::EXTXPART:
+                if(b_parts)
+                    ctx_parts.push_back(static_cast<const AttributesTag *>(tag));
+                break;
+
+            case AttributesTag::EXTXPRELOADHINT:
+            {
+                const AttributesTag *hinttag = static_cast<const AttributesTag *>(tag);
+                const Attribute *typeAttr = hinttag->getAttributeByName("TYPE");
+                if(typeAttr && typeAttr->value == "PART")
+                    ctx_preloadhint = hinttag;
+            }
+            break;
+
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const Attribute *blockAttr = static_cast<const AttributesTag *>(tag)->
+                                             getAttributeByName("CAN-BLOCK-RELOAD");
+                rep->b_blockingReload = blockAttr && blockAttr->value == "YES";
+            }
+            break;
+
             case Tag::EXTXENDLIST:
                 break;
         }
     }
 
+    if(b_parts)
+    {
+        /* Parts of the segment being produced, then the one hinted as next */
+        unsigned partscount = 0;
+        if(encryption.method == CommonEncryption::Method::None)
+        {
+            partscount = createParts(sequenceNumber);
+            const Attribute *uriAttr = ctx_preloadhint ? ctx_preloadhint->getAttributeByName("URI")
+                                                       : nullptr;
+            const Attribute *startAttr = ctx_preloadhint ? ctx_preloadhint->getAttributeByName("BYTERANGE-START")
+                                                         : nullptr;
+            const Attribute *lengthAttr = ctx_preloadhint ? ctx_preloadhint->getAttributeByName("BYTERANGE-LENGTH")
+                                                          : nullptr;
+            const std::size_t start = startAttr ? startAttr->decimal() : 0;
+            const std::size_t length = lengthAttr ? lengthAttr->decimal() : 0;
+            /* An open ended range would overlap the next parts of the resource,
+             * which are fetched again once listed */
+            if(uriAttr && start && !length)
+                uriAttr = nullptr;
+            HLSSegment *hint = uriAttr ? createSegment(uriAttr->quotedString(), partTarget,
+                                                       sequenceNumber, partscount)
+                                       : nullptr;
+            if(hint && length)
+                hint->setByteRange(start, start + length - 1);
+        }
+        rep->nextPartMediaSequence = sequenceNumber;
+        rep->nextPartIndex = partscount;
+
+        renumberSegments(rep->inheritSegmentList(), segmentstoappend);
+    }
+
     for(HLSSegment *seg : segmentstoappend)
         segmentList->addSegment(seg);
     segmentstoappend.clear();
@@ -99,6 +99,10 @@ namespace hls
                     EXTXSTART,
                     EXTXSTREAMINF,
                     EXTXSESSIONKEY,
+                    EXTXPART,
+                    EXTXPARTINF,
+                    EXTXPRELOADHINT,
+                    EXTXSERVERCONTROL,
                 };
                 AttributesTag(int, const std::string &);
                 virtual ~AttributesTag();
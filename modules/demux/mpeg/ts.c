@@ -34,6 +34,7 @@
 #include <vlc_access.h>    /* DVB-specific things */
 #include <vlc_demux.h>
 #include <vlc_input.h>
+#include <vlc_atomic.h>
 
 #include "ts_pid.h"
 #include "ts_streams.h"
@@ -123,6 +124,11 @@ static void Close ( vlc_object_t * );
 #define TS_OFFSETFIX_TEXT   "Try to fix too early PCR (or late DTS)"
 #define TS_GENERATED_PCR_OFFSET_TEXT "Offset in ms for generated PCR"
 
+#define BATCH_TEXT N_("Batched packet reading")
+#define BATCH_LONGTEXT N_("Read and check packets by batches rather than " \
+    "one by one. This lowers the demuxer load on high bitrate multiplexes, " \
+    "at the cost of some latency on low bitrate streams.")
+
 #define PCR_TEXT N_("Trust in-stream PCR")
 #define PCR_LONGTEXT N_("Use the stream PCR as a reference.")
 
@@ -163,6 +169,7 @@ vlc_module_begin ()
     add_bool( "ts-pcr-offsetfix", true, TS_OFFSETFIX_TEXT, NULL )
     add_integer_with_range( "ts-generated-pcr-offset", 120, 0, 500,
                             TS_GENERATED_PCR_OFFSET_TEXT, NULL )
+    add_bool( "ts-batch", false, BATCH_TEXT, BATCH_LONGTEXT )
 
     set_capability( "demux", 10 )
     set_callbacks( Open, Close )
@@ -194,6 +201,9 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, stime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static void FlushTSBatch( demux_sys_t *p_sys );
+static uint64_t TsTell( demux_sys_t *p_sys );
+static int TsSeek( demux_sys_t *p_sys, uint64_t i_pos );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, stime_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, stime_t );
@@ -405,6 +415,9 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
+    p_sys->b_batch = var_InheritBool( p_demux, "ts-batch" );
+    p_sys->batch.i_count = 0;
+    p_sys->batch.i_pos = 0;
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
     p_sys->record_dir_path = NULL;
@@ -580,6 +593,8 @@ static void Close( vlc_object_t *p_this )
 
     ARRAY_RESET( p_sys->programs );
 
+    FlushTSBatch( p_sys );
+
 #ifdef HAVE_ARIBB24
     if ( p_sys->arib.p_instance )
         arib_instance_destroy( p_sys->arib.p_instance );
@@ -966,7 +981,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TsTell( p_sys );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -1013,7 +1028,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         i64 = stream_Size( p_sys->stream );
         if( i64 > 0 &&
-            vlc_stream_Seek( p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
+            TsSeek( p_sys, (int64_t)(i64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1164,9 +1179,11 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     }
 
     case DEMUX_SET_TITLE:
+        FlushTSBatch( p_sys );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_TITLE, args );
 
     case DEMUX_SET_SEEKPOINT:
+        FlushTSBatch( p_sys );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_SEEKPOINT,
                                      args );
 
@@ -1804,20 +1821,189 @@ static void PESDataChainHandle( vlc_object_t *p_obj, void *priv, block_t *p_data
     ParsePESDataChain( (demux_t *)p_obj, (ts_pid_t *) priv, p_data, i_flags, i_appendpcr );
 }
 
+static void FlushTSBatch( demux_sys_t *p_sys )
+{
+    while( p_sys->batch.i_pos < p_sys->batch.i_count )
+        block_Release( p_sys->batch.p_pkts[p_sys->batch.i_pos++] );
+    p_sys->batch.i_count = p_sys->batch.i_pos = 0;
+}
+
+/* Stream position of the next packet to be demuxed */
+static uint64_t TsTell( demux_sys_t *p_sys )
+{
+    const unsigned i_pending = p_sys->batch.i_count - p_sys->batch.i_pos;
+
+    return vlc_stream_Tell( p_sys->stream )
+         - (uint64_t)i_pending * p_sys->i_packet_size;
+}
+
+static int TsSeek( demux_sys_t *p_sys, uint64_t i_pos )
+{
+    FlushTSBatch( p_sys );
+    return vlc_stream_Seek( p_sys->stream, i_pos );
+}
+
+/* Counts the leading packets with a sync byte in a buffer */
+static unsigned CountSyncedPackets( const uint8_t *p_buf, unsigned i_max,
+                                    unsigned i_packet_size, unsigned i_header_size )
+{
+    const uint8_t *p_sync = &p_buf[i_header_size];
+    unsigned i_count = 0;
+
+    while( i_count < i_max && *p_sync == 0x47 )
+    {
+        p_sync += i_packet_size;
+        i_count++;
+    }
+    return i_count;
+}
+
+/* Counts the packets up to and including the first PAT or PMT packet */
+static unsigned CountPacketsToPSI( demux_sys_t *p_sys, const uint8_t *p_buf,
+                                   unsigned i_count )
+{
+    const uint8_t *p_pkt = &p_buf[p_sys->i_packet_header_size];
+
+    for( unsigned i = 0; i < i_count; i++, p_pkt += p_sys->i_packet_size )
+    {
+        const uint16_t i_pid = ((p_pkt[1] & 0x1f) << 8) | p_pkt[2];
+        const ts_pid_t *pid = GetPID( p_sys, i_pid );
+
+        if( pid->type == TYPE_PAT || pid->type == TYPE_PMT )
+            return i + 1;
+    }
+    return i_count;
+}
+
+/* Packets of a batch are views into a single block read from the stream,
+ * which is released along with the last of them */
+typedef struct ts_batch_t ts_batch_t;
+
+typedef struct
+{
+    block_t     block;
+    ts_batch_t *p_batch;
+} ts_batch_packet_t;
+
+struct ts_batch_t
+{
+    atomic_uint       refs;
+    block_t          *p_data;
+    ts_batch_packet_t pkts[TS_BATCH_PACKETS];
+};
+
+static void TSBatchRelease( ts_batch_t *p_batch )
+{
+    if( atomic_fetch_sub_explicit( &p_batch->refs, 1,
+                                   memory_order_acq_rel ) == 1 )
+    {
+        block_Release( p_batch->p_data );
+        free( p_batch );
+    }
+}
+
+static void TSBatchPacketRelease( block_t *p_block )
+{
+    ts_batch_packet_t *p_pkt = container_of( p_block, ts_batch_packet_t, block );
+
+    TSBatchRelease( p_pkt->p_batch );
+}
+
+static const struct vlc_block_callbacks ts_batch_packet_cbs =
+{
+    TSBatchPacketRelease,
+};
+
+/* Reads as many synchronized packets as available at once, up to
+ * TS_BATCH_PACKETS. Out of sync data is left to the regular path. */
+static block_t* ReadTSBatch( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const unsigned i_packet_size = p_sys->i_packet_size;
+    const uint8_t *p_peek;
+
+    assert( p_sys->batch.i_pos == p_sys->batch.i_count );
+    p_sys->batch.i_count = p_sys->batch.i_pos = 0;
+
+    ssize_t i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
+                                      TS_BATCH_PACKETS * i_packet_size );
+    if( i_peek < 2 * (ssize_t)i_packet_size )
+        return NULL;
+
+    unsigned i_count = CountSyncedPackets( p_peek, i_peek / i_packet_size,
+                                           i_packet_size,
+                                           p_sys->i_packet_header_size );
+    if( i_count < 2 )
+        return NULL;
+
+    /* Until the standard is known, a PMT may switch to ARIB and insert the
+     * descrambler in front of the stream: the packets following it must
+     * not be read ahead from the raw stream. */
+    if( p_sys->standard == TS_STANDARD_AUTO && p_sys->stream == p_demux->s )
+        i_count = CountPacketsToPSI( p_sys, p_peek, i_count );
+
+    /* p_peek is no longer valid past this point */
+    const ssize_t i_read = (size_t)i_count * i_packet_size;
+    ts_batch_t *p_batch = malloc( sizeof(*p_batch) );
+    if( unlikely(p_batch == NULL) )
+        return NULL;
+    p_batch->p_data = block_Alloc( i_read );
+    if( unlikely(p_batch->p_data == NULL) )
+    {
+        free( p_batch );
+        return NULL;
+    }
+
+    uint8_t *p_buf = p_batch->p_data->p_buffer;
+    if( vlc_stream_Read( p_sys->stream, p_buf, i_read ) != i_read )
+    {
+        block_Release( p_batch->p_data );
+        free( p_batch );
+        return NULL;
+    }
+
+    /* One reference per packet */
+    atomic_init( &p_batch->refs, i_count );
+
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        ts_batch_packet_t *p_pkt = &p_batch->pkts[i];
+
+        p_pkt->p_batch = p_batch;
+        block_Init( &p_pkt->block, &ts_batch_packet_cbs,
+                    &p_buf[i * i_packet_size], i_packet_size );
+        /* Skip header (BluRay streams), see ReadTSPacket() */
+        p_pkt->block.p_buffer += p_sys->i_packet_header_size;
+        p_pkt->block.i_buffer -= p_sys->i_packet_header_size;
+        p_sys->batch.p_pkts[i] = &p_pkt->block;
+    }
+    p_sys->batch.i_count = i_count;
+
+    return p_sys->batch.p_pkts[p_sys->batch.i_pos++];
+}
+
 static block_t* ReadTSPacket( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
     block_t     *p_pkt;
 
+    if( p_sys->batch.i_pos < p_sys->batch.i_count )
+        return p_sys->batch.p_pkts[p_sys->batch.i_pos++];
+
+    /* The ARIB descrambler may be inserted after any PMT packet */
+    if( p_sys->b_batch && p_sys->standard != TS_STANDARD_ARIB &&
+        (p_pkt = ReadTSBatch( p_demux )) )
+        return p_pkt;
+
     /* Get a new TS packet */
     if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
     {
         int64_t size = stream_Size( p_sys->stream );
-        if( size >= 0 && (uint64_t)size == vlc_stream_Tell( p_sys->stream ) )
-            msg_Dbg( p_demux, "EOF at %"PRIu64, vlc_stream_Tell( p_sys->stream ) );
+        if( size >= 0 && (uint64_t)size == TsTell( p_sys ) )
+            msg_Dbg( p_demux, "EOF at %"PRIu64, TsTell( p_sys ) );
         else
-            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, vlc_stream_Tell(p_sys->stream) );
+            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, TsTell( p_sys ) );
         return NULL;
     }
 
@@ -1863,7 +2049,7 @@ static block_t* ReadTSPacket( demux_t *p_demux )
                 i_skip++;
             }
             msg_Dbg( p_demux, "skipping %d bytes of garbage at %"PRIu64,
-                     i_skip, vlc_stream_Tell( p_sys->stream ) );
+                     i_skip, TsTell( p_sys ) );
             if (vlc_stream_Read( p_sys->stream, NULL, i_skip ) != i_skip)
                 return NULL;
 
@@ -1872,7 +2058,7 @@ static block_t* ReadTSPacket( demux_t *p_demux )
                 break;
             }
         }
-        msg_Dbg( p_demux, "resynced at %" PRIu64, vlc_stream_Tell( p_sys->stream ) );
+        msg_Dbg( p_demux, "resynced at %" PRIu64, TsTell( p_sys ) );
         if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
         {
             msg_Dbg( p_demux, "eof ?" );
@@ -2010,13 +2196,13 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return TsSeek( p_sys, 0 );
 
     const int64_t i_stream_size = stream_Size( p_sys->stream );
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TsTell( p_sys );
 
     /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
@@ -2032,7 +2218,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( TsSeek( p_sys, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -2046,7 +2232,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
                 break;
             }
             else
-                i_pos = vlc_stream_Tell( p_sys->stream );
+                i_pos = TsTell( p_sys );
 
             int i_pid = PIDGet( p_pkt );
             ts_pid_t *p_pid = GetPID(p_sys, i_pid);
@@ -2103,7 +2289,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) != VLC_SUCCESS )
+        if( TsSeek( p_sys, i_initial_pos ) != VLC_SUCCESS )
             msg_Err( p_demux, "Can't seek back to %" PRIu64, i_initial_pos );
         return VLC_EGENERIC;
     }
@@ -2189,7 +2375,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, bool *pb_fou
                         if( b_end )
                         {
                             p_pmt->i_last_dts = i_pcr;
-                            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                            p_pmt->i_last_dts_byte = TsTell( p_sys );
                         }
                         /* Start, only keep first */
                         else if( b_pcrresult && p_pmt->pcr.i_first == -1 )
@@ -2217,7 +2403,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, bool *pb_fou
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TsTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = 0;
@@ -2229,7 +2415,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_pos = (int64_t)p_sys->i_packet_size * i_probe_count;
         i_pos = __MIN( i_pos, i_stream_size );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TsSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         int i_count =  ProbeChunk( p_demux, i_program, false, &b_found );
@@ -2241,7 +2427,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
     } while( i_pos < i_stream_size && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TsSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2250,7 +2436,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TsTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = PROBE_CHUNK_COUNT;
@@ -2262,7 +2448,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         i_pos = i_stream_size - (p_sys->i_packet_size * i_probe_count);
         i_pos = __MAX( i_pos, 0 );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TsSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         int i_count = ProbeChunk( p_demux, i_program, true, &b_found );
@@ -2274,7 +2460,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TsSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2329,14 +2515,14 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr )
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TsTell( p_sys ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = TsTell( p_sys );
             }
         }
     }
@@ -31,6 +31,8 @@ typedef struct csa_t csa_t;
 
 #define TS_PSI_PAT_PID 0x00
 
+#define TS_BATCH_PACKETS 128
+
 _Static_assert (VLC_TICK_INVALID + 1 == VLC_TICK_0,
                 "can't define TS_UNKNOWN reference");
 #define TS_TICK_UNKNOWN (VLC_TICK_INVALID - 1)
@@ -72,6 +74,15 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* Packets read ahead from the stream (batched reading) */
+    bool        b_batch;
+    struct
+    {
+        block_t *p_pkts[TS_BATCH_PACKETS];
+        unsigned i_count;
+        unsigned i_pos;
+    } batch;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
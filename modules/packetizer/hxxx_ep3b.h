@@ -19,26 +19,73 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 #include <vlc_bits.h>
+#include "startcode_helper.h"
+
+/* Below that count, bytes are checked one by one */
+#define HXXX_EP3B_BULK 16
+
+static inline bool hxxx_ep3b_next( uint8_t **pp, uint8_t *end, unsigned *pi_prev )
+{
+    uint8_t *p = *pp;
+
+    if( ++p >= end )
+    {
+        *pp = p;
+        return false;
+    }
+
+    *pi_prev = (*pi_prev << 1) | (!*p);
+
+    if( *p == 0x03 &&
+       ( p + 1 ) != end ) /* Never escape sequence if no next byte */
+    {
+        if( (*pi_prev & 0x06) == 0x06 )
+        {
+            ++p;
+            *pi_prev = !*p;
+        }
+    }
+    *pp = p;
+    return true;
+}
 
 static inline uint8_t *hxxx_ep3b_to_rbsp( uint8_t *p, uint8_t *end, unsigned *pi_prev, size_t i_count )
 {
-    for( size_t i=0; i<i_count; i++ )
+    size_t i = 0;
+
+    for( ;; )
     {
-        if( ++p >= end )
-            return p;
+        /* The current and previous bytes must have been checked */
+        for( unsigned j = 0; j < 2 && i < i_count; j++, i++ )
+            if( !hxxx_ep3b_next( &p, end, pi_prev ) )
+                return p;
 
-        *pi_prev = (*pi_prev << 1) | (!*p);
+        if( i_count - i < HXXX_EP3B_BULK )
+            break;
 
-        if( *p == 0x03 &&
-           ( p + 1 ) != end ) /* Never escape sequence if no next byte */
+        /* Only a 0x00 0x00 0x03 sequence can make the count and the size
+         * differ: look it up, and skip straight to it */
+        uint8_t *target = p + ( i_count - i );
+        if( target >= end )
+            return end; /* the history no longer matters */
+
+        const uint8_t *ep3b = startcode_FindEP3B( p - 1, target + 1 );
+        if( ep3b == NULL )
         {
-            if( (*pi_prev & 0x06) == 0x06 )
-            {
-                ++p;
-                *pi_prev = !*p;
-            }
+            *pi_prev = (!target[-1] << 1) | (!target[0]);
+            return target;
         }
+
+        /* Resume at the last zero, the 0x03 is handled byte by byte */
+        i += ep3b + 1 - p;
+        p = (uint8_t *)ep3b + 1;
+        *pi_prev = 0x03;
     }
+
+    for( ; i < i_count; i++ )
+        if( !hxxx_ep3b_next( &p, end, pi_prev ) )
+            return p;
+
     return p;
 }
 
@@ -59,43 +59,35 @@ block_t *hxxx_AnnexB_to_xVC( block_t *p_block, uint8_t i_nal_length_size )
         goto error;
 
     /* Search all startcode of size 3 */
-    const uint8_t *p_buf = p_block->p_buffer;
+    const uint8_t *p_start = p_block->p_buffer;
+    const uint8_t *p_buf = p_start;
     const uint8_t *p_end = &p_block->p_buffer[p_block->i_buffer];
-    unsigned i_bitflow = 0;
     size_t i_move = 0;
-    while( p_buf != p_end )
+    while( (p_buf = startcode_FindAnnexB( p_buf, p_end )) != NULL )
     {
-        i_bitflow <<= 1;
-        if( !*p_buf )
+        if( p_buf > p_start && p_buf[-1] == 0 ) /* three zero prefixed 1 */
         {
-            i_bitflow |= 1;
+            p_list[i_nalcount].p = &p_buf[-1];
+            p_list[i_nalcount].prefix = 4;
         }
-        else if( *p_buf == 0x01 && (i_bitflow & 0x06) == 0x06 ) /* >= two zero prefixed 1 */
+        else /* two zero prefixed 1 */
         {
-            if( i_bitflow & 0x08 ) /* three zero prefixed 1 */
-            {
-                p_list[i_nalcount].p = &p_buf[-3];
-                p_list[i_nalcount].prefix = 4;
-            }
-            else /* two zero prefixed 1 */
-            {
-                p_list[i_nalcount].p = &p_buf[-2];
-                p_list[i_nalcount].prefix = 3;
-            }
-            i_move += (size_t) i_nal_length_size - p_list[i_nalcount].prefix;
-            p_list[i_nalcount++].move = i_move;
-
-            /* Check and realloc our list */
-            if(i_nalcount == i_list)
-            {
-                i_list += 16;
-                struct nalmoves_e *p_new = realloc( p_list, sizeof(*p_new) * i_list );
-                if(unlikely(!p_new))
-                    goto error;
-                p_list = p_new;
-            }
+            p_list[i_nalcount].p = p_buf;
+            p_list[i_nalcount].prefix = 3;
         }
-        p_buf++;
+        i_move += (size_t) i_nal_length_size - p_list[i_nalcount].prefix;
+        p_list[i_nalcount++].move = i_move;
+
+        /* Check and realloc our list */
+        if(i_nalcount == i_list)
+        {
+            i_list += 16;
+            struct nalmoves_e *p_new = realloc( p_list, sizeof(*p_new) * i_list );
+            if(unlikely(!p_new))
+                goto error;
+            p_list = p_new;
+        }
+        p_buf += 3;
     }
 
     if( !i_nalcount )
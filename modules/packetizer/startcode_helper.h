@@ -20,18 +20,21 @@
 #ifndef VLC_STARTCODE_HELPER_H_
 #define VLC_STARTCODE_HELPER_H_
 
+#include <stdbit.h>
+#include <string.h>
 #include <vlc_cpu.h>
+#ifdef CAN_COMPILE_AVX2
+#  include <immintrin.h>
+#endif
 
-#ifdef CAN_COMPILE_SSE2
-#  if defined __has_attribute
-#    if __has_attribute(__vector_size__)
-#      define HAS_ATTRIBUTE_VECTORSIZE
-#    endif
+#if defined __has_attribute
+#  if __has_attribute(__vector_size__)
+#    define HAS_ATTRIBUTE_VECTORSIZE
 #  endif
+#endif
 
-#  ifdef HAS_ATTRIBUTE_VECTORSIZE
+#ifdef HAS_ATTRIBUTE_VECTORSIZE
     typedef unsigned char v16qu __attribute__((__vector_size__(16)));
-#  endif
 #endif
 
 /* Looks up efficiently for an AnnexB startcode 0x00 0x00 0x01
@@ -119,6 +122,90 @@ static inline const uint8_t * startcode_FindAnnexB_SSE2( const uint8_t *p, const
 
 #endif
 
+#ifdef CAN_COMPILE_AVX2
+
+/* Looks up 0x00 0x00 code: compares 32 positions at once with three
+ * overlapping loads, so that only exact matches are left in the mask. */
+VLC_AVX2
+static inline const uint8_t * startcode_Find_AVX2( const uint8_t *p, const uint8_t *end,
+                                                   uint8_t code )
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i last = _mm256_set1_epi8( code );
+
+    for( ; end - p >= 34; p += 32 )
+    {
+        __m256i v0 = _mm256_loadu_si256( (const __m256i *)p );
+        __m256i v1 = _mm256_loadu_si256( (const __m256i *)(p + 1) );
+        __m256i v2 = _mm256_loadu_si256( (const __m256i *)(p + 2) );
+        __m256i m = _mm256_and_si256( _mm256_cmpeq_epi8( v0, zero ),
+                                      _mm256_cmpeq_epi8( v1, zero ) );
+        m = _mm256_and_si256( m, _mm256_cmpeq_epi8( v2, last ) );
+
+        uint32_t match = _mm256_movemask_epi8( m );
+        if( match )
+            return p + stdc_trailing_zeros( match );
+    }
+
+    for( end -= 2; p < end; p++ )
+        if( p[0] == 0 && p[1] == 0 && p[2] == code )
+            return p;
+
+    return NULL;
+}
+
+VLC_AVX2
+static inline const uint8_t * startcode_FindAnnexB_AVX2( const uint8_t *p, const uint8_t *end )
+{
+    return startcode_Find_AVX2( p, end, 1 );
+}
+
+#endif
+
+#ifdef HAS_ATTRIBUTE_VECTORSIZE
+
+/* Same as the AVX2 version with the generic vectors of the compiler,
+ * for NEON and other 128-bits SIMD */
+static inline const uint8_t * startcode_Find_Vector( const uint8_t *p, const uint8_t *end,
+                                                     uint8_t code )
+{
+    const v16qu zero = { 0 };
+    const v16qu last = zero + code;
+
+    for( ; end - p >= 18; p += 16 )
+    {
+        v16qu v0, v1, v2;
+        memcpy( &v0, p, 16 );
+        memcpy( &v1, p + 1, 16 );
+        memcpy( &v2, p + 2, 16 );
+
+        __typeof__(v0 == zero) m = (v0 == zero) & (v1 == zero) & (v2 == last);
+        uint64_t match[2];
+        memcpy( match, &m, 16 );
+
+        for( unsigned i = 0; i < 2; i++ )
+            if( match[i] )
+#  ifdef WORDS_BIGENDIAN
+                return p + 8 * i + stdc_leading_zeros( match[i] ) / 8;
+#  else
+                return p + 8 * i + stdc_trailing_zeros( match[i] ) / 8;
+#  endif
+    }
+
+    for( end -= 2; p < end; p++ )
+        if( p[0] == 0 && p[1] == 0 && p[2] == code )
+            return p;
+
+    return NULL;
+}
+
+static inline const uint8_t * startcode_FindAnnexB_Vector( const uint8_t *p, const uint8_t *end )
+{
+    return startcode_Find_Vector( p, end, 1 );
+}
+
+#endif
+
 /* That code is adapted from libav's ff_avc_find_startcode_internal
  * and i believe the trick originated from
  * https://graphics.stanford.edu/~seander/bithacks.html#ZeroInWord
@@ -150,16 +237,39 @@ static inline const uint8_t * startcode_FindAnnexB_Bits( const uint8_t *p, const
 }
 #undef TRY_MATCH
 
-#ifdef CAN_COMPILE_SSE2
+#if defined(CAN_COMPILE_SSE2) || defined(CAN_COMPILE_AVX2) || \
+    (defined(__ARM_NEON) && defined(HAS_ATTRIBUTE_VECTORSIZE))
 static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint8_t *end )
 {
+#  ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        return startcode_FindAnnexB_AVX2(p, end);
+#  endif
+#  ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return startcode_FindAnnexB_SSE2(p, end);
-    else
-        return startcode_FindAnnexB_Bits(p, end);
+#  endif
+#  if defined(__ARM_NEON) && defined(HAS_ATTRIBUTE_VECTORSIZE)
+    return startcode_FindAnnexB_Vector(p, end);
+#  else
+    return startcode_FindAnnexB_Bits(p, end);
+#  endif
 }
 #else
     #define startcode_FindAnnexB startcode_FindAnnexB_Bits
 #endif
 
+/* Looks up the next 0x00 0x00 0x03 emulation prevention sequence */
+static inline const uint8_t * startcode_FindEP3B( const uint8_t *p, const uint8_t *end )
+{
+#ifdef HAS_ATTRIBUTE_VECTORSIZE
+    return startcode_Find_Vector( p, end, 3 );
+#else
+    for( end -= 2; p < end; p++ )
+        if( p[0] == 0 && p[1] == 0 && p[2] == 3 )
+            return p;
+    return NULL;
+#endif
+}
+
 #endif
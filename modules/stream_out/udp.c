@@ -22,6 +22,7 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
@@ -29,6 +30,9 @@
 #ifdef HAVE_ARPA_INET_H
 #include <arpa/inet.h>
 #endif
+#ifdef HAVE_SENDMMSG
+#include <netinet/udp.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_configuration.h>
@@ -47,6 +51,10 @@ struct sout_stream_udp
     session_descriptor_t *sap;
     int fd;
     uint_fast16_t mtu;
+    unsigned batch;
+    bool gso;
+    uint64_t datagrams;
+    uint64_t syscalls;
 };
 
 static void *
@@ -148,51 +156,211 @@ static int Control(sout_stream_t *stream, int query, va_list args)
     return VLC_SUCCESS;
 }
 
+#define UDP_IOV_MAX 16 /* I/O vectors per datagram */
+
+/**
+ * Gathers as many blocks as fit in one datagram of at most MTU bytes.
+ *
+ * \return the first block not included in the datagram
+ */
+static block_t *Gather(const struct sout_stream_udp *sys, block_t *block,
+                       struct iovec *iov, size_t *restrict iovlen,
+                       size_t *restrict len)
+{
+    size_t count = 0, tosend = 0;
+
+    do {
+        if (count >= UDP_IOV_MAX)
+            break;
+        if (block->i_buffer + tosend > sys->mtu && likely(count > 0))
+            break;
+
+        iov[count].iov_base = block->p_buffer;
+        iov[count].iov_len = block->i_buffer;
+        count++;
+        tosend += block->i_buffer;
+        block = block->p_next;
+    } while (block != NULL);
+
+    *iovlen = count;
+    *len = tosend;
+    return block;
+}
+
+static void ReleaseUntil(block_t *block, const block_t *end)
+{
+    while (block != end) {
+        block_t *next = block->p_next;
+
+        block_Release(block);
+        block = next;
+    }
+}
+
 static ssize_t AccessOutWrite(sout_access_out_t *access, block_t *block)
 {
     struct sout_stream_udp *sys = access->p_sys;
     ssize_t total = 0;
 
     while (block != NULL) {
-        struct iovec iov[16];
-        block_t *unsent = block;
-        unsigned iovlen = 0;
-        size_t tosend = 0;
-
-        /* Count how many blocks to gather */
-        do {
-            if (iovlen >= ARRAY_SIZE(iov))
-                break;
-            if (unsent->i_buffer + tosend > sys->mtu && likely(iovlen > 0))
-                break;
-
-            iov[iovlen].iov_base = unsent->p_buffer;
-            iov[iovlen].iov_len = unsent->i_buffer;
-            iovlen++;
-            tosend += unsent->i_buffer;
-            unsent = unsent->p_next;
-        } while (unsent != NULL);
+        struct iovec iov[UDP_IOV_MAX];
+        size_t iovlen, len;
+        block_t *unsent = Gather(sys, block, iov, &iovlen, &len);
 
         /* Send */
         struct msghdr hdr = { .msg_iov = iov, .msg_iovlen = iovlen };
         ssize_t val = sendmsg(sys->fd, &hdr, 0);
 
+        sys->syscalls++;
         if (val < 0)
             msg_Err(access, "send error: %s", vlc_strerror_c(errno));
-        else
+        else {
+            sys->datagrams++;
             total += val;
+        }
+
+        ReleaseUntil(block, unsent);
+        block = unsent;
+    }
 
-        /* Free */
-        do {
-            block_t *next = block->p_next;
+    return total;
+}
+
+#ifdef HAVE_SENDMMSG
+#define UDP_BATCH_MAX 64 /* messages per sendmmsg() call */
+#define UDP_GSO_SEGMENTS_MAX 64 /* UDP_MAX_SEGMENTS in Linux */
+#define UDP_GSO_SIZE_MAX 65507u /* largest IPv4 UDP payload */
+
+/*
+ * Batched output: the whole block chain is split into MTU-sized datagrams
+ * exactly as in AccessOutWrite(), but up to sys->batch of them are handed to
+ * the kernel with a single sendmmsg() call. With UDP GSO, runs of datagrams
+ * of the same size are further coalesced into a single message which the
+ * kernel (or the NIC) splits on the wire.
+ */
+static ssize_t AccessOutWriteBatch(sout_access_out_t *access, block_t *block)
+{
+    struct sout_stream_udp *sys = access->p_sys;
+    ssize_t total = 0;
+
+    while (block != NULL) {
+        struct mmsghdr msgs[UDP_BATCH_MAX];
+        struct iovec iov[UDP_BATCH_MAX * UDP_IOV_MAX];
+#ifdef UDP_SEGMENT
+        union {
+            char buf[CMSG_SPACE(sizeof (uint16_t))];
+            struct cmsghdr align;
+        } cmsg[UDP_BATCH_MAX];
+#endif
+        size_t segsize[UDP_BATCH_MAX], bytes[UDP_BATCH_MAX];
+        unsigned segs[UDP_BATCH_MAX];
+        block_t *first[UDP_BATCH_MAX];
+        block_t *unsent = block;
+        unsigned count = 0, iovcount = 0;
+        bool gso = sys->gso, open_run = false;
+
+        /* Split the chain into messages */
+        while (unsent != NULL && iovcount + UDP_IOV_MAX <= ARRAY_SIZE(iov)) {
+            size_t iovlen, len;
+            block_t *next = Gather(sys, unsent, iov + iovcount, &iovlen,
+                                   &len);
+
+            if (open_run && len <= segsize[count - 1]
+             && segs[count - 1] < UDP_GSO_SEGMENTS_MAX
+             && bytes[count - 1] + len <= UDP_GSO_SIZE_MAX) {
+                /* Append to the current GSO run; a short datagram ends it */
+                struct msghdr *hdr = &msgs[count - 1].msg_hdr;
+
+                hdr->msg_iovlen += iovlen;
+                segs[count - 1]++;
+                bytes[count - 1] += len;
+                open_run = len == segsize[count - 1];
+            } else {
+                if (count >= sys->batch)
+                    break;
+
+                struct msghdr *hdr = &msgs[count].msg_hdr;
+
+                memset(hdr, 0, sizeof (*hdr));
+                hdr->msg_iov = iov + iovcount;
+                hdr->msg_iovlen = iovlen;
+                first[count] = unsent;
+                segsize[count] = len;
+                bytes[count] = len;
+                segs[count] = 1;
+                count++;
+                open_run = gso && len > 0;
+            }
+
+            iovcount += iovlen;
+            unsent = next;
+        }
+
+#ifdef UDP_SEGMENT
+        /* Attach segment sizes to coalesced messages */
+        for (unsigned i = 0; i < count; i++) {
+            if (segs[i] <= 1)
+                continue;
+
+            struct msghdr *hdr = &msgs[i].msg_hdr;
+            struct cmsghdr *cm = &cmsg[i].align;
+
+            hdr->msg_control = cmsg[i].buf;
+            hdr->msg_controllen = sizeof (cmsg[i].buf);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof (uint16_t));
+            *(uint16_t *)CMSG_DATA(cm) = segsize[i];
+        }
+#else
+        assert(!gso); /* no runs of several segments */
+#endif
 
-            block_Release(block);
-            block = next;
-        } while (block != unsent);
+        /* Send */
+        unsigned sent = 0;
+
+        while (sent < count) {
+            int val = sendmmsg(sys->fd, msgs + sent, count - sent, 0);
+
+            sys->syscalls++;
+            if (val < 0) {
+                int errval = errno;
+
+                if (gso && segs[sent] > 1
+                 && (errval == EINVAL || errval == EIO
+                  || errval == ENOPROTOOPT)) {
+                    msg_Warn(access, "segmentation offload failed (%s), "
+                             "disabling", vlc_strerror_c(errval));
+                    sys->gso = false;
+                    break;
+                }
+
+                msg_Err(access, "send error: %s", vlc_strerror_c(errval));
+                val = 1; /* skip the failed message */
+            } else {
+                for (int i = 0; i < val; i++) {
+                    total += msgs[sent + i].msg_len;
+                    sys->datagrams += segs[sent + i];
+                }
+            }
+            sent += val;
+        }
+
+        if (sent < count) {
+            /* Resend the rest of the chain without offload */
+            assert(!sys->gso);
+            ReleaseUntil(block, first[sent]);
+            block = first[sent];
+            continue;
+        }
+
+        ReleaseUntil(block, unsent);
+        block = unsent;
     }
 
     return total;
 }
+#endif
 
 static void Close(sout_stream_t *stream)
 {
@@ -202,6 +370,8 @@ static void Close(sout_stream_t *stream)
         sout_AnnounceUnRegister(stream, sys->sap);
 
     sout_MuxDelete(sys->mux);
+    msg_Dbg(stream, "sent %"PRIu64" datagrams in %"PRIu64" system calls",
+            sys->datagrams, sys->syscalls);
     sout_AccessOutDelete(sys->access);
     net_Close(sys->fd);
     free(sys);
@@ -217,7 +387,7 @@ static const struct sout_stream_operations ops = {
 };
 
 static const char *const chain_options[] = {
-    "avformat", "dst", "sap", "name", "description", NULL
+    "avformat", "dst", "sap", "name", "description", "batch", "gso", NULL
 };
 
 #define DEFAULT_PORT 1234
@@ -315,6 +485,22 @@ static int Open(vlc_object_t *obj)
     sys->access = access;
     sys->fd = fd;
     sys->mtu = var_InheritInteger(stream, "mtu");
+    sys->batch = var_GetInteger(stream, SOUT_CFG_PREFIX "batch");
+    sys->gso = var_GetBool(stream, SOUT_CFG_PREFIX "gso");
+    sys->datagrams = 0;
+    sys->syscalls = 0;
+#ifndef UDP_SEGMENT
+    if (sys->gso) {
+        msg_Warn(stream, "UDP segmentation offload not supported");
+        sys->gso = false;
+    }
+#endif
+#ifdef HAVE_SENDMMSG
+    if (sys->batch > 1)
+        access->pf_write = AccessOutWriteBatch;
+    else
+#endif
+        sys->gso = false;
 
     sout_mux_t *mux = sout_MuxNew(access, muxmod);
     if (mux == NULL) {
@@ -353,6 +539,14 @@ error:
 #define DESC_TEXT N_("SAP description")
 #define DESC_LONGTEXT N_( \
     "Short description of the stream that will be announced with SAP.")
+#define BATCH_TEXT N_("Datagrams per system call")
+#define BATCH_LONGTEXT N_( \
+    "Maximum number of datagrams sent with a single system call. " \
+    "1 sends each datagram separately.")
+#define GSO_TEXT N_("UDP segmentation offload")
+#define GSO_LONGTEXT N_( \
+    "Let the operating system split consecutive datagrams of equal size, " \
+    "further reducing the number of system calls (Linux only).")
 
 vlc_module_begin()
     set_shortname(N_("UDP"))
@@ -366,6 +560,9 @@ vlc_module_begin()
     add_bool(SOUT_CFG_PREFIX "sap", false, SAP_TEXT, SAP_LONGTEXT)
     add_string(SOUT_CFG_PREFIX "name", "", NAME_TEXT, NAME_LONGTEXT)
     add_string(SOUT_CFG_PREFIX "description", "", DESC_TEXT, DESC_LONGTEXT)
+    add_integer_with_range(SOUT_CFG_PREFIX "batch", 32, 1, 64,
+                           BATCH_TEXT, BATCH_LONGTEXT)
+    add_bool(SOUT_CFG_PREFIX "gso", false, GSO_TEXT, GSO_LONGTEXT)
 
     set_callback(Open)
 vlc_module_end()
@@ -331,18 +331,71 @@ static int BuildTransformChain( filter_t *p_filter )
     return i_ret;
 }
 
+static int BuildChromaResizeFused( filter_t *p_filter )
+{
+    es_format_t fmt_mid;
+    int i_ret = VLC_EGENERIC;
+
+    /* Only accept single pass converters (swscale...) for the second step,
+     * doing both the conversion and the scaling: a nested chain would bring
+     * back an intermediate picture at one of the sizes. */
+    const int64_t i_level = var_GetInteger( p_filter, "chain-level" );
+    var_SetInteger( p_filter, "chain-level", CHAIN_LEVEL_MAX );
+
+    const vlc_fourcc_t *pi_allowed_chromas = get_allowed_chromas( p_filter );
+    for( int i = 0; pi_allowed_chromas[i]; i++ )
+    {
+        const vlc_fourcc_t i_chroma = pi_allowed_chromas[i];
+        if( i_chroma == p_filter->fmt_in.i_codec ||
+            i_chroma == p_filter->fmt_out.i_codec )
+            continue;
+
+        msg_Dbg( p_filter, "Trying to build chroma, then chroma+resize "
+                 "with %4.4s as middle man", (char*)&i_chroma );
+
+        es_format_Copy( &fmt_mid, &p_filter->fmt_in );
+        fmt_mid.i_codec        =
+        fmt_mid.video.i_chroma = i_chroma;
+
+        i_ret = CreateChain( p_filter, &fmt_mid );
+        es_format_Clean( &fmt_mid );
+
+        if( i_ret == VLC_SUCCESS )
+            break;
+    }
+
+    var_SetInteger( p_filter, "chain-level", i_level );
+    return i_ret;
+}
+
 static int BuildChromaResize( filter_t *p_filter )
 {
     es_format_t fmt_mid;
     int i_ret;
 
-    /* Lets try resizing and then doing the chroma conversion */
-    msg_Dbg( p_filter, "Trying to build resize+chroma" );
-    EsFormatMergeSize( &fmt_mid, &p_filter->fmt_in, &p_filter->fmt_out );
-    i_ret = CreateResizeChromaChain( p_filter, &fmt_mid );
-    es_format_Clean( &fmt_mid );
+    /* Convert the smallest of the two pictures: scale first when
+     * downscaling, convert first otherwise */
+    const bool b_downscale =
+        (uint64_t)p_filter->fmt_out.video.i_visible_width
+                * p_filter->fmt_out.video.i_visible_height
+      < (uint64_t)p_filter->fmt_in.video.i_visible_width
+                * p_filter->fmt_in.video.i_visible_height;
 
-    if( i_ret == VLC_SUCCESS )
+    if( b_downscale )
+    {
+        /* Lets try resizing and then doing the chroma conversion */
+        msg_Dbg( p_filter, "Trying to build resize+chroma" );
+        EsFormatMergeSize( &fmt_mid, &p_filter->fmt_in, &p_filter->fmt_out );
+        i_ret = CreateResizeChromaChain( p_filter, &fmt_mid );
+        es_format_Clean( &fmt_mid );
+
+        if( i_ret == VLC_SUCCESS )
+            return VLC_SUCCESS;
+    }
+
+    /* Lets try converting to a chroma that can be converted and resized at
+     * once */
+    if( BuildChromaResizeFused( p_filter ) == VLC_SUCCESS )
         return VLC_SUCCESS;
 
     /* Lets try it the other way around (chroma and then resize) */
@@ -353,6 +406,17 @@ static int BuildChromaResize( filter_t *p_filter )
     if( i_ret == VLC_SUCCESS )
         return VLC_SUCCESS;
 
+    if( !b_downscale )
+    {
+        msg_Dbg( p_filter, "Trying to build resize+chroma" );
+        EsFormatMergeSize( &fmt_mid, &p_filter->fmt_in, &p_filter->fmt_out );
+        i_ret = CreateResizeChromaChain( p_filter, &fmt_mid );
+        es_format_Clean( &fmt_mid );
+
+        if( i_ret == VLC_SUCCESS )
+            return VLC_SUCCESS;
+    }
+
     return VLC_EGENERIC;
 }
 
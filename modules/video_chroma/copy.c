@@ -35,6 +35,9 @@
 #include <assert.h>
 
 #include "copy.h"
+#ifdef CAN_COMPILE_AVX2
+# include <immintrin.h>
+#endif
 static void CopyPlane(uint8_t *dst, size_t dst_pitch,
                       const uint8_t *src, size_t src_pitch,
                       unsigned height, int bitshift);
@@ -131,6 +134,198 @@ void CopyCleanCache(copy_cache_t *cache)
 # undef vlc_CPU_SSE2
 # define vlc_CPU_SSE2() (0)
 #endif
+#if defined(COPY_TEST) && !defined(COPY_TEST_AVX2)
+# undef vlc_CPU_AVX2
+# define vlc_CPU_AVX2() (0)
+#endif
+
+#ifdef CAN_COMPILE_AVX2
+/* AVX2 variants of the copy helpers below. They are selected at run-time
+ * by the SSE functions, and work on 32/64 bytes per iteration. The cache
+ * lines are only 16 bytes aligned, hence unaligned loads and stores. */
+VLC_AVX2
+static inline __m256i AVX2_Shift(__m256i v, int bitshift, __m128i count)
+{
+    if (bitshift > 0)
+        return _mm256_srl_epi16(v, count);
+    if (bitshift < 0)
+        return _mm256_sll_epi16(v, count);
+    return v;
+}
+
+VLC_AVX2
+static void AVX2_CopyFromUswc(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *src, size_t src_pitch,
+                              unsigned width, unsigned height, int bitshift)
+{
+    const __m128i count = _mm_cvtsi32_si128(abs(bitshift));
+
+    _mm_mfence();
+
+    for (unsigned y = 0; y < height; y++) {
+        const unsigned unaligned = (-(uintptr_t)src) & 0x1f;
+        unsigned x = 0;
+
+        if (unaligned == 0 || unaligned + 64 <= width) {
+            if (unaligned != 0) {
+                __m256i v = _mm256_loadu_si256((const __m256i *)src);
+                _mm256_storeu_si256((__m256i *)dst,
+                                    AVX2_Shift(v, bitshift, count));
+                x = unaligned;
+            }
+            for (; x + 63 < width; x += 64) {
+                __m256i v0 = _mm256_stream_load_si256((const __m256i *)&src[x]);
+                __m256i v1 = _mm256_stream_load_si256((const __m256i *)&src[x + 32]);
+                _mm256_storeu_si256((__m256i *)&dst[x],
+                                    AVX2_Shift(v0, bitshift, count));
+                _mm256_storeu_si256((__m256i *)&dst[x + 32],
+                                    AVX2_Shift(v1, bitshift, count));
+            }
+        }
+        if (x < width)
+            CopyPlane(&dst[x], dst_pitch - x, &src[x], src_pitch - x, 1, bitshift);
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+
+    _mm_mfence();
+}
+
+VLC_AVX2
+static void AVX2_Copy2d(uint8_t *dst, size_t dst_pitch,
+                        const uint8_t *src, size_t src_pitch,
+                        unsigned width, unsigned height)
+{
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        if (((intptr_t)dst & 0x1f) == 0) {
+            for (; x + 63 < width; x += 64) {
+                __m256i v0 = _mm256_loadu_si256((const __m256i *)&src[x]);
+                __m256i v1 = _mm256_loadu_si256((const __m256i *)&src[x + 32]);
+                _mm256_stream_si256((__m256i *)&dst[x], v0);
+                _mm256_stream_si256((__m256i *)&dst[x + 32], v1);
+            }
+        } else {
+            for (; x + 63 < width; x += 64) {
+                __m256i v0 = _mm256_loadu_si256((const __m256i *)&src[x]);
+                __m256i v1 = _mm256_loadu_si256((const __m256i *)&src[x + 32]);
+                _mm256_storeu_si256((__m256i *)&dst[x], v0);
+                _mm256_storeu_si256((__m256i *)&dst[x + 32], v1);
+            }
+        }
+
+        for (; x < width; x++)
+            dst[x] = src[x];
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+    _mm_sfence();
+}
+
+VLC_AVX2
+static void AVX2_InterleaveUV(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *srcu, size_t srcu_pitch,
+                              const uint8_t *srcv, size_t srcv_pitch,
+                              unsigned width, unsigned height,
+                              uint8_t pixel_size)
+{
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        for (; x < (width & ~31); x += 32) {
+            __m256i u = _mm256_loadu_si256((const __m256i *)&srcu[x]);
+            __m256i v = _mm256_loadu_si256((const __m256i *)&srcv[x]);
+            __m256i lo, hi;
+
+            if (pixel_size == 1) {
+                lo = _mm256_unpacklo_epi8(u, v);
+                hi = _mm256_unpackhi_epi8(u, v);
+            } else {
+                lo = _mm256_unpacklo_epi16(u, v);
+                hi = _mm256_unpackhi_epi16(u, v);
+            }
+            /* unpack works within 128-bit lanes: put them back in order */
+            _mm256_storeu_si256((__m256i *)&dst[2*x],
+                                _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256((__m256i *)&dst[2*x + 32],
+                                _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+
+        if (pixel_size == 1) {
+            for (; x < width; x++) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcv[x];
+            }
+        } else {
+            for (; x < width; x += 2) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcu[x + 1];
+                dst[2*x+2] = srcv[x];
+                dst[2*x+3] = srcv[x + 1];
+            }
+        }
+        srcu += srcu_pitch;
+        srcv += srcv_pitch;
+        dst += dst_pitch;
+    }
+}
+
+VLC_AVX2
+static void AVX2_SplitUV(uint8_t *dstu, size_t dstu_pitch,
+                         uint8_t *dstv, size_t dstv_pitch,
+                         const uint8_t *src, size_t src_pitch,
+                         unsigned width, unsigned height, uint8_t pixel_size)
+{
+    const __m256i mask = pixel_size == 1 ? _mm256_set1_epi16(0x00ff)
+                                         : _mm256_set1_epi32(0xffff);
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        for (; x < (width & ~31); x += 32) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)&src[2*x]);
+            __m256i b = _mm256_loadu_si256((const __m256i *)&src[2*x + 32]);
+            __m256i u, v;
+
+            if (pixel_size == 1) {
+                u = _mm256_packus_epi16(_mm256_and_si256(a, mask),
+                                        _mm256_and_si256(b, mask));
+                v = _mm256_packus_epi16(_mm256_srli_epi16(a, 8),
+                                        _mm256_srli_epi16(b, 8));
+            } else {
+                u = _mm256_packus_epi32(_mm256_and_si256(a, mask),
+                                        _mm256_and_si256(b, mask));
+                v = _mm256_packus_epi32(_mm256_srli_epi32(a, 16),
+                                        _mm256_srli_epi32(b, 16));
+            }
+            /* pack works within 128-bit lanes: put them back in order */
+            _mm256_storeu_si256((__m256i *)&dstu[x],
+                                _mm256_permute4x64_epi64(u, _MM_SHUFFLE(3, 1, 2, 0)));
+            _mm256_storeu_si256((__m256i *)&dstv[x],
+                                _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+
+        if (pixel_size == 1) {
+            for (; x < width; x++) {
+                dstu[x] = src[2*x+0];
+                dstv[x] = src[2*x+1];
+            }
+        } else {
+            for (; x < width; x += 2) {
+                dstu[x] = src[2*x+0];
+                dstu[x+1] = src[2*x+1];
+                dstv[x] = src[2*x+2];
+                dstv[x+1] = src[2*x+3];
+            }
+        }
+        src  += src_pitch;
+        dstu += dstu_pitch;
+        dstv += dstv_pitch;
+    }
+}
+#endif /* CAN_COMPILE_AVX2 */
 
 /* Optimized copy from "Uncacheable Speculative Write Combining" memory
  * as used by some video surface.
@@ -143,6 +338,15 @@ static void CopyFromUswc(uint8_t *dst, size_t dst_pitch,
 {
     assert(((intptr_t)dst & 0x0f) == 0 && (dst_pitch & 0x0f) == 0);
 
+#ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+    {
+        AVX2_CopyFromUswc(dst, dst_pitch, src, src_pitch, width, height,
+                          bitshift);
+        return;
+    }
+#endif
+
     asm volatile ("mfence");
 
 #define SSE_USWC_COPY(shiftstr16, shiftstr64) \
@@ -196,7 +400,7 @@ static void CopyFromUswc(uint8_t *dst, size_t dst_pitch,
             SSE_USWC_COPY(COPY16_SHIFTR("$4"), COPY64_SHIFTR("$4"))
             break;
         case -4:
-            SSE_USWC_COPY(COPY16_SHIFTL("$2"), COPY64_SHIFTL("$2"))
+            SSE_USWC_COPY(COPY16_SHIFTL("$4"), COPY64_SHIFTL("$4"))
             break;
         default:
             vlc_assert_unreachable();
@@ -213,6 +417,14 @@ static void Copy2d(uint8_t *dst, size_t dst_pitch,
 {
     assert(((intptr_t)src & 0x0f) == 0 && (src_pitch & 0x0f) == 0);
 
+#ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+    {
+        AVX2_Copy2d(dst, dst_pitch, src, src_pitch, width, height);
+        return;
+    }
+#endif
+
     for (unsigned y = 0; y < height; y++) {
         unsigned x = 0;
 
@@ -243,6 +455,15 @@ SSE_InterleaveUV(uint8_t *dst, size_t dst_pitch,
     assert(!((intptr_t)srcu & 0xf) && !(srcu_pitch & 0x0f) &&
            !((intptr_t)srcv & 0xf) && !(srcv_pitch & 0x0f));
 
+#ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+    {
+        AVX2_InterleaveUV(dst, dst_pitch, srcu, srcu_pitch, srcv, srcv_pitch,
+                          width, height, pixel_size);
+        return;
+    }
+#endif
+
     static const uint8_t shuffle_8[] = { 0, 8,
                                          1, 9,
                                          2, 10,
@@ -358,6 +579,15 @@ static void SSE_SplitUV(uint8_t *dstu, size_t dstu_pitch,
     assert(pixel_size == 1 || pixel_size == 2);
     assert(((intptr_t)src & 0xf) == 0 && (src_pitch & 0x0f) == 0);
 
+#ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+    {
+        AVX2_SplitUV(dstu, dstu_pitch, dstv, dstv_pitch, src, src_pitch,
+                     width, height, pixel_size);
+        return;
+    }
+#endif
+
 #define LOAD64 \
     "movdqa  0(%[src]), %%xmm0\n" \
     "movdqa 16(%[src]), %%xmm1\n" \
@@ -1109,7 +1339,15 @@ int main(void)
 {
     alarm(10);
 
-#ifndef COPY_TEST_NOOPTIM
+#if defined(COPY_TEST_AVX2)
+#ifdef CAN_COMPILE_AVX2
+    if (!vlc_CPU_AVX2())
+#endif
+    {
+        fprintf(stderr, "WARNING: could not test AVX2\n");
+        return 77;
+    }
+#elif !defined(COPY_TEST_NOOPTIM)
 #ifdef CAN_COMPILE_SSE2
     if (!vlc_CPU_SSE2())
 #endif
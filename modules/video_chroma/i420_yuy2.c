@@ -293,6 +293,34 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
 #endif
 
 #elif defined(PLUGIN_SSE2)
+#if defined(CAN_COMPILE_AVX2)
+    if( vlc_CPU_AVX2() )
+    {
+        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        {
+            unsigned i_width = p_filter->fmt_in.video.i_x_offset
+                             + p_filter->fmt_in.video.i_visible_width;
+
+            p_line1 = p_line2;
+            p_line2 += p_dest->p->i_pitch;
+
+            p_y1 = p_y2;
+            p_y2 += p_source->p[Y_PLANE].i_pitch;
+
+            AVX2_CALL( p_u, p_v, false );
+            for( i_x = i_width / 2; i_x-- ; )
+            {
+                C_YUV420_YUYV( );
+            }
+
+            p_y2 += i_source_margin;
+            p_u += i_source_margin_c;
+            p_v += i_source_margin_c;
+            p_line2 += i_dest_margin;
+        }
+    }
+    else
+#endif
     /*
     ** SSE2 128 bits fetch/store instructions are faster
     ** if memory access is 16 bytes aligned
@@ -493,6 +521,34 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
 #endif
 
 #elif defined(PLUGIN_SSE2)
+#if defined(CAN_COMPILE_AVX2)
+    if( vlc_CPU_AVX2() )
+    {
+        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        {
+            unsigned i_width = p_filter->fmt_in.video.i_x_offset
+                             + p_filter->fmt_in.video.i_visible_width;
+
+            p_line1 = p_line2;
+            p_line2 += p_dest->p->i_pitch;
+
+            p_y1 = p_y2;
+            p_y2 += p_source->p[Y_PLANE].i_pitch;
+
+            AVX2_CALL( p_v, p_u, false );
+            for( i_x = i_width / 2; i_x-- ; )
+            {
+                C_YUV420_YVYU( );
+            }
+
+            p_y2 += i_source_margin;
+            p_u += i_source_margin_c;
+            p_v += i_source_margin_c;
+            p_line2 += i_dest_margin;
+        }
+    }
+    else
+#endif
     /*
     ** SSE2 128 bits fetch/store instructions are faster
     ** if memory access is 16 bytes aligned
@@ -691,6 +747,34 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
 #endif
 
 #elif defined(PLUGIN_SSE2)
+#if defined(CAN_COMPILE_AVX2)
+    if( vlc_CPU_AVX2() )
+    {
+        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        {
+            unsigned i_width = p_filter->fmt_in.video.i_x_offset
+                             + p_filter->fmt_in.video.i_visible_width;
+
+            p_line1 = p_line2;
+            p_line2 += p_dest->p->i_pitch;
+
+            p_y1 = p_y2;
+            p_y2 += p_source->p[Y_PLANE].i_pitch;
+
+            AVX2_CALL( p_u, p_v, true );
+            for( i_x = i_width / 2; i_x-- ; )
+            {
+                C_YUV420_UYVY( );
+            }
+
+            p_y2 += i_source_margin;
+            p_u += i_source_margin_c;
+            p_v += i_source_margin_c;
+            p_line2 += i_dest_margin;
+        }
+    }
+    else
+#endif
     /*
     ** SSE2 128 bits fetch/store instructions are faster
     ** if memory access is 16 bytes aligned
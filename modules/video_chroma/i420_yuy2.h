@@ -187,7 +187,7 @@ movdqu    %%xmm1, 16(%1)  # Store high UYVY                             \n\
     xmm4 = _mm_unpacklo_epi8(xmm4, xmm1);           \
     _mm_stream_si128((__m128i*)(p_line2), xmm4);    \
     xmm3 = _mm_unpackhi_epi8(xmm3, xmm1);           \
-    _mm_stream_si128((__m128i*)(p_line1+16), xmm3);
+    _mm_stream_si128((__m128i*)(p_line2+16), xmm3);
 
 #define SSE2_YUV420_YUYV_UNALIGNED                  \
     xmm1 = _mm_loadl_epi64((__m128i *)p_u);         \
@@ -206,7 +206,7 @@ movdqu    %%xmm1, 16(%1)  # Store high UYVY                             \n\
     xmm4 = _mm_unpacklo_epi8(xmm4, xmm1);           \
     _mm_storeu_si128((__m128i*)(p_line2), xmm4);    \
     xmm3 = _mm_unpackhi_epi8(xmm3, xmm1);           \
-    _mm_storeu_si128((__m128i*)(p_line1+16), xmm3);
+    _mm_storeu_si128((__m128i*)(p_line2+16), xmm3);
 
 #define SSE2_YUV420_YVYU_ALIGNED                    \
     xmm1 = _mm_loadl_epi64((__m128i *)p_v);         \
@@ -223,7 +223,7 @@ movdqu    %%xmm1, 16(%1)  # Store high UYVY                             \n\
     xmm4 = _mm_unpacklo_epi8(xmm4, xmm1);           \
     _mm_stream_si128((__m128i*)(p_line2), xmm4);    \
     xmm3 = _mm_unpackhi_epi8(xmm3, xmm1);           \
-    _mm_stream_si128((__m128i*)(p_line1+16), xmm3);
+    _mm_stream_si128((__m128i*)(p_line2+16), xmm3);
 
 #define SSE2_YUV420_YVYU_UNALIGNED                  \
     xmm1 = _mm_loadl_epi64((__m128i *)p_v);         \
@@ -242,7 +242,7 @@ movdqu    %%xmm1, 16(%1)  # Store high UYVY                             \n\
     xmm4 = _mm_unpacklo_epi8(xmm4, xmm1);           \
     _mm_storeu_si128((__m128i*)(p_line2), xmm4);    \
     xmm3 = _mm_unpackhi_epi8(xmm3, xmm1);           \
-    _mm_storeu_si128((__m128i*)(p_line1+16), xmm3);
+    _mm_storeu_si128((__m128i*)(p_line2+16), xmm3);
 
 #define SSE2_YUV420_UYVY_ALIGNED                    \
     xmm1 = _mm_loadl_epi64((__m128i *)p_u);         \
@@ -260,7 +260,7 @@ movdqu    %%xmm1, 16(%1)  # Store high UYVY                             \n\
     xmm4 = _mm_unpacklo_epi8(xmm4, xmm3);           \
     _mm_stream_si128((__m128i*)(p_line2), xmm4);    \
     xmm1 = _mm_unpackhi_epi8(xmm1, xmm3);           \
-    _mm_stream_si128((__m128i*)(p_line1+16), xmm1);
+    _mm_stream_si128((__m128i*)(p_line2+16), xmm1);
 
 #define SSE2_YUV420_UYVY_UNALIGNED                  \
     xmm1 = _mm_loadl_epi64((__m128i *)p_u);         \
@@ -280,7 +280,77 @@ movdqu    %%xmm1, 16(%1)  # Store high UYVY                             \n\
     xmm4 = _mm_unpacklo_epi8(xmm4, xmm3);           \
     _mm_storeu_si128((__m128i*)(p_line2), xmm4);    \
     xmm1 = _mm_unpackhi_epi8(xmm1, xmm3);           \
-    _mm_storeu_si128((__m128i*)(p_line1+16), xmm1);
+    _mm_storeu_si128((__m128i*)(p_line2+16), xmm1);
+
+#endif
+
+#if defined(CAN_COMPILE_AVX2)
+
+/* AVX2 intrinsics */
+
+#include <immintrin.h>
+
+/* Packs two lines, 32 pixels at a time, with p_c1/p_c2 the first and
+ * second chroma samples of each pair, and returns the count of pixels done */
+VLC_AVX2
+static inline unsigned AVX2_YUV420_Pack( uint8_t *p_line1, uint8_t *p_line2,
+                                         const uint8_t *p_y1,
+                                         const uint8_t *p_y2,
+                                         const uint8_t *p_c1,
+                                         const uint8_t *p_c2,
+                                         unsigned i_width, bool b_chroma_first )
+{
+    unsigned i_x;
+
+    for( i_x = 0; i_x + 32 <= i_width; i_x += 32 )
+    {
+        __m128i c1 = _mm_loadu_si128( (const __m128i *)&p_c1[i_x / 2] );
+        __m128i c2 = _mm_loadu_si128( (const __m128i *)&p_c2[i_x / 2] );
+        /* chroma pairs 0-7 in the low lane, 8-15 in the high lane */
+        __m256i uv = _mm256_set_m128i( _mm_unpackhi_epi8( c1, c2 ),
+                                       _mm_unpacklo_epi8( c1, c2 ) );
+        __m256i y1 = _mm256_loadu_si256( (const __m256i *)&p_y1[i_x] );
+        __m256i y2 = _mm256_loadu_si256( (const __m256i *)&p_y2[i_x] );
+        __m256i lo1, hi1, lo2, hi2;
+
+        if( b_chroma_first )
+        {
+            lo1 = _mm256_unpacklo_epi8( uv, y1 );
+            hi1 = _mm256_unpackhi_epi8( uv, y1 );
+            lo2 = _mm256_unpacklo_epi8( uv, y2 );
+            hi2 = _mm256_unpackhi_epi8( uv, y2 );
+        }
+        else
+        {
+            lo1 = _mm256_unpacklo_epi8( y1, uv );
+            hi1 = _mm256_unpackhi_epi8( y1, uv );
+            lo2 = _mm256_unpacklo_epi8( y2, uv );
+            hi2 = _mm256_unpackhi_epi8( y2, uv );
+        }
+
+        /* the low lanes hold pixels 0-15, the high lanes pixels 16-31 */
+        _mm256_storeu_si256( (__m256i *)&p_line1[2 * i_x],
+                             _mm256_permute2x128_si256( lo1, hi1, 0x20 ) );
+        _mm256_storeu_si256( (__m256i *)&p_line1[2 * i_x + 32],
+                             _mm256_permute2x128_si256( lo1, hi1, 0x31 ) );
+        _mm256_storeu_si256( (__m256i *)&p_line2[2 * i_x],
+                             _mm256_permute2x128_si256( lo2, hi2, 0x20 ) );
+        _mm256_storeu_si256( (__m256i *)&p_line2[2 * i_x + 32],
+                             _mm256_permute2x128_si256( lo2, hi2, 0x31 ) );
+    }
+    return i_x;
+}
+
+#define AVX2_CALL( p_c1, p_c2, b_chroma_first )                            \
+    do {                                                                    \
+        unsigned i_done = AVX2_YUV420_Pack( p_line1, p_line2, p_y1, p_y2,  \
+                                            p_c1, p_c2, i_width,           \
+                                            b_chroma_first );               \
+        p_line1 += 2 * i_done; p_line2 += 2 * i_done;                       \
+        p_y1 += i_done; p_y2 += i_done;                                     \
+        p_u += i_done / 2; p_v += i_done / 2;                               \
+        i_width -= i_done;                                                  \
+    } while(0)
 
 #endif
 
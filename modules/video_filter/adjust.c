@@ -104,10 +104,10 @@ typedef struct
     _Atomic float f_hue;
     _Atomic float f_saturation;
     _Atomic float f_gamma;
-    int (*pf_process_sat_hue)( picture_t *, picture_t *, int, int, int,
-                               int, int );
-    int (*pf_process_sat_hue_clip)( picture_t *, picture_t *, int, int,
-                                    int, int, int );
+    int (*pf_process_sat_hue)( picture_t *, picture_t *, unsigned, unsigned,
+                               int, int, int, int, int );
+    int (*pf_process_sat_hue_clip)( picture_t *, picture_t *, unsigned,
+                                    unsigned, int, int, int, int, int );
 } filter_sys_t;
 
 static int FloatCallback( vlc_object_t *obj, char const *varname,
@@ -221,72 +221,37 @@ static void Destroy( filter_t *p_filter )
 /*****************************************************************************
  * Run the filter on a Planar YUV picture
  *****************************************************************************/
-static void FilterPlanar( filter_t *p_filter, picture_t *p_pic, picture_t *p_outpic )
+struct planar_slices
 {
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    bool b_16bit;
     /* The full range will only be used for 10-bit */
     int pi_luma[1024];
-    int pi_gamma[1024];
-
-    filter_sys_t *p_sys = p_filter->p_sys;
-
-    bool b_16bit;
-    float f_range;
-    switch( p_filter->fmt_in.video.i_chroma )
-    {
-        CASE_PLANAR_YUV10
-            b_16bit = true;
-            f_range = 1024.f;
-            break;
-        CASE_PLANAR_YUV9
-            b_16bit = true;
-            f_range = 512.f;
-            break;
-        default:
-            b_16bit = false;
-            f_range = 256.f;
-    }
-
-    const float f_max = f_range - 1.f;
-    const unsigned i_max = f_max;
-    const int i_range = f_range;
-    const unsigned i_size = i_range;
-    const unsigned i_mid = i_range >> 1;
-
-    /* Get variables */
-    int32_t i_cont = lroundf( atomic_load_explicit( &p_sys->f_contrast, memory_order_relaxed ) * f_max );
-    int32_t i_lum = lroundf( (atomic_load_explicit( &p_sys->f_brightness, memory_order_relaxed ) - 1.f) * f_max );
-    float f_hue = atomic_load_explicit( &p_sys->f_hue, memory_order_relaxed ) * (float)(M_PI / 180.);
-    int i_sat = (int)( atomic_load_explicit( &p_sys->f_saturation, memory_order_relaxed ) * f_range );
-    float f_gamma = 1.f / atomic_load_explicit( &p_sys->f_gamma, memory_order_relaxed );
-
-    /* Contrast is a fast but kludged function, so I put this gap to be
-     * cleaner :) */
-    i_lum += i_mid - i_cont / 2;
-
-    /* Fill the gamma lookup table */
-    for( unsigned i = 0 ; i < i_size; i++ )
-    {
-        pi_gamma[ i ] = VLC_CLIP( powf(i / f_max, f_gamma) * f_max, 0, i_max );
-    }
+    int (*pf_process_sat_hue)( picture_t *, picture_t *, unsigned, unsigned,
+                               int, int, int, int, int );
+    int i_sin, i_cos, i_sat, i_x, i_y;
+};
 
-    /* Fill the luma lookup table */
-    for( unsigned i = 0 ; i < i_size; i++ )
-    {
-        pi_luma[ i ] = pi_gamma[VLC_CLIP( (int)(i_lum + i_cont * i / i_range), 0, (int) i_max )];
-    }
+static void FilterPlanarLuma( filter_t *p_filter, void *opaque,
+                              unsigned i_first, unsigned i_last )
+{
+    const struct planar_slices *ctx = opaque;
+    const picture_t *p_pic = ctx->p_pic;
+    const picture_t *p_outpic = ctx->p_outpic;
+    const int *pi_luma = ctx->pi_luma;
 
-    /*
-     * Do the Y plane
-     */
-    if ( b_16bit )
+    if ( ctx->b_16bit )
     {
         uint16_t *p_in, *p_in_end, *p_line_end;
         uint16_t *p_out;
-        p_in = (uint16_t *) p_pic->p[Y_PLANE].p_pixels;
-        p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
+        p_in = (uint16_t *) (p_pic->p[Y_PLANE].p_pixels
+                             + i_first * p_pic->p[Y_PLANE].i_pitch);
+        p_in_end = p_in + (i_last - i_first)
             * (p_pic->p[Y_PLANE].i_pitch >> 1) - 8;
 
-        p_out = (uint16_t *) p_outpic->p[Y_PLANE].p_pixels;
+        p_out = (uint16_t *) (p_outpic->p[Y_PLANE].p_pixels
+                              + i_first * p_outpic->p[Y_PLANE].i_pitch);
 
         for( ; p_in < p_in_end ; )
         {
@@ -318,11 +283,13 @@ static void FilterPlanar( filter_t *p_filter, picture_t *p_pic, picture_t *p_out
     {
         uint8_t *p_in, *p_in_end, *p_line_end;
         uint8_t *p_out;
-        p_in = p_pic->p[Y_PLANE].p_pixels;
-        p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
+        p_in = p_pic->p[Y_PLANE].p_pixels
+             + i_first * p_pic->p[Y_PLANE].i_pitch;
+        p_in_end = p_in + (i_last - i_first)
                  * p_pic->p[Y_PLANE].i_pitch - 8;
 
-        p_out = p_outpic->p[Y_PLANE].p_pixels;
+        p_out = p_outpic->p[Y_PLANE].p_pixels
+              + i_first * p_outpic->p[Y_PLANE].i_pitch;
 
         for( ; p_in < p_in_end ; )
         {
@@ -350,32 +317,102 @@ static void FilterPlanar( filter_t *p_filter, picture_t *p_pic, picture_t *p_out
                    - p_outpic->p[Y_PLANE].i_visible_pitch;
         }
     }
+    VLC_UNUSED(p_filter);
+}
+
+static void FilterPlanarChroma( filter_t *p_filter, void *opaque,
+                                unsigned i_first, unsigned i_last )
+{
+    const struct planar_slices *ctx = opaque;
+
+    /* Currently no errors are implemented in the function, if any are added
+     * check them here */
+    ctx->pf_process_sat_hue( ctx->p_pic, ctx->p_outpic, i_first, i_last,
+                             ctx->i_sin, ctx->i_cos, ctx->i_sat,
+                             ctx->i_x, ctx->i_y );
+    VLC_UNUSED(p_filter);
+}
+
+static void FilterPlanar( filter_t *p_filter, picture_t *p_pic, picture_t *p_outpic )
+{
+    struct planar_slices ctx = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+    };
+    int pi_gamma[1024];
+
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    float f_range;
+    switch( p_filter->fmt_in.video.i_chroma )
+    {
+        CASE_PLANAR_YUV10
+            ctx.b_16bit = true;
+            f_range = 1024.f;
+            break;
+        CASE_PLANAR_YUV9
+            ctx.b_16bit = true;
+            f_range = 512.f;
+            break;
+        default:
+            ctx.b_16bit = false;
+            f_range = 256.f;
+    }
+
+    const float f_max = f_range - 1.f;
+    const unsigned i_max = f_max;
+    const int i_range = f_range;
+    const unsigned i_size = i_range;
+    const unsigned i_mid = i_range >> 1;
+
+    /* Get variables */
+    int32_t i_cont = lroundf( atomic_load_explicit( &p_sys->f_contrast, memory_order_relaxed ) * f_max );
+    int32_t i_lum = lroundf( (atomic_load_explicit( &p_sys->f_brightness, memory_order_relaxed ) - 1.f) * f_max );
+    float f_hue = atomic_load_explicit( &p_sys->f_hue, memory_order_relaxed ) * (float)(M_PI / 180.);
+    int i_sat = (int)( atomic_load_explicit( &p_sys->f_saturation, memory_order_relaxed ) * f_range );
+    float f_gamma = 1.f / atomic_load_explicit( &p_sys->f_gamma, memory_order_relaxed );
+
+    /* Contrast is a fast but kludged function, so I put this gap to be
+     * cleaner :) */
+    i_lum += i_mid - i_cont / 2;
+
+    /* Fill the gamma lookup table */
+    for( unsigned i = 0 ; i < i_size; i++ )
+    {
+        pi_gamma[ i ] = VLC_CLIP( powf(i / f_max, f_gamma) * f_max, 0, i_max );
+    }
+
+    /* Fill the luma lookup table */
+    for( unsigned i = 0 ; i < i_size; i++ )
+    {
+        ctx.pi_luma[ i ] = pi_gamma[VLC_CLIP( (int)(i_lum + i_cont * i / i_range), 0, (int) i_max )];
+    }
+
+    /*
+     * Do the Y plane
+     */
+    vlc_filter_RunSlices( p_filter, p_pic->p[Y_PLANE].i_visible_lines, 1,
+                          FilterPlanarLuma, &ctx );
 
     /*
      * Do the U and V planes
      */
 
-    int i_sin = sinf(f_hue) * f_max;
-    int i_cos = cosf(f_hue) * f_max;
+    ctx.i_sin = sinf(f_hue) * f_max;
+    ctx.i_cos = cosf(f_hue) * f_max;
 
     /* pow(2, (bpp * 2) - 1) */
-    int i_x = ( cosf(f_hue) + sinf(f_hue) ) * f_range * i_mid;
-    int i_y = ( cosf(f_hue) - sinf(f_hue) ) * f_range * i_mid;
+    ctx.i_x = ( cosf(f_hue) + sinf(f_hue) ) * f_range * i_mid;
+    ctx.i_y = ( cosf(f_hue) - sinf(f_hue) ) * f_range * i_mid;
+    ctx.i_sat = i_sat;
 
     if ( i_sat > i_range )
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
+        ctx.pf_process_sat_hue = p_sys->pf_process_sat_hue_clip;
     else
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
+        ctx.pf_process_sat_hue = p_sys->pf_process_sat_hue;
+
+    vlc_filter_RunSlices( p_filter, p_pic->p[U_PLANE].i_visible_lines, 1,
+                          FilterPlanarChroma, &ctx );
 }
 
 /*****************************************************************************
@@ -496,7 +533,8 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
 
     if ( i_sat > 256 )
     {
-        if ( p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
+        if ( p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, 0,
+                                   p_pic->p->i_visible_lines, i_sin, i_cos, i_sat,
                                              i_x, i_y ) != VLC_SUCCESS )
         {
             /* Currently only one error can happen in the function, but if there
@@ -509,7 +547,8 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
     }
     else
     {
-        if ( p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
+        if ( p_sys->pf_process_sat_hue( p_pic, p_outpic, 0,
+                                   p_pic->p->i_visible_lines, i_sin, i_cos, i_sat,
                                         i_x, i_y ) != VLC_SUCCESS )
         {
             /* Currently only one error can happen in the function, but if there
@@ -74,19 +74,24 @@
  * Hue and saturation adjusting routines
  *****************************************************************************/
 
-int planar_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic, int i_sin, int i_cos,
+int planar_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic,
+                         unsigned i_first, unsigned i_last, int i_sin, int i_cos,
                          int i_sat, int i_x, int i_y )
 {
     uint8_t *p_in, *p_in_v, *p_in_end, *p_line_end;
     uint8_t *p_out, *p_out_v;
 
-    p_in = p_pic->p[U_PLANE].p_pixels;
-    p_in_v = p_pic->p[V_PLANE].p_pixels;
-    p_in_end = p_in + p_pic->p[U_PLANE].i_visible_lines
+    p_in = p_pic->p[U_PLANE].p_pixels
+         + i_first * p_pic->p[U_PLANE].i_pitch;
+    p_in_v = p_pic->p[V_PLANE].p_pixels
+           + i_first * p_pic->p[V_PLANE].i_pitch;
+    p_in_end = p_in + (i_last - i_first)
                       * p_pic->p[U_PLANE].i_pitch - 8;
 
-    p_out = p_outpic->p[U_PLANE].p_pixels;
-    p_out_v = p_outpic->p[V_PLANE].p_pixels;
+    p_out = p_outpic->p[U_PLANE].p_pixels
+          + i_first * p_outpic->p[U_PLANE].i_pitch;
+    p_out_v = p_outpic->p[V_PLANE].p_pixels
+            + i_first * p_outpic->p[V_PLANE].i_pitch;
 
     uint8_t i_u, i_v;
 
@@ -120,19 +125,24 @@ int planar_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic, int i_sin, i
     return VLC_SUCCESS;
 }
 
-int planar_sat_hue_C( picture_t * p_pic, picture_t * p_outpic, int i_sin, int i_cos,
+int planar_sat_hue_C( picture_t * p_pic, picture_t * p_outpic,
+                         unsigned i_first, unsigned i_last, int i_sin, int i_cos,
                          int i_sat, int i_x, int i_y )
 {
     uint8_t *p_in, *p_in_v, *p_in_end, *p_line_end;
     uint8_t *p_out, *p_out_v;
 
-    p_in = p_pic->p[U_PLANE].p_pixels;
-    p_in_v = p_pic->p[V_PLANE].p_pixels;
-    p_in_end = p_in + p_pic->p[U_PLANE].i_visible_lines
+    p_in = p_pic->p[U_PLANE].p_pixels
+         + i_first * p_pic->p[U_PLANE].i_pitch;
+    p_in_v = p_pic->p[V_PLANE].p_pixels
+           + i_first * p_pic->p[V_PLANE].i_pitch;
+    p_in_end = p_in + (i_last - i_first)
                       * p_pic->p[U_PLANE].i_pitch - 8;
 
-    p_out = p_outpic->p[U_PLANE].p_pixels;
-    p_out_v = p_outpic->p[V_PLANE].p_pixels;
+    p_out = p_outpic->p[U_PLANE].p_pixels
+          + i_first * p_outpic->p[U_PLANE].i_pitch;
+    p_out_v = p_outpic->p[V_PLANE].p_pixels
+            + i_first * p_outpic->p[V_PLANE].i_pitch;
 
     uint8_t i_u, i_v;
 
@@ -166,7 +176,8 @@ int planar_sat_hue_C( picture_t * p_pic, picture_t * p_outpic, int i_sin, int i_
     return VLC_SUCCESS;
 }
 
-int planar_sat_hue_clip_C_16( picture_t * p_pic, picture_t * p_outpic, int i_sin, int i_cos,
+int planar_sat_hue_clip_C_16( picture_t * p_pic, picture_t * p_outpic,
+                         unsigned i_first, unsigned i_last, int i_sin, int i_cos,
                          int i_sat, int i_x, int i_y )
 {
     uint16_t *p_in, *p_in_v, *p_in_end, *p_line_end;
@@ -185,13 +196,17 @@ int planar_sat_hue_clip_C_16( picture_t * p_pic, picture_t * p_outpic, int i_sin
             vlc_assert_unreachable();
     }
 
-    p_in = (uint16_t *) p_pic->p[U_PLANE].p_pixels;
-    p_in_v = (uint16_t *) p_pic->p[V_PLANE].p_pixels;
-    p_in_end = p_in + p_pic->p[U_PLANE].i_visible_lines
+    p_in = (uint16_t *) (p_pic->p[U_PLANE].p_pixels
+                  + i_first * p_pic->p[U_PLANE].i_pitch);
+    p_in_v = (uint16_t *) (p_pic->p[V_PLANE].p_pixels
+                  + i_first * p_pic->p[V_PLANE].i_pitch);
+    p_in_end = p_in + (i_last - i_first)
         * (p_pic->p[U_PLANE].i_pitch >> 1) - 8;
 
-    p_out = (uint16_t *) p_outpic->p[U_PLANE].p_pixels;
-    p_out_v = (uint16_t *) p_outpic->p[V_PLANE].p_pixels;
+    p_out = (uint16_t *) (p_outpic->p[U_PLANE].p_pixels
+                  + i_first * p_outpic->p[U_PLANE].i_pitch);
+    p_out_v = (uint16_t *) (p_outpic->p[V_PLANE].p_pixels
+                  + i_first * p_outpic->p[V_PLANE].i_pitch);
 
     uint16_t i_u, i_v;
 
@@ -225,7 +240,8 @@ int planar_sat_hue_clip_C_16( picture_t * p_pic, picture_t * p_outpic, int i_sin
     return VLC_SUCCESS;
 }
 
-int planar_sat_hue_C_16( picture_t * p_pic, picture_t * p_outpic, int i_sin, int i_cos,
+int planar_sat_hue_C_16( picture_t * p_pic, picture_t * p_outpic,
+                         unsigned i_first, unsigned i_last, int i_sin, int i_cos,
                             int i_sat, int i_x, int i_y )
 {
     uint16_t *p_in, *p_in_v, *p_in_end, *p_line_end;
@@ -244,13 +260,17 @@ int planar_sat_hue_C_16( picture_t * p_pic, picture_t * p_outpic, int i_sin, int
             vlc_assert_unreachable();
     }
 
-    p_in = (uint16_t *) p_pic->p[U_PLANE].p_pixels;
-    p_in_v = (uint16_t *) p_pic->p[V_PLANE].p_pixels;
-    p_in_end = (uint16_t *) p_in + p_pic->p[U_PLANE].i_visible_lines
+    p_in = (uint16_t *) (p_pic->p[U_PLANE].p_pixels
+                  + i_first * p_pic->p[U_PLANE].i_pitch);
+    p_in_v = (uint16_t *) (p_pic->p[V_PLANE].p_pixels
+                  + i_first * p_pic->p[V_PLANE].i_pitch);
+    p_in_end = p_in + (i_last - i_first)
         * (p_pic->p[U_PLANE].i_pitch >> 1) - 8;
 
-    p_out = (uint16_t *) p_outpic->p[U_PLANE].p_pixels;
-    p_out_v = (uint16_t *) p_outpic->p[V_PLANE].p_pixels;
+    p_out = (uint16_t *) (p_outpic->p[U_PLANE].p_pixels
+                  + i_first * p_outpic->p[U_PLANE].i_pitch);
+    p_out_v = (uint16_t *) (p_outpic->p[V_PLANE].p_pixels
+                  + i_first * p_outpic->p[V_PLANE].i_pitch);
 
     uint16_t i_u, i_v;
 
@@ -284,30 +304,30 @@ int planar_sat_hue_C_16( picture_t * p_pic, picture_t * p_outpic, int i_sin, int
     return VLC_SUCCESS;
 }
 
-int packed_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic, int i_sin, int i_cos,
+int packed_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic,
+                         unsigned i_first, unsigned i_last, int i_sin, int i_cos,
                          int i_sat, int i_x, int i_y )
 {
     uint8_t *p_in, *p_in_v, *p_in_end, *p_line_end;
     uint8_t *p_out, *p_out_v;
 
     int i_y_offset, i_u_offset, i_v_offset;
-    int i_visible_lines, i_pitch, i_visible_pitch;
+    int i_pitch, i_visible_pitch;
 
 
     if ( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
                               &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
         return VLC_EGENERIC;
 
-    i_visible_lines = p_pic->p->i_visible_lines;
     i_pitch = p_pic->p->i_pitch;
     i_visible_pitch = p_pic->p->i_visible_pitch;
 
-    p_in = p_pic->p->p_pixels + i_u_offset;
-    p_in_v = p_pic->p->p_pixels + i_v_offset;
-    p_in_end = p_in + i_visible_lines * i_pitch - 8 * 4;
+    p_in = p_pic->p->p_pixels + i_first * i_pitch + i_u_offset;
+    p_in_v = p_pic->p->p_pixels + i_first * i_pitch + i_v_offset;
+    p_in_end = p_in + (i_last - i_first) * i_pitch - 8 * 4;
 
-    p_out = p_outpic->p->p_pixels + i_u_offset;
-    p_out_v = p_outpic->p->p_pixels + i_v_offset;
+    p_out = p_outpic->p->p_pixels + i_first * i_pitch + i_u_offset;
+    p_out_v = p_outpic->p->p_pixels + i_first * i_pitch + i_v_offset;
 
     uint8_t i_u, i_v;
 
@@ -337,30 +357,30 @@ int packed_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic, int i_sin, i
     return VLC_SUCCESS;
 }
 
-int packed_sat_hue_C( picture_t * p_pic, picture_t * p_outpic, int i_sin,
+int packed_sat_hue_C( picture_t * p_pic, picture_t * p_outpic,
+                         unsigned i_first, unsigned i_last, int i_sin,
                       int i_cos, int i_sat, int i_x, int i_y )
 {
     uint8_t *p_in, *p_in_v, *p_in_end, *p_line_end;
     uint8_t *p_out, *p_out_v;
 
     int i_y_offset, i_u_offset, i_v_offset;
-    int i_visible_lines, i_pitch, i_visible_pitch;
+    int i_pitch, i_visible_pitch;
 
 
     if ( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
                               &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
         return VLC_EGENERIC;
 
-    i_visible_lines = p_pic->p->i_visible_lines;
     i_pitch = p_pic->p->i_pitch;
     i_visible_pitch = p_pic->p->i_visible_pitch;
 
-    p_in = p_pic->p->p_pixels + i_u_offset;
-    p_in_v = p_pic->p->p_pixels + i_v_offset;
-    p_in_end = p_in + i_visible_lines * i_pitch - 8 * 4;
+    p_in = p_pic->p->p_pixels + i_first * i_pitch + i_u_offset;
+    p_in_v = p_pic->p->p_pixels + i_first * i_pitch + i_v_offset;
+    p_in_end = p_in + (i_last - i_first) * i_pitch - 8 * 4;
 
-    p_out = p_outpic->p->p_pixels + i_u_offset;
-    p_out_v = p_outpic->p->p_pixels + i_v_offset;
+    p_out = p_outpic->p->p_pixels + i_first * i_pitch + i_u_offset;
+    p_out_v = p_outpic->p->p_pixels + i_first * i_pitch + i_v_offset;
 
     uint8_t i_u, i_v;
 
@@ -31,6 +31,8 @@
  *
  * @param p_pic Source picture
  * @param p_outpic Destination picture
+ * @param i_first First chroma row to process
+ * @param i_last Chroma row following the last row to process
  * @param i_sin Sinus value of hue
  * @param i_cos Cosinus value of hue
  * @param i_sat Saturation
@@ -42,23 +44,27 @@
  * Basic C compiler generated function for planar format, i_sat > 256
  */
 int planar_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic,
+                           unsigned i_first, unsigned i_last,
                            int i_sin, int i_cos, int i_sat, int i_x, int i_y );
 
 /**
  * Basic C compiler generated function for planar format, i_sat <= 256
  */
 int planar_sat_hue_C( picture_t * p_pic, picture_t * p_outpic,
+                      unsigned i_first, unsigned i_last,
                       int i_sin, int i_cos, int i_sat, int i_x, int i_y );
 /**
  * Basic C compiler generated function for {9,10}-bit planar format, i_sat > {512,1024}
  */
 int planar_sat_hue_clip_C_16( picture_t * p_pic, picture_t * p_outpic,
+        unsigned i_first, unsigned i_last,
         int i_sin, int i_cos, int i_sat, int i_x, int i_y );
 
 /**
  * Basic C compiler generated function for {9,10}-bit planar format, i_sat <= {512,1024}
  */
 int planar_sat_hue_C_16( picture_t * p_pic, picture_t * p_outpic,
+        unsigned i_first, unsigned i_last,
         int i_sin, int i_cos, int i_sat, int i_x, int i_y );
 
 
@@ -66,10 +72,12 @@ int planar_sat_hue_C_16( picture_t * p_pic, picture_t * p_outpic,
  * Basic C compiler generated function for packed format, i_sat > 256
  */
 int packed_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic,
+                           unsigned i_first, unsigned i_last,
                            int i_sin, int i_cos, int i_sat, int i_x, int i_y );
 
 /**
  * Basic C compiler generated function for packed format, i_sat <= 256
  */
 int packed_sat_hue_C( picture_t * p_pic, picture_t * p_outpic,
+                      unsigned i_first, unsigned i_last,
                       int i_sin, int i_cos, int i_sat, int i_x, int i_y );
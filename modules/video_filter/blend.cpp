@@ -31,17 +31,27 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#if defined(CAN_COMPILE_SSE4_1) || defined(CAN_COMPILE_AVX2)
+# include <immintrin.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
 static int  Open (filter_t *);
 static void Close(filter_t *);
 
+#define SIMD_TEXT N_("Use SIMD blending routines")
+#define SIMD_LONGTEXT N_("Use the SSE4.1/AVX2 blending routines when the " \
+    "CPU supports them, instead of the generic ones.")
+
 vlc_module_begin()
     set_description(N_("Video pictures blending"))
     set_callback_video_blending(Open, 100)
+    add_bool("blend-simd", true, SIMD_TEXT, SIMD_LONGTEXT)
 vlc_module_end()
 
 static inline unsigned div255(unsigned v)
@@ -607,6 +617,409 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
+#if defined(CAN_COMPILE_SSE4_1) || defined(CAN_COMPILE_AVX2)
+/*****************************************************************************
+ * SIMD blending of YUVA onto 4:2:0 pictures, and of RGBA onto RGBA
+ *
+ * The kernels work on 16-bit lanes with the same formulas as div255() and
+ * merge(), so that the output is identical to the generic code. Remaining
+ * pixels at the end of each line go through the generic code.
+ *****************************************************************************/
+namespace {
+
+class CPictureLines : public CPicture {
+public:
+    CPictureLines(const CPicture &cfg) : CPicture(cfg)
+    {
+    }
+    uint8_t *line(unsigned plane, unsigned row, unsigned dx,
+                  unsigned rx, unsigned ry, unsigned bytes) const
+    {
+        const plane_t *p = &picture->p[plane];
+        return &p->p_pixels[(y + row) / ry * p->i_pitch + (x + dx) / rx * bytes];
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
+};
+
+static inline void BlendPixel(uint8_t *dst, unsigned src, unsigned src_a,
+                              unsigned alpha)
+{
+    const unsigned a = div255(alpha * src_a);
+    if (a > 0)
+        merge(dst, src, a);
+}
+
+static inline void BlendPixelRGBA(uint8_t *dst, const uint8_t *src,
+                                  unsigned alpha)
+{
+    const unsigned a = div255(alpha * src[3]);
+    if (a <= 0)
+        return;
+    /* Same as CPictureRGBX::merge() with the alpha byte last */
+    for (unsigned i = 0; i < 3; i++) {
+        merge(&dst[i], src[i], 255 - dst[3]);
+        merge(&dst[i], src[i], a);
+    }
+    merge(&dst[3], 255, a);
+}
+
+#ifdef CAN_COMPILE_SSE4_1
+# define VLC_SSE4_1 __attribute__ ((__target__ ("sse4.1")))
+
+struct BlendSSE4_1 {
+    VLC_SSE4_1
+    static inline __m128i div255(__m128i v)
+    {
+        v = _mm_add_epi16(_mm_add_epi16(_mm_srli_epi16(v, 8), v),
+                          _mm_set1_epi16(1));
+        return _mm_srli_epi16(v, 8);
+    }
+    /* merge() on 16-bit lanes */
+    VLC_SSE4_1
+    static inline __m128i merge(__m128i d, __m128i s, __m128i f)
+    {
+        const __m128i nf = _mm_sub_epi16(_mm_set1_epi16(255), f);
+        return div255(_mm_add_epi16(_mm_mullo_epi16(nf, d),
+                                    _mm_mullo_epi16(s, f)));
+    }
+    VLC_SSE4_1
+    static inline __m128i merge(__m128i d, __m128i s, __m128i a, __m128i alpha)
+    {
+        return merge(d, s, div255(_mm_mullo_epi16(a, alpha)));
+    }
+    /* 16 pixels, the source and alpha being already on 16-bit lanes */
+    VLC_SSE4_1
+    static inline void store(uint8_t *dst, __m128i slo, __m128i shi,
+                             __m128i alo, __m128i ahi, __m128i alpha)
+    {
+        const __m128i d = _mm_loadu_si128((const __m128i *)dst);
+        const __m128i lo = merge(_mm_cvtepu8_epi16(d), slo, alo, alpha);
+        const __m128i hi = merge(_mm_unpackhi_epi8(d, _mm_setzero_si128()),
+                                 shi, ahi, alpha);
+        _mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(lo, hi));
+    }
+
+    VLC_SSE4_1
+    static void BlendLine(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                          unsigned width, unsigned alpha)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i va = _mm_set1_epi16(alpha);
+        unsigned x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            const __m128i s = _mm_loadu_si128((const __m128i *)&src[x]);
+            const __m128i a = _mm_loadu_si128((const __m128i *)&src_a[x]);
+            store(&dst[x], _mm_cvtepu8_epi16(s), _mm_unpackhi_epi8(s, zero),
+                  _mm_cvtepu8_epi16(a), _mm_unpackhi_epi8(a, zero), va);
+        }
+        for (; x < width; x++)
+            BlendPixel(&dst[x], src[x], src_a[x], alpha);
+    }
+    /* Blends every other source pixel */
+    VLC_SSE4_1
+    static void BlendLineSub2(uint8_t *dst, const uint8_t *src,
+                              const uint8_t *src_a, unsigned width,
+                              unsigned alpha)
+    {
+        const __m128i even = _mm_set1_epi16(0xff);
+        const __m128i va = _mm_set1_epi16(alpha);
+        unsigned x = 0;
+
+        for (; 2 * (x + 16) <= width; x += 16) {
+            const uint8_t *s = &src[2 * x], *a = &src_a[2 * x];
+            store(&dst[x],
+                  _mm_and_si128(_mm_loadu_si128((const __m128i *)&s[0]), even),
+                  _mm_and_si128(_mm_loadu_si128((const __m128i *)&s[16]), even),
+                  _mm_and_si128(_mm_loadu_si128((const __m128i *)&a[0]), even),
+                  _mm_and_si128(_mm_loadu_si128((const __m128i *)&a[16]), even),
+                  va);
+        }
+        for (; 2 * x < width; x++)
+            BlendPixel(&dst[x], src[2 * x], src_a[2 * x], alpha);
+    }
+    /* Blends every other source pixel onto interleaved chroma, the width
+     * being in source pixels */
+    VLC_SSE4_1
+    static void BlendLineSemiPlanar(uint8_t *dst, const uint8_t *src_u,
+                                    const uint8_t *src_v, const uint8_t *src_a,
+                                    unsigned width, unsigned alpha)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i even = _mm_set1_epi16(0xff);
+        const __m128i va = _mm_set1_epi16(alpha);
+        unsigned x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            const __m128i u = _mm_loadu_si128((const __m128i *)&src_u[x]);
+            const __m128i v = _mm_loadu_si128((const __m128i *)&src_v[x]);
+            __m128i a = _mm_loadu_si128((const __m128i *)&src_a[x]);
+            const __m128i s = _mm_or_si128(_mm_and_si128(u, even),
+                                           _mm_slli_epi16(v, 8));
+            a = _mm_or_si128(_mm_and_si128(a, even), _mm_slli_epi16(a, 8));
+            store(&dst[x], _mm_cvtepu8_epi16(s), _mm_unpackhi_epi8(s, zero),
+                  _mm_cvtepu8_epi16(a), _mm_unpackhi_epi8(a, zero), va);
+        }
+        for (; x < width; x += 2) {
+            BlendPixel(&dst[x + 0], src_u[x], src_a[x], alpha);
+            BlendPixel(&dst[x + 1], src_v[x], src_a[x], alpha);
+        }
+    }
+    /* 2 RGBA pixels on 16-bit lanes */
+    VLC_SSE4_1
+    static inline __m128i mergeRGBA(__m128i d, __m128i s, __m128i alpha)
+    {
+        const __m128i rgb = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+        const __m128i max = _mm_set1_epi16(255);
+        const __m128i sa = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xff), 0xff);
+        const __m128i da = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, 0xff), 0xff);
+        const __m128i a = div255(_mm_mullo_epi16(sa, alpha));
+
+        /* Blend with the destination alpha first (not on the alpha lane) */
+        __m128i r = merge(d, s, _mm_and_si128(_mm_sub_epi16(max, da), rgb));
+        /* then with the source alpha, the alpha lane tending to 255 */
+        r = merge(r, _mm_blendv_epi8(max, s, rgb), a);
+        /* Fully transparent pixels are left untouched */
+        return _mm_blendv_epi8(r, d, _mm_cmpeq_epi16(a, _mm_setzero_si128()));
+    }
+    VLC_SSE4_1
+    static void BlendLineRGBA(uint8_t *dst, const uint8_t *src, unsigned width,
+                              unsigned alpha)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i va = _mm_set1_epi16(alpha);
+        unsigned x = 0;
+
+        for (; x + 4 <= width; x += 4) {
+            const __m128i d = _mm_loadu_si128((const __m128i *)&dst[4 * x]);
+            const __m128i s = _mm_loadu_si128((const __m128i *)&src[4 * x]);
+            const __m128i lo = mergeRGBA(_mm_cvtepu8_epi16(d),
+                                         _mm_cvtepu8_epi16(s), va);
+            const __m128i hi = mergeRGBA(_mm_unpackhi_epi8(d, zero),
+                                         _mm_unpackhi_epi8(s, zero), va);
+            _mm_storeu_si128((__m128i *)&dst[4 * x], _mm_packus_epi16(lo, hi));
+        }
+        for (; x < width; x++)
+            BlendPixelRGBA(&dst[4 * x], &src[4 * x], alpha);
+    }
+};
+#endif
+
+#ifdef CAN_COMPILE_AVX2
+struct BlendAVX2 {
+    VLC_AVX2
+    static inline __m256i div255(__m256i v)
+    {
+        v = _mm256_add_epi16(_mm256_add_epi16(_mm256_srli_epi16(v, 8), v),
+                             _mm256_set1_epi16(1));
+        return _mm256_srli_epi16(v, 8);
+    }
+    VLC_AVX2
+    static inline __m256i merge(__m256i d, __m256i s, __m256i f)
+    {
+        const __m256i nf = _mm256_sub_epi16(_mm256_set1_epi16(255), f);
+        return div255(_mm256_add_epi16(_mm256_mullo_epi16(nf, d),
+                                       _mm256_mullo_epi16(s, f)));
+    }
+    VLC_AVX2
+    static inline __m256i merge(__m256i d, __m256i s, __m256i a, __m256i alpha)
+    {
+        return merge(d, s, div255(_mm256_mullo_epi16(a, alpha)));
+    }
+    VLC_AVX2
+    static inline __m256i widen_lo(__m256i v)
+    {
+        return _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v));
+    }
+    VLC_AVX2
+    static inline __m256i widen_hi(__m256i v)
+    {
+        return _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1));
+    }
+    /* Packs back 2 vectors of 16-bit lanes in order */
+    VLC_AVX2
+    static inline __m256i pack(__m256i lo, __m256i hi)
+    {
+        return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+    }
+    /* 32 pixels, the source and alpha being already on 16-bit lanes */
+    VLC_AVX2
+    static inline void store(uint8_t *dst, __m256i slo, __m256i shi,
+                             __m256i alo, __m256i ahi, __m256i alpha)
+    {
+        const __m256i d = _mm256_loadu_si256((const __m256i *)dst);
+        const __m256i lo = merge(widen_lo(d), slo, alo, alpha);
+        const __m256i hi = merge(widen_hi(d), shi, ahi, alpha);
+        _mm256_storeu_si256((__m256i *)dst, pack(lo, hi));
+    }
+
+    VLC_AVX2
+    static void BlendLine(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                          unsigned width, unsigned alpha)
+    {
+        const __m256i va = _mm256_set1_epi16(alpha);
+        unsigned x = 0;
+
+        for (; x + 32 <= width; x += 32) {
+            const __m256i s = _mm256_loadu_si256((const __m256i *)&src[x]);
+            const __m256i a = _mm256_loadu_si256((const __m256i *)&src_a[x]);
+            store(&dst[x], widen_lo(s), widen_hi(s), widen_lo(a), widen_hi(a),
+                  va);
+        }
+        for (; x < width; x++)
+            BlendPixel(&dst[x], src[x], src_a[x], alpha);
+    }
+    VLC_AVX2
+    static void BlendLineSub2(uint8_t *dst, const uint8_t *src,
+                              const uint8_t *src_a, unsigned width,
+                              unsigned alpha)
+    {
+        const __m256i even = _mm256_set1_epi16(0xff);
+        const __m256i va = _mm256_set1_epi16(alpha);
+        unsigned x = 0;
+
+        for (; 2 * (x + 32) <= width; x += 32) {
+            const uint8_t *s = &src[2 * x], *a = &src_a[2 * x];
+            store(&dst[x],
+                  _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&s[0]), even),
+                  _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&s[32]), even),
+                  _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&a[0]), even),
+                  _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&a[32]), even),
+                  va);
+        }
+        for (; 2 * x < width; x++)
+            BlendPixel(&dst[x], src[2 * x], src_a[2 * x], alpha);
+    }
+    VLC_AVX2
+    static void BlendLineSemiPlanar(uint8_t *dst, const uint8_t *src_u,
+                                    const uint8_t *src_v, const uint8_t *src_a,
+                                    unsigned width, unsigned alpha)
+    {
+        const __m256i even = _mm256_set1_epi16(0xff);
+        const __m256i va = _mm256_set1_epi16(alpha);
+        unsigned x = 0;
+
+        for (; x + 32 <= width; x += 32) {
+            const __m256i u = _mm256_loadu_si256((const __m256i *)&src_u[x]);
+            const __m256i v = _mm256_loadu_si256((const __m256i *)&src_v[x]);
+            __m256i a = _mm256_loadu_si256((const __m256i *)&src_a[x]);
+            const __m256i s = _mm256_or_si256(_mm256_and_si256(u, even),
+                                              _mm256_slli_epi16(v, 8));
+            a = _mm256_or_si256(_mm256_and_si256(a, even),
+                                _mm256_slli_epi16(a, 8));
+            store(&dst[x], widen_lo(s), widen_hi(s), widen_lo(a), widen_hi(a),
+                  va);
+        }
+        for (; x < width; x += 2) {
+            BlendPixel(&dst[x + 0], src_u[x], src_a[x], alpha);
+            BlendPixel(&dst[x + 1], src_v[x], src_a[x], alpha);
+        }
+    }
+    VLC_AVX2
+    static inline __m256i mergeRGBA(__m256i d, __m256i s, __m256i alpha)
+    {
+        const __m256i rgb = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1,
+                                             0, -1, -1, -1, 0, -1, -1, -1);
+        const __m256i max = _mm256_set1_epi16(255);
+        const __m256i sa = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xff), 0xff);
+        const __m256i da = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(d, 0xff), 0xff);
+        const __m256i a = div255(_mm256_mullo_epi16(sa, alpha));
+
+        __m256i r = merge(d, s, _mm256_and_si256(_mm256_sub_epi16(max, da), rgb));
+        r = merge(r, _mm256_blendv_epi8(max, s, rgb), a);
+        return _mm256_blendv_epi8(r, d, _mm256_cmpeq_epi16(a, _mm256_setzero_si256()));
+    }
+    VLC_AVX2
+    static void BlendLineRGBA(uint8_t *dst, const uint8_t *src, unsigned width,
+                              unsigned alpha)
+    {
+        const __m256i va = _mm256_set1_epi16(alpha);
+        unsigned x = 0;
+
+        for (; x + 8 <= width; x += 8) {
+            const __m256i d = _mm256_loadu_si256((const __m256i *)&dst[4 * x]);
+            const __m256i s = _mm256_loadu_si256((const __m256i *)&src[4 * x]);
+            const __m256i lo = mergeRGBA(widen_lo(d), widen_lo(s), va);
+            const __m256i hi = mergeRGBA(widen_hi(d), widen_hi(s), va);
+            _mm256_storeu_si256((__m256i *)&dst[4 * x], pack(lo, hi));
+        }
+        for (; x < width; x++)
+            BlendPixelRGBA(&dst[4 * x], &src[4 * x], alpha);
+    }
+};
+#endif
+
+} // namespace
+
+template <class TKernel, bool swap_uv>
+void BlendYUVAToI420(const CPicture &dst_data, const CPicture &src_data,
+                     unsigned width, unsigned height, int alpha)
+{
+    const CPictureLines src(src_data);
+    const CPictureLines dst(dst_data);
+    /* Chroma is blended where the destination pixel is co-sited */
+    const unsigned dx = dst.getX() & 1;
+    const unsigned cwidth = width - dx;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *src_a = src.line(3, y, 0, 1, 1, 1);
+
+        TKernel::BlendLine(dst.line(0, y, 0, 1, 1, 1), src.line(0, y, 0, 1, 1, 1),
+                           src_a, width, alpha);
+        if (((dst.getY() + y) & 1) || cwidth == 0)
+            continue;
+        TKernel::BlendLineSub2(dst.line(swap_uv ? 2 : 1, y, dx, 2, 2, 1),
+                               src.line(1, y, dx, 1, 1, 1), src_a + dx,
+                               cwidth, alpha);
+        TKernel::BlendLineSub2(dst.line(swap_uv ? 1 : 2, y, dx, 2, 2, 1),
+                               src.line(2, y, dx, 1, 1, 1), src_a + dx,
+                               cwidth, alpha);
+    }
+}
+
+template <class TKernel, bool swap_uv>
+void BlendYUVAToNV12(const CPicture &dst_data, const CPicture &src_data,
+                     unsigned width, unsigned height, int alpha)
+{
+    const CPictureLines src(src_data);
+    const CPictureLines dst(dst_data);
+    const unsigned dx = dst.getX() & 1;
+    const unsigned cwidth = width - dx;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *src_a = src.line(3, y, 0, 1, 1, 1);
+
+        TKernel::BlendLine(dst.line(0, y, 0, 1, 1, 1), src.line(0, y, 0, 1, 1, 1),
+                           src_a, width, alpha);
+        if (((dst.getY() + y) & 1) || cwidth == 0)
+            continue;
+        TKernel::BlendLineSemiPlanar(dst.line(1, y, dx, 2, 2, 2),
+                                     src.line(swap_uv ? 2 : 1, y, dx, 1, 1, 1),
+                                     src.line(swap_uv ? 1 : 2, y, dx, 1, 1, 1),
+                                     src_a + dx, cwidth, alpha);
+    }
+}
+
+template <class TKernel>
+void BlendRGBAToRGBA(const CPicture &dst_data, const CPicture &src_data,
+                     unsigned width, unsigned height, int alpha)
+{
+    const CPictureLines src(src_data);
+    const CPictureLines dst(dst_data);
+
+    for (unsigned y = 0; y < height; y++)
+        TKernel::BlendLineRGBA(dst.line(0, y, 0, 1, 1, 4),
+                               src.line(0, y, 0, 1, 1, 4), width, alpha);
+}
+#endif
+
 namespace {
 
 static const struct {
@@ -687,11 +1100,48 @@ static const struct {
 #undef YUV
 };
 
+#if defined(CAN_COMPILE_SSE4_1) || defined(CAN_COMPILE_AVX2)
+#ifdef CAN_COMPILE_SSE4_1
+# define SSE4_1(...) __VA_ARGS__
+#else
+# define SSE4_1(...) NULL
+#endif
+#ifdef CAN_COMPILE_AVX2
+# define AVX2(...) __VA_ARGS__
+#else
+# define AVX2(...) NULL
+#endif
+static const struct {
+    vlc_fourcc_t     dst;
+    vlc_fourcc_t     src;
+    blend_function_t sse4_1;
+    blend_function_t avx2;
+} blends_simd[] = {
+#define SIMD(csp, src, func) \
+    { csp, src, SSE4_1(func<BlendSSE4_1>), AVX2(func<BlendAVX2>) }
+#define SIMD_UV(csp, src, func, swap_uv) \
+    { csp, src, SSE4_1(func<BlendSSE4_1, swap_uv>), AVX2(func<BlendAVX2, swap_uv>) }
+
+    SIMD_UV(VLC_CODEC_I420, VLC_CODEC_YUVA, BlendYUVAToI420, false),
+    SIMD_UV(VLC_CODEC_YV12, VLC_CODEC_YUVA, BlendYUVAToI420, true),
+    SIMD_UV(VLC_CODEC_NV12, VLC_CODEC_YUVA, BlendYUVAToNV12, false),
+    SIMD_UV(VLC_CODEC_NV21, VLC_CODEC_YUVA, BlendYUVAToNV12, true),
+    SIMD(VLC_CODEC_RGBA,    VLC_CODEC_RGBA, BlendRGBAToRGBA),
+
+#undef SIMD
+#undef SIMD_UV
+};
+#undef SSE4_1
+#undef AVX2
+#endif
+
 struct filter_sys_t {
-    filter_sys_t() : blend(NULL)
+    filter_sys_t() : blend(NULL), blend_c(NULL)
     {
     }
     blend_function_t blend;
+    /* generic routine, for alpha values the SIMD ones cannot handle */
+    blend_function_t blend_c;
 };
 
 } // namespace
@@ -718,7 +1168,8 @@ static void DoBlend(filter_t *filter,
     if (width <= 0 || height <= 0 || alpha <= 0)
         return;
 
-    sys->blend(CPicture(dst, &filter->fmt_out.video,
+    blend_function_t blend = alpha <= 255 ? sys->blend : sys->blend_c;
+    blend(CPicture(dst, &filter->fmt_out.video,
                         filter->fmt_out.video.i_x_offset + x_offset,
                         filter->fmt_out.video.i_y_offset + y_offset),
                CPicture(src, &filter->fmt_in.video,
@@ -753,6 +1204,23 @@ static int Open(filter_t *filter)
         delete sys;
         return VLC_EGENERIC;
     }
+    sys->blend_c = sys->blend;
+
+#if defined(CAN_COMPILE_SSE4_1) || defined(CAN_COMPILE_AVX2)
+    if (var_InheritBool(filter, "blend-simd")) {
+        for (size_t i = 0; i < sizeof(blends_simd) / sizeof(*blends_simd); i++) {
+            if (blends_simd[i].src != src || blends_simd[i].dst != dst)
+                continue;
+            if (blends_simd[i].avx2 && vlc_CPU_AVX2()) {
+                sys->blend = blends_simd[i].avx2;
+                msg_Dbg(filter, "using AVX2 blending routine");
+            } else if (blends_simd[i].sse4_1 && vlc_CPU_SSE4_1()) {
+                sys->blend = blends_simd[i].sse4_1;
+                msg_Dbg(filter, "using SSE4.1 blending routine");
+            }
+        }
+    }
+#endif
 
     filter->ops = &filter_ops.ops;
     filter->p_sys          = sys;
@@ -224,32 +224,37 @@ static void Destroy( filter_t *p_filter )
 }
 
 /*****************************************************************************
- * Render: displays previously rendered output
+ * blendbench_CreateBlender: loads a blending module, with or without its
+ * SIMD routines
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static filter_t *blendbench_CreateBlender( filter_t *p_filter, bool b_generic )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    filter_t *p_blend;
-
-    if( p_sys->b_done )
-        return p_pic;
-
-    p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
+    filter_t *p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
     if( !p_blend )
-    {
-        picture_Release( p_pic );
         return NULL;
-    }
+
     p_blend->fmt_out.video = p_sys->p_base_image->format;
     p_blend->fmt_in.video = p_sys->p_blend_image->format;
+    if( b_generic )
+    {
+        var_Create( p_blend, "blend-simd", VLC_VAR_BOOL );
+        var_SetBool( p_blend, "blend-simd", false );
+    }
     p_blend->p_module = vlc_filter_LoadModule( p_blend, "video blending", NULL, false );
     if( !p_blend->p_module )
     {
-        picture_Release( p_pic );
         vlc_object_delete(p_blend);
         return NULL;
     }
     assert( p_blend->ops != NULL );
+    return p_blend;
+}
+
+static void blendbench_Run( filter_t *p_filter, filter_t *p_blend,
+                            const char *psz_name )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
 
     vlc_tick_t time = vlc_tick_now();
     for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
@@ -259,13 +264,83 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     }
     time = vlc_tick_now() - time;
 
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              secf_from_vlc_tick(time) );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
+    msg_Info( p_filter, "%s: blended %d images in %f sec", psz_name,
+              p_sys->i_loops, secf_from_vlc_tick(time) );
+    msg_Info( p_filter, "%s: speed is: %f images/second, %f pixels/second",
+              psz_name,
               (float) p_sys->i_loops / time * CLOCK_FREQ,
               (float) p_sys->i_loops / time * CLOCK_FREQ *
                   p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
                   p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+}
+
+/*****************************************************************************
+ * blendbench_Compare: checks that both blenders give the same output
+ *****************************************************************************/
+static bool blendbench_Compare( filter_t *p_filter, filter_t *p_blend,
+                                filter_t *p_ref )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    picture_t *p_out = picture_NewFromFormat( &p_sys->p_base_image->format );
+    picture_t *p_ref_out = picture_NewFromFormat( &p_sys->p_base_image->format );
+    bool b_same = p_out != NULL && p_ref_out != NULL;
+
+    if( b_same )
+    {
+        picture_Copy( p_out, p_sys->p_base_image );
+        picture_Copy( p_ref_out, p_sys->p_base_image );
+        filter_Blend( p_blend, p_out, 0, 0, p_sys->p_blend_image,
+                      p_sys->i_alpha );
+        filter_Blend( p_ref, p_ref_out, 0, 0, p_sys->p_blend_image,
+                      p_sys->i_alpha );
+
+        for( int i = 0; i < p_out->i_planes && b_same; i++ )
+        {
+            const plane_t *p = &p_out->p[i], *r = &p_ref_out->p[i];
+            for( int y = 0; y < p->i_visible_lines && b_same; y++ )
+                b_same = !memcmp( &p->p_pixels[y * p->i_pitch],
+                                  &r->p_pixels[y * r->i_pitch],
+                                  p->i_visible_pitch );
+        }
+    }
+
+    if( p_out )
+        picture_Release( p_out );
+    if( p_ref_out )
+        picture_Release( p_ref_out );
+    return b_same;
+}
+
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    filter_t *p_blend, *p_ref;
+
+    if( p_sys->b_done )
+        return p_pic;
+
+    p_blend = blendbench_CreateBlender( p_filter, false );
+    if( !p_blend )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    /* The generic routines are used as the reference */
+    p_ref = blendbench_CreateBlender( p_filter, true );
+    if( p_ref )
+    {
+        if( blendbench_Compare( p_filter, p_blend, p_ref ) )
+            msg_Info( p_filter, "Output matches the generic blending" );
+        else
+            msg_Err( p_filter, "Output differs from the generic blending" );
+        blendbench_Run( p_filter, p_ref, "Generic" );
+        vlc_filter_Delete( p_ref );
+    }
+    blendbench_Run( p_filter, p_blend, "Default" );
 
     vlc_filter_Delete( p_blend );
 
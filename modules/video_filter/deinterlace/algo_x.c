@@ -29,6 +29,7 @@
 #include <vlc_common.h>
 #include <vlc_cpu.h>
 #include <vlc_picture.h>
+#include <vlc_filter.h>
 
 #include "deinterlace.h" /* filter_sys_t */
 
@@ -295,9 +296,39 @@ static inline void XDeintBand8x8C( uint8_t *dst, int i_dst,
  * Public functions
  *****************************************************************************/
 
-int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+struct x_slices
+{
+    picture_t *p_outpic;
+    picture_t *p_pic;
+    int i_plane;
+};
+
+/* Processes the 8-line bands [first, last) of one plane */
+static void RenderXBands( filter_t *p_filter, void *opaque,
+                          unsigned first, unsigned last )
 {
     VLC_UNUSED(p_filter);
+    const struct x_slices *ctx = opaque;
+    const plane_t *p_dst = &ctx->p_outpic->p[ctx->i_plane];
+    const plane_t *p_src = &ctx->p_pic->p[ctx->i_plane];
+
+    const int i_mbx = p_dst->i_visible_pitch/8;
+    const int i_modx = p_dst->i_visible_pitch - 8*i_mbx;
+
+    const int i_dst = p_dst->i_pitch;
+    const int i_src = p_src->i_pitch;
+
+    for( unsigned y = first; y < last; y++ )
+    {
+        uint8_t *dst = &p_dst->p_pixels[8*y*i_dst];
+        uint8_t *src = &p_src->p_pixels[8*y*i_src];
+
+        XDeintBand8x8C( dst, i_dst, src, i_src, i_mbx, i_modx );
+    }
+}
+
+int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+{
     int i_plane;
 
     /* Copy image and skip lines */
@@ -312,15 +343,14 @@ int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
         const int i_dst = p_outpic->p[i_plane].i_pitch;
         const int i_src = p_pic->p[i_plane].i_pitch;
 
-        int y, x;
+        int y = i_mby, x;
 
-        for( y = 0; y < i_mby; y++ )
-        {
-            uint8_t *dst = &p_outpic->p[i_plane].p_pixels[8*y*i_dst];
-            uint8_t *src = &p_pic->p[i_plane].p_pixels[8*y*i_src];
-
-            XDeintBand8x8C( dst, i_dst, src, i_src, i_mbx, i_modx );
-        }
+        /* The bands are independent from each other */
+        struct x_slices ctx = {
+            .p_outpic = p_outpic, .p_pic = p_pic, .i_plane = i_plane,
+        };
+        if( i_mby > 0 )
+            vlc_filter_RunSlices( p_filter, i_mby, 1, RenderXBands, &ctx );
 
         /* Last line (C only)*/
         if( i_mody )
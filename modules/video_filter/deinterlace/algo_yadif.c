@@ -46,6 +46,65 @@
    Necessary preprocessor macros are defined in common.h. */
 #include "yadif.h"
 
+struct yadif_slices
+{
+    void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
+                   int w, int prefs, int mrefs, int parity, int mode);
+    const plane_t *prevp, *curp, *nextp;
+    plane_t *dstp;
+    int i_field;
+    int parity;
+};
+
+/* Renders the lines [first + 1, last + 1) of one plane */
+static void RenderYadifLines( filter_t *p_filter, void *opaque,
+                              unsigned first, unsigned last )
+{
+    VLC_UNUSED(p_filter);
+    const struct yadif_slices *ctx = opaque;
+    const plane_t *prevp = ctx->prevp;
+    const plane_t *curp  = ctx->curp;
+    const plane_t *nextp = ctx->nextp;
+    plane_t *dstp        = ctx->dstp;
+    /* The line filters count pixels, not bytes */
+    const int i_width = dstp->i_visible_pitch / dstp->i_pixel_pitch;
+
+    for( int y = first + 1; y < (int)last + 1; y++ )
+    {
+        if( (y % 2) == ctx->i_field  ||  ctx->parity == 2 )
+        {
+            memcpy( &dstp->p_pixels[y * dstp->i_pitch],
+                        &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
+        }
+        else
+        {
+            int mode;
+            /* Spatial checks only when enough data */
+            mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
+
+            ctx->filter( &dstp->p_pixels[y * dstp->i_pitch],
+                         &prevp->p_pixels[y * prevp->i_pitch],
+                         &curp->p_pixels[y * curp->i_pitch],
+                         &nextp->p_pixels[y * nextp->i_pitch],
+                         i_width,
+                         y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
+                         y  - 1  ?  -curp->i_pitch : curp->i_pitch,
+                         ctx->parity,
+                         mode );
+        }
+
+        /* We duplicate the first and last lines */
+        if( y == 1 )
+            memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
+                       &dstp->p_pixels[ y    * dstp->i_pitch],
+                       dstp->i_pitch);
+        else if( y == dstp->i_visible_lines - 2 )
+            memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
+                       &dstp->p_pixels[ y    * dstp->i_pitch],
+                       dstp->i_pitch);
+    }
+}
+
 int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src )
 {
     return RenderYadif( p_filter, p_dst, p_src, 0, 0 );
@@ -108,65 +167,49 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
     /* Filter if we have all the pictures we need */
     if( p_prev && p_cur && p_next )
     {
-        /* */
-        void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
-                       int w, int prefs, int mrefs, int parity, int mode);
+        struct yadif_slices ctx = {
+            .i_field = i_field,
+            .parity = yadif_parity,
+        };
 
+        if( p_sys->chroma->pixel_size == 2 )
+        {
+#if defined(CAN_COMPILE_AVX2)
+            if( vlc_CPU_AVX2() )
+                ctx.filter = yadif_filter_line_avx2_16bit;
+            else
+#endif
+                ctx.filter = yadif_filter_line_c_16bit;
+        }
+        else
+#if defined(CAN_COMPILE_AVX2)
+        if( vlc_CPU_AVX2() )
+            ctx.filter = yadif_filter_line_avx2;
+        else
+#endif
 #if defined(HAVE_X86ASM)
         if( vlc_CPU_SSSE3() )
-            filter = vlcpriv_yadif_filter_line_ssse3;
+            ctx.filter = vlcpriv_yadif_filter_line_ssse3;
         else
         if( vlc_CPU_SSE2() )
-            filter = vlcpriv_yadif_filter_line_sse2;
+            ctx.filter = vlcpriv_yadif_filter_line_sse2;
         else
 #endif
-            filter = yadif_filter_line_c;
-
-        if( p_sys->chroma->pixel_size == 2 )
-            filter = yadif_filter_line_c_16bit;
+            ctx.filter = yadif_filter_line_c;
 
         for( int n = 0; n < p_dst->i_planes; n++ )
         {
-            const plane_t *prevp = &p_prev->p[n];
-            const plane_t *curp  = &p_cur->p[n];
-            const plane_t *nextp = &p_next->p[n];
-            plane_t *dstp        = &p_dst->p[n];
-
-            for( int y = 1; y < dstp->i_visible_lines - 1; y++ )
-            {
-                if( (y % 2) == i_field  ||  yadif_parity == 2 )
-                {
-                    memcpy( &dstp->p_pixels[y * dstp->i_pitch],
-                                &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
-                }
-                else
-                {
-                    int mode;
-                    /* Spatial checks only when enough data */
-                    mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
-
-                    assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
-                    filter( &dstp->p_pixels[y * dstp->i_pitch],
-                            &prevp->p_pixels[y * prevp->i_pitch],
-                            &curp->p_pixels[y * curp->i_pitch],
-                            &nextp->p_pixels[y * nextp->i_pitch],
-                            dstp->i_visible_pitch,
-                            y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
-                            y  - 1  ?  -curp->i_pitch : curp->i_pitch,
-                            yadif_parity,
-                            mode );
-                }
-
-                /* We duplicate the first and last lines */
-                if( y == 1 )
-                    memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-                else if( y == dstp->i_visible_lines - 2 )
-                    memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-            }
+            ctx.prevp = &p_prev->p[n];
+            ctx.curp  = &p_cur->p[n];
+            ctx.nextp = &p_next->p[n];
+            ctx.dstp  = &p_dst->p[n];
+
+            assert( ctx.prevp->i_pitch == ctx.curp->i_pitch &&
+                    ctx.curp->i_pitch == ctx.nextp->i_pitch );
+            /* Lines are independent: filter bands of lines in parallel */
+            if( ctx.dstp->i_visible_lines > 2 )
+                vlc_filter_RunSlices( p_filter, ctx.dstp->i_visible_lines - 2,
+                                      2, RenderYadifLines, &ctx );
         }
 
         p_sys->context.i_frame_offset = 1; /* p_cur will be rendered at next frame, too */
@@ -93,6 +93,154 @@ static void yadif_filter_line_c_16bit(uint8_t *dst8, uint8_t *prev8, uint8_t *cu
     FILTER
 }
 
+#ifdef CAN_COMPILE_AVX2
+#include <immintrin.h>
+
+/* Same as FILTER, on 16 (8-bit) or 8 (16-bit) pixels at a time, widened to
+ * 16-bit or 32-bit lanes respectively. */
+#define AVX2_OP_(op, bits) _mm256_##op##_epi##bits
+#define AVX2_OP(op, bits) AVX2_OP_(op, bits)
+
+#define AVX2_CHECK(j, mask) \
+    { \
+        __m256i score = AVX2_OP(add, BITS)(AVX2_OP(add, BITS)( \
+            AVX2_OP(abs, BITS)(AVX2_OP(sub, BITS)( \
+                LOAD(&cur[mrefs-1+(j)]), LOAD(&cur[prefs-1-(j)]))), \
+            AVX2_OP(abs, BITS)(AVX2_OP(sub, BITS)( \
+                LOAD(&cur[mrefs  +(j)]), LOAD(&cur[prefs  -(j)])))), \
+            AVX2_OP(abs, BITS)(AVX2_OP(sub, BITS)( \
+                LOAD(&cur[mrefs+1+(j)]), LOAD(&cur[prefs+1-(j)])))); \
+        mask = _mm256_and_si256(mask, \
+                                AVX2_OP(cmpgt, BITS)(spatial_score, score)); \
+        spatial_score = _mm256_blendv_epi8(spatial_score, score, mask); \
+        spatial_pred = _mm256_blendv_epi8(spatial_pred, \
+            AVX2_OP(srai, BITS)(AVX2_OP(add, BITS)( \
+                LOAD(&cur[mrefs+(j)]), LOAD(&cur[prefs-(j)])), 1), mask); \
+    }
+
+#define AVX2_FILTER \
+    for (x = 0; x + STEP <= w; x += STEP) { \
+        const __m256i ones = AVX2_OP(set1, BITS)(1); \
+        __m256i c = LOAD(&cur[mrefs]); \
+        __m256i d = AVX2_OP(srai, BITS)(AVX2_OP(add, BITS)( \
+                        LOAD(prev2), LOAD(next2)), 1); \
+        __m256i e = LOAD(&cur[prefs]); \
+        __m256i temporal_diff0 = AVX2_OP(abs, BITS)(AVX2_OP(sub, BITS)( \
+                                     LOAD(prev2), LOAD(next2))); \
+        __m256i temporal_diff1 = AVX2_OP(srai, BITS)(AVX2_OP(add, BITS)( \
+            AVX2_OP(abs, BITS)(AVX2_OP(sub, BITS)(LOAD(&prev[mrefs]), c)), \
+            AVX2_OP(abs, BITS)(AVX2_OP(sub, BITS)(LOAD(&prev[prefs]), e))), 1); \
+        __m256i temporal_diff2 = AVX2_OP(srai, BITS)(AVX2_OP(add, BITS)( \
+            AVX2_OP(abs, BITS)(AVX2_OP(sub, BITS)(LOAD(&next[mrefs]), c)), \
+            AVX2_OP(abs, BITS)(AVX2_OP(sub, BITS)(LOAD(&next[prefs]), e))), 1); \
+        __m256i diff = AVX2_OP(max, BITS)(AVX2_OP(max, BITS)( \
+            AVX2_OP(srai, BITS)(temporal_diff0, 1), temporal_diff1), \
+            temporal_diff2); \
+        __m256i spatial_pred = AVX2_OP(srai, BITS)( \
+                                   AVX2_OP(add, BITS)(c, e), 1); \
+        __m256i spatial_score = AVX2_OP(sub, BITS)(AVX2_OP(add, BITS)( \
+            AVX2_OP(add, BITS)( \
+                AVX2_OP(abs, BITS)(AVX2_OP(sub, BITS)( \
+                    LOAD(&cur[mrefs-1]), LOAD(&cur[prefs-1]))), \
+                AVX2_OP(abs, BITS)(AVX2_OP(sub, BITS)(c, e))), \
+            AVX2_OP(abs, BITS)(AVX2_OP(sub, BITS)( \
+                LOAD(&cur[mrefs+1]), LOAD(&cur[prefs+1])))), ones); \
+        __m256i mask; \
+ \
+        /* CHECK(-2) only applies where CHECK(-1) did, and so on */ \
+        mask = _mm256_set1_epi8(-1); \
+        AVX2_CHECK(-1, mask) AVX2_CHECK(-2, mask) \
+        mask = _mm256_set1_epi8(-1); \
+        AVX2_CHECK( 1, mask) AVX2_CHECK( 2, mask) \
+ \
+        if (mode < 2) { \
+            __m256i b = AVX2_OP(srai, BITS)(AVX2_OP(add, BITS)( \
+                LOAD(&prev2[2*mrefs]), LOAD(&next2[2*mrefs])), 1); \
+            __m256i f = AVX2_OP(srai, BITS)(AVX2_OP(add, BITS)( \
+                LOAD(&prev2[2*prefs]), LOAD(&next2[2*prefs])), 1); \
+            __m256i de = AVX2_OP(sub, BITS)(d, e); \
+            __m256i dc = AVX2_OP(sub, BITS)(d, c); \
+            __m256i bc = AVX2_OP(sub, BITS)(b, c); \
+            __m256i fe = AVX2_OP(sub, BITS)(f, e); \
+            __m256i max = AVX2_OP(max, BITS)(AVX2_OP(max, BITS)(de, dc), \
+                                             AVX2_OP(min, BITS)(bc, fe)); \
+            __m256i min = AVX2_OP(min, BITS)(AVX2_OP(min, BITS)(de, dc), \
+                                             AVX2_OP(max, BITS)(bc, fe)); \
+ \
+            diff = AVX2_OP(max, BITS)(AVX2_OP(max, BITS)(diff, min), \
+                AVX2_OP(sub, BITS)(_mm256_setzero_si256(), max)); \
+        } \
+ \
+        /* diff is never negative */ \
+        spatial_pred = AVX2_OP(min, BITS)(spatial_pred, \
+                                          AVX2_OP(add, BITS)(d, diff)); \
+        spatial_pred = AVX2_OP(max, BITS)(spatial_pred, \
+                                          AVX2_OP(sub, BITS)(d, diff)); \
+ \
+        STORE(dst, spatial_pred); \
+ \
+        dst += STEP; \
+        cur += STEP; \
+        prev += STEP; \
+        next += STEP; \
+        prev2 += STEP; \
+        next2 += STEP; \
+    }
+
+VLC_AVX2
+static void yadif_filter_line_avx2(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    int x;
+    uint8_t *prev2= parity ? prev : cur ;
+    uint8_t *next2= parity ? cur  : next;
+#define BITS 16
+#define STEP 16
+#define LOAD(p) _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+#define STORE(p, v) \
+    _mm_storeu_si128((__m128i *)(p), \
+                     _mm_packus_epi16(_mm256_castsi256_si128(v), \
+                                      _mm256_extracti128_si256(v, 1)))
+    AVX2_FILTER
+#undef STORE
+#undef LOAD
+#undef STEP
+#undef BITS
+    /* Remaining pixels */
+    if (x < w)
+        yadif_filter_line_c(dst, prev, cur, next, w - x, prefs, mrefs,
+                            parity, mode);
+}
+
+VLC_AVX2
+static void yadif_filter_line_avx2_16bit(uint8_t *dst8, uint8_t *prev8, uint8_t *cur8, uint8_t *next8, int w, int prefs, int mrefs, int parity, int mode) {
+    uint16_t *dst = (uint16_t *)dst8;
+    uint16_t *prev = (uint16_t *)prev8;
+    uint16_t *cur = (uint16_t *)cur8;
+    uint16_t *next = (uint16_t *)next8;
+    int x;
+    uint16_t *prev2= parity ? prev : cur ;
+    uint16_t *next2= parity ? cur  : next;
+    mrefs /= 2;
+    prefs /= 2;
+#define BITS 32
+#define STEP 8
+#define LOAD(p) _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(p)))
+#define STORE(p, v) \
+    _mm_storeu_si128((__m128i *)(p), \
+                     _mm_packus_epi32(_mm256_castsi256_si128(v), \
+                                      _mm256_extracti128_si256(v, 1)))
+    AVX2_FILTER
+#undef STORE
+#undef LOAD
+#undef STEP
+#undef BITS
+    /* Remaining pixels */
+    if (x < w)
+        yadif_filter_line_c_16bit((uint8_t *)dst, (uint8_t *)prev,
+                                  (uint8_t *)cur, (uint8_t *)next, w - x,
+                                  2 * prefs, 2 * mrefs, parity, mode);
+}
+#endif
+
 #if defined(__i386__) || defined(__x86_64__)
 void vlcpriv_yadif_filter_line_ssse3(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode);
 void vlcpriv_yadif_filter_line_sse2(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode);
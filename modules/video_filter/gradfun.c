@@ -100,6 +100,7 @@ typedef struct
     int              radius;
     const vlc_chroma_description_t *chroma;
     struct vf_priv_s cfg;
+    size_t           buf_size; /* per plane, in elements */
 } filter_sys_t;
 
 static int Open(filter_t *filter)
@@ -124,6 +125,7 @@ static int Open(filter_t *filter)
     var_AddCallback(filter, CFG_PREFIX "strength", Callback, NULL);
     var_AddCallback(filter, CFG_PREFIX "radius",   Callback, NULL);
     sys->cfg.buf = NULL;
+    sys->buf_size = 0;
 
     struct vf_priv_s *cfg = &sys->cfg;
     cfg->thresh      = 0.0;
@@ -158,6 +160,40 @@ static void Close(filter_t *filter)
     free(sys);
 }
 
+struct gradfun_slices
+{
+    filter_sys_t *sys;
+    picture_t *src, *dst;
+};
+
+static void FilterPlanes(filter_t *filter, void *opaque,
+                         unsigned first, unsigned last)
+{
+    const struct gradfun_slices *ctx = opaque;
+    filter_sys_t *sys = ctx->sys;
+    const video_format_t *fmt = &filter->fmt_in.video;
+
+    for (unsigned i = first; i < last; i++) {
+        const plane_t *srcp = &ctx->src->p[i];
+        plane_t       *dstp = &ctx->dst->p[i];
+        struct vf_priv_s cfg = sys->cfg;
+
+        const vlc_chroma_description_t *chroma = sys->chroma;
+        int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
+        int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
+        int r = (cfg.radius  * chroma->p[i].w.num / chroma->p[i].w.den +
+                 cfg.radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
+        r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
+        if (__MIN(w, h) > 2 * r && cfg.buf) {
+            cfg.buf += i * sys->buf_size;
+            filter_plane(&cfg, dstp->p_pixels, srcp->p_pixels,
+                         w, h, dstp->i_pitch, srcp->i_pitch, r);
+        } else {
+            plane_CopyPixels(dstp, srcp);
+        }
+    }
+}
+
 static void Filter(filter_t *filter, picture_t *src, picture_t *dst)
 {
     filter_sys_t *sys = filter->p_sys;
@@ -173,27 +209,19 @@ static void Filter(filter_t *filter, picture_t *src, picture_t *dst)
     cfg->thresh = (1 << 15) / strength;
     if (cfg->radius != radius) {
         cfg->radius = radius;
-        cfg->buf    = aligned_alloc(16,
-                                   (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32) * sizeof(*cfg->buf));
+        /* One buffer per plane, so that the planes can be filtered in
+         * parallel; keep each of them 16-bytes aligned */
+        sys->buf_size = (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2
+                         + 32 + 7) & ~7;
+        aligned_free(cfg->buf);
+        cfg->buf    = aligned_alloc(16, sys->buf_size * sys->chroma->plane_count
+                                        * sizeof(*cfg->buf));
     }
 
-    for (int i = 0; i < dst->i_planes; i++) {
-        const plane_t *srcp = &src->p[i];
-        plane_t       *dstp = &dst->p[i];
-
-        const vlc_chroma_description_t *chroma = sys->chroma;
-        int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
-        int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
-        int r = (cfg->radius  * chroma->p[i].w.num / chroma->p[i].w.den +
-                 cfg->radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
-        r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
-        if (__MIN(w, h) > 2 * r && cfg->buf) {
-            filter_plane(cfg, dstp->p_pixels, srcp->p_pixels,
-                         w, h, dstp->i_pitch, srcp->i_pitch, r);
-        } else {
-            plane_CopyPixels(dstp, srcp);
-        }
-    }
+    /* The blur of each plane is computed with running sums over the rows,
+     * so the planes are processed in parallel rather than slices of rows */
+    struct gradfun_slices ctx = { .sys = sys, .src = src, .dst = dst };
+    vlc_filter_RunSlices(filter, dst->i_planes, 1, FilterPlanes, &ctx);
 }
 
 static int Callback(vlc_object_t *object, char const *cmd,
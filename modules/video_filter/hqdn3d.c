@@ -89,6 +89,7 @@ typedef struct
 {
     const vlc_chroma_description_t *chroma;
     int w[3], h[3];
+    int wmax;
 
     struct vf_priv_s cfg;
     bool   b_recalc_coefs;
@@ -135,7 +136,10 @@ static int Open(filter_t *filter)
         if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
     }
-    cfg->Line = malloc(wmax*sizeof(unsigned int));
+    /* One line buffer per plane, so that the planes can be denoised in
+     * parallel */
+    sys->wmax = wmax;
+    cfg->Line = malloc(3*wmax*sizeof(unsigned int));
     if (!cfg->Line) {
         free(sys);
         return VLC_ENOMEM;
@@ -191,6 +195,34 @@ static void Close(filter_t *filter)
 /*****************************************************************************
  * Filter
  *****************************************************************************/
+struct denoise_slices
+{
+    filter_sys_t *sys;
+    picture_t *src, *dst;
+};
+
+/* The planes are denoised independently, but the recursive vertical
+ * filter of each plane cannot be split in slices of rows */
+static void DenoisePlanes(filter_t *filter, void *opaque,
+                          unsigned first, unsigned last)
+{
+    const struct denoise_slices *ctx = opaque;
+    filter_sys_t *sys = ctx->sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+
+    for (unsigned i = first; i < last; i++) {
+        const int spat = i == 0 ? 0 : 2;
+
+        deNoise(ctx->src->p[i].p_pixels, ctx->dst->p[i].p_pixels,
+                &cfg->Line[i * sys->wmax], &cfg->Frame[i], sys->w[i], sys->h[i],
+                ctx->src->p[i].i_pitch, ctx->dst->p[i].i_pitch,
+                cfg->Coefs[spat],
+                cfg->Coefs[spat],
+                cfg->Coefs[spat + 1]);
+    }
+    VLC_UNUSED(filter);
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     picture_t *dst;
@@ -220,24 +252,8 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     }
     vlc_mutex_unlock( &sys->coefs_mutex );
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
+    struct denoise_slices ctx = { .sys = sys, .src = src, .dst = dst };
+    vlc_filter_RunSlices(filter, 3, 1, DenoisePlanes, &ctx);
 
     if(unlikely(!cfg->Frame[0] || !cfg->Frame[1] || !cfg->Frame[2]))
     {
@@ -154,6 +154,7 @@ static void Destroy( filter_t *p_filter )
 #define IS_YUV_420_10BITS(fmt) (fmt == VLC_CODEC_I420_10L ||    \
                                 fmt == VLC_CODEC_I420_10B)
 
+/* Processes the luma rows [first, last) */
 #define SHARPEN_FRAME(maxval, data_t)                                   \
     do                                                                  \
     {                                                                   \
@@ -163,11 +164,22 @@ static void Destroy( filter_t *p_filter )
         const unsigned data_sz = sizeof(data_t);                        \
         const int i_src_line_len = p_pic->p[Y_PLANE].i_pitch / data_sz; \
         const int i_out_line_len = p_outpic->p[Y_PLANE].i_pitch / data_sz; \
-        const int sigma = atomic_load(&p_sys->sigma);         \
+        const int sigma = ctx->sigma;                                   \
                                                                         \
-        memcpy(p_out, p_src, i_visible_pitch);                          \
+        if( first == 0 )                                                \
+        {                                                               \
+            memcpy(p_out, p_src, i_visible_pitch);                      \
+            first = 1;                                                  \
+        }                                                               \
+        if( last == i_visible_lines )                                   \
+        {                                                               \
+            memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],      \
+                   &p_src[(i_visible_lines - 1) * i_src_line_len],      \
+                   i_visible_pitch);                                    \
+            last = i_visible_lines - 1;                                 \
+        }                                                               \
                                                                         \
-        for( unsigned i = 1; i < i_visible_lines - 1; i++ )             \
+        for( unsigned i = first; i < last; i++ )                        \
         {                                                               \
             p_out[i * i_out_line_len] = p_src[i * i_src_line_len];      \
                                                                         \
@@ -194,24 +206,45 @@ static void Destroy( filter_t *p_filter )
             p_out[i * i_out_line_len + i_visible_pitch / data_sz - 1] = \
                 p_src[i * i_src_line_len + i_visible_pitch / data_sz - 1];  \
         }                                                               \
-        memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],          \
-               &p_src[(i_visible_lines - 1) * i_src_line_len],          \
-               i_visible_pitch);                                        \
     } while (0)
 
-static void Filter( filter_t *p_filter, picture_t *p_pic, picture_t *p_outpic )
+struct sharpen_slices
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    int sigma;
+};
+
+static void FilterSlice( filter_t *p_filter, void *opaque,
+                         unsigned first, unsigned last )
 {
+    const struct sharpen_slices *ctx = opaque;
+    picture_t *p_pic = ctx->p_pic;
+    picture_t *p_outpic = ctx->p_outpic;
     const int v1 = -1;
     const int v2 = 3; /* 2^3 = 8 */
     const unsigned i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
     const unsigned i_visible_pitch = p_pic->p[Y_PLANE].i_visible_pitch;
 
-    filter_sys_t *p_sys = p_filter->p_sys;
-
     if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
         SHARPEN_FRAME(255, uint8_t);
     else
         SHARPEN_FRAME(1023, uint16_t);
+    VLC_UNUSED(p_filter);
+}
+
+static void Filter( filter_t *p_filter, picture_t *p_pic, picture_t *p_outpic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    /* Same strength for all the slices of the picture */
+    struct sharpen_slices ctx = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .sigma = atomic_load(&p_sys->sigma),
+    };
+
+    vlc_filter_RunSlices( p_filter, p_pic->p[Y_PLANE].i_visible_lines, 1,
+                          FilterSlice, &ctx );
 
     plane_CopyPixels( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE] );
     plane_CopyPixels( &p_outpic->p[V_PLANE], &p_pic->p[V_PLANE] );
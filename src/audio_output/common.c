@@ -29,7 +29,13 @@
 
 #include <vlc_common.h>
 #include <vlc_aout.h>
+#include <vlc_cpu.h>
 #include "aout_internal.h"
+#ifdef CAN_COMPILE_AVX2
+# include <immintrin.h>
+#elif defined(__SSE__)
+# include <xmmintrin.h>
+#endif
 
 /*
  * Formats management (internal and external)
@@ -339,6 +345,127 @@ do { \
     }
 }
 
+/*
+ * Stereo float (the usual layout of planar decoders) is (de)interleaved with
+ * SIMD. These return the number of samples per channel handled.
+ */
+#ifdef CAN_COMPILE_AVX2
+VLC_AVX2
+static unsigned AVX2_InterleaveStereoFL32( float *restrict d,
+                                           const float *l, const float *r,
+                                           unsigned samples )
+{
+    unsigned i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+    {
+        __m256 vl = _mm256_loadu_ps( &l[i] ), vr = _mm256_loadu_ps( &r[i] );
+        __m256 lo = _mm256_unpacklo_ps( vl, vr );
+        __m256 hi = _mm256_unpackhi_ps( vl, vr );
+
+        _mm256_storeu_ps( &d[2 * i], _mm256_permute2f128_ps( lo, hi, 0x20 ) );
+        _mm256_storeu_ps( &d[2 * i + 8],
+                          _mm256_permute2f128_ps( lo, hi, 0x31 ) );
+    }
+    return i;
+}
+
+VLC_AVX2
+static unsigned AVX2_DeinterleaveStereoFL32( float *restrict l,
+                                             float *restrict r,
+                                             const float *s, unsigned samples )
+{
+    unsigned i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+    {
+        __m256 a = _mm256_loadu_ps( &s[2 * i] );
+        __m256 b = _mm256_loadu_ps( &s[2 * i + 8] );
+        /* within each lane; the 64-bit halves are then put back in order */
+        __m256d vl = _mm256_castps_pd( _mm256_shuffle_ps( a, b, 0x88 ) );
+        __m256d vr = _mm256_castps_pd( _mm256_shuffle_ps( a, b, 0xdd ) );
+
+        _mm256_storeu_pd( (double *)&l[i],
+                          _mm256_permute4x64_pd( vl, _MM_SHUFFLE(3,1,2,0) ) );
+        _mm256_storeu_pd( (double *)&r[i],
+                          _mm256_permute4x64_pd( vr, _MM_SHUFFLE(3,1,2,0) ) );
+    }
+    return i;
+}
+#endif
+
+#ifdef __SSE__
+static unsigned SSE_InterleaveStereoFL32( float *restrict d,
+                                          const float *l, const float *r,
+                                          unsigned samples )
+{
+    unsigned i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+    {
+        __m128 vl = _mm_loadu_ps( &l[i] ), vr = _mm_loadu_ps( &r[i] );
+
+        _mm_storeu_ps( &d[2 * i], _mm_unpacklo_ps( vl, vr ) );
+        _mm_storeu_ps( &d[2 * i + 4], _mm_unpackhi_ps( vl, vr ) );
+    }
+    return i;
+}
+
+static unsigned SSE_DeinterleaveStereoFL32( float *restrict l,
+                                            float *restrict r,
+                                            const float *s, unsigned samples )
+{
+    unsigned i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+    {
+        __m128 a = _mm_loadu_ps( &s[2 * i] ), b = _mm_loadu_ps( &s[2 * i + 4] );
+
+        _mm_storeu_ps( &l[i], _mm_shuffle_ps( a, b, _MM_SHUFFLE(2,0,2,0) ) );
+        _mm_storeu_ps( &r[i], _mm_shuffle_ps( a, b, _MM_SHUFFLE(3,1,3,1) ) );
+    }
+    return i;
+}
+#endif
+
+static void InterleaveStereoFL32( float *restrict d, const float *l,
+                                  const float *r, unsigned samples )
+{
+    unsigned i = 0;
+
+#ifdef CAN_COMPILE_AVX2
+    if( vlc_CPU_AVX2() )
+        i = AVX2_InterleaveStereoFL32( d, l, r, samples );
+#endif
+#ifdef __SSE__
+    i += SSE_InterleaveStereoFL32( &d[2 * i], &l[i], &r[i], samples - i );
+#endif
+    for( ; i < samples; i++ )
+    {
+        d[2 * i] = l[i];
+        d[2 * i + 1] = r[i];
+    }
+}
+
+static void DeinterleaveStereoFL32( float *restrict l, float *restrict r,
+                                    const float *s, unsigned samples )
+{
+    unsigned i = 0;
+
+#ifdef CAN_COMPILE_AVX2
+    if( vlc_CPU_AVX2() )
+        i = AVX2_DeinterleaveStereoFL32( l, r, s, samples );
+#endif
+#ifdef __SSE__
+    i += SSE_DeinterleaveStereoFL32( &l[i], &r[i], &s[2 * i], samples - i );
+#endif
+    for( ; i < samples; i++ )
+    {
+        l[i] = s[2 * i];
+        r[i] = s[2 * i + 1];
+    }
+}
+
 /**
  * Interleaves audio samples within a block of samples.
  * \param dst destination buffer for interleaved samples
@@ -352,6 +479,12 @@ do { \
 void aout_Interleave( void *restrict dst, const void *const *srcv,
                       unsigned samples, unsigned chans, vlc_fourcc_t fourcc )
 {
+    if( fourcc == VLC_CODEC_FL32 && chans == 2 )
+    {
+        InterleaveStereoFL32( dst, srcv[0], srcv[1], samples );
+        return;
+    }
+
 #define INTERLEAVE_TYPE(type) \
 do { \
     type *d = dst; \
@@ -388,6 +521,14 @@ do { \
 void aout_Deinterleave( void *restrict dst, const void *restrict src,
                       unsigned samples, unsigned chans, vlc_fourcc_t fourcc )
 {
+    if( fourcc == VLC_CODEC_FL32 && chans == 2 )
+    {
+        float *d = dst;
+
+        DeinterleaveStereoFL32( d, d + samples, src, samples );
+        return;
+    }
+
 #define DEINTERLEAVE_TYPE(type) \
 do { \
     type *d = dst; \
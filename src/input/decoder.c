@@ -139,6 +139,38 @@ struct vlc_input_decoder_t
     es_format_t pktz_fmt_in;
     bool b_packetizer;
 
+    /* Packetizer thread, if pktz.fifo is not NULL: the input frames go to
+     * pktz.fifo, and the PacketizerThread queues the packetized frames to
+     * p_fifo. The fifo lock protects the flags; it is never held while
+     * locking p_fifo, but can be taken with p_fifo locked. */
+    struct
+    {
+        vlc_thread_t thread;
+        block_fifo_t *fifo;
+        vlc_cond_t wait; /* a frame was dequeued (pacing) */
+        bool busy;
+        bool draining;
+        bool flushing;
+        bool aborting;
+        atomic_uint generation; /* incremented by each flush */
+
+        /* Packetized frames queued ahead of the decoder at most */
+        size_t depth;
+
+        /* Formats of the frames flagged BLOCK_FLAG_CORE_PRIVATE_FORMAT,
+         * protected by p_fifo. fmt is only used by the PacketizerThread. */
+        struct vlc_list formats;
+        es_format_t fmt;
+        bool fmt_resend;
+
+        /* Statistics, only written by the PacketizerThread */
+        unsigned frames_in;
+        unsigned frames_out;
+        unsigned full_waits;
+        size_t max_depth;
+        vlc_tick_t busy_time;
+    } pktz;
+
     /* Current format in use by the output */
     es_format_t    fmt;
     vlc_video_context *vctx;
@@ -151,6 +183,16 @@ struct vlc_input_decoder_t
     /* fifo */
     block_fifo_t *p_fifo;
 
+    /* Lock-free input queue, or NULL if disabled. Frames only go to p_fifo
+     * when the ring is full ("overflow"), until the decoder thread empties
+     * p_fifo. The mark and discard request are protected by the p_fifo lock. */
+    vlc_spsc_fifo_t *p_ring;
+    size_t ring_mark;
+    bool ring_discard;
+    atomic_bool ring_overflow;
+    atomic_bool ring_waiting;
+    atomic_bool status_changed;
+
     /* Lock for communication with decoder thread */
     vlc_cond_t  wait_request;
     vlc_cond_t  wait_acknowledge;
@@ -252,7 +294,15 @@ struct vlc_input_decoder_t
 
 /* */
 #define DECODER_SPU_VOUT_WAIT_DURATION   VLC_TICK_FROM_MS(200)
+#define DECODER_RING_SIZE                1024
 #define BLOCK_FLAG_CORE_PRIVATE_RELOADED (1 << BLOCK_FLAG_CORE_PRIVATE_SHIFT)
+#define BLOCK_FLAG_CORE_PRIVATE_FORMAT   (2 << BLOCK_FLAG_CORE_PRIVATE_SHIFT)
+
+struct decoder_pktz_format
+{
+    es_format_t fmt;
+    struct vlc_list node;
+};
 
 #define decoder_Notify(decoder_priv, event, ...) \
     if (decoder_priv->cbs && decoder_priv->cbs->event) \
@@ -277,6 +327,161 @@ static inline bool vlc_input_decoder_IsSynchronous( const vlc_input_decoder_t *d
     return dec->p_sout != NULL;
 }
 
+static size_t DecoderQueue_CountLocked( const vlc_input_decoder_t *p_owner )
+{
+    size_t count = vlc_fifo_GetCount( p_owner->p_fifo );
+
+    if( p_owner->p_ring != NULL )
+        count += vlc_spsc_fifo_GetCount( p_owner->p_ring );
+    return count;
+}
+
+static size_t DecoderQueue_BytesLocked( const vlc_input_decoder_t *p_owner )
+{
+    size_t size = vlc_fifo_GetBytes( p_owner->p_fifo );
+
+    if( p_owner->p_ring != NULL )
+        size += vlc_spsc_fifo_GetBytes( p_owner->p_ring );
+    return size;
+}
+
+static void DecoderQueue_CleanFormats( vlc_input_decoder_t *p_owner )
+{
+    struct decoder_pktz_format *format;
+
+    vlc_list_foreach( format, &p_owner->pktz.formats, node )
+    {
+        vlc_list_remove( &format->node );
+        es_format_Clean( &format->fmt );
+        free( format );
+    }
+}
+
+/**
+ * Drops all frames not yet dequeued by the DecoderThread.
+ *
+ * Frames in the lock-free queue can only be dequeued by the DecoderThread,
+ * so they are marked here and discarded by DecoderQueue_DequeueLocked().
+ */
+static void DecoderQueue_ResetLocked( vlc_input_decoder_t *p_owner )
+{
+    block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+
+    /* The formats of the dropped frames are lost: the decoder must check the
+     * format of the next packetized frame */
+    DecoderQueue_CleanFormats( p_owner );
+    p_owner->pktz.fmt_resend = true;
+
+    if( p_owner->p_ring != NULL )
+    {
+        p_owner->ring_mark = vlc_spsc_fifo_Mark( p_owner->p_ring );
+        p_owner->ring_discard = true;
+        atomic_store_explicit( &p_owner->ring_overflow, false,
+                               memory_order_relaxed );
+    }
+}
+
+static void DecoderQueue_Locked( vlc_input_decoder_t *p_owner,
+                                 vlc_frame_t *frame )
+{
+    if( p_owner->p_ring != NULL )
+    {
+        if( !atomic_load_explicit( &p_owner->ring_overflow,
+                                   memory_order_relaxed )
+         && vlc_spsc_fifo_Push( p_owner->p_ring, frame ) )
+        {
+            vlc_fifo_Signal( p_owner->p_fifo );
+            return;
+        }
+        /* Keep queueing to the locked FIFO until the DecoderThread has
+         * emptied it, so that frames remain in order. */
+        atomic_store_explicit( &p_owner->ring_overflow, true,
+                               memory_order_relaxed );
+    }
+    vlc_fifo_QueueUnlocked( p_owner->p_fifo, frame );
+}
+
+/**
+ * Queues a frame without locking, if possible.
+ *
+ * @return false if the frame must be queued with the FIFO lock held
+ */
+static bool DecoderQueue_Lockless( vlc_input_decoder_t *p_owner,
+                                   vlc_frame_t *frame, bool b_do_pace )
+{
+    vlc_spsc_fifo_t *ring = p_owner->p_ring;
+
+    if( atomic_load_explicit( &p_owner->ring_overflow, memory_order_relaxed ) )
+        return false;
+    if( b_do_pace ? vlc_spsc_fifo_GetCount( ring ) >= 10
+                  : vlc_spsc_fifo_GetBytes( ring ) > 400*1024*1024 )
+        return false;
+    if( !vlc_spsc_fifo_Push( ring, frame ) )
+        return false;
+
+    /* Pairs with the fence in DecoderThread_WaitLocked() */
+    atomic_thread_fence( memory_order_seq_cst );
+    if( atomic_load_explicit( &p_owner->ring_waiting, memory_order_relaxed ) )
+    {
+        vlc_fifo_Lock( p_owner->p_fifo );
+        vlc_fifo_Signal( p_owner->p_fifo );
+        vlc_fifo_Unlock( p_owner->p_fifo );
+    }
+    return true;
+}
+
+static vlc_frame_t *DecoderQueue_DequeueLocked( vlc_input_decoder_t *p_owner )
+{
+    vlc_fifo_Assert( p_owner->p_fifo );
+
+    if( p_owner->p_ring == NULL )
+        return vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
+
+    if( p_owner->ring_discard )
+    {
+        p_owner->ring_discard = false;
+        block_ChainRelease( vlc_spsc_fifo_DequeueUntil( p_owner->p_ring,
+                                                        p_owner->ring_mark ) );
+    }
+
+    vlc_frame_t *frame = vlc_spsc_fifo_Pop( p_owner->p_ring );
+    if( frame == NULL )
+    {
+        frame = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
+        if( vlc_fifo_IsEmpty( p_owner->p_fifo ) )
+            atomic_store_explicit( &p_owner->ring_overflow, false,
+                                   memory_order_relaxed );
+    }
+    return frame;
+}
+
+static bool DecoderQueue_IsEmptyLocked( const vlc_input_decoder_t *p_owner )
+{
+    return vlc_fifo_IsEmpty( p_owner->p_fifo )
+        && ( p_owner->p_ring == NULL
+          || vlc_spsc_fifo_GetCount( p_owner->p_ring ) == 0 );
+}
+
+/**
+ * Waits for a frame to be queued, or for any other request.
+ */
+static void DecoderThread_WaitLocked( vlc_input_decoder_t *p_owner )
+{
+    if( p_owner->p_ring == NULL )
+    {
+        vlc_fifo_Wait( p_owner->p_fifo );
+        return;
+    }
+
+    /* Request a wake-up from DecoderQueue_Lockless(), then check that the
+     * producer did not queue anything before seeing the request. */
+    atomic_store_explicit( &p_owner->ring_waiting, true, memory_order_relaxed );
+    atomic_thread_fence( memory_order_seq_cst );
+    if( vlc_spsc_fifo_GetCount( p_owner->p_ring ) == 0 )
+        vlc_fifo_Wait( p_owner->p_fifo );
+    atomic_store_explicit( &p_owner->ring_waiting, false, memory_order_relaxed );
+}
+
 static void Decoder_ChangeOutputPause( vlc_input_decoder_t *p_owner, bool paused, vlc_tick_t date )
 {
     vlc_fifo_Assert(p_owner->p_fifo);
@@ -479,6 +684,8 @@ static void DecoderUpdateFormatLocked( vlc_input_decoder_t *p_owner )
     }
 
     p_owner->b_fmt_description = true;
+    atomic_store_explicit( &p_owner->status_changed, true,
+                           memory_order_relaxed );
 }
 
 static void MouseEvent( const vlc_mouse_t *newmouse, void *user_data )
@@ -1247,6 +1454,8 @@ static void DecoderPlayCcLocked( vlc_input_decoder_t *p_owner, vlc_frame_t *p_cc
     {
         p_owner->cc.desc = *p_desc;
         p_owner->cc.desc_changed = true;
+        atomic_store_explicit(&p_owner->status_changed, true,
+                              memory_order_relaxed);
     }
 
     if (p_owner->cc.count == 0)
@@ -1653,6 +1862,39 @@ static void DecoderThread_DecodeBlock( vlc_input_decoder_t *p_owner, vlc_frame_t
     }
 }
 
+/**
+ * Restarts the decoder module if the format of the packetized frames queued
+ * by the PacketizerThread changed
+ */
+static int DecoderThread_UpdatePacketizedFormat( vlc_input_decoder_t *p_owner )
+{
+    decoder_t *p_dec = &p_owner->dec;
+    struct decoder_pktz_format *format =
+        vlc_list_first_entry_or_null( &p_owner->pktz.formats,
+                                      struct decoder_pktz_format, node );
+    int ret = VLC_SUCCESS;
+
+    if( format == NULL ) /* out of memory in the PacketizerThread */
+        return VLC_SUCCESS;
+    vlc_list_remove( &format->node );
+
+    if( !p_owner->error && !es_format_IsSimilar( p_dec->fmt_in, &format->fmt ) )
+    {
+        msg_Dbg( p_dec, "restarting module due to input format change");
+        es_format_LogDifferences( vlc_object_logger(p_dec),
+                                  "decoder in", p_dec->fmt_in,
+                                  "packetizer out", &format->fmt );
+
+        /* Drain the decoder module */
+        DecoderThread_DecodeBlock( p_owner, NULL );
+
+        ret = DecoderThread_Reload( p_owner, &format->fmt, RELOAD_DECODER );
+    }
+    es_format_Clean( &format->fmt );
+    free( format );
+    return ret;
+}
+
 /**
  * Decode a frame
  *
@@ -1663,6 +1905,13 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_
 {
     decoder_t *p_dec = &p_owner->dec;
 
+    if( frame != NULL && ( frame->i_flags & BLOCK_FLAG_CORE_PRIVATE_FORMAT ) )
+    {
+        frame->i_flags &= ~BLOCK_FLAG_CORE_PRIVATE_FORMAT;
+        if( DecoderThread_UpdatePacketizedFormat( p_owner ) != VLC_SUCCESS )
+            goto error;
+    }
+
     if( p_owner->error )
         goto error;
 
@@ -1680,13 +1929,17 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_
             goto error;
     }
 
-    bool packetize = p_owner->p_packetizer != NULL;
+    /* Frames from the PacketizerThread are already packetized, and it
+     * updated the preroll with the input frames */
+    const bool threaded = p_owner->pktz.fifo != NULL;
+    bool packetize = p_owner->p_packetizer != NULL && !threaded;
     if( frame )
     {
         if( frame->i_buffer <= 0 )
             goto error;
 
-        DecoderUpdatePreroll( &p_owner->i_preroll_end, frame );
+        if( !threaded )
+            DecoderUpdatePreroll( &p_owner->i_preroll_end, frame );
         if( unlikely( frame->i_flags & BLOCK_FLAG_CORE_PRIVATE_RELOADED ) )
         {
             /* This frame has already been packetized */
@@ -1768,13 +2021,223 @@ static void DecoderThread_Flush( vlc_input_decoder_t *p_owner )
     if( p_owner->error )
         return;
 
-    if( p_packetizer != NULL && p_packetizer->pf_flush != NULL )
+    /* The PacketizerThread flushes its packetizer itself */
+    if( p_packetizer != NULL && p_packetizer->pf_flush != NULL
+     && p_owner->pktz.fifo == NULL )
         p_packetizer->pf_flush( p_packetizer );
 
     if ( p_dec->pf_flush != NULL )
         p_dec->pf_flush( p_dec );
 }
 
+/**
+ * Queues packetized frames to the decoder, or drops them if the decoder was
+ * flushed since the input frame was dequeued.
+ *
+ * \return false if the frames were dropped
+ */
+static bool PacketizerThread_QueueLocked( vlc_input_decoder_t *p_owner,
+                                          vlc_frame_t *frames,
+                                          unsigned generation )
+{
+    decoder_t *p_packetizer = p_owner->p_packetizer;
+
+    vlc_fifo_Assert( p_owner->p_fifo );
+
+    if( p_owner->pktz.fmt_resend
+     || !es_format_IsSimilar( &p_owner->pktz.fmt, &p_packetizer->fmt_out ) )
+    {
+        struct decoder_pktz_format *format = malloc( sizeof (*format) );
+
+        if( likely(format != NULL) )
+        {
+            if( es_format_Copy( &format->fmt,
+                                &p_packetizer->fmt_out ) == VLC_SUCCESS )
+            {
+                vlc_list_append( &format->node, &p_owner->pktz.formats );
+                frames->i_flags |= BLOCK_FLAG_CORE_PRIVATE_FORMAT;
+            }
+            else
+                free( format );
+        }
+        es_format_Clean( &p_owner->pktz.fmt );
+        es_format_Copy( &p_owner->pktz.fmt, &p_packetizer->fmt_out );
+        p_owner->pktz.fmt_resend = false;
+    }
+
+    if( p_packetizer->pf_get_cc )
+        PacketizerGetCc( p_owner, p_packetizer );
+
+    while( frames != NULL )
+    {
+        /* The queue is not consumed when waiting, cf. the pacing in
+         * vlc_input_decoder_DecodeWithStatus() */
+        while( DecoderQueue_CountLocked( p_owner ) >= p_owner->pktz.depth
+            && !p_owner->b_waiting && !p_owner->aborting
+            && atomic_load( &p_owner->pktz.generation ) == generation )
+        {
+            p_owner->pktz.full_waits++;
+            vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->wait_fifo );
+        }
+
+        if( p_owner->aborting
+         || atomic_load( &p_owner->pktz.generation ) != generation )
+        {
+            block_ChainRelease( frames );
+            return false;
+        }
+
+        vlc_frame_t *next = frames->p_next;
+        frames->p_next = NULL;
+        DecoderQueue_Locked( p_owner, frames );
+        p_owner->pktz.frames_out++;
+        frames = next;
+
+        size_t count = DecoderQueue_CountLocked( p_owner );
+        if( count > p_owner->pktz.max_depth )
+            p_owner->pktz.max_depth = count;
+    }
+    return true;
+}
+
+/**
+ * Packetizes an input frame, or drains the packetizer if frame is NULL
+ */
+static void PacketizerThread_Packetize( vlc_input_decoder_t *p_owner,
+                                        vlc_frame_t *frame,
+                                        unsigned generation )
+{
+    decoder_t *p_packetizer = p_owner->p_packetizer;
+    vlc_frame_t **ppframe = frame ? &frame : NULL;
+    vlc_frame_t preroll;
+    bool update_preroll = frame != NULL;
+
+    /* The frame is consumed by the packetizer, keep what the preroll needs */
+    if( frame != NULL )
+        preroll = *frame;
+
+    for( ;; )
+    {
+        vlc_tick_t start = vlc_tick_now();
+        vlc_frame_t *frames = p_packetizer->pf_packetize( p_packetizer,
+                                                          ppframe );
+        p_owner->pktz.busy_time += vlc_tick_now() - start;
+
+        vlc_fifo_Lock( p_owner->p_fifo );
+        if( atomic_load( &p_owner->pktz.generation ) != generation )
+        {   /* Flushed: the packetizer will be flushed too */
+            vlc_fifo_Unlock( p_owner->p_fifo );
+            if( frames != NULL )
+                block_ChainRelease( frames );
+            return;
+        }
+
+        if( update_preroll )
+        {
+            DecoderUpdatePreroll( &p_owner->i_preroll_end, &preroll );
+            update_preroll = false;
+        }
+
+        if( frames == NULL )
+        {
+            if( ppframe == NULL )
+            {   /* Now drain the decoder */
+                p_owner->b_draining = true;
+                vlc_fifo_Signal( p_owner->p_fifo );
+            }
+            vlc_fifo_Unlock( p_owner->p_fifo );
+            return;
+        }
+
+        bool queued = PacketizerThread_QueueLocked( p_owner, frames,
+                                                    generation );
+        vlc_fifo_Unlock( p_owner->p_fifo );
+        if( !queued )
+            return;
+    }
+}
+
+/**
+ * The packetizing main loop, ahead of the DecoderThread
+ *
+ * \param p_data the input decoder object
+ */
+static void *PacketizerThread( void *p_data )
+{
+    vlc_input_decoder_t *p_owner = p_data;
+    block_fifo_t *fifo = p_owner->pktz.fifo;
+
+    vlc_thread_set_name( "vlc-packetizer" );
+
+    vlc_fifo_Lock( fifo );
+    while( !p_owner->pktz.aborting )
+    {
+        if( p_owner->pktz.flushing )
+        {
+            p_owner->pktz.flushing = false;
+            vlc_fifo_Unlock( fifo );
+
+            if( p_owner->p_packetizer->pf_flush != NULL )
+                p_owner->p_packetizer->pf_flush( p_owner->p_packetizer );
+
+            vlc_fifo_Lock( fifo );
+            continue;
+        }
+
+        vlc_frame_t *frame = vlc_fifo_DequeueUnlocked( fifo );
+        if( frame == NULL )
+        {
+            if( !p_owner->pktz.draining )
+            {
+                vlc_fifo_Wait( fifo );
+                continue;
+            }
+            /* The input is empty: drain the packetizer, then the decoder */
+            p_owner->pktz.draining = false;
+        }
+        else
+            p_owner->pktz.frames_in++;
+
+        unsigned generation = atomic_load( &p_owner->pktz.generation );
+        p_owner->pktz.busy = true;
+        vlc_cond_signal( &p_owner->pktz.wait );
+        vlc_fifo_Unlock( fifo );
+
+        PacketizerThread_Packetize( p_owner, frame, generation );
+
+        vlc_fifo_Lock( fifo );
+        p_owner->pktz.busy = false;
+
+        if( vlc_fifo_IsEmpty( fifo ) )
+        {   /* Let vlc_input_decoder_Wait() check if it is starving */
+            vlc_fifo_Unlock( fifo );
+            vlc_fifo_Lock( p_owner->p_fifo );
+            vlc_cond_signal( &p_owner->wait_acknowledge );
+            vlc_fifo_Unlock( p_owner->p_fifo );
+            vlc_fifo_Lock( fifo );
+        }
+    }
+    vlc_fifo_Unlock( fifo );
+    return NULL;
+}
+
+/**
+ * Checks if the PacketizerThread has nothing left to packetize
+ */
+static bool PacketizerThread_IsIdle( vlc_input_decoder_t *p_owner )
+{
+    block_fifo_t *fifo = p_owner->pktz.fifo;
+
+    if( fifo == NULL )
+        return true;
+
+    vlc_fifo_Lock( fifo );
+    bool idle = vlc_fifo_IsEmpty( fifo ) && !p_owner->pktz.busy
+             && !p_owner->pktz.draining;
+    vlc_fifo_Unlock( fifo );
+    return idle;
+}
+
 /**
  * The decoding main loop
  *
@@ -1815,7 +2278,8 @@ static void *DecoderThread( void *p_data )
              * is called again. This will avoid a second useless flush (but
              * harmless). */
             p_owner->flushing = false;
-            p_owner->i_preroll_end = PREROLL_NONE;
+            if( p_owner->pktz.fifo == NULL ) /* cf. vlc_input_decoder_Flush() */
+                p_owner->i_preroll_end = PREROLL_NONE;
             continue;
         }
 
@@ -1848,14 +2312,14 @@ static void *DecoderThread( void *p_data )
 
         vlc_cond_signal( &p_owner->wait_fifo );
 
-        vlc_frame_t *frame = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
+        vlc_frame_t *frame = DecoderQueue_DequeueLocked( p_owner );
         if( frame == NULL )
         {
             if( likely(!p_owner->b_draining) )
             {   /* Wait for a block to decode (or a request to drain) */
                 p_owner->b_idle = true;
                 vlc_cond_signal( &p_owner->wait_acknowledge );
-                vlc_fifo_Wait( p_owner->p_fifo );
+                DecoderThread_WaitLocked( p_owner );
                 p_owner->b_idle = false;
                 continue;
             }
@@ -1999,6 +2463,27 @@ CreateDecoder( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
         return NULL;
     }
 
+    p_owner->p_ring = NULL;
+    if( cfg->sout == NULL && var_InheritBool( p_dec, "dec-lockfree" ) )
+    {
+        p_owner->p_ring = vlc_spsc_fifo_New( DECODER_RING_SIZE );
+        if( unlikely(p_owner->p_ring == NULL) )
+        {
+            block_FifoRelease( p_owner->p_fifo );
+            vlc_object_delete(p_dec);
+            return NULL;
+        }
+    }
+    p_owner->ring_mark = 0;
+    p_owner->ring_discard = false;
+    atomic_init( &p_owner->ring_overflow, false );
+    atomic_init( &p_owner->ring_waiting, false );
+    atomic_init( &p_owner->status_changed, false );
+
+    p_owner->pktz.fifo = NULL;
+    vlc_list_init( &p_owner->pktz.formats );
+    es_format_Init( &p_owner->pktz.fmt, UNKNOWN_ES, 0 );
+
     vlc_mutex_init( &p_owner->mouse_lock );
     vlc_cond_init( &p_owner->wait_request );
     vlc_cond_init( &p_owner->wait_acknowledge );
@@ -2025,6 +2510,27 @@ CreateDecoder( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
         }
     }
 
+    /* Packetize video on its own thread, ahead of the decoder */
+    if( p_owner->p_packetizer != NULL && fmt->i_cat == VIDEO_ES
+     && var_InheritBool( p_dec, "dec-packetizer-thread" )
+     && es_format_Copy( &p_owner->pktz.fmt, fmt ) == VLC_SUCCESS )
+    {
+        p_owner->pktz.fifo = block_FifoNew();
+        vlc_cond_init( &p_owner->pktz.wait );
+        p_owner->pktz.busy = false;
+        p_owner->pktz.draining = false;
+        p_owner->pktz.flushing = false;
+        p_owner->pktz.aborting = false;
+        atomic_init( &p_owner->pktz.generation, 0 );
+        p_owner->pktz.depth = var_InheritInteger( p_dec,
+                                                  "dec-packetizer-depth" );
+        p_owner->pktz.fmt_resend = false;
+        p_owner->pktz.frames_in = p_owner->pktz.frames_out = 0;
+        p_owner->pktz.full_waits = 0;
+        p_owner->pktz.max_depth = 0;
+        p_owner->pktz.busy_time = 0;
+    }
+
     switch( fmt->i_cat )
     {
         case VIDEO_ES:
@@ -2177,6 +2683,12 @@ static void DeleteDecoder( vlc_input_decoder_t *p_owner, enum es_format_category
     if( p_owner->p_description )
         vlc_meta_Delete( p_owner->p_description );
 
+    if( p_owner->p_ring != NULL )
+        vlc_spsc_fifo_Delete( p_owner->p_ring );
+    if( p_owner->pktz.fifo != NULL )
+        block_FifoRelease( p_owner->pktz.fifo );
+    DecoderQueue_CleanFormats( p_owner );
+    es_format_Clean( &p_owner->pktz.fmt );
     block_FifoRelease( p_owner->p_fifo );
     decoder_Destroy( p_owner->p_packetizer );
     decoder_Destroy( &p_owner->dec );
@@ -2200,6 +2712,35 @@ static void DecoderUnsupportedCodec( decoder_t *p_dec, const es_format_t *fmt, b
     }
 }
 
+/**
+ * Stops the PacketizerThread, if any, and logs its statistics
+ */
+static void PacketizerThread_Stop( vlc_input_decoder_t *p_owner )
+{
+    block_fifo_t *fifo = p_owner->pktz.fifo;
+
+    if( fifo == NULL )
+        return;
+
+    vlc_fifo_Lock( fifo );
+    p_owner->pktz.aborting = true;
+    vlc_fifo_Signal( fifo );
+    vlc_fifo_Unlock( fifo );
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    vlc_cond_broadcast( &p_owner->wait_fifo );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+
+    vlc_join( p_owner->pktz.thread, NULL );
+
+    msg_Dbg( &p_owner->dec, "packetizer thread: %u frames in, %u frames out, "
+             "%"PRId64" ms busy, decoder queue full %u times, max depth %zu/%zu",
+             p_owner->pktz.frames_in, p_owner->pktz.frames_out,
+             MS_FROM_VLC_TICK( p_owner->pktz.busy_time ),
+             p_owner->pktz.full_waits, p_owner->pktz.max_depth,
+             p_owner->pktz.depth );
+}
+
 /* TODO: pass p_sout through p_resource? -- Courmisch */
 static vlc_input_decoder_t *
 decoder_New( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
@@ -2241,12 +2782,21 @@ decoder_New( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
         }
     }
 
+    if( p_owner->pktz.fifo != NULL
+     && vlc_clone( &p_owner->pktz.thread, PacketizerThread, p_owner ) )
+    {
+        msg_Warn( p_dec, "cannot spawn packetizer thread" );
+        block_FifoRelease( p_owner->pktz.fifo );
+        p_owner->pktz.fifo = NULL;
+    }
+
     if( !vlc_input_decoder_IsSynchronous( p_owner ) )
     {
         /* Spawn the decoder thread in asynchronous scenario. */
         if( vlc_clone( &p_owner->thread, DecoderThread, p_owner ) )
         {
             msg_Err( p_dec, "cannot spawn decoder thread" );
+            PacketizerThread_Stop( p_owner );
             DeleteDecoder( p_owner, p_dec->fmt_in->i_cat );
             return NULL;
         }
@@ -2316,8 +2866,11 @@ void vlc_input_decoder_Delete( vlc_input_decoder_t *p_owner )
 
     /* Make sure we aren't waiting/decoding anymore */
     vlc_cond_signal( &p_owner->wait_request );
+    vlc_cond_broadcast( &p_owner->wait_fifo );
     vlc_fifo_Unlock( p_owner->p_fifo );
 
+    PacketizerThread_Stop( p_owner );
+
     if( !vlc_input_decoder_IsSynchronous( p_owner ) )
         vlc_join( p_owner->thread, NULL );
 
@@ -2397,6 +2950,8 @@ static void GetStatusLocked(vlc_input_decoder_t *p_owner,
 {
     vlc_fifo_Assert(p_owner->p_fifo);
 
+    atomic_store_explicit(&p_owner->status_changed, false,
+                          memory_order_relaxed);
     status->format.changed = p_owner->b_fmt_description;
     p_owner->b_fmt_description = false;
 
@@ -2421,6 +2976,37 @@ static void GetStatusLocked(vlc_input_decoder_t *p_owner,
     GetCCDescLocked(p_owner, &status->subdec_desc);
 }
 
+/**
+ * Queues an input frame to the PacketizerThread
+ */
+static void PacketizerThread_Queue( vlc_input_decoder_t *p_owner,
+                                    vlc_frame_t *frame, bool b_do_pace )
+{
+    block_fifo_t *fifo = p_owner->pktz.fifo;
+
+    vlc_fifo_Lock( fifo );
+    if( !b_do_pace )
+    {
+        /* 400 MiB, as for the decoder fifo */
+        if( vlc_fifo_GetBytes( fifo ) > 400*1024*1024 )
+        {
+            msg_Warn( &p_owner->dec, "packetizer fifo full (data not "
+                      "consumed quickly enough), resetting fifo!" );
+            block_ChainRelease( vlc_fifo_DequeueAllUnlocked( fifo ) );
+            frame->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+        }
+    }
+    else
+    if( !p_owner->b_waiting )
+    {   /* The decoder fifo is bounded by the PacketizerThread, cf.
+         * PacketizerThread_QueueLocked() */
+        while( vlc_fifo_GetCount( fifo ) >= 10 )
+            vlc_fifo_WaitCond( fifo, &p_owner->pktz.wait );
+    }
+    vlc_fifo_QueueUnlocked( fifo, frame );
+    vlc_fifo_Unlock( fifo );
+}
+
 void vlc_input_decoder_DecodeWithStatus(vlc_input_decoder_t *p_owner, vlc_frame_t *frame,
                                         bool b_do_pace,
                                         struct vlc_input_decoder_status *status)
@@ -2437,17 +3023,48 @@ void vlc_input_decoder_DecodeWithStatus(vlc_input_decoder_t *p_owner, vlc_frame_
         return;
     }
 
+    if( p_owner->pktz.fifo != NULL )
+    {
+        PacketizerThread_Queue( p_owner, frame, b_do_pace );
+        if( status != NULL )
+        {
+            vlc_fifo_Lock( p_owner->p_fifo );
+            GetStatusLocked(p_owner, status);
+            vlc_fifo_Unlock( p_owner->p_fifo );
+        }
+        return;
+    }
+
+    if( p_owner->p_ring != NULL
+     && DecoderQueue_Lockless( p_owner, frame, b_do_pace ) )
+    {
+        if( status == NULL )
+            return;
+        if( !atomic_load_explicit( &p_owner->status_changed,
+                                   memory_order_relaxed ) )
+        {   /* Nothing to report: do not bother locking */
+            status->format.changed = false;
+            status->subdec_desc.fmt_array = NULL;
+            status->subdec_desc.fmt_count = 0;
+            return;
+        }
+        vlc_fifo_Lock( p_owner->p_fifo );
+        GetStatusLocked(p_owner, status);
+        vlc_fifo_Unlock( p_owner->p_fifo );
+        return;
+    }
+
     vlc_fifo_Lock( p_owner->p_fifo );
     if( !b_do_pace )
     {
         /* FIXME: ideally we would check the time amount of data
          * in the FIFO instead of its size. */
         /* 400 MiB, i.e. ~ 50mb/s for 60s */
-        if( vlc_fifo_GetBytes( p_owner->p_fifo ) > 400*1024*1024 )
+        if( DecoderQueue_BytesLocked( p_owner ) > 400*1024*1024 )
         {
             msg_Warn( &p_owner->dec, "decoder/packetizer fifo full (data not "
                       "consumed quickly enough), resetting fifo!" );
-            block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+            DecoderQueue_ResetLocked( p_owner );
             frame->i_flags |= BLOCK_FLAG_DISCONTINUITY;
         }
     }
@@ -2456,11 +3073,11 @@ void vlc_input_decoder_DecodeWithStatus(vlc_input_decoder_t *p_owner, vlc_frame_
     {   /* The FIFO is not consumed when waiting, so pacing would deadlock VLC.
          * Locking is not necessary as b_waiting is only read, not written by
          * the decoder thread. */
-        while( vlc_fifo_GetCount( p_owner->p_fifo ) >= 10 )
+        while( DecoderQueue_CountLocked( p_owner ) >= 10 )
             vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->wait_fifo );
     }
 
-    vlc_fifo_QueueUnlocked( p_owner->p_fifo, frame );
+    DecoderQueue_Locked( p_owner, frame );
     if (status != NULL)
         GetStatusLocked(p_owner, status);
     vlc_fifo_Unlock( p_owner->p_fifo );
@@ -2477,7 +3094,8 @@ bool vlc_input_decoder_IsEmpty( vlc_input_decoder_t * p_owner )
     assert( !p_owner->b_waiting );
 
     vlc_fifo_Lock( p_owner->p_fifo );
-    if( !vlc_fifo_IsEmpty( p_owner->p_fifo ) || p_owner->b_draining )
+    if( !DecoderQueue_IsEmptyLocked( p_owner ) || p_owner->b_draining
+     || !PacketizerThread_IsIdle( p_owner ) )
     {
         vlc_fifo_Unlock( p_owner->p_fifo );
         return false;
@@ -2509,6 +3127,15 @@ void vlc_input_decoder_Drain( vlc_input_decoder_t *p_owner )
         return;
     }
 
+    if( p_owner->pktz.fifo != NULL )
+    {   /* The PacketizerThread drains the decoder once drained */
+        vlc_fifo_Lock( p_owner->pktz.fifo );
+        p_owner->pktz.draining = true;
+        vlc_fifo_Signal( p_owner->pktz.fifo );
+        vlc_fifo_Unlock( p_owner->pktz.fifo );
+        return;
+    }
+
     vlc_fifo_Lock( p_owner->p_fifo );
     p_owner->b_draining = true;
     vlc_fifo_Signal( p_owner->p_fifo );
@@ -2517,11 +3144,26 @@ void vlc_input_decoder_Drain( vlc_input_decoder_t *p_owner )
 
 void vlc_input_decoder_Flush( vlc_input_decoder_t *p_owner )
 {
+    if( p_owner->pktz.fifo != NULL )
+    {
+        block_fifo_t *fifo = p_owner->pktz.fifo;
+
+        /* Frames being packetized are dropped, from the generation change,
+         * before they reach the decoder fifo reset below */
+        vlc_fifo_Lock( fifo );
+        block_ChainRelease( vlc_fifo_DequeueAllUnlocked( fifo ) );
+        atomic_fetch_add( &p_owner->pktz.generation, 1 );
+        p_owner->pktz.flushing = true;
+        p_owner->pktz.draining = false;
+        vlc_fifo_Signal( fifo );
+        vlc_fifo_Unlock( fifo );
+    }
+
     vlc_fifo_Lock( p_owner->p_fifo );
     enum es_format_category_e cat = p_owner->dec.fmt_in->i_cat;
 
     /* Empty the fifo */
-    block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+    DecoderQueue_ResetLocked( p_owner );
 
     /* Don't need to wait for the DecoderThread to flush. Indeed, if called a
      * second time, this function will clear the FIFO again before anything was
@@ -2530,6 +3172,11 @@ void vlc_input_decoder_Flush( vlc_input_decoder_t *p_owner )
     p_owner->flushing = true;
     p_owner->b_draining = false;
 
+    /* The PacketizerThread may update the preroll with the next frames before
+     * the DecoderThread handles the flush */
+    if( p_owner->pktz.fifo != NULL )
+        p_owner->i_preroll_end = PREROLL_NONE;
+
     /* Flush video/spu decoder when paused: increment frames_countdown in order
      * to display one frame/subtitle */
     if( p_owner->paused && ( cat == VIDEO_ES || cat == SPU_ES )
@@ -2559,6 +3206,7 @@ void vlc_input_decoder_Flush( vlc_input_decoder_t *p_owner )
         }
     }
     vlc_fifo_Signal( p_owner->p_fifo );
+    vlc_cond_broadcast( &p_owner->wait_fifo );
 
     if (unlikely(p_owner->b_waiting && p_owner->b_has_data))
     {
@@ -2661,6 +3309,8 @@ void vlc_input_decoder_StartWait( vlc_input_decoder_t *p_owner )
     p_owner->b_first = true;
     p_owner->b_waiting = true;
     vlc_cond_signal(&p_owner->wait_request);
+    /* The PacketizerThread must not wait for the decoder anymore */
+    vlc_cond_broadcast(&p_owner->wait_fifo);
     vlc_fifo_Unlock(p_owner->p_fifo);
 }
 
@@ -2689,7 +3339,8 @@ void vlc_input_decoder_Wait( vlc_input_decoder_t *p_owner )
          * owner */
         if( p_owner->paused )
             break;
-        if( p_owner->b_idle && vlc_fifo_IsEmpty( p_owner->p_fifo ) )
+        if( p_owner->b_idle && DecoderQueue_IsEmptyLocked( p_owner )
+         && PacketizerThread_IsIdle( p_owner ) )
         {
             msg_Err( &p_owner->dec, "buffer deadlock prevented" );
             break;
@@ -2719,7 +3370,15 @@ void vlc_input_decoder_FrameNext( vlc_input_decoder_t *p_owner )
 
 size_t vlc_input_decoder_GetFifoSize( vlc_input_decoder_t *p_owner )
 {
-    return block_FifoSize( p_owner->p_fifo );
+    size_t size = block_FifoSize( p_owner->p_fifo );
+
+    if( p_owner->pktz.fifo != NULL )
+    {
+        vlc_fifo_Lock( p_owner->pktz.fifo );
+        size += vlc_fifo_GetBytes( p_owner->pktz.fifo );
+        vlc_fifo_Unlock( p_owner->pktz.fifo );
+    }
+    return size;
 }
 
 static bool DecoderHasVbi( decoder_t *dec )
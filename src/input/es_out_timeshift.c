@@ -36,6 +36,10 @@
 #endif
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
+#ifdef HAVE_MMAP
+#  include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_arrays.h>
@@ -197,13 +201,17 @@ struct ts_storage_t
     ts_storage_t *p_next;
 
     /* */
+    bool    b_memory;   /* Anonymous memory instead of a temporary file */
+    size_t  i_file_max; /* Max size in bytes */
+    size_t  i_file_size;/* Current size in bytes */
+    uint8_t *p_data;    /* Mapped data (or heap memory without mmap) */
+#ifndef HAVE_MMAP
 #ifdef _WIN32
     char    *psz_file;  /* Filename */
 #endif
-    size_t  i_file_max; /* Max size in bytes */
-    int64_t i_file_size;/* Current size in bytes */
     FILE    *p_filew;   /* FILE handle for data writing */
     FILE    *p_filer;   /* FILE handle for data reading */
+#endif
 
     /* */
     uint8_t *p_cmd_r;
@@ -220,6 +228,8 @@ typedef struct
     es_out_t       *p_tsout;
     struct vlc_input_es_out *p_out;
     int64_t        i_tmp_size_max;
+    int64_t        i_storage_max;
+    int64_t        i_memory_max;
     const char     *psz_tmp_path;
 
     /* Lock for all following fields */
@@ -243,6 +253,10 @@ typedef struct
     /* */
     ts_storage_t   *p_storage_r;
     ts_storage_t   *p_storage_w;
+    ts_storage_t   *p_storage_free; /* Drained storage kept for reuse */
+    int64_t        i_storage_size;  /* Size of all the storages */
+    int64_t        i_memory_size;   /* Size of the memory storages */
+    bool           b_overflow;
 
     vlc_tick_t     i_cmd_delay;
 
@@ -251,6 +265,7 @@ typedef struct
 struct es_out_id_t
 {
     es_out_id_t *p_es;
+    bool        b_discontinuity; /* Data was dropped since the last block */
 };
 
 struct es_out_timeshift
@@ -260,6 +275,8 @@ struct es_out_timeshift
 
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
+    int64_t        i_storage_max;     /* Maximal total size in byte, or 0 */
+    int64_t        i_memory_max;      /* Maximal size in memory in byte */
     char           *psz_tmp_path;     /* Path for temporary files */
 
     /* Lock for all following fields */
@@ -294,15 +311,18 @@ static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
 static int          TsChangePause( ts_thread_t *, bool b_source_paused, bool b_paused, vlc_tick_t i_date );
 static int          TsChangeRate( ts_thread_t *, float src_rate, float rate );
+static void         TsStorageRelease( ts_thread_t *, ts_storage_t *, bool b_keep );
 
 static void         *TsRun( void * );
 
-static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
+static ts_storage_t *TsStorageNew( const char *psz_path, size_t i_size, bool b_memory );
 static void         TsStorageDelete( ts_storage_t * );
+static int          TsStorageReset( ts_storage_t * );
+static size_t       TsStorageSizeofData( const ts_cmd_t *p_cmd );
 static void         TsStoragePack( ts_storage_t *p_storage );
 static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
-static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
+static int          TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
 static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
 
 static void CmdClean( ts_cmd_t * );
@@ -390,6 +410,7 @@ static es_out_id_t *Add( es_out_t *p_out, input_source_t *in, const es_format_t
     es_out_id_t *p_es = malloc( sizeof( *p_es ) );
     if( !p_es )
         return NULL;
+    p_es->b_discontinuity = false;
 
     vlc_mutex_lock( &p_sys->lock );
 
@@ -884,6 +905,11 @@ input_EsOutTimeshiftNew(input_thread_t *p_input,
     msg_Dbg( p_input, "using timeshift granularity of %d MiB",
              (int)p_sys->i_tmp_size_max/(1024*1024) );
 
+    const int64_t i_storage_max = var_InheritInteger( p_input, "input-timeshift-size" );
+    p_sys->i_storage_max = i_storage_max > 0
+                         ? __MAX( i_storage_max, 2 * p_sys->i_tmp_size_max ) : 0;
+    p_sys->i_memory_max = __MAX( var_InheritInteger( p_input, "input-timeshift-memory" ), 0 );
+
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32)
     if( p_sys->psz_tmp_path == NULL )
@@ -962,6 +988,8 @@ static int TsStart(struct es_out_timeshift *p_sys)
         return VLC_EGENERIC;
 
     p_ts->i_tmp_size_max = p_sys->i_tmp_size_max;
+    p_ts->i_storage_max = p_sys->i_storage_max;
+    p_ts->i_memory_max = p_sys->i_memory_max;
     p_ts->psz_tmp_path = p_sys->psz_tmp_path;
     p_ts->p_input = p_sys->p_input;
     p_ts->ts = p_sys;
@@ -980,6 +1008,10 @@ static int TsStart(struct es_out_timeshift *p_sys)
     p_ts->i_cmd_delay = 0;
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
+    p_ts->p_storage_free = NULL;
+    p_ts->i_storage_size = 0;
+    p_ts->i_memory_size = 0;
+    p_ts->b_overflow = false;
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts ) )
@@ -1027,23 +1059,98 @@ static void TsStop( ts_thread_t *p_ts )
     assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
     if( p_ts->p_storage_r )
         TsStorageDelete( p_ts->p_storage_r );
+    if( p_ts->p_storage_free )
+        TsStorageDelete( p_ts->p_storage_free );
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
 }
+static ts_storage_t *TsGetStorage( ts_thread_t *p_ts, const ts_cmd_t *p_cmd )
+{
+    const size_t i_size = __MAX( (size_t)p_ts->i_tmp_size_max,
+                                 TsStorageSizeofData( p_cmd ) );
+    ts_storage_t *p_storage = p_ts->p_storage_free;
+
+    vlc_mutex_assert( &p_ts->lock );
+
+    /* Reuse the last drained storage if it is large enough */
+    if( p_storage != NULL )
+    {
+        p_ts->p_storage_free = NULL;
+        if( p_storage->i_file_max >= i_size && !TsStorageReset( p_storage ) )
+            return p_storage;
+        TsStorageRelease( p_ts, p_storage, false );
+    }
+
+    /* Data blocks are dropped rather than exceeding the size limit; other
+     * commands are always stored. */
+    if( p_cmd->header.i_type == C_SEND && p_ts->i_storage_max > 0
+     && p_ts->i_storage_size + (int64_t)i_size > p_ts->i_storage_max )
+    {
+        if( !p_ts->b_overflow )
+            msg_Warn( p_ts->p_input, "timeshift size limit reached, "
+                      "dropping data" );
+        p_ts->b_overflow = true;
+        return NULL;
+    }
+
+    const bool b_memory = p_ts->i_memory_size + (int64_t)i_size <= p_ts->i_memory_max;
+
+    p_storage = TsStorageNew( p_ts->psz_tmp_path, i_size, b_memory );
+    if( p_storage )
+    {
+        p_ts->i_storage_size += i_size;
+        if( b_memory )
+            p_ts->i_memory_size += i_size;
+    }
+    return p_storage;
+}
+
+/* Releases a drained storage, keeping one of them for reuse */
+static void TsStorageRelease( ts_thread_t *p_ts, ts_storage_t *p_storage,
+                              bool b_keep )
+{
+    vlc_mutex_assert( &p_ts->lock );
+
+    if( b_keep && p_ts->p_storage_free == NULL )
+    {
+        p_ts->p_storage_free = p_storage;
+        return;
+    }
+
+    p_ts->i_storage_size -= p_storage->i_file_max;
+    if( p_storage->b_memory )
+        p_ts->i_memory_size -= p_storage->i_file_max;
+    TsStorageDelete( p_storage );
+}
+
+/* Drops a command that could not be stored, warning only once in a row */
+static void TsDropCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
+{
+    vlc_mutex_assert( &p_ts->lock );
+
+    /* The next stored block of the ES will follow a gap */
+    if( p_cmd->header.i_type == C_SEND )
+        p_cmd->send.p_es->b_discontinuity = true;
+
+    if( !p_ts->b_overflow )
+        msg_Warn( p_ts->p_input, "cannot store timeshift data, dropping" );
+    p_ts->b_overflow = true;
+    CmdClean( p_cmd );
+}
+
 static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_lock( &p_ts->lock );
 
     if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        ts_storage_t *p_storage = TsGetStorage( p_ts, p_cmd );
 
         if( !p_storage )
         {
-            CmdClean( p_cmd );
+            TsDropCmd( p_ts, p_cmd );
             vlc_mutex_unlock( &p_ts->lock );
-            /* TODO warn the user (but only once) */
             return;
         }
 
@@ -1059,31 +1166,59 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
         }
     }
 
-    /* TODO return error and warn the user (but only once) */
-    TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w );
+    bool b_discontinuity = false;
+    if( p_cmd->header.i_type == C_SEND )
+    {
+        es_out_id_t *p_es = p_cmd->send.p_es;
+
+        b_discontinuity = p_es->b_discontinuity;
+        if( b_discontinuity )
+            p_cmd->send.p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+    }
+
+    if( TsStoragePushCmd( p_ts->p_storage_w, p_cmd,
+                          p_ts->p_storage_r == p_ts->p_storage_w ) )
+    {
+        TsDropCmd( p_ts, p_cmd );
+        vlc_mutex_unlock( &p_ts->lock );
+        return;
+    }
+
+    if( p_cmd->header.i_type == C_SEND )
+    {
+        if( b_discontinuity )
+            p_cmd->send.p_es->b_discontinuity = false;
+        p_ts->b_overflow = false;
+    }
 
     vlc_cond_signal( &p_ts->wait );
 
     vlc_mutex_unlock( &p_ts->lock );
 }
-static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
+static void TsSkipDrainedStorages( ts_thread_t *p_ts, bool b_flush )
 {
-    vlc_mutex_assert( &p_ts->lock );
-
-    if( TsStorageIsEmpty( p_ts->p_storage_r ) )
-        return VLC_EGENERIC;
-
-    TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
-
-    while( TsStorageIsEmpty( p_ts->p_storage_r ) )
+    /* The storage being read may have been drained before the next one was
+     * started. */
+    while( p_ts->p_storage_r && TsStorageIsEmpty( p_ts->p_storage_r ) )
     {
         ts_storage_t *p_next = p_ts->p_storage_r->p_next;
         if( !p_next )
             break;
 
-        TsStorageDelete( p_ts->p_storage_r );
+        TsStorageRelease( p_ts, p_ts->p_storage_r, !b_flush );
         p_ts->p_storage_r = p_next;
     }
+}
+static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
+{
+    vlc_mutex_assert( &p_ts->lock );
+
+    TsSkipDrainedStorages( p_ts, b_flush );
+    if( TsStorageIsEmpty( p_ts->p_storage_r ) )
+        return VLC_EGENERIC;
+
+    TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
+    TsSkipDrainedStorages( p_ts, b_flush );
 
     return VLC_SUCCESS;
 }
@@ -1284,54 +1419,108 @@ static const size_t TsStorageSizeofCommand[] =
     [C_PRIVCONTROL] = sizeof(ts_cmd_privcontrol_t)
 };
 
-static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max )
+/* Block properties stored in front of the block data */
+typedef struct
+{
+    vlc_tick_t i_dts;
+    vlc_tick_t i_pts;
+    vlc_tick_t i_length;
+    uint32_t   i_flags;
+    uint32_t   i_nb_samples;
+    size_t     i_buffer;
+} ts_storage_block_t;
+
+static size_t TsStorageSizeofData( const ts_cmd_t *p_cmd )
+{
+    if( p_cmd == NULL || p_cmd->header.i_type != C_SEND )
+        return 0;
+    return sizeof(ts_storage_block_t) + p_cmd->send.p_block->i_buffer;
+}
+
+static ts_storage_t *TsStorageNew( const char *psz_tmp_path, size_t i_size,
+                                   bool b_memory )
 {
     ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
     if( unlikely(p_storage == NULL) )
         return NULL;
 
-    char *psz_file;
-    int fd = GetTmpFile( &psz_file, psz_tmp_path );
-    if( fd == -1 )
+    p_storage->p_next = NULL;
+    p_storage->b_memory = b_memory;
+    p_storage->i_file_max = i_size;
+    p_storage->i_file_size = 0;
+#if !defined(HAVE_MMAP) && defined(_WIN32)
+    p_storage->psz_file = NULL;
+#endif
+
+    if( b_memory )
     {
-        free( p_storage );
-        return NULL;
+#ifdef HAVE_MMAP
+        p_storage->p_data = mmap( NULL, i_size, PROT_READ|PROT_WRITE,
+                                  MAP_PRIVATE|MAP_ANONYMOUS, -1, 0 );
+        if( p_storage->p_data == MAP_FAILED )
+            goto error;
+#else
+        p_storage->p_data = malloc( i_size );
+        if( p_storage->p_data == NULL )
+            goto error;
+#endif
     }
-
-    p_storage->p_filew = fdopen( fd, "w+b" );
-    if( p_storage->p_filew == NULL )
+    else
     {
+        char *psz_file;
+        int fd = GetTmpFile( &psz_file, psz_tmp_path );
+        if( fd == -1 )
+            goto error;
+
+#ifdef HAVE_MMAP
+        /* Reserve the disk space now: writing to a mapped hole of a full
+         * file system would raise SIGBUS. */
+# ifdef HAVE_POSIX_FALLOCATE
+        bool b_ok = posix_fallocate( fd, 0, i_size ) == 0;
+# else
+        bool b_ok = ftruncate( fd, i_size ) == 0;
+# endif
+        if( b_ok )
+            p_storage->p_data = mmap( NULL, i_size, PROT_READ|PROT_WRITE,
+                                      MAP_SHARED, fd, 0 );
         vlc_close( fd );
         vlc_unlink( psz_file );
-        goto error;
-    }
+        free( psz_file );
+        if( !b_ok || p_storage->p_data == MAP_FAILED )
+            goto error;
+#else
+        p_storage->p_data = NULL;
+        p_storage->p_filew = fdopen( fd, "w+b" );
+        if( p_storage->p_filew == NULL )
+        {
+            vlc_close( fd );
+            vlc_unlink( psz_file );
+            free( psz_file );
+            goto error;
+        }
 
-    p_storage->p_filer = vlc_fopen( psz_file, "rb" );
-    if( p_storage->p_filer == NULL )
-    {
-        fclose( p_storage->p_filew );
+        p_storage->p_filer = vlc_fopen( psz_file, "rb" );
+        if( p_storage->p_filer == NULL )
+        {
+            fclose( p_storage->p_filew );
+            vlc_unlink( psz_file );
+            free( psz_file );
+            goto error;
+        }
+# ifndef _WIN32
         vlc_unlink( psz_file );
-        goto error;
-    }
-
-#ifndef _WIN32
-    vlc_unlink( psz_file );
-    free( psz_file );
-#else
-    p_storage->psz_file = psz_file;
+        free( psz_file );
+# else
+        p_storage->psz_file = psz_file;
+# endif
 #endif
-    p_storage->p_next = NULL;
-
-    /* */
-    p_storage->i_file_max = i_tmp_size_max;
-    p_storage->i_file_size = 0;
+    }
 
     /* */
     p_storage->p_cmd_buf = vlc_alloc( TS_STORAGE_COMMAND_PREALLOC, MAX_COMMAND_SIZE );
     p_storage->i_cmd_buf = TS_STORAGE_COMMAND_PREALLOC * MAX_COMMAND_SIZE;
     p_storage->p_cmd_w = p_storage->p_cmd_buf;
     p_storage->p_cmd_r = p_storage->p_cmd_buf;
-    //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
 
     if( !p_storage->p_cmd_buf )
     {
@@ -1340,7 +1529,6 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     }
     return p_storage;
 error:
-    free( psz_file );
     free( p_storage );
     return NULL;
 }
@@ -1357,15 +1545,49 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     }
     free( p_storage->p_cmd_buf );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
-#ifdef _WIN32
-    vlc_unlink( p_storage->psz_file );
+#ifdef HAVE_MMAP
+    munmap( p_storage->p_data, p_storage->i_file_max );
+#else
+    free( p_storage->p_data );
+    if( !p_storage->b_memory )
+    {
+        fclose( p_storage->p_filer );
+        fclose( p_storage->p_filew );
+    }
+# ifdef _WIN32
+    if( p_storage->psz_file != NULL )
+        vlc_unlink( p_storage->psz_file );
     free( p_storage->psz_file );
+# endif
 #endif
     free( p_storage );
 }
 
+/* Prepares an empty storage to be written again from the start */
+static int TsStorageReset( ts_storage_t *p_storage )
+{
+    assert( TsStorageIsEmpty( p_storage ) );
+
+    if( p_storage->i_cmd_buf < TS_STORAGE_COMMAND_PREALLOC * MAX_COMMAND_SIZE )
+    {   /* Undo TsStoragePack() */
+        uint8_t *p_realloc = realloc( p_storage->p_cmd_buf,
+                                      TS_STORAGE_COMMAND_PREALLOC * MAX_COMMAND_SIZE );
+        if( !p_realloc )
+            return VLC_ENOMEM;
+        p_storage->p_cmd_buf = p_realloc;
+        p_storage->i_cmd_buf = TS_STORAGE_COMMAND_PREALLOC * MAX_COMMAND_SIZE;
+    }
+    p_storage->p_next = NULL;
+    p_storage->p_cmd_w = p_storage->p_cmd_buf;
+    p_storage->p_cmd_r = p_storage->p_cmd_buf;
+    p_storage->i_file_size = 0;
+#ifndef HAVE_MMAP
+    if( !p_storage->b_memory )
+        rewind( p_storage->p_filew );
+#endif
+    return VLC_SUCCESS;
+}
+
 static void TsStoragePack( ts_storage_t *p_storage )
 {
     /* Try to release a bit of memory */
@@ -1385,13 +1607,8 @@ static void TsStoragePack( ts_storage_t *p_storage )
 
 static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
-    if( p_cmd && p_cmd->header.i_type == C_SEND && p_storage->p_cmd_w )
-    {
-        size_t i_size = sizeof(*p_cmd->send.p_block) + p_cmd->send.p_block->i_buffer;
-
-        if( p_storage->i_file_size + i_size >= p_storage->i_file_max )
-            return true;
-    }
+    if( p_storage->i_file_size + TsStorageSizeofData( p_cmd ) > p_storage->i_file_max )
+        return true;
     return (size_t)(p_storage->p_cmd_w - p_storage->p_cmd_buf) > p_storage->i_cmd_buf - MAX_COMMAND_SIZE;
 }
 
@@ -1400,7 +1617,42 @@ static bool TsStorageIsEmpty( ts_storage_t *p_storage )
     return !p_storage || p_storage->p_cmd_r >= p_storage->p_cmd_w;
 }
 
-static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
+static int TsStorageWrite( ts_storage_t *p_storage, const void *p_buf, size_t i_size )
+{
+    assert( p_storage->i_file_size + i_size <= p_storage->i_file_max );
+#ifndef HAVE_MMAP
+    if( !p_storage->b_memory )
+    {
+        if( i_size > 0 && fwrite( p_buf, i_size, 1, p_storage->p_filew ) != 1 )
+            return VLC_EGENERIC;
+        p_storage->i_file_size += i_size;
+        return VLC_SUCCESS;
+    }
+#endif
+    memcpy( &p_storage->p_data[p_storage->i_file_size], p_buf, i_size );
+    p_storage->i_file_size += i_size;
+    return VLC_SUCCESS;
+}
+
+static int TsStorageRead( ts_storage_t *p_storage, size_t i_offset,
+                          void *p_buf, size_t i_size )
+{
+    if( i_offset + i_size > p_storage->i_file_size )
+        return VLC_EGENERIC;
+#ifndef HAVE_MMAP
+    if( !p_storage->b_memory )
+    {
+        if( fseek( p_storage->p_filer, i_offset, SEEK_SET )
+         || fread( p_buf, i_size, 1, p_storage->p_filer ) != 1 )
+            return VLC_EGENERIC;
+        return VLC_SUCCESS;
+    }
+#endif
+    memcpy( p_buf, &p_storage->p_data[i_offset], i_size );
+    return VLC_SUCCESS;
+}
+
+static int TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
 {
     assert( !TsStorageIsFull( p_storage, p_cmd ) );
     ts_cmd_t cmd;
@@ -1409,33 +1661,34 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
     if( cmd.header.i_type == C_SEND )
     {
         block_t *p_block = cmd.send.p_block;
+        const ts_storage_block_t block = {
+            .i_dts = p_block->i_dts,
+            .i_pts = p_block->i_pts,
+            .i_length = p_block->i_length,
+            .i_flags = p_block->i_flags,
+            .i_nb_samples = p_block->i_nb_samples,
+            .i_buffer = p_block->i_buffer,
+        };
 
         cmd.send.p_block = NULL;
-        cmd.send.i_offset = ftell( p_storage->p_filew );
+        cmd.send.i_offset = p_storage->i_file_size;
 
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
-        {
-            block_Release( p_block );
-            return;
-        }
-        p_storage->i_file_size += sizeof(*p_block);
-        if( p_block->i_buffer > 0 )
-        {
-            if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
-            {
-                block_Release( p_block );
-                return;
-            }
-        }
-        p_storage->i_file_size += p_block->i_buffer;
+        /* On error, the block is left to the caller */
+        if( TsStorageWrite( p_storage, &block, sizeof(block) )
+         || TsStorageWrite( p_storage, p_block->p_buffer, p_block->i_buffer ) )
+            return VLC_EGENERIC;
         block_Release( p_block );
 
-        if( b_flush )
+#ifndef HAVE_MMAP
+        if( b_flush && !p_storage->b_memory )
             fflush( p_storage->p_filew );
+#endif
     }
+    (void) b_flush;
     size_t i_cmdsize = TsStorageSizeofCommand[ cmd.header.i_type ];
     memcpy( p_storage->p_cmd_w, &cmd, i_cmdsize );
     p_storage->p_cmd_w += i_cmdsize;
+    return VLC_SUCCESS;
 }
 
 static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
@@ -1449,29 +1702,30 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
 
     if( p_cmd->header.i_type == C_SEND )
     {
-        block_t block;
+        const size_t i_offset = p_cmd->send.i_offset;
+        ts_storage_block_t block;
 
-        if( !b_flush &&
-            !fseek( p_storage->p_filer, p_cmd->send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
-        {
-            block_t *p_block = block_Alloc( block.i_buffer );
-            if( p_block )
-            {
-                p_block->i_dts      = block.i_dts;
-                p_block->i_pts      = block.i_pts;
-                p_block->i_flags    = block.i_flags;
-                p_block->i_length   = block.i_length;
-                p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
-            }
-            p_cmd->send.p_block = p_block;
-        }
-        else
+        p_cmd->send.p_block = NULL;
+        if( b_flush
+         || TsStorageRead( p_storage, i_offset, &block, sizeof(block) ) )
+            return;
+
+        block_t *p_block = block_Alloc( block.i_buffer );
+        if( p_block == NULL )
+            return;
+
+        if( TsStorageRead( p_storage, i_offset + sizeof(block),
+                           p_block->p_buffer, block.i_buffer ) )
         {
-            //perror( "TsStoragePopCmd" );
-            p_cmd->send.p_block = block_Alloc( 1 );
+            block_Release( p_block );
+            return;
         }
+        p_block->i_dts      = block.i_dts;
+        p_block->i_pts      = block.i_pts;
+        p_block->i_flags    = block.i_flags;
+        p_block->i_length   = block.i_length;
+        p_block->i_nb_samples = block.i_nb_samples;
+        p_cmd->send.p_block = p_block;
     }
 }
 
@@ -29,6 +29,7 @@
 
 #include <vlc_common.h>
 #include "input/input_internal.h"
+#include "misc/frame.h"
 
 /**
  * Create a statistics counter
@@ -111,6 +112,13 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                     memory_order_relaxed);
     st->i_lost_pictures = atomic_load_explicit(&stats->lost_pictures,
                                                memory_order_relaxed);
+
+    /* Frames */
+    struct vlc_frame_cache_stats frames;
+
+    vlc_frame_cache_GetStats(&frames);
+    st->i_frame_allocs = frames.allocs;
+    st->i_frame_heap_allocs = frames.heap_allocs;
 }
 
 /** Update a counter element with new values
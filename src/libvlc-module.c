@@ -99,6 +99,12 @@ static const char *const ppsz_snap_formats[] =
     "This is the verbosity level (0=only errors and " \
     "standard messages, 1=warnings, 2=debug).")
 
+#define LOG_ASYNC_TEXT N_("Asynchronous logging")
+#define LOG_ASYNC_LONGTEXT N_( \
+    "Pass log messages to the logger modules from a dedicated thread, " \
+    "so that logging does not slow down the other threads. Messages " \
+    "may be dropped if they are emitted faster than they can be logged.")
+
 #define OPEN_TEXT N_("Default stream")
 #define OPEN_LONGTEXT N_( \
     "This stream will always be opened at VLC startup." )
@@ -415,6 +421,11 @@ static const char *const screensaver_texts[] = {
     "picture quality, for instance deinterlacing, or distort " \
     "the video.")
 
+#define FILTER_THREADS_TEXT N_("Video filter threads")
+#define FILTER_THREADS_LONGTEXT N_( \
+    "Number of threads processing slices of pictures in parallel in the " \
+    "video filters supporting it (0 = number of CPUs, 1 = disabled).")
+
 #define SNAP_PATH_TEXT N_("Video snapshot directory (or filename)")
 #define SNAP_PATH_LONGTEXT N_( \
     "Directory where the video snapshots will be stored.")
@@ -760,6 +771,16 @@ static const char* const ppsz_restore_playback_desc[] = {
     "This is the maximum size in bytes of the temporary files " \
     "that will be used to store the timeshifted streams." )
 
+#define INPUT_TIMESHIFT_SIZE_TEXT N_("Timeshift size limit")
+#define INPUT_TIMESHIFT_SIZE_LONGTEXT N_( \
+    "This is the maximum size in bytes of the timeshifted streams. " \
+    "Stream data is dropped when it is reached. 0 means unlimited." )
+
+#define INPUT_TIMESHIFT_MEMORY_TEXT N_("Timeshift memory size")
+#define INPUT_TIMESHIFT_MEMORY_LONGTEXT N_( \
+    "This is the size in bytes of the timeshifted streams that may be " \
+    "kept in memory rather than in temporary files." )
+
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
     "$a: Artist<br>$b: Album<br>$c: Copyright<br>$t: Title<br>$g: Genre<br>"  \
@@ -1007,6 +1028,22 @@ static const char* const ppsz_restore_playback_desc[] = {
 #define DEC_DEV_TEXT N_("Preferred decoder hardware device")
 #define DEC_DEV_LONGTEXT N_("This allows hardware decoding when available.")
 
+#define DEC_LOCKFREE_TEXT N_("Lock-free decoder input queue")
+#define DEC_LOCKFREE_LONGTEXT N_( \
+    "Queue demultiplexed data to the decoder threads without locking. " \
+    "This reduces contention with streams carrying many small packets.")
+
+#define DEC_PKTZ_THREAD_TEXT N_("Packetize video on a separate thread")
+#define DEC_PKTZ_THREAD_LONGTEXT N_( \
+    "Parse the video bitstreams which need to be packetized on their own " \
+    "thread, so that packetizing overlaps with decoding. This helps with " \
+    "high bitrate H.264 and HEVC streams.")
+
+#define DEC_PKTZ_DEPTH_TEXT N_("Packetized video queue depth")
+#define DEC_PKTZ_DEPTH_LONGTEXT N_( \
+    "Maximum number of packetized video frames queued ahead of the decoder " \
+    "by the packetizer thread.")
+
 /*****************************************************************************
  * Sout
  ****************************************************************************/
@@ -1749,6 +1786,8 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_VIDEO_VFILTER )
     add_module_list("video-filter", "video filter", NULL,
                     VIDEO_FILTER_TEXT, VIDEO_FILTER_LONGTEXT)
+    add_integer_with_range( "filter-threads", 0, 0, 64,
+                            FILTER_THREADS_TEXT, FILTER_THREADS_LONGTEXT )
 
 #if 0
     add_string( "pixel-ratio", "1", PIXEL_RATIO_TEXT, PIXEL_RATIO_TEXT )
@@ -2000,6 +2039,10 @@ vlc_module_begin ()
                   INPUT_TIMESHIFT_PATH_TEXT, INPUT_TIMESHIFT_PATH_LONGTEXT)
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT )
+    add_integer( "input-timeshift-size", 0, INPUT_TIMESHIFT_SIZE_TEXT,
+                 INPUT_TIMESHIFT_SIZE_LONGTEXT )
+    add_integer( "input-timeshift-memory", 0, INPUT_TIMESHIFT_MEMORY_TEXT,
+                 INPUT_TIMESHIFT_MEMORY_LONGTEXT )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT )
 
@@ -2021,6 +2064,11 @@ vlc_module_begin ()
     add_bool( "hw-dec", true, HW_DEC_TEXT, HW_DEC_LONGTEXT )
     add_obsolete_string( "encoder" ) /* since 4.0.0 */
     add_module("dec-dev", "decoder device", "any", DEC_DEV_TEXT, DEC_DEV_LONGTEXT)
+    add_bool( "dec-lockfree", false, DEC_LOCKFREE_TEXT, DEC_LOCKFREE_LONGTEXT )
+    add_bool( "dec-packetizer-thread", false, DEC_PKTZ_THREAD_TEXT,
+              DEC_PKTZ_THREAD_LONGTEXT )
+    add_integer_with_range( "dec-packetizer-depth", 8, 1, 256,
+                            DEC_PKTZ_DEPTH_TEXT, DEC_PKTZ_DEPTH_LONGTEXT )
 
     //set_subcategory( SUBCAT_INPUT_SCODEC )
     set_subcategory( SUBCAT_INPUT_STREAM_FILTER )
@@ -2208,6 +2256,7 @@ vlc_module_begin ()
     add_integer( "verbose", 0, VERBOSE_TEXT, VERBOSE_LONGTEXT )
         change_short('v')
         change_volatile ()
+    add_bool( "log-async", false, LOG_ASYNC_TEXT, LOG_ASYNC_LONGTEXT )
 #if !defined(_WIN32) && !defined(__OS2__)
     add_obsolete_bool( "daemon" ) /* since 4.0.0 */
         change_short('d')
@@ -63,9 +63,11 @@
 #include <vlc_modules.h>
 #include <vlc_media_library.h>
 #include <vlc_tracer.h>
+#include <vlc_executor.h>
 #include "player/player.h"
 
 #include "libvlc.h"
+#include "misc/frame.h"
 
 #include <vlc_vlm.h>
 
@@ -96,8 +98,12 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv->main_playlist = NULL;
     priv->p_vlm = NULL;
     priv->media_source_provider = NULL;
+    priv->filter_executor = NULL;
+    priv->filter_threads = 1;
+    priv->filter_once = (vlc_once_t) VLC_STATIC_ONCE;
 
     vlc_ExitInit( &priv->exit );
+    vlc_frame_cache_Hold();
 
     return p_libvlc;
 }
@@ -214,6 +220,14 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
 
     vlc_CPU_dump( VLC_OBJECT(p_libvlc) );
 
+    /* Video filters slice threads (the filter thread processes slices too),
+     * started by the first filter to use them */
+    int64_t filter_threads = var_InheritInteger( p_libvlc, "filter-threads" );
+    if( filter_threads <= 0 )
+        filter_threads = vlc_GetCPUCount();
+    if( filter_threads > 1 )
+        priv->filter_threads = filter_threads;
+
     if( var_InheritBool( p_libvlc, "media-library") )
     {
         priv->p_media_library = libvlc_MlCreate( p_libvlc );
@@ -372,6 +386,9 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if( priv->media_source_provider )
         vlc_media_source_provider_Delete( priv->media_source_provider );
 
+    if( priv->filter_executor )
+        vlc_executor_Delete( priv->filter_executor );
+
     libvlc_InternalDialogClean( p_libvlc );
     libvlc_InternalKeystoreClean( p_libvlc );
     libvlc_InternalActionsClean( p_libvlc );
@@ -397,6 +414,7 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
 void libvlc_InternalDestroy( libvlc_int_t *p_libvlc )
 {
     vlc_object_delete(p_libvlc);
+    vlc_frame_cache_Drop();
 }
 
 /*****************************************************************************
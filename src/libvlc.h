@@ -187,6 +187,9 @@ typedef struct libvlc_priv_t
     vlc_actions_t *actions; ///< Hotkeys handler
     struct vlc_medialibrary_t *p_media_library; ///< Media library instance
     struct vlc_tracer *tracer; ///< Tracer callbacks
+    struct vlc_executor *filter_executor; ///< Video filters slice threads
+    unsigned filter_threads; ///< Video filters slice threads count
+    vlc_once_t filter_once; ///< Video filters slice threads creation
 
     /* Exit callback */
     vlc_exit_t       exit;
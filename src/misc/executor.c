@@ -29,23 +29,32 @@
 #include <vlc_threads.h>
 #include "libvlc.h"
 
+#define PRIORITY_COUNT (VLC_EXECUTOR_PRIORITY_HIGH + 1)
+
 /**
  * An executor can spawn several threads.
  *
  * This structure contains the data specific to one thread.
+ *
+ * Each thread owns one queue of pending runnables per priority class. A
+ * thread takes runnables from the front of its own queues, and steals from
+ * the front of the queues of the other threads when its own are empty.
  */
 struct vlc_executor_thread {
-    /** Node of vlc_executor.threads list */
-    struct vlc_list node;
-
     /** The executor owning the thread */
     vlc_executor_t *owner;
 
     /** The system thread */
     vlc_thread_t thread;
 
-    /** The current task executed by the thread, NULL if none */
-    struct vlc_runnable *current_task;
+    /** Index of the thread in vlc_executor.threads */
+    unsigned index;
+
+    /** Lock protecting the queues */
+    vlc_mutex_t lock;
+
+    /** Queues of vlc_runnable, one per priority class */
+    struct vlc_list queues[PRIORITY_COUNT];
 };
 
 /**
@@ -53,64 +62,186 @@ struct vlc_executor_thread {
  * header).
  */
 struct vlc_executor {
+    /** Lock protecting thread creation, sleeping threads and closing */
     vlc_mutex_t lock;
 
     /** Maximum number of threads to run the tasks */
     unsigned max_threads;
 
-    /** List of active vlc_executor_thread */
-    struct vlc_list threads;
-
-    /** Thread count (in a separate field to quickly compare to max_threads) */
-    unsigned nthreads;
+    /** Thread count (threads[0] to threads[nthreads - 1] are running) */
+    atomic_uint nthreads;
 
     /* Number of tasks requested but not finished. */
-    unsigned unfinished;
+    atomic_uint unfinished;
+
+    /** Number of queued tasks, per priority class */
+    atomic_uint pending[PRIORITY_COUNT];
+
+    /** Number of threads waiting on queue_wait */
+    atomic_uint sleepers;
+
+    /** Next thread to queue a task submitted from outside the executor */
+    atomic_uint next;
 
     /** Wait for the executor to be idle (i.e. unfinished == 0) */
     vlc_cond_t idle_wait;
 
-    /** Queue of vlc_runnable */
-    struct vlc_list queue;
-
-    /** Wait for the queue to be non-empty */
+    /** Wait for a task to be queued */
     vlc_cond_t queue_wait;
 
     /** True if executor deletion is requested */
     bool closing;
+
+    /** Threads (max_threads entries) */
+    struct vlc_executor_thread threads[];
 };
 
+/** The executor thread running on the calling thread, if any */
+static thread_local struct vlc_executor_thread *current_thread;
+
 static void
 QueuePush(vlc_executor_t *executor, struct vlc_runnable *runnable)
 {
-    vlc_mutex_assert(&executor->lock);
+    struct vlc_executor_thread *thread = current_thread;
+    enum vlc_executor_priority priority = runnable->priority;
 
-    vlc_list_append(&runnable->node, &executor->queue);
-    vlc_cond_signal(&executor->queue_wait);
+    /* A task submitted from a task is queued to the current thread, other
+     * tasks are spread over all the threads. */
+    if (thread == NULL || thread->owner != executor)
+    {
+        unsigned nthreads = atomic_load_explicit(&executor->nthreads,
+                                                 memory_order_acquire);
+        unsigned next = atomic_fetch_add_explicit(&executor->next, 1,
+                                                  memory_order_relaxed);
+        thread = &executor->threads[next % nthreads];
+    }
+
+    runnable->queue = thread;
+
+    vlc_mutex_lock(&thread->lock);
+    vlc_list_append(&runnable->node, &thread->queues[priority]);
+    atomic_fetch_add(&executor->pending[priority], 1);
+    vlc_mutex_unlock(&thread->lock);
+
+    /* Pairs with the sleepers increment in ThreadWait() */
+    if (atomic_load(&executor->sleepers) > 0)
+    {
+        vlc_mutex_lock(&executor->lock);
+        vlc_cond_signal(&executor->queue_wait);
+        vlc_mutex_unlock(&executor->lock);
+    }
 }
 
+/**
+ * Takes the oldest task of a priority class from the queue of a thread.
+ *
+ * Stolen tasks are also taken from the head. This only keeps the submission
+ * order within the queue of one thread: tasks queued to different threads
+ * start roughly in order.
+ */
 static struct vlc_runnable *
-QueueTake(vlc_executor_t *executor)
+QueueTake(struct vlc_executor_thread *thread,
+          enum vlc_executor_priority priority)
 {
-    vlc_mutex_assert(&executor->lock);
+    vlc_executor_t *executor = thread->owner;
+    struct vlc_list *queue = &thread->queues[priority];
+    struct vlc_runnable *runnable;
+
+    vlc_mutex_lock(&thread->lock);
+    runnable = vlc_list_first_entry_or_null(queue, struct vlc_runnable, node);
+    if (runnable != NULL)
+    {
+        vlc_list_remove(&runnable->node);
+
+        /* Set links to NULL to know that it has been taken by a thread in
+         * vlc_executor_Cancel() */
+        runnable->node.prev = runnable->node.next = NULL;
+        atomic_fetch_sub_explicit(&executor->pending[priority], 1,
+                                  memory_order_relaxed);
+    }
+    vlc_mutex_unlock(&thread->lock);
+
+    return runnable;
+}
+
+/**
+ * Takes the next task to run: the first task of the highest priority class
+ * from the queues of the thread, or else from the queues of another thread.
+ */
+static struct vlc_runnable *
+ThreadTake(struct vlc_executor_thread *thread)
+{
+    vlc_executor_t *executor = thread->owner;
+
+    for (int priority = PRIORITY_COUNT - 1; priority >= 0; priority--)
+    {
+        if (atomic_load_explicit(&executor->pending[priority],
+                                 memory_order_relaxed) == 0)
+            continue;
+
+        struct vlc_runnable *runnable = QueueTake(thread, priority);
+        if (runnable != NULL)
+            return runnable;
+
+        unsigned nthreads = atomic_load_explicit(&executor->nthreads,
+                                                 memory_order_acquire);
+        for (unsigned i = 1; i <= nthreads; i++)
+        {
+            unsigned index = (thread->index + i) % nthreads;
+
+            if (index == thread->index)
+                continue;
+
+            runnable = QueueTake(&executor->threads[index], priority);
+            if (runnable != NULL)
+                return runnable;
+        }
+    }
+    return NULL;
+}
+
+static bool
+HasPending(vlc_executor_t *executor)
+{
+    for (unsigned i = 0; i < PRIORITY_COUNT; i++)
+        if (atomic_load(&executor->pending[i]) > 0)
+            return true;
+    return false;
+}
+
+/**
+ * Waits for a task to be queued.
+ *
+ * \retval false if the executor is closing
+ */
+static bool
+ThreadWait(vlc_executor_t *executor)
+{
+    vlc_mutex_lock(&executor->lock);
+    atomic_fetch_add(&executor->sleepers, 1);
 
-    while (!executor->closing && vlc_list_is_empty(&executor->queue))
+    while (!executor->closing && !HasPending(executor))
         vlc_cond_wait(&executor->queue_wait, &executor->lock);
 
-    if (executor->closing)
-        return NULL;
+    atomic_fetch_sub(&executor->sleepers, 1);
+    bool closing = executor->closing;
+    vlc_mutex_unlock(&executor->lock);
 
-    struct vlc_runnable *runnable =
-        vlc_list_first_entry_or_null(&executor->queue, struct vlc_runnable,
-                                     node);
-    assert(runnable);
-    vlc_list_remove(&runnable->node);
+    return !closing;
+}
 
-    /* Set links to NULL to know that it has been taken by a thread in
-     * vlc_executor_Cancel() */
-    runnable->node.prev = runnable->node.next = NULL;
+static void
+TaskDone(vlc_executor_t *executor)
+{
+    unsigned unfinished = atomic_fetch_sub(&executor->unfinished, 1);
 
-    return runnable;
+    assert(unfinished > 0);
+    if (unfinished == 1)
+    {
+        vlc_mutex_lock(&executor->lock);
+        vlc_cond_broadcast(&executor->idle_wait);
+        vlc_mutex_unlock(&executor->lock);
+    }
 }
 
 static void *
@@ -120,56 +251,53 @@ ThreadRun(void *userdata)
     vlc_executor_t *executor = thread->owner;
 
     vlc_thread_set_name("vlc-exec-runner");
+    current_thread = thread;
 
-    vlc_mutex_lock(&executor->lock);
-
-    struct vlc_runnable *runnable;
-    /* When the executor is closing, QueueTake() returns NULL */
-    while ((runnable = QueueTake(executor)))
+    for (;;)
     {
-        thread->current_task = runnable;
-        vlc_mutex_unlock(&executor->lock);
+        struct vlc_runnable *runnable = ThreadTake(thread);
 
-        /* Execute the user-provided runnable, without the executor lock */
-        runnable->run(runnable->userdata);
+        if (runnable == NULL)
+        {
+            /* When the executor is closing, ThreadWait() returns false */
+            if (!ThreadWait(executor))
+                break;
+            continue;
+        }
 
-        vlc_mutex_lock(&executor->lock);
-        thread->current_task = NULL;
+        /* Execute the user-provided runnable, without any lock */
+        runnable->run(runnable->userdata);
 
         vlc_thread_set_name("vlc-exec-runner");
-
-        assert(executor->unfinished > 0);
-        --executor->unfinished;
-        if (!executor->unfinished)
-            vlc_cond_signal(&executor->idle_wait);
+        TaskDone(executor);
     }
 
-    vlc_mutex_unlock(&executor->lock);
-
+    current_thread = NULL;
     return NULL;
 }
 
 static int
 SpawnThread(vlc_executor_t *executor)
 {
-    assert(executor->nthreads < executor->max_threads);
+    vlc_mutex_assert(&executor->lock);
 
-    struct vlc_executor_thread *thread = malloc(sizeof(*thread));
-    if (!thread)
-        return VLC_ENOMEM;
+    unsigned index = atomic_load_explicit(&executor->nthreads,
+                                          memory_order_relaxed);
+    assert(index < executor->max_threads);
+
+    struct vlc_executor_thread *thread = &executor->threads[index];
 
     thread->owner = executor;
-    thread->current_task = NULL;
+    thread->index = index;
+    vlc_mutex_init(&thread->lock);
+    for (unsigned i = 0; i < PRIORITY_COUNT; i++)
+        vlc_list_init(&thread->queues[i]);
 
     if (vlc_clone(&thread->thread, ThreadRun, thread))
-    {
-        free(thread);
         return VLC_EGENERIC;
-    }
-
-    executor->nthreads++;
-    vlc_list_append(&thread->node, &executor->threads);
 
+    atomic_store_explicit(&executor->nthreads, index + 1,
+                          memory_order_release);
     return VLC_SUCCESS;
 }
 
@@ -177,18 +305,20 @@ vlc_executor_t *
 vlc_executor_New(unsigned max_threads)
 {
     assert(max_threads);
-    vlc_executor_t *executor = malloc(sizeof(*executor));
+    vlc_executor_t *executor =
+        malloc(sizeof(*executor) + max_threads * sizeof(executor->threads[0]));
     if (!executor)
         return NULL;
 
     vlc_mutex_init(&executor->lock);
 
     executor->max_threads = max_threads;
-    executor->nthreads = 0;
-    executor->unfinished = 0;
-
-    vlc_list_init(&executor->threads);
-    vlc_list_init(&executor->queue);
+    atomic_init(&executor->nthreads, 0);
+    atomic_init(&executor->unfinished, 0);
+    for (unsigned i = 0; i < PRIORITY_COUNT; i++)
+        atomic_init(&executor->pending[i], 0);
+    atomic_init(&executor->sleepers, 0);
+    atomic_init(&executor->next, 0);
 
     vlc_cond_init(&executor->idle_wait);
     vlc_cond_init(&executor->queue_wait);
@@ -196,7 +326,9 @@ vlc_executor_New(unsigned max_threads)
     executor->closing = false;
 
     /* Create one thread on init so that vlc_executor_Submit() may never fail */
+    vlc_mutex_lock(&executor->lock);
     int ret = SpawnThread(executor);
+    vlc_mutex_unlock(&executor->lock);
     if (ret != VLC_SUCCESS)
     {
         free(executor);
@@ -207,26 +339,50 @@ vlc_executor_New(unsigned max_threads)
 }
 
 void
-vlc_executor_Submit(vlc_executor_t *executor, struct vlc_runnable *runnable)
+vlc_executor_SubmitWithPriority(vlc_executor_t *executor,
+                                struct vlc_runnable *runnable,
+                                enum vlc_executor_priority priority)
 {
-    vlc_mutex_lock(&executor->lock);
+    assert(priority < PRIORITY_COUNT);
 
-    assert(!executor->closing);
+    runnable->priority = priority;
 
-    QueuePush(executor, runnable);
+    unsigned unfinished = atomic_fetch_add(&executor->unfinished, 1) + 1;
 
-    if (++executor->unfinished > executor->nthreads
-            && executor->nthreads < executor->max_threads)
-        /* If it fails, this is not an error, there is at least one thread */
-        SpawnThread(executor);
+    if (unfinished > atomic_load_explicit(&executor->nthreads,
+                                          memory_order_relaxed))
+    {
+        vlc_mutex_lock(&executor->lock);
+        assert(!executor->closing);
+
+        if (unfinished > atomic_load_explicit(&executor->nthreads,
+                                              memory_order_relaxed)
+         && atomic_load_explicit(&executor->nthreads, memory_order_relaxed)
+                < executor->max_threads)
+            /* If it fails, this is not an error, there is at least one
+             * thread */
+            SpawnThread(executor);
+        vlc_mutex_unlock(&executor->lock);
+    }
 
-    vlc_mutex_unlock(&executor->lock);
+    QueuePush(executor, runnable);
+}
+
+void
+vlc_executor_Submit(vlc_executor_t *executor, struct vlc_runnable *runnable)
+{
+    vlc_executor_SubmitWithPriority(executor, runnable,
+                                    VLC_EXECUTOR_PRIORITY_NORMAL);
 }
 
 bool
 vlc_executor_Cancel(vlc_executor_t *executor, struct vlc_runnable *runnable)
 {
-    vlc_mutex_lock(&executor->lock);
+    struct vlc_executor_thread *thread = runnable->queue;
+
+    assert(thread->owner == executor);
+
+    vlc_mutex_lock(&thread->lock);
 
     /* Either both prev and next are set, either both are NULL */
     assert(!runnable->node.prev == !runnable->node.next);
@@ -235,14 +391,15 @@ vlc_executor_Cancel(vlc_executor_t *executor, struct vlc_runnable *runnable)
     if (in_queue)
     {
         vlc_list_remove(&runnable->node);
-
-        assert(executor->unfinished > 0);
-        --executor->unfinished;
-        if (!executor->unfinished)
-            vlc_cond_signal(&executor->idle_wait);
+        runnable->node.prev = runnable->node.next = NULL;
+        atomic_fetch_sub_explicit(&executor->pending[runnable->priority], 1,
+                                  memory_order_relaxed);
     }
 
-    vlc_mutex_unlock(&executor->lock);
+    vlc_mutex_unlock(&thread->lock);
+
+    if (in_queue)
+        TaskDone(executor);
 
     return in_queue;
 }
@@ -251,7 +408,7 @@ void
 vlc_executor_WaitIdle(vlc_executor_t *executor)
 {
     vlc_mutex_lock(&executor->lock);
-    while (executor->unfinished)
+    while (atomic_load(&executor->unfinished))
         vlc_cond_wait(&executor->idle_wait, &executor->lock);
     vlc_mutex_unlock(&executor->lock);
 }
@@ -264,29 +421,26 @@ vlc_executor_Delete(vlc_executor_t *executor)
     executor->closing = true;
 
     /* All the tasks must be canceled on delete */
-    assert(vlc_list_is_empty(&executor->queue));
+    assert(!HasPending(executor));
 
     /* "closing" is now true, this will wake up threads */
     vlc_cond_broadcast(&executor->queue_wait);
 
     vlc_mutex_unlock(&executor->lock);
 
-    /* The threads list may not be written at this point, so it is safe to read
-     * it without mutex locked (the mutex must be released to join the
+    /* No threads may be spawned at this point, so it is safe to read the
+     * count without mutex locked (the mutex must be released to join the
      * threads). */
+    unsigned nthreads = atomic_load(&executor->nthreads);
 
-    struct vlc_executor_thread *thread;
-    vlc_list_foreach(thread, &executor->threads, node)
-    {
-        vlc_join(thread->thread, NULL);
-        free(thread);
-    }
+    for (unsigned i = 0; i < nthreads; i++)
+        vlc_join(executor->threads[i].thread, NULL);
 
-    /* The queue must still be empty (no runnable submitted a new runnable) */
-    assert(vlc_list_is_empty(&executor->queue));
+    /* The queues must still be empty (no runnable submitted a new runnable) */
+    assert(!HasPending(executor));
 
     /* There are no tasks anymore */
-    assert(!executor->unfinished);
+    assert(!atomic_load(&executor->unfinished));
 
     free(executor);
 }
@@ -26,6 +26,7 @@
 #endif
 
 #include <assert.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 
 #include <vlc_common.h>
@@ -141,3 +142,145 @@ block_t *vlc_fifo_Show( block_fifo_t *p_fifo )
 
     return b;
 }
+
+/**
+ * Internal state for single-producer single-consumer queues
+ *
+ * The producer and consumer indices are kept in separate cache lines, along
+ * with a private copy of the other side's index, so that each side only
+ * touches shared state when the FIFO looks full or empty.
+ */
+struct vlc_spsc_fifo
+{
+    /* Producer side */
+    atomic_size_t write;
+    size_t read_cache;
+    char pad_write[64 - sizeof (atomic_size_t) - sizeof (size_t)];
+
+    /* Consumer side */
+    atomic_size_t read;
+    size_t write_cache;
+    char pad_read[64 - sizeof (atomic_size_t) - sizeof (size_t)];
+
+    atomic_size_t bytes;
+    size_t mask;
+    vlc_frame_t *ring[];
+};
+
+vlc_spsc_fifo_t *vlc_spsc_fifo_New(size_t capacity)
+{
+    size_t size = 1;
+
+    while (size < capacity)
+        size <<= 1;
+
+    vlc_spsc_fifo_t *fifo = malloc(sizeof (*fifo) + size * sizeof (*fifo->ring));
+    if (unlikely(fifo == NULL))
+        return NULL;
+
+    atomic_init(&fifo->write, 0);
+    fifo->read_cache = 0;
+    atomic_init(&fifo->read, 0);
+    fifo->write_cache = 0;
+    atomic_init(&fifo->bytes, 0);
+    fifo->mask = size - 1;
+    return fifo;
+}
+
+void vlc_spsc_fifo_Delete(vlc_spsc_fifo_t *fifo)
+{
+    block_ChainRelease(vlc_spsc_fifo_DequeueUntil(fifo,
+                                                  vlc_spsc_fifo_Mark(fifo)));
+    free(fifo);
+}
+
+bool vlc_spsc_fifo_Push(vlc_spsc_fifo_t *fifo, block_t *block)
+{
+    size_t write = atomic_load_explicit(&fifo->write, memory_order_relaxed);
+    size_t count = 0, size = 0;
+
+    for (block_t *b = block; b != NULL; b = b->p_next) {
+        count++;
+        size += b->i_buffer;
+    }
+
+    if (write + count - fifo->read_cache > fifo->mask + 1) {
+        fifo->read_cache = atomic_load_explicit(&fifo->read,
+                                                memory_order_acquire);
+        if (write + count - fifo->read_cache > fifo->mask + 1)
+            return false;
+    }
+
+    atomic_fetch_add_explicit(&fifo->bytes, size, memory_order_relaxed);
+
+    while (block != NULL) {
+        block_t *next = block->p_next;
+
+        block->p_next = NULL;
+        fifo->ring[write++ & fifo->mask] = block;
+        block = next;
+    }
+
+    atomic_store_explicit(&fifo->write, write, memory_order_release);
+    return true;
+}
+
+block_t *vlc_spsc_fifo_Pop(vlc_spsc_fifo_t *fifo)
+{
+    size_t read = atomic_load_explicit(&fifo->read, memory_order_relaxed);
+
+    if (read == fifo->write_cache) {
+        fifo->write_cache = atomic_load_explicit(&fifo->write,
+                                                 memory_order_acquire);
+        if (read == fifo->write_cache)
+            return NULL;
+    }
+
+    block_t *block = fifo->ring[read & fifo->mask];
+
+    assert(atomic_load_explicit(&fifo->bytes, memory_order_relaxed)
+           >= block->i_buffer);
+    atomic_fetch_sub_explicit(&fifo->bytes, block->i_buffer,
+                              memory_order_relaxed);
+    atomic_store_explicit(&fifo->read, read + 1, memory_order_release);
+    return block;
+}
+
+size_t vlc_spsc_fifo_Mark(vlc_spsc_fifo_t *fifo)
+{
+    return atomic_load_explicit(&fifo->write, memory_order_relaxed);
+}
+
+block_t *vlc_spsc_fifo_DequeueUntil(vlc_spsc_fifo_t *fifo, size_t mark)
+{
+    size_t read = atomic_load_explicit(&fifo->read, memory_order_relaxed);
+    block_t *head = NULL, **pp = &head;
+
+    /* The mark may be behind if the frames were already dequeued. */
+    size_t count = mark - read;
+    if (count > fifo->mask + 1)
+        return NULL;
+
+    while (count-- > 0) {
+        block_t *block = vlc_spsc_fifo_Pop(fifo);
+
+        assert(block != NULL);
+        *pp = block;
+        pp = &block->p_next;
+    }
+    return head;
+}
+
+size_t vlc_spsc_fifo_GetCount(const vlc_spsc_fifo_t *fifo)
+{
+    /* Load the consumer index first, so that it cannot be ahead. */
+    size_t read = atomic_load(&fifo->read);
+    size_t write = atomic_load(&fifo->write);
+
+    return write - read;
+}
+
+size_t vlc_spsc_fifo_GetBytes(const vlc_spsc_fifo_t *fifo)
+{
+    return atomic_load_explicit(&fifo->bytes, memory_order_relaxed);
+}
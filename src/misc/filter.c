@@ -31,6 +31,8 @@
 #include <libvlc.h>
 #include <vlc_filter.h>
 #include <vlc_modules.h>
+#include <vlc_executor.h>
+#include <vlc_atomic.h>
 #include "../misc/variables.h"
 
 /* */
@@ -110,6 +112,107 @@ void filter_DelProxyCallbacks( vlc_object_t *obj, filter_t *filter,
 
 /* */
 
+/* Maximum number of threads processing the slices of one call */
+#define SLICES_MAX_THREADS 32
+/* Slices per thread, to even out differences in slices processing time */
+#define SLICES_PER_THREAD 4
+
+struct vlc_filter_slices
+{
+    filter_t *filter;
+    vlc_filter_slice_cb cb;
+    void *opaque;
+    unsigned rows;
+    unsigned step;
+    unsigned count;
+    atomic_uint next;
+    vlc_sem_t done;
+    struct vlc_runnable runnables[SLICES_MAX_THREADS];
+};
+
+static void ProcessSlices(struct vlc_filter_slices *slices)
+{
+    unsigned i;
+
+    while ((i = atomic_fetch_add_explicit(&slices->next, 1,
+                                          memory_order_relaxed))
+           < slices->count)
+    {
+        unsigned first = i * slices->step;
+        unsigned last = __MIN(first + slices->step, slices->rows);
+
+        slices->cb(slices->filter, slices->opaque, first, last);
+    }
+}
+
+static void RunSlicesThread(void *data)
+{
+    struct vlc_filter_slices *slices = data;
+
+    ProcessSlices(slices);
+    vlc_sem_post(&slices->done);
+}
+
+static void CreateSlicesThreads(void *data)
+{
+    libvlc_priv_t *priv = data;
+
+    priv->filter_executor = vlc_executor_New(priv->filter_threads - 1);
+}
+
+void vlc_filter_RunSlices(filter_t *filter, unsigned rows, unsigned align,
+                          vlc_filter_slice_cb cb, void *opaque)
+{
+    libvlc_priv_t *priv = libvlc_priv(vlc_object_instance(filter));
+    unsigned threads = filter->b_allow_slices ? priv->filter_threads : 1;
+
+    if (align == 0)
+        align = 1;
+
+    unsigned units = (rows + align - 1) / align;
+    unsigned count = __MIN(units, threads * SLICES_PER_THREAD);
+
+    if (threads > 1 && count > 1)
+        vlc_once(&priv->filter_once, CreateSlicesThreads, priv);
+
+    if (threads <= 1 || count <= 1 || priv->filter_executor == NULL)
+    {
+        cb(filter, opaque, 0, rows);
+        return;
+    }
+
+    struct vlc_filter_slices slices = {
+        .filter = filter,
+        .cb = cb,
+        .opaque = opaque,
+        .rows = rows,
+        .step = (units + count - 1) / count * align,
+    };
+    slices.count = (rows + slices.step - 1) / slices.step;
+    atomic_init(&slices.next, 0);
+    vlc_sem_init(&slices.done, 0);
+
+    unsigned workers = __MIN(__MIN(threads, slices.count) - 1,
+                             SLICES_MAX_THREADS);
+
+    for (unsigned i = 0; i < workers; i++)
+    {
+        struct vlc_runnable *runnable = &slices.runnables[i];
+
+        runnable->run = RunSlicesThread;
+        runnable->userdata = &slices;
+        vlc_executor_SubmitWithPriority(priv->filter_executor, runnable,
+                                        VLC_EXECUTOR_PRIORITY_HIGH);
+    }
+
+    ProcessSlices(&slices);
+
+    /* Workers that did not start yet have nothing left to do */
+    for (unsigned i = 0; i < workers; i++)
+        if (!vlc_executor_Cancel(priv->filter_executor, &slices.runnables[i]))
+            vlc_sem_wait(&slices.done);
+}
+
 vlc_blender_t *filter_NewBlend( vlc_object_t *p_this,
                            const video_format_t *p_dst_chroma )
 {
@@ -29,6 +29,7 @@
 #include <vlc_configuration.h>
 #include <vlc_modules.h>
 #include <vlc_mouse.h>
+#include <vlc_picture_pool.h>
 #include <vlc_spu.h>
 #include <libvlc.h>
 #include <assert.h>
@@ -124,6 +125,8 @@ typedef struct chained_filter_t
     struct vlc_list node;
     vlc_mouse_t mouse;
     vlc_picture_chain_t pending;
+    picture_pool_t *pool; /**< Intermediate pictures (not for the last filter) */
+    video_format_t pool_fmt;
 } chained_filter_t;
 
 /* */
@@ -175,6 +178,29 @@ filter_chain_t *filter_chain_NewSPU( vlc_object_t *obj, const char *cap )
     return filter_chain_NewInner( obj, cap, NULL, false, SPU_ES );
 }
 
+/* Pictures between two filters of a chain are usually released by the next
+ * filter before the following one is requested, so that a couple of them are
+ * enough to avoid allocating a new picture for every frame. Filters keeping
+ * more pictures (deinterlacers...) fall back to the heap. */
+#define FILTER_CHAIN_POOL_SIZE 2
+
+static picture_t *filter_chain_PoolGet( chained_filter_t *chained )
+{
+    const video_format_t *fmt = &chained->filter.fmt_out.video;
+
+    if( !video_format_IsSimilar( &chained->pool_fmt, fmt ) )
+    {
+        if( chained->pool != NULL )
+            picture_pool_Release( chained->pool );
+        video_format_Clean( &chained->pool_fmt );
+        video_format_Copy( &chained->pool_fmt, fmt );
+        /* Fails for opaque chromas, which are allocated by their owner */
+        chained->pool = picture_pool_NewFromFormat( fmt,
+                                                    FILTER_CHAIN_POOL_SIZE );
+    }
+    return chained->pool != NULL ? picture_pool_Get( chained->pool ) : NULL;
+}
+
 /** Chained filter picture allocator function */
 static picture_t *filter_chain_VideoBufferNew( filter_t *filter )
 {
@@ -183,6 +209,10 @@ static picture_t *filter_chain_VideoBufferNew( filter_t *filter )
     filter_chain_t *chain = filter->owner.sys;
     if( !vlc_list_is_last( &chained->node, &chain->filter_list ) )
     {
+        pic = filter_chain_PoolGet( chained );
+        if( pic != NULL )
+            return pic;
+
         // HACK as intermediate filters may not have the same video format as
         // the last one handled by the owner
         filter_owner_t saved_owner = filter->owner;
@@ -313,6 +343,7 @@ static filter_t *filter_chain_AppendInner( filter_chain_t *chain,
     filter->vctx_in = vctx_in;
     es_format_Copy( &filter->fmt_out, fmt_out );
     filter->b_allow_fmt_out_change = chain->b_allow_fmt_out_change;
+    filter->b_allow_slices = fmt_in->i_cat == VIDEO_ES;
     filter->p_cfg = cfg;
     filter->psz_name = name;
 
@@ -347,6 +378,8 @@ static filter_t *filter_chain_AppendInner( filter_chain_t *chain,
 
     vlc_mouse_Init( &chained->mouse );
     vlc_picture_chain_Init( &chained->pending );
+    chained->pool = NULL;
+    video_format_Init( &chained->pool_fmt, 0 );
 
     msg_Dbg( chain->obj, "Filter '%s' (%p) appended to chain (%p)",
              (name != NULL) ? name : module_GetShortName(filter->p_module),
@@ -391,6 +424,9 @@ void filter_chain_DeleteFilter( filter_chain_t *chain, filter_t *filter )
 
     msg_Dbg( chain->obj, "Filter %p removed from chain", (void *)filter );
     FilterDeletePictures( &chained->pending );
+    if( chained->pool != NULL )
+        picture_pool_Release( chained->pool );
+    video_format_Clean( &chained->pool_fmt );
 
     es_format_Clean( &filter->fmt_out );
     es_format_Clean( &filter->fmt_in );
@@ -40,6 +40,7 @@
 #include <vlc_fs.h>
 
 #include "ancillary.h"
+#include "frame.h"
 
 #ifndef NDEBUG
 static void vlc_frame_Check (vlc_frame_t *frame)
@@ -112,6 +113,382 @@ vlc_frame_t *vlc_frame_Init(vlc_frame_t *restrict f, const struct vlc_frame_call
 /** Initial reserved header and footer size. */
 #define VLC_FRAME_PADDING      32
 
+/*
+ * Frame cache
+ *
+ * Small and medium frames are allocated from size classes (powers of two
+ * from 256 bytes to 64 KiB of payload). Released frames are kept in a
+ * per-thread free list for their class, so that a thread allocating and
+ * releasing frames at a steady rate does not call the heap allocator.
+ * Frames are commonly allocated by one thread and released by another, so
+ * the per-thread lists are balanced through a global list per class: a full
+ * per-thread list gives half of its frames to the global list, and an empty
+ * one takes frames back from it in a single locked operation.
+ *
+ * The global lists share a bound on their total size. The cache exists while
+ * a LibVLC instance does: releasing the last one empties the global lists
+ * and those of the calling thread.
+ */
+#define VLC_FRAME_CACHE_MIN_SHIFT 8
+#define VLC_FRAME_CACHE_CLASSES   9
+
+struct vlc_frame_cached
+{
+    vlc_frame_t frame;
+    unsigned cls;
+};
+
+struct vlc_frame_cache_bin
+{
+    vlc_frame_t *head;
+    unsigned count;
+};
+
+struct vlc_frame_cache_thread
+{
+    struct vlc_frame_cache_bin bins[VLC_FRAME_CACHE_CLASSES];
+    uint64_t allocs;
+    uint64_t heap_allocs;
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    struct vlc_frame_cache_bin bin;
+} vlc_frame_cache[VLC_FRAME_CACHE_CLASSES] = {
+#define BIN { VLC_STATIC_MUTEX, { NULL, 0 } }
+    BIN, BIN, BIN, BIN, BIN, BIN, BIN, BIN, BIN,
+#undef BIN
+};
+
+static atomic_uint_fast64_t vlc_frame_cache_allocs = 0;
+static atomic_uint_fast64_t vlc_frame_cache_heap_allocs = 0;
+
+static atomic_size_t vlc_frame_cache_bytes = 0;
+
+static vlc_mutex_t vlc_frame_cache_lock = VLC_STATIC_MUTEX;
+static unsigned vlc_frame_cache_refs = 0;
+static vlc_threadvar_t vlc_frame_cache_key;
+static atomic_bool vlc_frame_cache_ok = false;
+
+static unsigned vlc_frame_cache_Class(size_t size)
+{
+    unsigned cls = 0;
+
+    while (size > ((size_t)1 << (VLC_FRAME_CACHE_MIN_SHIFT + cls)))
+        if (++cls >= VLC_FRAME_CACHE_CLASSES)
+            break;
+    return cls;
+}
+
+/** Maximum number of frames in a per-thread list */
+static unsigned vlc_frame_cache_ThreadMax(unsigned cls)
+{
+    unsigned max = (256 * 1024) >> (VLC_FRAME_CACHE_MIN_SHIFT + cls);
+    return VLC_CLIP(max, 8, 64);
+}
+
+/** Maximum total size of the frames in the global lists */
+#define VLC_FRAME_CACHE_GLOBAL_MAX (4 * 1024 * 1024)
+
+/** Allocated size of a cached frame */
+static size_t vlc_frame_cache_Size(unsigned cls)
+{
+    return sizeof (struct vlc_frame_cached) + VLC_FRAME_ALIGN
+         + (2 * VLC_FRAME_PADDING)
+         + ((size_t)1 << (VLC_FRAME_CACHE_MIN_SHIFT + cls));
+}
+
+/**
+ * Accounts for up to count frames of a given size in the global lists.
+ * \return the number of frames that fit
+ */
+static unsigned vlc_frame_cache_Reserve(size_t size, unsigned count)
+{
+    size_t bytes = atomic_load_explicit(&vlc_frame_cache_bytes,
+                                        memory_order_relaxed);
+    unsigned n;
+
+    do
+    {
+        size_t room = (bytes < VLC_FRAME_CACHE_GLOBAL_MAX)
+                    ? (VLC_FRAME_CACHE_GLOBAL_MAX - bytes) / size : 0;
+
+        n = (count < room) ? count : room;
+        if (n == 0)
+            break;
+    }
+    while (!atomic_compare_exchange_weak_explicit(&vlc_frame_cache_bytes,
+                                                  &bytes, bytes + n * size,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed));
+    return n;
+}
+
+static void vlc_frame_cache_FlushStats(struct vlc_frame_cache_thread *tc)
+{
+    atomic_fetch_add_explicit(&vlc_frame_cache_allocs, tc->allocs,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&vlc_frame_cache_heap_allocs, tc->heap_allocs,
+                              memory_order_relaxed);
+    tc->allocs = 0;
+    tc->heap_allocs = 0;
+}
+
+/**
+ * Moves frames from a per-thread list to the global list of their class.
+ * Frames that do not fit in the global list are freed.
+ */
+static void vlc_frame_cache_Give(struct vlc_frame_cache_bin *bin,
+                                 unsigned cls, unsigned count)
+{
+    unsigned n = vlc_frame_cache_Reserve(vlc_frame_cache_Size(cls), count);
+
+    count -= n;
+    vlc_mutex_lock(&vlc_frame_cache[cls].lock);
+    struct vlc_frame_cache_bin *global = &vlc_frame_cache[cls].bin;
+
+    for (; n > 0; n--)
+    {
+        vlc_frame_t *f = bin->head;
+
+        bin->head = f->p_next;
+        bin->count--;
+        f->p_next = global->head;
+        global->head = f;
+        global->count++;
+    }
+    vlc_mutex_unlock(&vlc_frame_cache[cls].lock);
+
+    for (; count > 0; count--)
+    {
+        vlc_frame_t *f = bin->head;
+
+        bin->head = f->p_next;
+        bin->count--;
+        free(container_of(f, struct vlc_frame_cached, frame));
+    }
+}
+
+/**
+ * Moves up to count frames from the global list to a per-thread list.
+ */
+static void vlc_frame_cache_Take(struct vlc_frame_cache_bin *bin,
+                                 unsigned cls, unsigned count)
+{
+    unsigned n = 0;
+
+    vlc_mutex_lock(&vlc_frame_cache[cls].lock);
+    struct vlc_frame_cache_bin *global = &vlc_frame_cache[cls].bin;
+
+    for (; n < count && global->count > 0; n++)
+    {
+        vlc_frame_t *f = global->head;
+
+        global->head = f->p_next;
+        global->count--;
+        f->p_next = bin->head;
+        bin->head = f;
+        bin->count++;
+    }
+    vlc_mutex_unlock(&vlc_frame_cache[cls].lock);
+
+    atomic_fetch_sub_explicit(&vlc_frame_cache_bytes,
+                              n * vlc_frame_cache_Size(cls),
+                              memory_order_relaxed);
+}
+
+static void vlc_frame_cache_Free(vlc_frame_t *f)
+{
+    while (f != NULL)
+    {
+        vlc_frame_t *next = f->p_next;
+
+        free(container_of(f, struct vlc_frame_cached, frame));
+        f = next;
+    }
+}
+
+static void vlc_frame_cache_ThreadDestroy(void *data)
+{
+    struct vlc_frame_cache_thread *tc = data;
+
+    for (unsigned cls = 0; cls < VLC_FRAME_CACHE_CLASSES; cls++)
+    {
+        struct vlc_frame_cache_bin *bin = &tc->bins[cls];
+
+        if (bin->count > 0)
+            vlc_frame_cache_Give(bin, cls, bin->count);
+    }
+    vlc_frame_cache_FlushStats(tc);
+    free(tc);
+}
+
+void vlc_frame_cache_Hold(void)
+{
+    vlc_mutex_lock(&vlc_frame_cache_lock);
+    if (vlc_frame_cache_refs++ == 0)
+    {
+        bool ok = vlc_threadvar_create(&vlc_frame_cache_key,
+                                       vlc_frame_cache_ThreadDestroy) == 0;
+
+        atomic_store_explicit(&vlc_frame_cache_ok, ok, memory_order_release);
+    }
+    vlc_mutex_unlock(&vlc_frame_cache_lock);
+}
+
+void vlc_frame_cache_Drop(void)
+{
+    vlc_mutex_lock(&vlc_frame_cache_lock);
+    assert(vlc_frame_cache_refs > 0);
+    if (--vlc_frame_cache_refs == 0
+     && atomic_load_explicit(&vlc_frame_cache_ok, memory_order_relaxed))
+    {
+        atomic_store_explicit(&vlc_frame_cache_ok, false,
+                              memory_order_relaxed);
+
+        /* Deleting the key does not run the destructor */
+        struct vlc_frame_cache_thread *tc =
+            vlc_threadvar_get(vlc_frame_cache_key);
+        if (tc != NULL)
+        {
+            for (unsigned cls = 0; cls < VLC_FRAME_CACHE_CLASSES; cls++)
+                vlc_frame_cache_Free(tc->bins[cls].head);
+            vlc_frame_cache_FlushStats(tc);
+            free(tc);
+            vlc_threadvar_set(vlc_frame_cache_key, NULL);
+        }
+        vlc_threadvar_delete(&vlc_frame_cache_key);
+
+        for (unsigned cls = 0; cls < VLC_FRAME_CACHE_CLASSES; cls++)
+        {
+            vlc_mutex_lock(&vlc_frame_cache[cls].lock);
+            struct vlc_frame_cache_bin global = vlc_frame_cache[cls].bin;
+
+            vlc_frame_cache[cls].bin.head = NULL;
+            vlc_frame_cache[cls].bin.count = 0;
+            vlc_mutex_unlock(&vlc_frame_cache[cls].lock);
+
+            atomic_fetch_sub_explicit(&vlc_frame_cache_bytes,
+                                      global.count * vlc_frame_cache_Size(cls),
+                                      memory_order_relaxed);
+            vlc_frame_cache_Free(global.head);
+        }
+    }
+    vlc_mutex_unlock(&vlc_frame_cache_lock);
+}
+
+static struct vlc_frame_cache_thread *vlc_frame_cache_Thread(void)
+{
+    if (!atomic_load_explicit(&vlc_frame_cache_ok, memory_order_acquire))
+        return NULL;
+
+    struct vlc_frame_cache_thread *tc = vlc_threadvar_get(vlc_frame_cache_key);
+    if (likely(tc != NULL))
+        return tc;
+
+    tc = calloc(1, sizeof (*tc));
+    if (unlikely(tc == NULL))
+        return NULL;
+    if (unlikely(vlc_threadvar_set(vlc_frame_cache_key, tc)))
+    {
+        free(tc);
+        return NULL;
+    }
+    return tc;
+}
+
+static void vlc_frame_cache_Release(vlc_frame_t *f)
+{
+    struct vlc_frame_cached *cf = container_of(f, struct vlc_frame_cached,
+                                               frame);
+    struct vlc_frame_cache_thread *tc = vlc_frame_cache_Thread();
+    unsigned cls = cf->cls;
+
+    if (unlikely(tc == NULL))
+    {
+        free(cf);
+        return;
+    }
+
+    struct vlc_frame_cache_bin *bin = &tc->bins[cls];
+    unsigned max = vlc_frame_cache_ThreadMax(cls);
+
+    f->p_next = bin->head;
+    bin->head = f;
+    if (++bin->count > max)
+        vlc_frame_cache_Give(bin, cls, max / 2);
+}
+
+static const struct vlc_frame_callbacks vlc_frame_cache_cbs =
+{
+    vlc_frame_cache_Release,
+};
+
+static vlc_frame_t *vlc_frame_cache_Alloc(size_t size)
+{
+#ifdef __SANITIZE_ADDRESS__
+    /* Do not hide use-after-free errors from the address sanitizer */
+    return NULL;
+#endif
+    unsigned cls = vlc_frame_cache_Class(size);
+    if (cls >= VLC_FRAME_CACHE_CLASSES)
+        return NULL;
+
+    struct vlc_frame_cache_thread *tc = vlc_frame_cache_Thread();
+    if (unlikely(tc == NULL))
+        return NULL;
+
+    struct vlc_frame_cache_bin *bin = &tc->bins[cls];
+    size_t capacity = (2 * VLC_FRAME_PADDING)
+                    + ((size_t)1 << (VLC_FRAME_CACHE_MIN_SHIFT + cls));
+    struct vlc_frame_cached *cf;
+
+    if (bin->count == 0)
+        vlc_frame_cache_Take(bin, cls, vlc_frame_cache_ThreadMax(cls) / 2);
+
+    if (++tc->allocs >= 1024 || bin->count == 0)
+        vlc_frame_cache_FlushStats(tc);
+    if (likely(bin->count > 0))
+    {
+        vlc_frame_t *f = bin->head;
+
+        bin->head = f->p_next;
+        bin->count--;
+        cf = container_of(f, struct vlc_frame_cached, frame);
+    }
+    else
+    {
+        cf = malloc(vlc_frame_cache_Size(cls));
+        if (unlikely(cf == NULL))
+            return NULL;
+        cf->cls = cls;
+        tc->heap_allocs++;
+    }
+
+    unsigned char *buf = (unsigned char *)(cf + 1);
+
+    buf += (-(uintptr_t)(void *)buf) % (uintptr_t)VLC_FRAME_ALIGN;
+
+    vlc_frame_t *f = vlc_frame_Init(&cf->frame, &vlc_frame_cache_cbs,
+                                    buf, capacity);
+    f->p_buffer = buf + VLC_FRAME_PADDING;
+    f->i_buffer = size;
+    return f;
+}
+
+void vlc_frame_cache_GetStats(struct vlc_frame_cache_stats *stats)
+{
+    struct vlc_frame_cache_thread *tc = vlc_frame_cache_Thread();
+
+    if (tc != NULL)
+        vlc_frame_cache_FlushStats(tc);
+    stats->allocs = atomic_load_explicit(&vlc_frame_cache_allocs,
+                                         memory_order_relaxed);
+    stats->heap_allocs = atomic_load_explicit(&vlc_frame_cache_heap_allocs,
+                                              memory_order_relaxed);
+}
+
 vlc_frame_t *vlc_frame_Alloc (size_t size)
 {
     if (unlikely(size >> 28))
@@ -120,6 +497,15 @@ vlc_frame_t *vlc_frame_Alloc (size_t size)
         return NULL;
     }
 
+    vlc_frame_t *f = vlc_frame_cache_Alloc(size);
+    if (f != NULL)
+        return f;
+
+    atomic_fetch_add_explicit(&vlc_frame_cache_allocs, 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&vlc_frame_cache_heap_allocs, 1,
+                              memory_order_relaxed);
+
     static_assert ((VLC_FRAME_PADDING % VLC_FRAME_ALIGN) == 0,
                    "VLC_FRAME_PADDING must be a multiple of VLC_FRAME_ALIGN");
 
@@ -136,7 +522,7 @@ vlc_frame_t *vlc_frame_Alloc (size_t size)
     if (unlikely(buf == NULL))
         return NULL;
 
-    vlc_frame_t *f = vlc_frame_heap_Alloc(buf, capacity);
+    f = vlc_frame_heap_Alloc(buf, capacity);
     if (likely(f != NULL)) {
 #ifndef HAVE_ALIGNED_ALLOC
         /* Alignment */
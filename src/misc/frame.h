@@ -0,0 +1,60 @@
+/*****************************************************************************
+ * frame.h: frame internals
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FRAME_INTERNAL_H
+# define VLC_FRAME_INTERNAL_H 1
+
+#include <stdint.h>
+
+/**
+ * Enables the frame cache.
+ *
+ * The cache is reference counted: it is enabled until vlc_frame_cache_Drop()
+ * has been called as many times as this function.
+ */
+void vlc_frame_cache_Hold(void);
+
+/**
+ * Releases a reference to the frame cache.
+ *
+ * Dropping the last reference frees the frames kept by the global lists and
+ * by the calling thread. No other thread may allocate or release frames
+ * concurrently.
+ */
+void vlc_frame_cache_Drop(void);
+
+/**
+ * Process-wide statistics of vlc_frame_Alloc()
+ */
+struct vlc_frame_cache_stats
+{
+    uint64_t allocs; /**< Frames allocated */
+    uint64_t heap_allocs; /**< Frames that were not recycled from the cache */
+};
+
+/**
+ * Gets the frame allocation statistics.
+ *
+ * The counters of each thread are published in batches, so recent
+ * allocations of other threads may not be accounted for yet.
+ */
+void vlc_frame_cache_GetStats(struct vlc_frame_cache_stats *);
+
+#endif
@@ -38,6 +38,7 @@
 
 #include <vlc_common.h>
 #include <vlc_threads.h>
+#include <vlc_atomic.h>
 #include <vlc_interface.h>
 #include <vlc_charset.h>
 #include <vlc_modules.h>
@@ -418,6 +419,287 @@ static struct vlc_logger *vlc_LogModuleCreate(vlc_object_t *parent)
     return &module->frontend;
 }
 
+/**
+ * Asynchronous message log.
+ *
+ * A message log that queues messages in a bounded lock-free ring and passes
+ * them to another log from a dedicated thread. The emitting threads only
+ * format the message in place; the back-end, its locks and its I/O run on
+ * the logging thread.
+ */
+#define LOG_ASYNC_SLOTS     1024 /* must be a power of two */
+#define LOG_ASYNC_TEXT_SIZE  256
+
+struct vlc_log_async_slot {
+    atomic_size_t seq;
+    int type;
+    vlc_log_t meta;
+    char *text; /**< Message text, NULL if lost */
+    char *heap; /**< Heap storage for long messages, or NULL */
+    char buf[LOG_ASYNC_TEXT_SIZE]; /**< Module, header and text storage */
+};
+
+struct vlc_logger_async {
+    struct vlc_logger frontend;
+    struct vlc_logger *backend;
+    vlc_thread_t thread;
+
+    atomic_size_t head; /**< Next slot to be claimed by an emitter */
+    atomic_size_t tail; /**< Next slot to be passed to the back-end */
+    atomic_ulong dropped; /**< Messages dropped since the last report */
+    atomic_bool waiting; /**< Whether the logging thread may be sleeping */
+    atomic_bool closing;
+    atomic_uint wakeup; /**< Wake-up sequence for the logging thread */
+
+    struct vlc_log_async_slot slots[LOG_ASYNC_SLOTS];
+};
+
+/**
+ * Copies the message meta-data and formats the message text into a slot.
+ *
+ * The module name and the header may not outlive the call, so they are
+ * copied along with the text, in the slot buffer if they fit.
+ */
+static void vlc_LogAsyncFill(struct vlc_log_async_slot *slot, int type,
+                             const vlc_log_t *item, const char *format,
+                             va_list ap)
+{
+    size_t modlen = strlen(item->psz_module) + 1;
+    size_t hdrlen = (item->psz_header != NULL)
+                  ? strlen(item->psz_header) + 1 : 0;
+    size_t offset = modlen + hdrlen;
+    char *buf = slot->buf;
+    va_list dol;
+    int len;
+
+    va_copy(dol, ap);
+    if (offset < sizeof (slot->buf))
+        len = vsnprintf(buf + offset, sizeof (slot->buf) - offset, format,
+                        dol);
+    else
+        len = vsnprintf(NULL, 0, format, dol);
+    va_end(dol);
+
+    if (unlikely(len < 0))
+        len = 0;
+
+    if (offset + len >= sizeof (slot->buf))
+    {   /* Too long for the slot: format again on the heap. */
+        buf = malloc(offset + len + 1);
+        if (likely(buf != NULL))
+            vsnprintf(buf + offset, len + 1, format, ap);
+    }
+
+    slot->type = type;
+    slot->meta = *item;
+    slot->heap = (buf != slot->buf) ? buf : NULL;
+
+    if (unlikely(buf == NULL))
+    {
+        strlcpy(slot->buf, item->psz_module, sizeof (slot->buf));
+        slot->meta.psz_module = slot->buf;
+        slot->meta.psz_header = NULL;
+        slot->text = NULL;
+        return;
+    }
+
+    memcpy(buf, item->psz_module, modlen);
+    slot->meta.psz_module = buf;
+    if (hdrlen > 0)
+    {
+        memcpy(buf + modlen, item->psz_header, hdrlen);
+        slot->meta.psz_header = buf + modlen;
+    }
+    slot->text = buf + offset;
+}
+
+static void vlc_vaLogAsync(void *d, int type, const vlc_log_t *item,
+                           const char *format, va_list ap)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, frontend);
+    struct vlc_log_async_slot *slot;
+    size_t pos = atomic_load_explicit(&async->head, memory_order_relaxed);
+
+    for (;;)
+    {
+        /* Debug messages must leave room for more important ones. */
+        if (type == VLC_MSG_DBG
+         && pos - atomic_load_explicit(&async->tail, memory_order_relaxed)
+                >= LOG_ASYNC_SLOTS * 3 / 4)
+            goto drop;
+
+        slot = &async->slots[pos & (LOG_ASYNC_SLOTS - 1)];
+
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&async->head, &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            goto drop; /* full */
+        else
+            pos = atomic_load_explicit(&async->head, memory_order_relaxed);
+    }
+
+    vlc_LogAsyncFill(slot, type, item, format, ap);
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    /* Pairs with the fence in vlc_LogAsyncThread() */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&async->waiting, memory_order_relaxed))
+    {
+        atomic_fetch_add_explicit(&async->wakeup, 1, memory_order_relaxed);
+        vlc_atomic_notify_one(&async->wakeup);
+    }
+    return;
+
+drop:
+    atomic_fetch_add_explicit(&async->dropped, 1, memory_order_relaxed);
+}
+
+static void vlc_LogAsyncForward(struct vlc_logger *backend, int type,
+                                const vlc_log_t *item, const char *format,
+                                ...)
+{
+    va_list ap;
+
+    va_start(ap, format);
+    backend->ops->log(backend, type, item, format, ap);
+    va_end(ap);
+}
+
+static void vlc_LogAsyncReportDropped(struct vlc_logger_async *async)
+{
+    unsigned long dropped = atomic_exchange_explicit(&async->dropped, 0,
+                                                     memory_order_relaxed);
+    if (dropped == 0)
+        return;
+
+    vlc_log_t meta = {
+        .i_object_id = (uintptr_t)(void *)async,
+        .psz_object_type = "logger",
+        .psz_module = "core",
+        .psz_header = NULL,
+        .file = __FILE__,
+        .line = __LINE__,
+        .func = __func__,
+        .tid = vlc_thread_id(),
+    };
+
+    vlc_LogAsyncForward(async->backend, VLC_MSG_WARN, &meta,
+                        "%lu log message(s) dropped", dropped);
+}
+
+static void *vlc_LogAsyncThread(void *data)
+{
+    struct vlc_logger_async *async = data;
+    size_t pos = atomic_load_explicit(&async->tail, memory_order_relaxed);
+
+    vlc_thread_set_name("vlc-logger");
+
+    for (;;)
+    {
+        struct vlc_log_async_slot *slot =
+            &async->slots[pos & (LOG_ASYNC_SLOTS - 1)];
+
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) == pos + 1)
+        {
+            vlc_LogAsyncForward(async->backend, slot->type, &slot->meta, "%s",
+                                (slot->text != NULL) ? slot->text
+                                                     : "message lost");
+            free(slot->heap);
+
+            atomic_store_explicit(&slot->seq, pos + LOG_ASYNC_SLOTS,
+                                  memory_order_release);
+            atomic_store_explicit(&async->tail, ++pos, memory_order_relaxed);
+            continue;
+        }
+
+        vlc_LogAsyncReportDropped(async);
+
+        if (atomic_load_explicit(&async->closing, memory_order_acquire))
+            break;
+
+        /* Sleep until an emitter or the owner wakes us up */
+        unsigned val = atomic_load_explicit(&async->wakeup,
+                                            memory_order_relaxed);
+
+        atomic_store_explicit(&async->waiting, true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != pos + 1
+         && !atomic_load_explicit(&async->closing, memory_order_relaxed))
+            vlc_atomic_wait(&async->wakeup, val);
+
+        atomic_store_explicit(&async->waiting, false, memory_order_relaxed);
+    }
+
+    return NULL;
+}
+
+static void vlc_LogAsyncClose(void *d)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, frontend);
+    struct vlc_logger *backend = async->backend;
+
+    /* No emitters are left at this point: drain the queue and stop. */
+    atomic_store_explicit(&async->closing, true, memory_order_release);
+    atomic_fetch_add_explicit(&async->wakeup, 1, memory_order_release);
+    vlc_atomic_notify_one(&async->wakeup);
+    vlc_join(async->thread, NULL);
+
+    backend->ops->destroy(backend);
+    free(async);
+}
+
+static const struct vlc_logger_operations async_ops = {
+    vlc_vaLogAsync,
+    vlc_LogAsyncClose,
+};
+
+/**
+ * Wraps a message log into an asynchronous message log.
+ *
+ * \return the asynchronous log, or the original log on error
+ */
+static struct vlc_logger *vlc_LogAsyncCreate(struct vlc_logger *backend)
+{
+    if (backend == &discard_log)
+        return backend;
+
+    struct vlc_logger_async *async = malloc(sizeof (*async));
+    if (unlikely(async == NULL))
+        return backend;
+
+    async->frontend.ops = &async_ops;
+    async->backend = backend;
+    atomic_init(&async->head, 0);
+    atomic_init(&async->tail, 0);
+    atomic_init(&async->dropped, 0);
+    atomic_init(&async->waiting, false);
+    atomic_init(&async->closing, false);
+    atomic_init(&async->wakeup, 0);
+    for (size_t i = 0; i < LOG_ASYNC_SLOTS; i++)
+        atomic_init(&async->slots[i].seq, i);
+
+    if (vlc_clone(&async->thread, vlc_LogAsyncThread, async))
+    {
+        free(async);
+        return backend;
+    }
+    return &async->frontend;
+}
+
 /**
  * Initializes the messages logging subsystem and drain the early messages to
  * the configured log.
@@ -427,6 +709,8 @@ void vlc_LogInit(libvlc_int_t *vlc)
     struct vlc_logger *logger = vlc_LogModuleCreate(VLC_OBJECT(vlc));
     if (logger == NULL)
         logger = &discard_log;
+    else if (var_InheritBool(vlc, "log-async"))
+        logger = vlc_LogAsyncCreate(logger);
 
     vlc_LogSwitch(vlc->obj.logger, logger);
 }
@@ -562,6 +846,8 @@ void vlc_LogSet(libvlc_int_t *vlc, const struct vlc_logger_operations *ops,
 
     if (logger == NULL)
         logger = &discard_log;
+    else if (var_InheritBool(vlc, "log-async"))
+        logger = vlc_LogAsyncCreate(logger);
 
     vlc_LogSwitch(vlc->obj.logger, logger);
     vlc_LogSpam(VLC_OBJECT(vlc));
@@ -27,9 +27,6 @@
 # include "config.h"
 #endif
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 #include <assert.h>
 #include <float.h>
 #include <math.h>
@@ -67,7 +64,8 @@ typedef struct variable_ops_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    char *       psz_name; /**< The variable unique name */
+    uint32_t     hash; /**< Hash of the name */
 
     /** The variable's exported value */
     vlc_value_t  val;
@@ -138,23 +136,138 @@ int_ops    = { CmpInt,     DupDummy,  FreeDummy,  },
 string_ops = { CmpString,  DupString, FreeString, },
 coords_ops = { NULL,       DupDummy,  FreeDummy,  };
 
-static int varcmp( const void *a, const void *b )
+/**
+ * Interned variable name, see var_Lookup()
+ */
+struct vlc_var_name
 {
-    const variable_t *va = a, *vb = b;
+    struct vlc_var_name *next;
+    uint32_t hash;
+    char name[];
+};
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+static uint32_t var_Hash( const char *name )
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++)
+        hash = (hash ^ *p) * 16777619u;
+    return hash;
 }
 
-static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
+/**
+ * Finds the slot of a variable, or the free slot where it would be inserted.
+ */
+static variable_t **FindSlot( vlc_object_internals_t *priv,
+                              const char *psz_name, uint32_t hash )
+{
+    vlc_mutex_assert(&priv->var_lock);
+    assert(priv->var_slots != NULL);
+
+    for (size_t i = hash & priv->var_mask;; i = (i + 1) & priv->var_mask)
+    {
+        variable_t **slot = &priv->var_slots[i];
+        variable_t *var = *slot;
+
+        if (var == NULL
+         || (var->hash == hash && strcmp(var->psz_name, psz_name) == 0))
+            return slot;
+    }
+}
+
+/**
+ * Resizes the table of variables.
+ */
+static int Rehash( vlc_object_internals_t *priv, size_t size )
+{
+    variable_t **slots = calloc(size, sizeof (*slots));
+    if (unlikely(slots == NULL))
+        return VLC_ENOMEM;
+
+    variable_t **old_slots = priv->var_slots;
+    size_t old_size = (old_slots != NULL) ? priv->var_mask + 1 : 0;
+
+    priv->var_slots = slots;
+    priv->var_mask = size - 1;
+
+    for (size_t i = 0; i < old_size; i++)
+    {
+        variable_t *var = old_slots[i];
+
+        if (var != NULL)
+            *FindSlot(priv, var->psz_name, var->hash) = var;
+    }
+    free(old_slots);
+    return VLC_SUCCESS;
+}
+
+static int Insert( vlc_object_internals_t *priv, variable_t *var )
+{
+    /* Keep the load factor at most 3/4 */
+    if (priv->var_slots == NULL
+     || (priv->var_count + 1) * 4 > (priv->var_mask + 1) * 3)
+    {
+        size_t size = (priv->var_slots != NULL) ? (priv->var_mask + 1) * 2
+                                                : 8;
+
+        if (Rehash(priv, size))
+            return VLC_ENOMEM;
+    }
+
+    variable_t **slot = FindSlot(priv, var->psz_name, var->hash);
+
+    assert(*slot == NULL);
+    *slot = var;
+    priv->var_count++;
+    return VLC_SUCCESS;
+}
+
+static void Remove( vlc_object_internals_t *priv, variable_t *var )
+{
+    size_t mask = priv->var_mask;
+    size_t i = FindSlot(priv, var->psz_name, var->hash) - priv->var_slots;
+
+    assert(priv->var_slots[i] == var);
+
+    /* Backward shift deletion: move up the following entries of the probe
+     * sequence that are not at their home slot, so that no tombstones are
+     * needed. */
+    for (size_t j = (i + 1) & mask;; j = (j + 1) & mask)
+    {
+        variable_t *next = priv->var_slots[j];
+
+        if (next == NULL)
+            break;
+
+        size_t home = next->hash & mask;
+
+        /* Can the entry at j be moved to the hole at i? */
+        if (((j - home) & mask) >= ((j - i) & mask))
+        {
+            priv->var_slots[i] = next;
+            i = j;
+        }
+    }
+
+    priv->var_slots[i] = NULL;
+    priv->var_count--;
+}
+
+static variable_t *LookupHash( vlc_object_t *obj, const char *psz_name,
+                               uint32_t hash )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
-    void **pp_var;
 
     vlc_mutex_lock(&priv->var_lock);
-    pp_var = tfind( &psz_name, &priv->var_root, varcmp );
-    return (pp_var != NULL) ? *pp_var : NULL;
+    if (priv->var_slots == NULL)
+        return NULL;
+    return *FindSlot(priv, psz_name, hash);
+}
+
+static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
+{
+    return LookupHash(obj, psz_name, var_Hash(psz_name));
 }
 
 static void Destroy( variable_t *p_var )
@@ -295,6 +408,7 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         return VLC_ENOMEM;
 
     p_var->psz_name = strdup( psz_name );
+    p_var->hash = var_Hash( psz_name );
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
@@ -354,17 +468,22 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         var_Inherit(p_this, psz_name, i_type, &p_var->val);
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
-    void **pp_var;
     variable_t *p_oldvar;
     int ret = VLC_SUCCESS;
 
-    vlc_mutex_lock( &p_priv->var_lock );
+    if( unlikely(p_var->psz_name == NULL) )
+    {
+        Destroy( p_var );
+        return VLC_ENOMEM;
+    }
 
-    pp_var = tsearch( p_var, &p_priv->var_root, varcmp );
-    if( unlikely(pp_var == NULL) )
-        ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var ) /* Variable create */
-        p_var = NULL; /* Variable created */
+    p_oldvar = LookupHash( p_this, p_var->psz_name, p_var->hash );
+    if( p_oldvar == NULL ) /* Variable create */
+    {
+        ret = Insert( p_priv, p_var );
+        if( likely(ret == VLC_SUCCESS) )
+            p_var = NULL; /* Variable created */
+    }
     else /* Variable already exists */
     {
         assert (((i_type ^ p_oldvar->i_type) & VLC_VAR_CLASS) == 0);
@@ -394,7 +513,7 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
     else if( --p_var->i_usage == 0 )
     {
         assert(!p_var->b_incallback);
-        tdelete( p_var, &p_priv->var_root, varcmp );
+        Remove( p_priv, p_var );
     }
     else
     {
@@ -407,17 +526,19 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
         Destroy( p_var );
 }
 
-static void CleanupVar( void *var )
-{
-    Destroy( var );
-}
-
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    if( priv->var_slots != NULL )
+        for( size_t i = 0; i <= priv->var_mask; i++ )
+            if( priv->var_slots[i] != NULL )
+                Destroy( priv->var_slots[i] );
+
+    free( priv->var_slots );
+    priv->var_slots = NULL;
+    priv->var_mask = 0;
+    priv->var_count = 0;
 }
 
 int (var_Change)(vlc_object_t *p_this, const char *psz_name, int i_action, ...)
@@ -673,8 +794,8 @@ int (var_Type)(vlc_object_t *p_this, const char *psz_name)
     return i_type;
 }
 
-int (var_SetChecked)(vlc_object_t *p_this, const char *psz_name,
-                     int expected_type, vlc_value_t val)
+static int SetChecked( vlc_object_t *p_this, const char *psz_name,
+                       uint32_t hash, int expected_type, vlc_value_t val )
 {
     variable_t *p_var;
     vlc_value_t oldval;
@@ -683,7 +804,7 @@ int (var_SetChecked)(vlc_object_t *p_this, const char *psz_name,
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
 
-    p_var = Lookup( p_this, psz_name );
+    p_var = LookupHash( p_this, psz_name, hash );
     if( p_var == NULL )
     {
         vlc_mutex_unlock( &p_priv->var_lock );
@@ -718,13 +839,26 @@ int (var_SetChecked)(vlc_object_t *p_this, const char *psz_name,
     return VLC_SUCCESS;
 }
 
+int (var_SetChecked)(vlc_object_t *p_this, const char *psz_name,
+                     int expected_type, vlc_value_t val)
+{
+    return SetChecked( p_this, psz_name, var_Hash( psz_name ), expected_type,
+                       val );
+}
+
+int (var_SetCheckedByHandle)(vlc_object_t *p_this, const vlc_var_name_t *name,
+                             int expected_type, vlc_value_t val)
+{
+    return SetChecked( p_this, name->name, name->hash, expected_type, val );
+}
+
 int (var_Set)(vlc_object_t *p_this, const char *psz_name, vlc_value_t val)
 {
     return var_SetChecked( p_this, psz_name, 0, val );
 }
 
-int (var_GetChecked)(vlc_object_t *p_this, const char *psz_name,
-                     int expected_type, vlc_value_t *p_val)
+static int GetChecked( vlc_object_t *p_this, const char *psz_name,
+                       uint32_t hash, int expected_type, vlc_value_t *p_val )
 {
     assert( p_this );
 
@@ -732,7 +866,7 @@ int (var_GetChecked)(vlc_object_t *p_this, const char *psz_name,
     variable_t *p_var;
     int err = VLC_SUCCESS;
 
-    p_var = Lookup( p_this, psz_name );
+    p_var = LookupHash( p_this, psz_name, hash );
     if( p_var != NULL )
     {
         assert( expected_type == 0 ||
@@ -752,6 +886,19 @@ int (var_GetChecked)(vlc_object_t *p_this, const char *psz_name,
     return err;
 }
 
+int (var_GetChecked)(vlc_object_t *p_this, const char *psz_name,
+                     int expected_type, vlc_value_t *p_val)
+{
+    return GetChecked( p_this, psz_name, var_Hash( psz_name ), expected_type,
+                       p_val );
+}
+
+int (var_GetCheckedByHandle)(vlc_object_t *p_this, const vlc_var_name_t *name,
+                             int expected_type, vlc_value_t *p_val)
+{
+    return GetChecked( p_this, name->name, name->hash, expected_type, p_val );
+}
+
 int (var_Get)(vlc_object_t *p_this, const char *psz_name, vlc_value_t *p_val)
 {
     return var_GetChecked( p_this, psz_name, 0, p_val );
@@ -1135,21 +1282,6 @@ error:
     return VLC_EGENERIC;
 }
 
-static thread_local void *twalk_ctx;
-
-static void TwalkGetNames(const void *data, const VISIT which, const int depth)
-{
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
-
-    const variable_t *var = *(const variable_t **)data;
-    DECL_ARRAY(char *) *names = twalk_ctx;
-    char *dup = strdup(var->psz_name);
-    if (dup != NULL)
-        ARRAY_APPEND(*names, dup);
-}
-
 char **var_GetAllNames(vlc_object_t *obj)
 {
     vlc_object_internals_t *priv = vlc_internals(obj);
@@ -1157,9 +1289,18 @@ char **var_GetAllNames(vlc_object_t *obj)
     DECL_ARRAY(char *) names;
     ARRAY_INIT(names);
 
-    twalk_ctx = &names;
     vlc_mutex_lock(&priv->var_lock);
-    twalk(priv->var_root, TwalkGetNames);
+    if (priv->var_slots != NULL)
+        for (size_t i = 0; i <= priv->var_mask; i++)
+        {
+            const variable_t *var = priv->var_slots[i];
+            if (var == NULL)
+                continue;
+
+            char *dup = strdup(var->psz_name);
+            if (dup != NULL)
+                ARRAY_APPEND(names, dup);
+        }
     vlc_mutex_unlock(&priv->var_lock);
 
     if (names.i_size == 0)
@@ -1167,3 +1308,34 @@ char **var_GetAllNames(vlc_object_t *obj)
     ARRAY_APPEND(names, NULL);
     return names.p_elems;
 }
+
+static struct
+{
+    vlc_mutex_t lock;
+    struct vlc_var_name *buckets[256];
+} var_names = { VLC_STATIC_MUTEX, { NULL } };
+
+const vlc_var_name_t *var_Lookup(const char *psz_name)
+{
+    uint32_t hash = var_Hash(psz_name);
+    struct vlc_var_name **pp = &var_names.buckets[hash % 256], *name;
+
+    vlc_mutex_lock(&var_names.lock);
+    while ((name = *pp) != NULL)
+    {
+        if (name->hash == hash && strcmp(name->name, psz_name) == 0)
+            goto out;
+        pp = &name->next;
+    }
+
+    size_t len = strlen(psz_name) + 1;
+
+    name = xmalloc(sizeof (*name) + len);
+    name->next = NULL;
+    name->hash = hash;
+    memcpy(name->name, psz_name, len);
+    *pp = name;
+out:
+    vlc_mutex_unlock(&var_names.lock);
+    return name;
+}
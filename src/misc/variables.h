@@ -37,8 +37,10 @@ struct vlc_object_internals
     vlc_object_t *parent; /**< Parent object (or NULL) */
     const char *typename; /**< Object type human-readable name */
 
-    /* Object variables */
-    void           *var_root;
+    /* Object variables (open addressing hash table, linear probing) */
+    struct variable_t **var_slots; /**< Table slots (or NULL if empty) */
+    size_t          var_mask; /**< Number of slots minus one */
+    size_t          var_count; /**< Number of variables */
     vlc_mutex_t     var_lock;
 
     /* Object resources */
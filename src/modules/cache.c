@@ -36,9 +36,14 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <assert.h>
+#include <stdckdint.h>
+#ifdef HAVE_SEARCH_H
+# include <search.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include <vlc_memstream.h>
 #include "libvlc.h"
 
 #include <vlc_plugin.h>
@@ -57,13 +62,112 @@
 #ifdef HAVE_DYNAMIC_PLUGINS
 /* Sub-version number
  * (only used to avoid breakage in dev version when cache structure changes) */
-#define CACHE_SUBVERSION_NUM 36
+#define CACHE_SUBVERSION_NUM 37
 
 /* Cache filename */
 #define CACHE_NAME "plugins.dat"
 /* Magic for the cache filename */
 #define CACHE_STRING "cache "PACKAGE_NAME" "PACKAGE_VERSION
 
+/*
+ * The cache file is mapped in memory and used in place. After the text and
+ * version header, it contains a table of contents pointing to:
+ *  - tables of fixed-size plugin, module and configuration item records,
+ *    with the modules and items of each plugin stored consecutively,
+ *  - a table of string references, for module shortcuts and choices lists,
+ *  - a table of integers, for integer choices lists,
+ *  - a pool of nul-terminated strings.
+ * Strings are referenced by their offset within the pool, zero meaning NULL.
+ * All other offsets are relative to the start of the file.
+ */
+struct vlc_cache_section
+{
+    uint32_t offset; /**< Offset of the first entry */
+    uint32_t count; /**< Number of entries (bytes for the string pool) */
+};
+
+struct vlc_cache_toc
+{
+    struct vlc_cache_section plugins;
+    struct vlc_cache_section modules;
+    struct vlc_cache_section params;
+    struct vlc_cache_section refs;
+    struct vlc_cache_section integers;
+    struct vlc_cache_section strings;
+};
+
+struct vlc_cache_plugin
+{
+    int64_t mtime;
+    uint64_t size;
+    uint32_t path;
+    uint32_t textdomain;
+    uint32_t modules; /**< Number of module records */
+    uint16_t params; /**< Number of configuration item records */
+    uint8_t unloadable;
+};
+
+struct vlc_cache_module
+{
+    uint32_t shortname;
+    uint32_t longname;
+    uint32_t help;
+    uint32_t help_html;
+    uint32_t capability;
+    uint32_t activate;
+    uint32_t deactivate;
+    int32_t score;
+    uint32_t shortcuts; /**< Number of string references */
+};
+
+union vlc_cache_value
+{
+    int64_t i;
+    float f;
+};
+
+#define CACHE_PARAM_INTERNAL 0x1
+#define CACHE_PARAM_UNSAVED  0x2
+#define CACHE_PARAM_SAFE     0x4
+#define CACHE_PARAM_OBSOLETE 0x8
+
+struct vlc_cache_param
+{
+    union vlc_cache_value orig; /**< Default (string offset for strings) */
+    union vlc_cache_value min;
+    union vlc_cache_value max;
+    uint32_t type;
+    uint32_t name;
+    uint32_t text;
+    uint32_t longtext;
+    uint16_t list_count;
+    uint8_t i_type;
+    uint8_t shortname;
+    uint8_t flags;
+};
+
+/** Cursors over the tables of a mapped cache file */
+struct vlc_cache_reader
+{
+    const struct vlc_cache_plugin *plugins;
+    const struct vlc_cache_module *modules;
+    const struct vlc_cache_param *params;
+    const uint32_t *refs;
+    const int *integers;
+    const char *strings;
+    struct vlc_cache_toc toc;
+
+    size_t modules_next;
+    size_t params_next;
+    size_t refs_next;
+    size_t integers_next;
+
+    /* Run-time descriptors, allocated at once */
+    vlc_plugin_t *plugin_tab;
+    module_t *module_tab;
+    struct vlc_param *param_tab;
+    const char **ref_tab;
+};
 
 static int vlc_cache_load_immediate(void *out, block_t *in, size_t size)
 {
@@ -76,207 +180,261 @@ static int vlc_cache_load_immediate(void *out, block_t *in, size_t size)
     return 0;
 }
 
-static int vlc_cache_load_bool(bool *out, block_t *in)
+static int vlc_cache_load_align(size_t align, block_t *file)
 {
-    unsigned char b;
+    assert(align > 0);
+
+    size_t skip = (-(uintptr_t)file->p_buffer) % align;
+    if (skip == 0)
+        return 0;
+
+    assert(skip < align);
 
-    if (vlc_cache_load_immediate(&b, in, 1) || b > 1)
+    if (file->i_buffer < skip)
         return -1;
 
-    *out = b;
+    file->p_buffer += skip;
+    file->i_buffer -= skip;
+    assert((((uintptr_t)file->p_buffer) % align) == 0);
     return 0;
 }
 
-static int vlc_cache_load_array(const void **p, size_t size, size_t n,
-                                block_t *file)
+/**
+ * Checks that a section lies within the file and is suitably aligned.
+ */
+static int vlc_cache_load_section(const void **p,
+                                  const unsigned char *start, size_t size,
+                                  const struct vlc_cache_section *section,
+                                  size_t entry_size, size_t align)
 {
-    if (n == 0)
-    {
-        *p = NULL;
-        return 0;
-    }
+    size_t length;
 
-    if (unlikely(size * n < size))
+    if (ckd_mul(&length, entry_size, section->count)
+     || section->offset > size
+     || length > size - section->offset)
         return -1;
 
-    size *= n;
+    const unsigned char *base = start + section->offset;
 
-    if (file->i_buffer < size)
+    if (((uintptr_t)base) % align)
         return -1;
 
-    *p = file->p_buffer;
-    file->p_buffer += size;
-    file->i_buffer -= size;
+    *p = base;
     return 0;
 }
 
-static int vlc_cache_load_string(const char **restrict p, block_t *file)
-{
-    uint16_t size;
-
-    if (vlc_cache_load_immediate(&size, file, sizeof (size)) || size > 16384)
-        return -1;
+#define LOAD_SECTION(name,type) \
+    do \
+    { \
+        const void *base; \
+        if (vlc_cache_load_section(&base, start, size, &r->toc.name, \
+                                   sizeof (type), alignof (type))) \
+            return -1; \
+        r->name = base; \
+    } while (0)
 
-    if (size == 0)
+static int vlc_cache_load_string(const struct vlc_cache_reader *r,
+                                 uint32_t offset, const char **restrict p)
+{
+    if (offset == 0)
     {
         *p = NULL;
         return 0;
     }
 
-    const char *str = (char *)file->p_buffer;
-
-    if (file->i_buffer < size || str[size - 1] != '\0')
+    /* The pool is nul-terminated, so is any string within it */
+    if (offset >= r->toc.strings.count)
         return -1;
 
-    file->p_buffer += size;
-    file->i_buffer -= size;
-    *p = str;
+    *p = r->strings + offset;
     return 0;
 }
 
-static int vlc_cache_load_align(size_t align, block_t *file)
+/**
+ * Resolves the next string references into a table of string pointers.
+ *
+ * \param empty replacement for NULL references
+ */
+static int vlc_cache_load_refs(struct vlc_cache_reader *r, const char ***p,
+                               size_t count, const char *empty)
 {
-    assert(align > 0);
-
-    size_t skip = (-(uintptr_t)file->p_buffer) % align;
-    if (skip == 0)
+    if (count == 0)
+    {
+        *p = NULL;
         return 0;
+    }
 
-    assert(skip < align);
-
-    if (file->i_buffer < skip)
+    if (count > r->toc.refs.count - r->refs_next)
         return -1;
 
-    file->p_buffer += skip;
-    file->i_buffer -= skip;
-    assert((((uintptr_t)file->p_buffer) % align) == 0);
+    const char **tab = r->ref_tab + r->refs_next;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (vlc_cache_load_string(r, r->refs[r->refs_next + i], &tab[i]))
+            return -1;
+        if (tab[i] == NULL)
+            tab[i] = empty;
+    }
+
+    r->refs_next += count;
+    *p = tab;
     return 0;
 }
 
-#define LOAD_IMMEDIATE(a) \
-    if (vlc_cache_load_immediate(&(a), file, sizeof (a))) \
+#define LOAD_STRING(a,o) \
+    if (vlc_cache_load_string(r, (o), &(a))) \
         goto error
-#define LOAD_FLAG(a) \
-    do \
-    { \
-        bool b; \
-        if (vlc_cache_load_bool(&b, file)) \
-            goto error; \
-        (a) = b; \
-    } while (0)
-#define LOAD_ARRAY(a,n) \
+#define LOAD_REFS(a,n,e) \
     do \
     { \
-        const void *base; \
-        if (vlc_cache_load_array(&base, sizeof (*(a)), (n), file)) \
+        const char **tab; \
+        if (vlc_cache_load_refs(r, &tab, (n), (e))) \
             goto error; \
-        (a) = base; \
+        (a) = tab; \
     } while (0)
-#define LOAD_STRING(a) \
-    if (vlc_cache_load_string(&(a), file)) \
-        goto error
-#define LOAD_ALIGNOF(t) \
-    if (vlc_cache_load_align(alignof(t), file)) \
-        goto error
 
-static int vlc_cache_load_config(struct vlc_param *param, block_t *file)
+static int vlc_cache_load_config(struct vlc_cache_reader *r,
+                                 struct vlc_param *param)
 {
+    const struct vlc_cache_param *rec = r->params + r->params_next++;
     module_config_t *cfg = &param->item;
 
-    LOAD_IMMEDIATE (cfg->i_type);
-    LOAD_IMMEDIATE (param->shortname);
-    LOAD_FLAG (param->internal);
-    LOAD_FLAG (param->unsaved);
-    LOAD_FLAG (param->safe);
-    LOAD_FLAG (param->obsolete);
-    LOAD_STRING (cfg->psz_type);
-    LOAD_STRING (cfg->psz_name);
-    LOAD_STRING (cfg->psz_text);
-    LOAD_STRING (cfg->psz_longtext);
-    LOAD_IMMEDIATE (cfg->list_count);
-
-    if (IsConfigStringType (cfg->i_type))
+    cfg->i_type = rec->i_type;
+    param->shortname = rec->shortname;
+    param->internal = (rec->flags & CACHE_PARAM_INTERNAL) != 0;
+    param->unsaved = (rec->flags & CACHE_PARAM_UNSAVED) != 0;
+    param->safe = (rec->flags & CACHE_PARAM_SAFE) != 0;
+    param->obsolete = (rec->flags & CACHE_PARAM_OBSOLETE) != 0;
+    LOAD_STRING(cfg->psz_type, rec->type);
+    LOAD_STRING(cfg->psz_name, rec->name);
+    LOAD_STRING(cfg->psz_text, rec->text);
+    LOAD_STRING(cfg->psz_longtext, rec->longtext);
+    cfg->list_count = rec->list_count;
+
+    if (IsConfigStringType(cfg->i_type))
     {
         const char *psz;
-        LOAD_STRING(psz);
+
+        if (rec->orig.i < 0 || rec->orig.i > UINT32_MAX)
+            goto error;
+        LOAD_STRING(psz, rec->orig.i);
         cfg->orig.psz = (char *)psz;
         atomic_init(&param->value.str, NULL);
         vlc_param_SetString(param, psz);
 
-        if (cfg->list_count)
-            cfg->list.psz = xmalloc (cfg->list_count * sizeof (char *));
-        for (unsigned i = 0; i < cfg->list_count; i++)
-        {
-            LOAD_STRING (cfg->list.psz[i]);
-            if (cfg->list.psz[i] == NULL /* NULL -> empty string */
-             && (cfg->list.psz[i] = calloc (1, 1)) == NULL)
-                goto error;
-        }
+        /* NULL -> empty string */
+        LOAD_REFS(cfg->list.psz, cfg->list_count, "");
     }
     else
     {
-        LOAD_IMMEDIATE (cfg->orig);
-        LOAD_IMMEDIATE (cfg->min);
-        LOAD_IMMEDIATE (cfg->max);
         if (IsConfigFloatType(cfg->i_type))
-            atomic_store_explicit(&param->value.f, cfg->orig.f,
-                                  memory_order_relaxed);
+        {
+            cfg->orig.f = rec->orig.f;
+            cfg->min.f = rec->min.f;
+            cfg->max.f = rec->max.f;
+            atomic_init(&param->value.f, cfg->orig.f);
+        }
         else
-            atomic_store_explicit(&param->value.i, cfg->orig.i,
-                                  memory_order_relaxed);
-        cfg->value = cfg->orig;
-
-        if (cfg->list_count)
         {
-            LOAD_ALIGNOF(int);
+            cfg->orig.i = rec->orig.i;
+            cfg->min.i = rec->min.i;
+            cfg->max.i = rec->max.i;
+            atomic_init(&param->value.i, cfg->orig.i);
         }
+        cfg->value = cfg->orig;
 
-        LOAD_ARRAY(cfg->list.i, cfg->list_count);
+        if (cfg->list_count > r->toc.integers.count - r->integers_next)
+            goto error;
+        cfg->list.i = cfg->list_count ? r->integers + r->integers_next : NULL;
+        r->integers_next += cfg->list_count;
     }
 
-    cfg->list_text = xmalloc (cfg->list_count * sizeof (char *));
-    for (unsigned i = 0; i < cfg->list_count; i++)
-    {
-        LOAD_STRING (cfg->list_text[i]);
-        if (cfg->list_text[i] == NULL /* NULL -> empty string */
-         && (cfg->list_text[i] = calloc (1, 1)) == NULL)
+    LOAD_REFS(cfg->list_text, cfg->list_count, "");
+    return 0;
+error:
+    return -1;
+}
+
+static int vlc_cache_load_module(struct vlc_cache_reader *r,
+                                 vlc_plugin_t *plugin, module_t *module)
+{
+    const struct vlc_cache_module *rec = r->modules + r->modules_next++;
+
+    module->plugin = plugin;
+    module->next = NULL;
+    LOAD_STRING(module->psz_shortname, rec->shortname);
+    LOAD_STRING(module->psz_longname, rec->longname);
+    LOAD_STRING(module->psz_help, rec->help);
+    LOAD_STRING(module->psz_help_html, rec->help_html);
+
+    if (rec->shortcuts > MODULE_SHORTCUT_MAX)
+        goto error;
+    module->i_shortcuts = rec->shortcuts;
+    LOAD_REFS(module->pp_shortcuts, module->i_shortcuts, NULL);
+    for (unsigned i = 0; i < module->i_shortcuts; i++)
+        if (module->pp_shortcuts[i] == NULL)
             goto error;
-    }
 
+    LOAD_STRING(module->activate_name, rec->activate);
+    LOAD_STRING(module->deactivate_name, rec->deactivate);
+    LOAD_STRING(module->psz_capability, rec->capability);
+    module->i_score = rec->score;
+    module->pf_activate = NULL;
+    module->deactivate = NULL;
     return 0;
 error:
-    return -1; /* FIXME: leaks */
+    return -1;
 }
 
-static int vlc_cache_load_plugin_config(vlc_plugin_t *plugin, block_t *file)
+static int vlc_cache_load_plugin(struct vlc_cache_reader *r,
+                                 const struct vlc_cache_plugin *rec,
+                                 vlc_plugin_t *plugin)
 {
-    uint16_t lines;
+    plugin->next = NULL;
+    plugin->module = NULL;
+    plugin->modules_count = 0;
+    plugin->conf.params = NULL;
+    plugin->conf.size = 0;
+    plugin->conf.count = 0;
+    plugin->conf.booleans = 0;
+    plugin->unloadable = rec->unloadable != 0;
+    plugin->cached = true;
+    atomic_init(&plugin->handle, 0);
+    plugin->abspath = NULL;
+    plugin->mtime = rec->mtime;
+    plugin->size = rec->size;
+
+    if (rec->modules > r->toc.modules.count - r->modules_next
+     || rec->params > r->toc.params.count - r->params_next)
+        return -1;
 
-    /* Calculate the structure length */
-    LOAD_IMMEDIATE (lines);
+    module_t **pp = &plugin->module;
 
-    /* Allocate memory */
-    if (lines)
+    for (size_t i = 0; i < rec->modules; i++)
     {
-        plugin->conf.params = calloc(lines, sizeof (struct vlc_param));
-        if (unlikely(plugin->conf.params == NULL))
-        {
-            plugin->conf.size = 0;
+        module_t *module = r->module_tab + r->modules_next;
+
+        if (vlc_cache_load_module(r, plugin, module))
             return -1;
-        }
+
+        *pp = module;
+        pp = &module->next;
+        plugin->modules_count++;
     }
-    else
-        plugin->conf.params = NULL;
 
-    plugin->conf.size = lines;
+    if (rec->params > 0)
+        plugin->conf.params = r->param_tab + r->params_next;
 
-    /* Do the duplication job */
-    for (size_t i = 0; i < lines; i++)
+    for (size_t i = 0; i < rec->params; i++)
     {
         struct vlc_param *param = plugin->conf.params + i;
         module_config_t *item = &param->item;
 
-        if (vlc_cache_load_config(param, file))
+        param->owner = plugin;
+        /* Counted first, so that a partially loaded value gets freed */
+        plugin->conf.size++;
+        if (vlc_cache_load_config(r, param))
             return -1;
 
         if (CONFIG_ITEM(item->i_type))
@@ -285,84 +443,73 @@ static int vlc_cache_load_plugin_config(vlc_plugin_t *plugin, block_t *file)
             if (item->i_type == CONFIG_ITEM_BOOL)
                 plugin->conf.booleans++;
         }
-        param->owner = plugin;
     }
 
-    return 0;
-error:
-    return -1; /* FIXME: leaks */
-}
+    const char *path;
 
-static int vlc_cache_load_module(vlc_plugin_t *plugin, block_t *file)
-{
-    module_t *module = vlc_module_create(plugin);
-    if (unlikely(module == NULL))
+    if (vlc_cache_load_string(r, rec->textdomain, &plugin->textdomain)
+     || vlc_cache_load_string(r, rec->path, &path) || path == NULL)
         return -1;
 
-    LOAD_STRING(module->psz_shortname);
-    LOAD_STRING(module->psz_longname);
-    LOAD_STRING(module->psz_help);
-    LOAD_STRING(module->psz_help_html);
-
-    LOAD_IMMEDIATE(module->i_shortcuts);
-    if (module->i_shortcuts > MODULE_SHORTCUT_MAX)
-        goto error;
-    else
-    {
-        module->pp_shortcuts =
-            xmalloc (sizeof (*module->pp_shortcuts) * module->i_shortcuts);
-        for (unsigned j = 0; j < module->i_shortcuts; j++)
-            LOAD_STRING(module->pp_shortcuts[j]);
-    }
-
-    LOAD_STRING(module->activate_name);
-    LOAD_STRING(module->deactivate_name);
-    LOAD_STRING(module->psz_capability);
-    LOAD_IMMEDIATE(module->i_score);
+    plugin->path = (char *)path;
     return 0;
-error:
-    return -1;
 }
 
-static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
+/**
+ * Allocates the run-time descriptors of all cached plugins at once.
+ *
+ * \return a heap block owning the descriptors, or NULL on error.
+ */
+static block_t *vlc_cache_alloc(struct vlc_cache_reader *r)
 {
-    vlc_plugin_t *plugin = vlc_plugin_create();
-    if (unlikely(plugin == NULL))
-        return NULL;
-
-    uint32_t modules;
-    LOAD_IMMEDIATE(modules);
+    const size_t align = alignof (max_align_t);
+    size_t params_size, plugins_size, modules_size, refs_size, total;
 
-    for (size_t i = 0; i < modules; i++)
-        if (vlc_cache_load_module(plugin, file))
-            goto error;
-
-    if (vlc_cache_load_plugin_config(plugin, file))
-        goto error;
-
-    LOAD_STRING(plugin->textdomain);
+    if (ckd_mul(&params_size, sizeof (*r->param_tab), r->toc.params.count)
+     || ckd_mul(&plugins_size, sizeof (*r->plugin_tab), r->toc.plugins.count)
+     || ckd_mul(&modules_size, sizeof (*r->module_tab), r->toc.modules.count)
+     || ckd_mul(&refs_size, sizeof (*r->ref_tab), r->toc.refs.count))
+        return NULL;
 
-    const char *path;
-    LOAD_STRING(path);
-    if (path == NULL)
-        goto error;
+    params_size = (params_size + align - 1) & ~(align - 1);
+    plugins_size = (plugins_size + align - 1) & ~(align - 1);
+    modules_size = (modules_size + align - 1) & ~(align - 1);
 
-    plugin->path = strdup(path);
-    if (unlikely(plugin->path == NULL))
-        goto error;
+    if (ckd_add(&total, params_size, plugins_size)
+     || ckd_add(&total, total, modules_size)
+     || ckd_add(&total, total, refs_size))
+        return NULL;
 
-    LOAD_FLAG(plugin->unloadable);
-    LOAD_IMMEDIATE(plugin->mtime);
-    LOAD_IMMEDIATE(plugin->size);
+    unsigned char *arena = calloc(1, total ? total : 1);
+    if (unlikely(arena == NULL))
+        return NULL;
 
-    if (plugin->textdomain != NULL)
-        vlc_bindtextdomain(plugin->textdomain);
+    block_t *block = block_heap_Alloc(arena, total);
+    if (unlikely(block == NULL))
+        return NULL;
 
-    return plugin;
+    r->param_tab = (void *)arena;
+    r->plugin_tab = (void *)(arena + params_size);
+    r->module_tab = (void *)(arena + params_size + plugins_size);
+    r->ref_tab = (void *)(arena + params_size + plugins_size + modules_size);
+    return block;
+}
 
-error:
-    vlc_plugin_destroy(plugin);
-    return NULL;
+static int vlc_cache_load_toc(struct vlc_cache_reader *r,
+                              const unsigned char *start, size_t size)
+{
+    LOAD_SECTION(plugins, struct vlc_cache_plugin);
+    LOAD_SECTION(modules, struct vlc_cache_module);
+    LOAD_SECTION(params, struct vlc_cache_param);
+    LOAD_SECTION(refs, uint32_t);
+    LOAD_SECTION(integers, int);
+    LOAD_SECTION(strings, char);
+
+    /* Offset zero is reserved for NULL, and the pool is nul-terminated */
+    if (r->toc.strings.count < 1
+     || r->strings[r->toc.strings.count - 1] != '\0')
+        return -1;
+    return 0;
 }
 
 /**
@@ -393,6 +540,10 @@ vlc_plugin_t *vlc_cache_load(libvlc_int_t *p_this, const char *dir,
     if (file == NULL)
         return NULL;
 
+    /* Sections offsets are relative to the file start */
+    const unsigned char *start = file->p_buffer;
+    const size_t size = file->i_buffer;
+
     /* Check the file is a plugins cache */
     char cachestr[sizeof (CACHE_STRING) - 1];
 
@@ -444,162 +595,284 @@ vlc_plugin_t *vlc_cache_load(libvlc_int_t *p_this, const char *dir,
         return NULL;
     }
 
+    struct vlc_cache_reader reader = { 0 }, *r = &reader;
     vlc_plugin_t *cache = NULL;
+    block_t *descs = NULL;
+    size_t count = 0;
+
+    if (vlc_cache_load_align(alignof (struct vlc_cache_toc), file)
+     || vlc_cache_load_immediate(&r->toc, file, sizeof (r->toc))
+     || vlc_cache_load_toc(r, start, size))
+        goto error;
 
-    while (file->i_buffer > 0)
+    descs = vlc_cache_alloc(r);
+    if (unlikely(descs == NULL))
+        goto error;
+
+    for (; count < r->toc.plugins.count; count++)
     {
-        vlc_plugin_t *plugin = vlc_cache_load_plugin(file);
-        if (plugin == NULL)
+        vlc_plugin_t *plugin = r->plugin_tab + count;
+
+        if (vlc_cache_load_plugin(r, r->plugins + count, plugin))
+        {
+            count++; /* partially initialized plugin */
             goto error;
+        }
 
         if (unlikely(asprintf(&plugin->abspath, "%s" DIR_SEP "%s", dir,
                               plugin->path) == -1))
         {
             plugin->abspath = NULL;
-            vlc_plugin_destroy(plugin);
+            count++;
             goto error;
         }
 
+        if (plugin->textdomain != NULL)
+            vlc_bindtextdomain(plugin->textdomain);
+
         plugin->next = cache;
         cache = plugin;
     }
 
-    file->p_next = *backingp;
+    if (r->modules_next != r->toc.modules.count
+     || r->params_next != r->toc.params.count)
+        goto error;
+
+    /* Keep the file mapping and the descriptors until the bank is freed */
+    file->p_next = descs;
+    descs->p_next = *backingp;
     *backingp = file;
     return cache;
 
 error:
     msg_Warn( p_this, "plugins cache not loaded (corrupted)" );
 
-    /* TODO: cleanup */
+    for (size_t i = 0; i < count; i++)
+        vlc_plugin_destroy(r->plugin_tab + i);
+    if (descs != NULL)
+        block_Release(descs);
     block_Release(file);
     return NULL;
 }
 
-#define SAVE_IMMEDIATE( a ) \
-    if (fwrite (&(a), sizeof(a), 1, file) != 1) \
-        goto error
-#define SAVE_FLAG(a) \
-    do { \
-        char b = (a); \
-        SAVE_IMMEDIATE(b); \
-    } while (0)
+/** Cache file writer state */
+struct vlc_cache_writer
+{
+    struct vlc_memstream plugins;
+    struct vlc_memstream modules;
+    struct vlc_memstream params;
+    struct vlc_memstream refs;
+    struct vlc_memstream integers;
+    struct vlc_memstream strings;
+    struct vlc_cache_toc toc;
+    void *strings_tree;
+};
+
+struct vlc_cache_string
+{
+    const char *str;
+    uint32_t offset;
+};
 
-static int CacheSaveString (FILE *file, const char *str)
+static int vlc_cache_string_cmp(const void *a, const void *b)
 {
-    uint16_t size = (str != NULL) ? (strlen (str) + 1) : 0;
+    const struct vlc_cache_string *sa = a, *sb = b;
+    return strcmp(sa->str, sb->str);
+}
 
-    SAVE_IMMEDIATE (size);
-    if (size != 0 && fwrite(str, 1, size, file) != size)
+/**
+ * Adds a string to the pool, unless it is already there.
+ *
+ * \return the string offset within the pool, or 0 for NULL
+ */
+static uint32_t CacheSaveString(struct vlc_cache_writer *w, const char *str)
+{
+    if (str == NULL)
+        return 0;
+
+    struct vlc_cache_string *node = malloc(sizeof (*node));
+    if (likely(node != NULL))
     {
-error:
-        return -1;
+        node->str = str;
+        node->offset = w->toc.strings.count;
+
+        void **pp = tsearch(node, &w->strings_tree, vlc_cache_string_cmp);
+        if (pp != NULL && *pp != node)
+        {
+            free(node);
+            return ((const struct vlc_cache_string *)*pp)->offset;
+        }
+        if (unlikely(pp == NULL))
+            free(node);
     }
-    return 0;
-}
 
-#define SAVE_STRING( a ) \
-    if (CacheSaveString (file, (a))) \
-        goto error
+    size_t len = strlen(str) + 1;
+    uint32_t offset = w->toc.strings.count;
 
-static int CacheSaveAlign(FILE *file, size_t align)
-{
-    assert(align > 0);
+    vlc_memstream_write(&w->strings, str, len);
+    w->toc.strings.count += len;
+    return offset;
+}
 
-    size_t skip = (-ftell(file)) % align;
-    if (skip == 0)
-        return 0;
+static void CacheSaveRef(struct vlc_cache_writer *w, const char *str)
+{
+    uint32_t offset = CacheSaveString(w, str);
 
-    assert(((ftell(file) + skip) % align) == 0);
-    return fseek(file, skip, SEEK_CUR);
+    vlc_memstream_write(&w->refs, &offset, sizeof (offset));
+    w->toc.refs.count++;
 }
 
-#define SAVE_ALIGNOF(t) \
-    if (CacheSaveAlign(file, alignof (t))) \
-        goto error
-
-static int CacheSaveConfig(FILE *file, const struct vlc_param *param)
+static void CacheSaveConfig(struct vlc_cache_writer *w,
+                            const struct vlc_param *param)
 {
     const module_config_t *cfg = &param->item;
-
-    SAVE_IMMEDIATE (cfg->i_type);
-    SAVE_IMMEDIATE (param->shortname);
-    SAVE_FLAG (param->internal);
-    SAVE_FLAG (param->unsaved);
-    SAVE_FLAG (param->safe);
-    SAVE_FLAG (param->obsolete);
-    SAVE_STRING (cfg->psz_type);
-    SAVE_STRING (cfg->psz_name);
-    SAVE_STRING (cfg->psz_text);
-    SAVE_STRING (cfg->psz_longtext);
-    SAVE_IMMEDIATE (cfg->list_count);
-
-    if (IsConfigStringType (cfg->i_type))
+    struct vlc_cache_param rec = {
+        .type = CacheSaveString(w, cfg->psz_type),
+        .name = CacheSaveString(w, cfg->psz_name),
+        .text = CacheSaveString(w, cfg->psz_text),
+        .longtext = CacheSaveString(w, cfg->psz_longtext),
+        .list_count = cfg->list_count,
+        .i_type = cfg->i_type,
+        .shortname = param->shortname,
+        .flags = (param->internal ? CACHE_PARAM_INTERNAL : 0)
+               | (param->unsaved ? CACHE_PARAM_UNSAVED : 0)
+               | (param->safe ? CACHE_PARAM_SAFE : 0)
+               | (param->obsolete ? CACHE_PARAM_OBSOLETE : 0),
+    };
+
+    if (IsConfigStringType(cfg->i_type))
     {
-        SAVE_STRING (cfg->orig.psz);
+        rec.orig.i = CacheSaveString(w, cfg->orig.psz);
 
         for (unsigned i = 0; i < cfg->list_count; i++)
-            SAVE_STRING (cfg->list.psz[i]);
+            CacheSaveRef(w, cfg->list.psz[i]);
     }
     else
     {
-        SAVE_IMMEDIATE (cfg->orig);
-        SAVE_IMMEDIATE (cfg->min);
-        SAVE_IMMEDIATE (cfg->max);
-
-        if (cfg->list_count > 0)
+        if (IsConfigFloatType(cfg->i_type))
         {
-            SAVE_ALIGNOF(int);
+            rec.orig.f = cfg->orig.f;
+            rec.min.f = cfg->min.f;
+            rec.max.f = cfg->max.f;
+        }
+        else
+        {
+            rec.orig.i = cfg->orig.i;
+            rec.min.i = cfg->min.i;
+            rec.max.i = cfg->max.i;
         }
 
-        for (unsigned i = 0; i < cfg->list_count; i++)
-             SAVE_IMMEDIATE (cfg->list.i[i]);
+        vlc_memstream_write(&w->integers, cfg->list.i,
+                            cfg->list_count * sizeof (*cfg->list.i));
+        w->toc.integers.count += cfg->list_count;
     }
+
     for (unsigned i = 0; i < cfg->list_count; i++)
-        SAVE_STRING (cfg->list_text[i]);
+        CacheSaveRef(w, cfg->list_text[i]);
 
-    return 0;
-error:
-    return -1;
+    vlc_memstream_write(&w->params, &rec, sizeof (rec));
+    w->toc.params.count++;
+}
+
+static void CacheSaveModule(struct vlc_cache_writer *w,
+                            const module_t *module)
+{
+    struct vlc_cache_module rec = {
+        .shortname = CacheSaveString(w, module->psz_shortname),
+        .longname = CacheSaveString(w, module->psz_longname),
+        .help = CacheSaveString(w, module->psz_help),
+        .help_html = CacheSaveString(w, module->psz_help_html),
+        .capability = CacheSaveString(w, module->psz_capability),
+        .activate = CacheSaveString(w, module->activate_name),
+        .deactivate = CacheSaveString(w, module->deactivate_name),
+        .score = module->i_score,
+        .shortcuts = module->i_shortcuts,
+    };
+
+    for (size_t j = 0; j < module->i_shortcuts; j++)
+        CacheSaveRef(w, module->pp_shortcuts[j]);
+
+    vlc_memstream_write(&w->modules, &rec, sizeof (rec));
+    w->toc.modules.count++;
 }
 
-static int CacheSaveModuleConfig(FILE *file, const vlc_plugin_t *plugin)
+static int CacheSavePlugin(struct vlc_cache_writer *w,
+                           const vlc_plugin_t *plugin)
 {
-    uint16_t lines = plugin->conf.size;
+    struct vlc_cache_plugin rec = {
+        .mtime = plugin->mtime,
+        .size = plugin->size,
+        .path = CacheSaveString(w, plugin->path),
+        .textdomain = CacheSaveString(w, plugin->textdomain),
+        .modules = plugin->modules_count,
+        .params = plugin->conf.size,
+        .unloadable = plugin->unloadable,
+    };
+
+    if (plugin->conf.size > UINT16_MAX)
+        return -1;
 
-    SAVE_IMMEDIATE (lines);
+    for (module_t *module = plugin->module;
+         module != NULL;
+         module = module->next)
+        CacheSaveModule(w, module);
 
-    for (size_t i = 0; i < lines; i++)
-        if (CacheSaveConfig(file, plugin->conf.params + i))
-           goto error;
+    for (size_t i = 0; i < plugin->conf.size; i++)
+        CacheSaveConfig(w, plugin->conf.params + i);
 
+    vlc_memstream_write(&w->plugins, &rec, sizeof (rec));
+    w->toc.plugins.count++;
     return 0;
-error:
-    return -1;
 }
 
-static int CacheSaveModule(FILE *file, const module_t *module)
+#define SAVE_IMMEDIATE( a ) \
+    if (fwrite (&(a), sizeof(a), 1, file) != 1) \
+        goto error
+
+static int CacheSaveAlign(FILE *file, size_t align)
 {
-    SAVE_STRING(module->psz_shortname);
-    SAVE_STRING(module->psz_longname);
-    SAVE_STRING(module->psz_help);
-    SAVE_STRING(module->psz_help_html);
-    SAVE_IMMEDIATE(module->i_shortcuts);
+    assert(align > 0);
 
-    for (size_t j = 0; j < module->i_shortcuts; j++)
-         SAVE_STRING(module->pp_shortcuts[j]);
+    size_t skip = (-ftell(file)) % align;
+    if (skip == 0)
+        return 0;
+
+    assert(((ftell(file) + skip) % align) == 0);
+    return fseek(file, skip, SEEK_CUR);
+}
+
+#define SAVE_ALIGNOF(t) \
+    if (CacheSaveAlign(file, alignof (t))) \
+        goto error
+
+/**
+ * Computes the offset of a section, following the previous one.
+ */
+static int CacheSaveSection(struct vlc_cache_section *section,
+                            const struct vlc_memstream *ms,
+                            size_t *offset)
+{
+    const size_t align = alignof (max_align_t);
 
-    SAVE_STRING(module->activate_name);
-    SAVE_STRING(module->deactivate_name);
-    SAVE_STRING(module->psz_capability);
-    SAVE_IMMEDIATE(module->i_score);
+    *offset = (*offset + align - 1) & ~(align - 1);
+    if (*offset > UINT32_MAX)
+        return -1;
+
+    section->offset = *offset;
+    *offset += ms->length;
     return 0;
-error:
-    return -1;
 }
 
-static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
+static int CacheSaveFile(FILE *file, struct vlc_cache_writer *w)
 {
+    const struct vlc_memstream *const streams[] = {
+        &w->plugins, &w->modules, &w->params,
+        &w->refs, &w->integers, &w->strings,
+    };
+    struct vlc_cache_section *const sections[] = {
+        &w->toc.plugins, &w->toc.modules, &w->toc.params,
+        &w->toc.refs, &w->toc.integers, &w->toc.strings,
+    };
     uint32_t i_file_size = 0;
 
     /* Contains version number */
@@ -621,29 +894,24 @@ static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
     if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
         goto error;
 
-    for (size_t i = 0; i < n; i++)
-    {
-        const vlc_plugin_t *plugin = cache[i];
-        uint32_t count = plugin->modules_count;
-
-        SAVE_IMMEDIATE(count);
+    /* Table of contents */
+    SAVE_ALIGNOF(struct vlc_cache_toc);
 
-        for (module_t *module = plugin->module;
-             module != NULL;
-             module = module->next)
-            if (CacheSaveModule(file, module))
-                goto error;
+    size_t offset = ftell(file) + sizeof (w->toc);
 
-        /* Config stuff */
-        if (CacheSaveModuleConfig(file, plugin))
+    for (size_t i = 0; i < ARRAY_SIZE(streams); i++)
+        if (CacheSaveSection(sections[i], streams[i], &offset))
             goto error;
 
-        /* Save common info */
-        SAVE_STRING(plugin->textdomain);
-        SAVE_STRING(plugin->path);
-        SAVE_FLAG(plugin->unloadable);
-        SAVE_IMMEDIATE(plugin->mtime);
-        SAVE_IMMEDIATE(plugin->size);
+    SAVE_IMMEDIATE(w->toc);
+
+    for (size_t i = 0; i < ARRAY_SIZE(streams); i++)
+    {
+        SAVE_ALIGNOF(max_align_t);
+        assert((size_t)ftell(file) == sections[i]->offset);
+        if (fwrite(streams[i]->ptr, 1, streams[i]->length, file)
+                != streams[i]->length)
+            goto error;
     }
 
     if (fflush (file)) /* flush libc buffers */
@@ -654,6 +922,38 @@ error:
     return -1;
 }
 
+static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
+{
+    struct vlc_cache_writer writer = { 0 }, *w = &writer;
+    struct vlc_memstream *const streams[] = {
+        &w->plugins, &w->modules, &w->params,
+        &w->refs, &w->integers, &w->strings,
+    };
+    int ret = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(streams); i++)
+        vlc_memstream_open(streams[i]);
+
+    /* Offset zero is reserved for NULL strings */
+    vlc_memstream_putc(&w->strings, '\0');
+    w->toc.strings.count = 1;
+
+    for (size_t i = 0; i < n && ret == 0; i++)
+        ret = CacheSavePlugin(w, cache[i]);
+
+    for (size_t i = 0; i < ARRAY_SIZE(streams); i++)
+        if (vlc_memstream_close(streams[i]))
+            ret = -1;
+    tdestroy(w->strings_tree, free);
+
+    if (ret == 0)
+        ret = CacheSaveFile(file, w);
+
+    for (size_t i = 0; i < ARRAY_SIZE(streams); i++)
+        free(streams[i]->ptr);
+    return ret;
+}
+
 /**
  * Saves a module cache to disk, and release cache data from memory.
  */
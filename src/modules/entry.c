@@ -108,6 +108,7 @@ vlc_plugin_t *vlc_plugin_create(void)
     plugin->conf.booleans = 0;
 #ifdef HAVE_DYNAMIC_PLUGINS
     plugin->unloadable = true;
+    plugin->cached = false;
     atomic_init(&plugin->handle, 0);
     plugin->abspath = NULL;
     plugin->path = NULL;
@@ -129,6 +130,24 @@ void vlc_plugin_destroy(vlc_plugin_t *plugin)
     assert(!plugin->unloadable || atomic_load(&plugin->handle) == 0);
 #endif
 
+#ifdef HAVE_DYNAMIC_PLUGINS
+    if (plugin->cached)
+    {
+        /* Modules, parameters and strings belong to the plugins cache
+         * backing memory: only free the run-time parameter values. */
+        for (size_t i = 0; i < plugin->conf.size; i++)
+        {
+            struct vlc_param *param = plugin->conf.params + i;
+
+            if (IsConfigStringType(param->item.i_type))
+                free(atomic_load_explicit(&param->value.str,
+                                          memory_order_relaxed));
+        }
+        free(plugin->abspath);
+        return;
+    }
+#endif
+
     if (plugin->module != NULL)
         vlc_module_destroy(plugin->module);
 
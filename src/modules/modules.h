@@ -50,6 +50,7 @@ typedef struct vlc_plugin_t
 
 #ifdef HAVE_DYNAMIC_PLUGINS
     bool unloadable; /**< Whether the plug-in can be unloaded safely */
+    bool cached; /**< Whether the descriptors are stored in a plugins cache */
     atomic_uintptr_t handle; /**< Run-time linker handle (or nul) */
     char *abspath; /**< Absolute path */
 
@@ -83,6 +83,26 @@ static void test_audio_output (void)
     libvlc_release (vlc);
 }
 
+static void test_startup (const char *mode, unsigned count)
+{
+    const char *argv[] = { "--ignore-config", mode };
+    int argc = sizeof (argv) / sizeof (argv[0]);
+
+    int64_t start = libvlc_clock ();
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        libvlc_instance_t *vlc = libvlc_new (argc, argv);
+        assert (vlc != NULL);
+        libvlc_release (vlc);
+    }
+
+    int64_t elapsed = libvlc_clock () - start;
+
+    test_log ("Startup with %s: %"PRId64" us per instance\n", mode,
+              elapsed / count);
+}
+
 int main (void)
 {
     test_init();
@@ -90,6 +110,13 @@ int main (void)
     test_core (test_defaults_args, test_defaults_nargs);
     test_audiovideofilterlists (test_defaults_args, test_defaults_nargs);
     test_audio_output ();
+    /* Startup time, with the plugins cache only or scanning plugins.
+     * Without a generated cache, the former would not load any plugin. */
+    if (access (TOP_BUILDDIR"/modules/plugins.dat", R_OK) == 0)
+        test_startup ("--no-plugins-scan", 20);
+    else
+        test_log ("No plugins cache, skipping cached startup\n");
+    test_startup ("--no-plugins-cache", 1);
 
     return 0;
 }
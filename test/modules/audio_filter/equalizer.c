@@ -0,0 +1,284 @@
+/*****************************************************************************
+ * equalizer.c: equalizers test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+
+#include "../../../modules/audio_filter/equalizer_presets.h"
+
+#define RATE     96000
+#define CHANNELS 8
+#define SAMPLES  RATE /* 1 second */
+#define BLOCK    1024
+#define TOLERANCE 1e-4f
+
+static const char *const args[] = {
+    "--equalizer-bands=-6 2 4 2 0 -2 -4 -2 0 12",
+    "--equalizer-preamp=0",
+    "--param-eq-lowgain=6",
+    "--param-eq-gain1=-8",
+    "--param-eq-gain2=4",
+    "--param-eq-gain3=-3",
+    "--param-eq-highgain=5",
+};
+
+/*
+ * The equalizer as it was before the bands were processed as vectors, one
+ * sample, channel and band at a time.
+ */
+static float ref_alpha[EQZ_BANDS_MAX], ref_beta[EQZ_BANDS_MAX];
+static float ref_gamma[EQZ_BANDS_MAX], ref_amp[EQZ_BANDS_MAX];
+static float ref_x[CHANNELS][2], ref_y[CHANNELS][EQZ_BANDS_MAX][2];
+
+static void RefInit(void)
+{
+    static const float db[EQZ_BANDS_MAX] = { -6, 2, 4, 2, 0, -2, -4, -2, 0, 12 };
+    const float octave_factor = powf(2.0f, 0.5f);
+    const float octave_factor_1 = 0.5f * (octave_factor + 1.0f);
+    const float octave_factor_2 = 0.5f * (octave_factor - 1.0f);
+
+    for (int i = 0; i < EQZ_BANDS_MAX; i++)
+    {
+        float theta_1 = (2.0f * (float)M_PI * f_vlc_frequency_table_10b[i])
+                      / RATE;
+        float theta_2 = theta_1 / octave_factor;
+        float sin_ = sinf(theta_2);
+        float sin_prd = sinf(theta_2 * octave_factor_1)
+                      * sinf(theta_2 * octave_factor_2);
+        float sin_hlf = sin_ * 0.5f;
+        float den = sin_hlf + sin_prd;
+
+        ref_alpha[i] = sin_prd / den;
+        ref_beta[i] = (sin_hlf - sin_prd) / den;
+        ref_gamma[i] = sin_ * cosf(theta_1) / den;
+        ref_amp[i] = 0.25f * (powf(10.0f, db[i] / 20.0f) - 1.0f);
+    }
+}
+
+static void RefFilter(float *buf, unsigned samples)
+{
+    for (unsigned i = 0; i < samples; i++, buf += CHANNELS)
+        for (unsigned ch = 0; ch < CHANNELS; ch++)
+        {
+            const float x = buf[ch];
+            float o = 0.0f;
+
+            for (unsigned j = 0; j < EQZ_BANDS_MAX; j++)
+            {
+                float y = ref_alpha[j] * (x - ref_x[ch][1]) +
+                          ref_gamma[j] * ref_y[ch][j][0] -
+                          ref_beta[j] * ref_y[ch][j][1];
+
+                ref_y[ch][j][1] = ref_y[ch][j][0];
+                ref_y[ch][j][0] = y;
+                o += y * ref_amp[j];
+            }
+            ref_x[ch][1] = ref_x[ch][0];
+            ref_x[ch][0] = x;
+            buf[ch] = 0.25f * x + o;
+        }
+}
+
+static void FillSignal(float *buf, unsigned samples)
+{
+    uint32_t seed = 0x1234567;
+
+    for (unsigned i = 0; i < samples; i++)
+        for (unsigned ch = 0; ch < CHANNELS; ch++)
+        {
+            /* A tone per channel, with some noise */
+            seed = seed * 1103515245 + 12345;
+            buf[i * CHANNELS + ch] =
+                .4f * sinf(2.f * (float)M_PI * (50.f + 1500.f * ch) * i / RATE)
+                + ((float)(seed >> 16) / 65536.f - .5f) * .2f;
+        }
+}
+
+static filter_t *CreateFilter(vlc_object_t *obj, const char *name,
+                              unsigned channels)
+{
+    static const uint16_t layouts[] = {
+        [1] = AOUT_CHAN_CENTER,
+        [2] = AOUT_CHANS_STEREO,
+        [8] = AOUT_CHANS_7_1,
+    };
+    filter_t *filter = vlc_object_create(obj, sizeof (*filter));
+    assert(filter != NULL);
+
+    es_format_Init(&filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32);
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    filter->fmt_in.audio.i_rate = RATE;
+    filter->fmt_in.audio.i_physical_channels = layouts[channels];
+    aout_FormatPrepare(&filter->fmt_in.audio);
+    es_format_Copy(&filter->fmt_out, &filter->fmt_in);
+
+    assert(vlc_filter_LoadModule(filter, "audio filter", name, true) != NULL);
+    return filter;
+}
+
+static void DeleteFilter(filter_t *filter)
+{
+    vlc_filter_UnloadModule(filter);
+    es_format_Clean(&filter->fmt_out);
+    es_format_Clean(&filter->fmt_in);
+    vlc_object_delete(filter);
+}
+
+/* Filters the signal in blocks of varying sizes */
+static void Run(filter_t *filter, const char *name, float *buf,
+                unsigned channels)
+{
+    vlc_tick_t total = 0;
+
+    for (unsigned done = 0, i = 0; done < SAMPLES; i++)
+    {
+        unsigned count = BLOCK - (i % 3) * 333;
+        if (count > SAMPLES - done)
+            count = SAMPLES - done;
+
+        block_t *block = block_Alloc(count * channels * sizeof (float));
+        assert(block != NULL);
+        memcpy(block->p_buffer, &buf[done * channels],
+               count * channels * sizeof (float));
+        block->i_nb_samples = count;
+
+        vlc_tick_t start = vlc_tick_now();
+        block = filter->ops->filter_audio(filter, block);
+        total += vlc_tick_now() - start;
+
+        assert(block != NULL);
+        memcpy(&buf[done * channels], block->p_buffer,
+               count * channels * sizeof (float));
+        block_Release(block);
+        done += count;
+    }
+
+    test_log("%s, %u channels: %.1f Msamples/s\n", name, channels,
+             (total > 0) ? (double)SAMPLES * channels / 1e6
+                           / secf_from_vlc_tick(total) : 0.);
+}
+
+static void TestEqualizer(vlc_object_t *obj, const float *signal)
+{
+    float *buf = malloc(SAMPLES * CHANNELS * sizeof (float));
+    float *ref = malloc(SAMPLES * CHANNELS * sizeof (float));
+    assert(buf != NULL && ref != NULL);
+
+    memcpy(buf, signal, SAMPLES * CHANNELS * sizeof (float));
+    memcpy(ref, signal, SAMPLES * CHANNELS * sizeof (float));
+
+    filter_t *filter = CreateFilter(obj, "equalizer", CHANNELS);
+    Run(filter, "equalizer", buf, CHANNELS);
+    DeleteFilter(filter);
+
+    RefInit();
+    vlc_tick_t start = vlc_tick_now();
+    RefFilter(ref, SAMPLES);
+    vlc_tick_t total = vlc_tick_now() - start;
+    test_log("reference equalizer, %u channels: %.1f Msamples/s\n", CHANNELS,
+             (total > 0) ? (double)SAMPLES * CHANNELS / 1e6
+                           / secf_from_vlc_tick(total) : 0.);
+
+    /* Only the order of the sum of the bands differs */
+    for (size_t i = 0; i < SAMPLES * CHANNELS; i++)
+        assert(fabsf(buf[i] - ref[i]) <= TOLERANCE);
+
+    free(ref);
+    free(buf);
+}
+
+/* Channels go in different lanes: each must be filtered the same way */
+static void TestParamEq(vlc_object_t *obj, const float *signal)
+{
+    float *multi = malloc(SAMPLES * CHANNELS * sizeof (float));
+    float *mono = malloc(SAMPLES * sizeof (float));
+    float *stereo = malloc(SAMPLES * 2 * sizeof (float));
+    assert(multi != NULL && mono != NULL && stereo != NULL);
+
+    /* The same signal on all the channels */
+    for (unsigned i = 0; i < SAMPLES; i++)
+    {
+        mono[i] = signal[i * CHANNELS];
+        stereo[2 * i] = stereo[2 * i + 1] = mono[i];
+        for (unsigned ch = 0; ch < CHANNELS; ch++)
+            multi[i * CHANNELS + ch] = mono[i];
+    }
+
+    const unsigned counts[] = { 1, 2, CHANNELS };
+    float *bufs[] = { mono, stereo, multi };
+
+    for (size_t i = 0; i < ARRAY_SIZE(counts); i++)
+    {
+        filter_t *filter = CreateFilter(obj, "param_eq", counts[i]);
+        Run(filter, "param_eq", bufs[i], counts[i]);
+        DeleteFilter(filter);
+    }
+
+    for (unsigned i = 0; i < SAMPLES; i++)
+    {
+        assert(isfinite(mono[i]));
+        for (unsigned ch = 0; ch < 2; ch++)
+            assert(stereo[2 * i + ch] == mono[i]);
+        for (unsigned ch = 0; ch < CHANNELS; ch++)
+            assert(multi[i * CHANNELS + ch] == mono[i]);
+    }
+
+    free(stereo);
+    free(mono);
+    free(multi);
+}
+
+int main(void)
+{
+    const char *argv[test_defaults_nargs + ARRAY_SIZE(args)];
+
+    test_init();
+
+    for (int i = 0; i < test_defaults_nargs; i++)
+        argv[i] = test_defaults_args[i];
+    for (size_t i = 0; i < ARRAY_SIZE(args); i++)
+        argv[test_defaults_nargs + i] = args[i];
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    float *signal = malloc(SAMPLES * CHANNELS * sizeof (float));
+    assert(signal != NULL);
+    FillSignal(signal, SAMPLES);
+
+    TestEqualizer(obj, signal);
+    TestParamEq(obj, signal);
+
+    free(signal);
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,326 @@
+/*****************************************************************************
+ * pcm.c: audio volume, sample format and interleaving test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_aout_volume.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+
+/* 1 second of 48 kHz stereo, plus an odd tail for the scalar code */
+#define SAMPLES (2 * 48000 + 7)
+#define RUNS    20
+
+/*
+ * The SIMD code must give the same samples as these scalar versions,
+ * which are copied from the modules.
+ */
+static void RefAmplify(float *p, size_t count, float mult)
+{
+    for (size_t i = 0; i < count; i++)
+        p[i] *= mult;
+}
+
+static void RefFl32toS16(int16_t *dst, const float *src, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        union { float f; int32_t i; } u;
+        u.f = src[i] + 384.f;
+        if (u.i > 0x43c07fff)
+            dst[i] = 32767;
+        else if (u.i < 0x43bf8000)
+            dst[i] = -32768;
+        else
+            dst[i] = u.i - 0x43c00000;
+    }
+}
+
+static void RefFl32toS32(int32_t *dst, const float *src, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float s = src[i] * -((float)INT32_MIN);
+        if (s >= ((float)INT32_MAX))
+            dst[i] = INT32_MAX;
+        else if (s <= ((float)INT32_MIN))
+            dst[i] = INT32_MIN;
+        else
+            dst[i] = lroundf(s);
+    }
+}
+
+static void RefS16toFl32(float *dst, const int16_t *src, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        union { float f; int32_t i; } u;
+        u.i = src[i] + 0x43c00000;
+        dst[i] = u.f - 384.f;
+    }
+}
+
+static void RefS32toFl32(float *dst, const int32_t *src, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        dst[i] = (float)src[i] / -((float)INT32_MIN);
+}
+
+static uint32_t seed = 0x1234567;
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed;
+}
+
+static void FillFloat(float *p, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        /* Mostly in range, some clipping, and exact halves for rounding */
+        switch (Random() >> 29)
+        {
+            case 0:
+                p[i] = ((float)(Random() >> 8) / (1 << 23) - .5f) * 3.f;
+                break;
+            case 1:
+                p[i] = ((int)(Random() >> 20) - 2048) * .5f
+                       / -((float)INT32_MIN);
+                break;
+            case 2:
+                p[i] = ((int)(Random() >> 16) - 32768) / 32768.f;
+                break;
+            default:
+                p[i] = ((float)(Random() >> 8) / (1 << 23) - .5f) * 2.f;
+        }
+    }
+}
+
+static void Report(const char *what, vlc_tick_t ref, vlc_tick_t simd)
+{
+    test_log("%s: scalar %.1f, optimized %.1f Msamples/s\n", what,
+             (ref > 0) ? RUNS * SAMPLES / 1e6 / secf_from_vlc_tick(ref) : 0.,
+             (simd > 0) ? RUNS * SAMPLES / 1e6 / secf_from_vlc_tick(simd) : 0.);
+}
+
+static void TestVolume(vlc_object_t *obj)
+{
+    audio_volume_t *volume = vlc_object_create(obj, sizeof (*volume));
+    assert(volume != NULL);
+    volume->format = VLC_CODEC_FL32;
+
+    module_t *module = module_need(volume, "audio volume", "float_mixer", true);
+    assert(module != NULL);
+
+    block_t *block = block_Alloc(SAMPLES * sizeof (float));
+    float *ref = malloc(SAMPLES * sizeof (float));
+    assert(block != NULL && ref != NULL);
+
+    vlc_tick_t ref_time = 0, simd_time = 0;
+    for (unsigned i = 0; i < RUNS; i++)
+    {
+        const float mult = .25f + i * .1f;
+        float *p = (float *)block->p_buffer;
+
+        FillFloat(p, SAMPLES);
+        memcpy(ref, p, SAMPLES * sizeof (float));
+
+        vlc_tick_t start = vlc_tick_now();
+        RefAmplify(ref, SAMPLES, mult);
+        vlc_tick_t mid = vlc_tick_now();
+        volume->amplify(volume, block, mult);
+        vlc_tick_t end = vlc_tick_now();
+
+        ref_time += mid - start;
+        simd_time += end - mid;
+        assert(!memcmp(p, ref, SAMPLES * sizeof (float)));
+    }
+    Report("FL32 volume", ref_time, simd_time);
+
+    free(ref);
+    block_Release(block);
+    module_unneed(volume, module);
+    vlc_object_delete(volume);
+}
+
+static filter_t *CreateConverter(vlc_object_t *obj, vlc_fourcc_t in,
+                                 vlc_fourcc_t out)
+{
+    filter_t *filter = vlc_object_create(obj, sizeof (*filter));
+    assert(filter != NULL);
+
+    es_format_Init(&filter->fmt_in, AUDIO_ES, in);
+    filter->fmt_in.audio.i_format = in;
+    filter->fmt_in.audio.i_rate = 48000;
+    filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_STEREO;
+    aout_FormatPrepare(&filter->fmt_in.audio);
+    es_format_Copy(&filter->fmt_out, &filter->fmt_in);
+    filter->fmt_out.i_codec = filter->fmt_out.audio.i_format = out;
+    aout_FormatPrepare(&filter->fmt_out.audio);
+
+    module_t *module = vlc_filter_LoadModule(filter, "audio converter",
+                                             "audio_format", true);
+    assert(module != NULL);
+    return filter;
+}
+
+static void DeleteConverter(filter_t *filter)
+{
+    vlc_filter_UnloadModule(filter);
+    es_format_Clean(&filter->fmt_out);
+    es_format_Clean(&filter->fmt_in);
+    vlc_object_delete(filter);
+}
+
+static void TestConvert(vlc_object_t *obj, vlc_fourcc_t in, vlc_fourcc_t out)
+{
+    filter_t *filter = CreateConverter(obj, in, out);
+    const size_t in_size = aout_BitsPerSample(in) / 8;
+    const size_t out_size = aout_BitsPerSample(out) / 8;
+    uint8_t *src = malloc(SAMPLES * in_size);
+    uint8_t *ref = malloc(SAMPLES * out_size);
+    assert(src != NULL && ref != NULL);
+
+    vlc_tick_t ref_time = 0, simd_time = 0;
+    for (unsigned i = 0; i < RUNS; i++)
+    {
+        if (in == VLC_CODEC_FL32)
+            FillFloat((float *)src, SAMPLES);
+        else
+            for (size_t j = 0; j < SAMPLES * in_size; j++)
+                src[j] = Random() >> 24;
+
+        block_t *block = block_Alloc(SAMPLES * in_size);
+        assert(block != NULL);
+        memcpy(block->p_buffer, src, SAMPLES * in_size);
+        block->i_nb_samples = SAMPLES / 2;
+
+        vlc_tick_t start = vlc_tick_now();
+        if (in == VLC_CODEC_FL32 && out == VLC_CODEC_S16N)
+            RefFl32toS16((int16_t *)ref, (const float *)src, SAMPLES);
+        else if (in == VLC_CODEC_FL32 && out == VLC_CODEC_S32N)
+            RefFl32toS32((int32_t *)ref, (const float *)src, SAMPLES);
+        else if (in == VLC_CODEC_S16N)
+            RefS16toFl32((float *)ref, (const int16_t *)src, SAMPLES);
+        else
+            RefS32toFl32((float *)ref, (const int32_t *)src, SAMPLES);
+        vlc_tick_t mid = vlc_tick_now();
+        block = filter->ops->filter_audio(filter, block);
+        vlc_tick_t end = vlc_tick_now();
+
+        ref_time += mid - start;
+        simd_time += end - mid;
+        assert(block != NULL);
+        assert(block->i_buffer == SAMPLES * out_size);
+        assert(!memcmp(block->p_buffer, ref, SAMPLES * out_size));
+        block_Release(block);
+    }
+
+    char what[32];
+    snprintf(what, sizeof (what), "%4.4s -> %4.4s", (const char *)&in,
+             (const char *)&out);
+    Report(what, ref_time, simd_time);
+
+    free(ref);
+    free(src);
+    DeleteConverter(filter);
+}
+
+static void TestInterleave(void)
+{
+    const unsigned samples = SAMPLES / 2;
+    float *planar = malloc(SAMPLES * sizeof (float));
+    float *packed = malloc(SAMPLES * sizeof (float));
+    float *ref = malloc(SAMPLES * sizeof (float));
+    assert(planar != NULL && packed != NULL && ref != NULL);
+
+    FillFloat(planar, SAMPLES);
+
+    const void *planes[2] = { planar, planar + samples };
+    vlc_tick_t ref_time = 0, simd_time = 0;
+
+    for (unsigned i = 0; i < RUNS; i++)
+    {
+        vlc_tick_t start = vlc_tick_now();
+        for (unsigned j = 0; j < samples; j++)
+        {
+            ref[2 * j] = planar[j];
+            ref[2 * j + 1] = planar[samples + j];
+        }
+        vlc_tick_t mid = vlc_tick_now();
+        aout_Interleave(packed, planes, samples, 2, VLC_CODEC_FL32);
+        simd_time += vlc_tick_now() - mid;
+        ref_time += mid - start;
+        assert(!memcmp(packed, ref, 2 * samples * sizeof (float)));
+    }
+    Report("FL32 stereo interleave", ref_time, simd_time);
+
+    ref_time = simd_time = 0;
+    for (unsigned i = 0; i < RUNS; i++)
+    {
+        vlc_tick_t start = vlc_tick_now();
+        for (unsigned j = 0; j < samples; j++)
+        {
+            ref[j] = packed[2 * j];
+            ref[samples + j] = packed[2 * j + 1];
+        }
+        vlc_tick_t mid = vlc_tick_now();
+        aout_Deinterleave(planar, packed, samples, 2, VLC_CODEC_FL32);
+        simd_time += vlc_tick_now() - mid;
+        ref_time += mid - start;
+        assert(!memcmp(planar, ref, 2 * samples * sizeof (float)));
+    }
+    Report("FL32 stereo deinterleave", ref_time, simd_time);
+
+    free(ref);
+    free(packed);
+    free(planar);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    TestVolume(obj);
+    TestConvert(obj, VLC_CODEC_FL32, VLC_CODEC_S16N);
+    TestConvert(obj, VLC_CODEC_FL32, VLC_CODEC_S32N);
+    TestConvert(obj, VLC_CODEC_S16N, VLC_CODEC_FL32);
+    TestConvert(obj, VLC_CODEC_S32N, VLC_CODEC_FL32);
+    TestInterleave();
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*****************************************************************************
+ * scaletempo.c: audio tempo scaler test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+
+#define RATE    48000
+#define SAMPLES (4 * RATE)
+#define BLOCK   1024
+
+/*
+ * The default settings use the SIMD dot-products, the long overlap and
+ * search ones the FFT correlation.
+ */
+static const struct
+{
+    int stride;
+    float overlap;
+    int search;
+} settings[] = {
+    {  30, .2f,  14 },
+    { 100, .6f, 100 },
+};
+
+static const unsigned channels[] = { 1, 2, 6 };
+static const float rates[] = { .75f, 1.5f, 2.f, 3.f, 4.f };
+
+static filter_t *CreateFilter(vlc_object_t *obj, unsigned chans,
+                              unsigned setting)
+{
+    static const uint16_t layouts[] = {
+        [1] = AOUT_CHAN_CENTER,
+        [2] = AOUT_CHANS_STEREO,
+        [6] = AOUT_CHANS_5_1,
+    };
+    filter_t *filter = vlc_object_create(obj, sizeof (*filter));
+    assert(filter != NULL);
+
+    var_Create(filter, "scaletempo-stride", VLC_VAR_INTEGER);
+    var_SetInteger(filter, "scaletempo-stride", settings[setting].stride);
+    var_Create(filter, "scaletempo-overlap", VLC_VAR_FLOAT);
+    var_SetFloat(filter, "scaletempo-overlap", settings[setting].overlap);
+    var_Create(filter, "scaletempo-search", VLC_VAR_INTEGER);
+    var_SetInteger(filter, "scaletempo-search", settings[setting].search);
+
+    es_format_Init(&filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32);
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    filter->fmt_in.audio.i_rate = RATE;
+    filter->fmt_in.audio.i_physical_channels = layouts[chans];
+    aout_FormatPrepare(&filter->fmt_in.audio);
+    es_format_Copy(&filter->fmt_out, &filter->fmt_in);
+
+    assert(vlc_filter_LoadModule(filter, "audio filter", "scaletempo",
+                                 true) != NULL);
+    return filter;
+}
+
+static void DeleteFilter(filter_t *filter)
+{
+    vlc_filter_UnloadModule(filter);
+    es_format_Clean(&filter->fmt_out);
+    es_format_Clean(&filter->fmt_in);
+    vlc_object_delete(filter);
+}
+
+static float Amplitude(unsigned channel)
+{
+    return .5f - .05f * channel;
+}
+
+/*
+ * Plays a tone faster or slower. If the overlaps are not blended in phase,
+ * the level of the tone drops.
+ */
+static void Run(vlc_object_t *obj, unsigned chans, unsigned setting,
+                float rate)
+{
+    filter_t *filter = CreateFilter(obj, chans, setting);
+    float *out = malloc(2 * SAMPLES * chans * sizeof (float));
+    size_t out_frames = 0;
+    vlc_tick_t total = 0;
+
+    assert(out != NULL);
+    filter->fmt_in.audio.i_rate = lroundf(RATE * rate);
+
+    for (unsigned done = 0; done < SAMPLES; done += BLOCK)
+    {
+        block_t *block = block_Alloc(BLOCK * chans * sizeof (float));
+        assert(block != NULL);
+        block->i_nb_samples = BLOCK;
+
+        float *p = (float *)block->p_buffer;
+        for (unsigned i = 0; i < BLOCK; i++)
+            for (unsigned ch = 0; ch < chans; ch++)
+                *(p++) = Amplitude(ch)
+                       * sinf(2.f * (float)M_PI * 440.f * (done + i) / RATE);
+
+        vlc_tick_t start = vlc_tick_now();
+        block = filter->ops->filter_audio(filter, block);
+        total += vlc_tick_now() - start;
+
+        if (block != NULL)
+        {
+            assert(out_frames + block->i_nb_samples <= 2 * SAMPLES);
+            memcpy(&out[out_frames * chans], block->p_buffer,
+                   block->i_buffer);
+            out_frames += block->i_nb_samples;
+            block_Release(block);
+        }
+    }
+    DeleteFilter(filter);
+
+    /* Up to a queue of input is held back or skipped */
+    assert(fabsf(out_frames * rate - SAMPLES) < RATE / 4);
+
+    /* The first stride is blended with silence */
+    const size_t skip = RATE / 10;
+    for (unsigned ch = 0; ch < chans; ch++)
+    {
+        double energy = 0.;
+
+        for (size_t i = skip; i < out_frames; i++)
+            energy += out[i * chans + ch] * (double)out[i * chans + ch];
+
+        double level = sqrt(2. * energy / (out_frames - skip)) / Amplitude(ch);
+        assert(fabs(level - 1.) < .01);
+    }
+
+    test_log("stride %d ms, overlap %.1f, search %d ms, %u channel(s), "
+             "rate %.2f: %.1f Msamples/s\n", settings[setting].stride,
+             settings[setting].overlap, settings[setting].search, chans, rate,
+             (total > 0) ? (double)SAMPLES * chans / 1e6
+                           / secf_from_vlc_tick(total) : 0.);
+    free(out);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    for (unsigned s = 0; s < ARRAY_SIZE(settings); s++)
+        for (size_t c = 0; c < ARRAY_SIZE(channels); c++)
+            for (size_t r = 0; r < ARRAY_SIZE(rates); r++)
+                Run(obj, channels[c], s, rates[r]);
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,392 @@
+/*****************************************************************************
+ * ts_batch.c: MPEG-TS demuxer batched packet reading test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+
+#define PROGRAMS    8
+#define FRAMES      1000
+#define FRAME_SIZE  1500
+#define GARBAGE_AT  5000 /* packet index where junk bytes are inserted */
+#define RUNS        3
+
+/*
+ * Synthetic multiplex: PROGRAMS programs, each with one MPEG audio
+ * elementary stream carrying its own PCR.
+ */
+struct mux
+{
+    uint8_t *data;
+    size_t size;
+    size_t packets;
+    uint8_t cc[0x2000];
+};
+
+static uint32_t crc32_mpeg(const uint8_t *p, size_t len)
+{
+    uint32_t crc = 0xffffffff;
+
+    while (len-- > 0)
+    {
+        crc ^= (uint32_t)*(p++) << 24;
+        for (unsigned i = 0; i < 8; i++)
+            crc = (crc << 1) ^ ((crc & 0x80000000) ? 0x04c11db7 : 0);
+    }
+    return crc;
+}
+
+static uint8_t *mux_Packet(struct mux *mux)
+{
+    uint8_t *p = mux->data + mux->size;
+
+    if (mux->packets == GARBAGE_AT)
+    {   /* lose sync: the demuxer has to look for the next packet */
+        memset(p, 0x47, 50);
+        p += 50;
+        mux->size += 50;
+    }
+    mux->size += 188;
+    mux->packets++;
+    return p;
+}
+
+static size_t mux_Write(struct mux *mux, unsigned pid, bool unit_start,
+                        int64_t pcr, const uint8_t *data, size_t len)
+{
+    uint8_t *pkt = mux_Packet(mux);
+    uint8_t *p = pkt + 4;
+    size_t room = 184;
+
+    pkt[0] = 0x47;
+    pkt[1] = (unit_start ? 0x40 : 0x00) | (pid >> 8);
+    pkt[2] = pid & 0xff;
+    pkt[3] = 0x10 | mux->cc[pid];
+    mux->cc[pid] = (mux->cc[pid] + 1) & 0xf;
+
+    if (pcr >= 0 || len < room)
+    {
+        size_t af = (pcr >= 0) ? 8 : 1;
+        size_t payload = (len < room - af) ? len : room - af;
+        size_t af_size = room - payload;
+
+        pkt[3] |= 0x20;
+        p[0] = af_size - 1;
+        if (af_size > 1)
+        {
+            memset(&p[1], 0xff, af_size - 1);
+            p[1] = 0x00;
+            if (pcr >= 0)
+            {
+                p[1] = 0x10;
+                p[2] = pcr >> 25;
+                p[3] = pcr >> 17;
+                p[4] = pcr >> 9;
+                p[5] = pcr >> 1;
+                p[6] = ((pcr & 1) << 7) | 0x7e;
+                p[7] = 0x00;
+            }
+        }
+        p += af_size;
+        room = payload;
+    }
+    memcpy(p, data, room);
+    return room;
+}
+
+static void mux_Section(struct mux *mux, unsigned pid, uint8_t *sec, size_t len)
+{
+    uint8_t buf[184];
+
+    /* section_length covers the header remainder and the CRC */
+    sec[1] = 0xb0 | ((len + 4 - 3) >> 8);
+    sec[2] = (len + 4 - 3) & 0xff;
+    uint32_t crc = crc32_mpeg(sec, len);
+    SetDWBE(&sec[len], crc);
+    len += 4;
+
+    buf[0] = 0x00; /* pointer_field */
+    memcpy(&buf[1], sec, len);
+    memset(&buf[1 + len], 0xff, sizeof (buf) - 1 - len);
+    mux_Write(mux, pid, true, -1, buf, sizeof (buf));
+}
+
+static void mux_Tables(struct mux *mux)
+{
+    uint8_t sec[180];
+    size_t len = 8;
+
+    sec[0] = 0x00; /* PAT */
+    SetWBE(&sec[3], 1);
+    sec[5] = 0xc1;
+    sec[6] = sec[7] = 0x00;
+    for (unsigned i = 0; i < PROGRAMS; i++)
+    {
+        SetWBE(&sec[len], i + 1);
+        SetWBE(&sec[len + 2], 0xe000 | (0x100 + i));
+        len += 4;
+    }
+    mux_Section(mux, 0, sec, len);
+
+    for (unsigned i = 0; i < PROGRAMS; i++)
+    {
+        sec[0] = 0x02; /* PMT */
+        SetWBE(&sec[3], i + 1);
+        sec[5] = 0xc1;
+        sec[6] = sec[7] = 0x00;
+        SetWBE(&sec[8], 0xe000 | (0x200 + i)); /* PCR PID */
+        SetWBE(&sec[10], 0xf000);
+        sec[12] = 0x03; /* MPEG-1 audio */
+        SetWBE(&sec[13], 0xe000 | (0x200 + i));
+        SetWBE(&sec[15], 0xf000);
+        mux_Section(mux, 0x100 + i, sec, 17);
+    }
+}
+
+static void mux_Frame(struct mux *mux, unsigned prog, unsigned frame)
+{
+    uint8_t pes[14 + FRAME_SIZE];
+    int64_t pts = 90000 + frame * 3600;
+
+    pes[0] = pes[1] = 0x00;
+    pes[2] = 0x01;
+    pes[3] = 0xc0;
+    SetWBE(&pes[4], sizeof (pes) - 6);
+    pes[6] = 0x80;
+    pes[7] = 0x80;
+    pes[8] = 5;
+    pes[9] = 0x21 | ((pts >> 29) & 0x0e);
+    pes[10] = pts >> 22;
+    pes[11] = ((pts >> 14) & 0xfe) | 1;
+    pes[12] = pts >> 7;
+    pes[13] = ((pts << 1) & 0xfe) | 1;
+    for (size_t i = 0; i < FRAME_SIZE; i++)
+        pes[14 + i] = (uint8_t)(i * 31 + frame + prog);
+
+    size_t done = 0;
+    while (done < sizeof (pes))
+        done += mux_Write(mux, 0x200 + prog, done == 0,
+                          done == 0 ? pts - 9000 : -1,
+                          &pes[done], sizeof (pes) - done);
+}
+
+static int mux_Create(struct mux *mux)
+{
+    size_t max = (FRAMES / 25 + 1) * (PROGRAMS + 1)
+               + FRAMES * PROGRAMS * ((14 + FRAME_SIZE) / 176 + 1);
+
+    memset(mux, 0, sizeof (*mux));
+    mux->data = malloc(max * 188 + 50);
+    if (mux->data == NULL)
+        return -1;
+
+    for (unsigned f = 0; f < FRAMES; f++)
+    {
+        if (f % 25 == 0)
+            mux_Tables(mux);
+        for (unsigned i = 0; i < PROGRAMS; i++)
+            mux_Frame(mux, i, f);
+    }
+    assert(mux->size <= max * 188 + 50);
+    return 0;
+}
+
+/*
+ * ES output accumulating a checksum of the data received per PID
+ */
+struct es_out_id_t
+{
+    int pid;
+};
+
+struct test_es_out
+{
+    es_out_t out;
+    es_out_id_t ids[PROGRAMS];
+    uint64_t bytes[PROGRAMS];
+    uint32_t sums[PROGRAMS];
+    unsigned blocks;
+};
+
+static es_out_id_t *EsOutAdd(es_out_t *out, input_source_t *in,
+                             const es_format_t *fmt)
+{
+    struct test_es_out *ctx = container_of(out, struct test_es_out, out);
+    unsigned idx = fmt->i_id - 0x200;
+
+    (void) in;
+    if (idx >= PROGRAMS)
+        return NULL;
+    ctx->ids[idx].pid = fmt->i_id;
+    return &ctx->ids[idx];
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    struct test_es_out *ctx = container_of(out, struct test_es_out, out);
+    unsigned idx = id->pid - 0x200;
+
+    for (block_t *b = block; b != NULL; b = b->p_next)
+    {
+        uint32_t sum = ctx->sums[idx];
+
+        for (size_t i = 0; i < b->i_buffer; i++)
+            sum = sum * 33 + b->p_buffer[i];
+        ctx->sums[idx] = sum;
+        ctx->bytes[idx] += b->i_buffer;
+        ctx->blocks++;
+    }
+    block_ChainRelease(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDelete(es_out_t *out, es_out_id_t *id)
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl(es_out_t *out, input_source_t *in, int query,
+                        va_list args)
+{
+    (void) out; (void) in;
+
+    switch (query)
+    {
+        case ES_OUT_GET_ES_STATE:
+            (void) va_arg(args, es_out_id_t *);
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_GET_EMPTY:
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        default:
+            return VLC_SUCCESS;
+    }
+}
+
+static void EsOutDestroy(es_out_t *out)
+{
+    (void) out;
+}
+
+static const struct es_out_callbacks es_out_cbs =
+{
+    .add = EsOutAdd,
+    .send = EsOutSend,
+    .del = EsOutDelete,
+    .control = EsOutControl,
+    .destroy = EsOutDestroy,
+};
+
+/* Demuxes the multiplex, returning the time taken */
+static vlc_tick_t run(const struct mux *mux, bool batch,
+                      struct test_es_out *ctx)
+{
+    const char *argv[test_defaults_nargs + 1];
+
+    for (int i = 0; i < test_defaults_nargs; i++)
+        argv[i] = test_defaults_args[i];
+    argv[test_defaults_nargs] = batch ? "--ts-batch" : "--no-ts-batch";
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs + 1, argv);
+    assert(vlc != NULL);
+
+    memset(ctx, 0, sizeof (*ctx));
+    ctx->out.cbs = &es_out_cbs;
+
+    stream_t *s = vlc_stream_MemoryNew(vlc->p_libvlc_int, mux->data,
+                                       mux->size, true);
+    assert(s != NULL);
+
+    demux_t *demux = demux_New(VLC_OBJECT(vlc->p_libvlc_int), "ts",
+                               "vlc://nop", s, &ctx->out);
+    assert(demux != NULL);
+    demux_Control(demux, DEMUX_SET_GROUP_ALL);
+
+    vlc_tick_t start = vlc_tick_now();
+    while (demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+    vlc_tick_t end = vlc_tick_now();
+
+    demux_Delete(demux);
+    vlc_stream_Delete(s);
+    libvlc_release(vlc);
+    return end - start;
+}
+
+/* Runs a mode a few times, reporting and returning the best time */
+static vlc_tick_t bench(const struct mux *mux, bool batch,
+                        struct test_es_out *ctx)
+{
+    vlc_tick_t best = VLC_TICK_MAX;
+
+    for (unsigned i = 0; i < RUNS; i++)
+    {
+        vlc_tick_t elapsed = run(mux, batch, ctx);
+
+        if (elapsed < best)
+            best = elapsed;
+    }
+    if (best <= 0)
+        best = 1;
+
+    test_log("%s: %u blocks, %zu packets in %"PRId64" us "
+             "(%.0f packets/s, %.1f MiB/s)\n",
+             batch ? "batched" : "single", ctx->blocks, mux->packets,
+             (int64_t)US_FROM_VLC_TICK(best),
+             mux->packets / secf_from_vlc_tick(best),
+             mux->size / 1048576. / secf_from_vlc_tick(best));
+    return best;
+}
+
+int main(void)
+{
+    struct mux mux;
+    struct test_es_out single, batched;
+
+    test_init();
+
+    assert(mux_Create(&mux) == 0);
+    test_log("Synthetic multiplex: %zu packets, %u programs\n",
+             mux.packets, PROGRAMS);
+
+    vlc_tick_t single_time = bench(&mux, false, &single);
+    vlc_tick_t batched_time = bench(&mux, true, &batched);
+    test_log("Batched reading speed-up: %.2fx\n",
+             (double)single_time / batched_time);
+
+    for (unsigned i = 0; i < PROGRAMS; i++)
+    {
+        /* A few frames may be lost around the junk bytes and at the start */
+        assert(single.bytes[i] >= (FRAMES - 2) * FRAME_SIZE);
+        assert(single.bytes[i] == batched.bytes[i]);
+        assert(single.sums[i] == batched.sums[i]);
+    }
+    assert(single.blocks == batched.blocks);
+
+    free(mux.data);
+    return 0;
+}
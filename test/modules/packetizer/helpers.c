@@ -28,8 +28,44 @@
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_block_helper.h>
+#include <vlc_tick.h>
 
 #include "../modules/packetizer/startcode_helper.h"
+#include "../modules/packetizer/hxxx_ep3b.h"
+
+typedef const uint8_t *(*startcode_finder)(const uint8_t *, const uint8_t *);
+
+static const struct
+{
+    const char *name;
+    startcode_finder find;
+} finders[] = {
+    { "bits", startcode_FindAnnexB_Bits },
+#ifdef CAN_COMPILE_SSE2
+    { "sse2", startcode_FindAnnexB_SSE2 },
+#endif
+#ifdef CAN_COMPILE_AVX2
+    { "avx2", startcode_FindAnnexB_AVX2 },
+#endif
+#ifdef HAS_ATTRIBUTE_VECTORSIZE
+    { "vector", startcode_FindAnnexB_Vector },
+#endif
+    { "default", startcode_FindAnnexB },
+};
+
+static bool finder_usable( startcode_finder find )
+{
+#ifdef CAN_COMPILE_SSE2
+    if( find == startcode_FindAnnexB_SSE2 && !vlc_CPU_SSE2() )
+        return false;
+#endif
+#ifdef CAN_COMPILE_AVX2
+    if( find == startcode_FindAnnexB_AVX2 && !vlc_CPU_AVX2() )
+        return false;
+#endif
+    VLC_UNUSED(find);
+    return true;
+}
 
 struct results_s
 {
@@ -68,28 +104,206 @@ static int run_annexb_sets( const uint8_t *p_set, const uint8_t *p_end,
                             const struct results_s *p_results, size_t i_results,
                             ssize_t i_results_offset )
 {
-    int i_ret;
-
-    printf("checking bits code:\n");
-    i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
-                       startcode_FindAnnexB_Bits );
-    if( i_ret != 0 )
-        return i_ret;
-
-    /* Perform same tests on simd optimized code */
-    if( startcode_FindAnnexB_Bits != startcode_FindAnnexB )
+    /* Perform same tests on all the simd optimized code */
+    for( size_t i = 0; i < ARRAY_SIZE(finders); i++ )
     {
-        printf("checking asm:\n");
-        i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
-                           startcode_FindAnnexB );
+        if( !finder_usable( finders[i].find ) )
+        {
+            printf("%s not supported, skipping test:\n", finders[i].name);
+            continue;
+        }
+
+        printf("checking %s code:\n", finders[i].name);
+        int i_ret = check_set( p_set, p_end, p_results, i_results,
+                               i_results_offset, finders[i].find );
         if( i_ret != 0 )
             return i_ret;
     }
-    else printf("asm not built in, skipping test:\n");
 
     return 0;
 }
 
+/* Emulation prevention as the byte by byte version did it */
+static uint8_t *ref_ep3b_to_rbsp( uint8_t *p, uint8_t *end, unsigned *pi_prev,
+                                  size_t i_count )
+{
+    for( size_t i=0; i<i_count; i++ )
+    {
+        if( ++p >= end )
+            return p;
+
+        *pi_prev = (*pi_prev << 1) | (!*p);
+
+        if( *p == 0x03 && ( p + 1 ) != end )
+        {
+            if( (*pi_prev & 0x06) == 0x06 )
+            {
+                ++p;
+                *pi_prev = !*p;
+            }
+        }
+    }
+    return p;
+}
+
+static uint32_t seed = 0x1234567;
+
+static unsigned Random( void )
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+static int check_ep3b( void )
+{
+    uint8_t buf[512];
+
+    for( unsigned i = 0; i < 20000; i++ )
+    {
+        const size_t i_buf = 1 + Random() % sizeof(buf);
+
+        /* Mostly zeros and 0x03, so that all the cases are met */
+        for( size_t j = 0; j < i_buf; j++ )
+        {
+            const unsigned r = Random() % 8;
+            buf[j] = r < 4 ? 0 : r < 6 ? 3 : r;
+        }
+
+        uint8_t *p = buf, *p_ref = buf;
+        unsigned i_prev = 0, i_prev_ref = 0;
+
+        while( p < buf + i_buf )
+        {
+            const size_t i_count = (Random() & 1) ? 1 + Random() % 4
+                                                  : Random() % 200;
+
+            p = hxxx_ep3b_to_rbsp( p, buf + i_buf, &i_prev, i_count );
+            p_ref = ref_ep3b_to_rbsp( p_ref, buf + i_buf, &i_prev_ref, i_count );
+            /* Only the last two bytes of history are used, until the end */
+            if( p != p_ref ||
+                ( p < buf + i_buf && (i_prev & 3) != (i_prev_ref & 3) ) )
+            {
+                printf("ep3b mismatch at %td, expected %td\n",
+                       p - buf, p_ref - buf);
+                return 1;
+            }
+        }
+    }
+    printf("ep3b skipping matches the byte by byte version\n");
+    return 0;
+}
+
+/*
+ * Access units of real sizes, from a small P frame to a 4K I frame, with
+ * escaped random payloads: only the startcodes can be found.
+ */
+static size_t write_au( uint8_t *p_au, size_t i_au, size_t *offsets,
+                        size_t *pi_nals )
+{
+    size_t i_pos = 0, i_nals = 0;
+
+    while( i_pos + 32 < i_au )
+    {
+        /* 4 bytes startcode for the first NAL, then 3 or 4 */
+        if( i_nals == 0 || (Random() & 1) )
+            p_au[i_pos++] = 0;
+        p_au[i_pos++] = 0;
+        p_au[i_pos++] = 0;
+        offsets[i_nals++] = i_pos - 2;
+        p_au[i_pos++] = 1;
+
+        size_t i_nal = 8 + Random() % ((i_au / 4) + 1);
+        unsigned i_zeros = 0;
+        for( size_t j = 0; j < i_nal && i_pos + 2 < i_au; j++ )
+        {
+            uint8_t byte = (Random() & 3) ? Random() : 0;
+            if( i_zeros >= 2 && byte <= 3 )
+            {
+                p_au[i_pos++] = 3;
+                i_zeros = 0;
+            }
+            i_zeros = byte ? 0 : i_zeros + 1;
+            p_au[i_pos++] = byte;
+        }
+        if( p_au[i_pos - 1] == 0 ) /* no trailing zero */
+            p_au[i_pos - 1] = 0x80;
+    }
+    *pi_nals = i_nals;
+    return i_pos;
+}
+
+static int bench_access_units( void )
+{
+    static const size_t sizes[] = { 2 << 10, 60 << 10, 500 << 10 };
+    const size_t total_bytes = 20 << 20;
+
+    for( size_t s = 0; s < ARRAY_SIZE(sizes); s++ )
+    {
+        uint8_t *p_au = malloc( sizes[s] );
+        size_t *offsets = malloc( sizes[s] / 32 * sizeof(*offsets) );
+        if( !p_au || !offsets )
+        {
+            free( p_au );
+            free( offsets );
+            return 1;
+        }
+
+        size_t i_nals;
+        const size_t i_au = write_au( p_au, sizes[s], offsets, &i_nals );
+        const unsigned runs = total_bytes / i_au;
+
+        for( size_t i = 0; i < ARRAY_SIZE(finders); i++ )
+        {
+            if( !finder_usable( finders[i].find ) )
+                continue;
+
+            vlc_tick_t start = vlc_tick_now();
+            for( unsigned r = 0; r < runs; r++ )
+            {
+                const uint8_t *p = p_au;
+                for( size_t n = 0; n < i_nals; n++, p++ )
+                {
+                    p = finders[i].find( p, p_au + i_au );
+                    if( p != p_au + offsets[n] )
+                        return 1;
+                }
+                if( finders[i].find( p, p_au + i_au ) != NULL )
+                    return 1;
+            }
+            vlc_tick_t total = vlc_tick_now() - start;
+
+            printf("%zu bytes AU, %zu NALs, %s startcodes: %.2f GB/s\n",
+                   i_au, i_nals, finders[i].name, (total > 0) ?
+                   (double) i_au * runs / 1e9 / secf_from_vlc_tick(total) : 0.);
+        }
+
+        /* Skipping whole NALs, as with unparsed SEI payloads */
+        for( unsigned ref = 0; ref < 2; ref++ )
+        {
+            volatile unsigned i_sink = 0;
+            vlc_tick_t start = vlc_tick_now();
+            for( unsigned r = 0; r < runs; r++ )
+            {
+                unsigned i_prev = 0;
+                uint8_t *p = p_au, *end = p_au + i_au;
+                while( p < end )
+                    p = ref ? ref_ep3b_to_rbsp( p, end, &i_prev, 1000 )
+                            : hxxx_ep3b_to_rbsp( p, end, &i_prev, 1000 );
+                i_sink += i_prev;
+            }
+            vlc_tick_t total = vlc_tick_now() - start;
+
+            printf("%zu bytes AU, %s ep3b skipping: %.2f GB/s\n", i_au,
+                   ref ? "byte by byte" : "bulk", (total > 0) ?
+                   (double) i_au * runs / 1e9 / secf_from_vlc_tick(total) : 0.);
+        }
+
+        free( offsets );
+        free( p_au );
+    }
+    return 0;
+}
+
 int main( void )
 {
     const uint8_t test1_annexbdata[] = { 0, 0, 0, 1, 0x55, 0x55, 0x55, 0x55, 0x55, // 9
@@ -134,5 +348,9 @@ int main( void )
             return i_ret;
     }
 
-    return 0;
+    i_ret = check_ep3b();
+    if( i_ret != 0 )
+        return i_ret;
+
+    return bench_access_units();
 }
@@ -0,0 +1,261 @@
+/*****************************************************************************
+ * converters.c: video chroma converters test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#define FRAMES  10
+
+/*
+ * Each conversion is run with the plain C module, then with the SIMD one
+ * (if any); both must produce the same pictures when exact is set.
+ */
+struct conv
+{
+    vlc_fourcc_t in;
+    vlc_fourcc_t out;
+    const char *plain;
+    const char *simd;
+    bool exact;
+};
+
+static const struct conv convs[] = {
+    { VLC_CODEC_I420, VLC_CODEC_YUYV, "i420_yuy2", "i420_yuy2_sse2", true },
+    { VLC_CODEC_I420, VLC_CODEC_YVYU, "i420_yuy2", "i420_yuy2_sse2", true },
+    { VLC_CODEC_I420, VLC_CODEC_UYVY, "i420_yuy2", "i420_yuy2_sse2", true },
+    { VLC_CODEC_I420, VLC_CODEC_XRGB, "i420_rgb", "i420_rgb_sse2", false },
+    { VLC_CODEC_I422, VLC_CODEC_I420, "i422_i420", NULL, false },
+    { VLC_CODEC_YUYV, VLC_CODEC_I420, "yuy2_i420", NULL, false },
+    { VLC_CODEC_I420, VLC_CODEC_NV12, "i420_nv12", NULL, false },
+    { VLC_CODEC_NV12, VLC_CODEC_I420, "i420_nv12", NULL, false },
+    { VLC_CODEC_I420_10L, VLC_CODEC_P010, "i420_nv12", NULL, false },
+};
+
+static const struct
+{
+    unsigned width;
+    unsigned height;
+} sizes[] = {
+    {  640,  360 },
+    { 1366,  768 }, /* not a multiple of the SIMD block widths */
+    { 1920, 1080 },
+    { 3840, 2160 },
+};
+
+static picture_t *NewPicture(const video_format_t *fmt, uint32_t seed)
+{
+    picture_t *pic = picture_NewFromFormat(fmt);
+
+    assert(pic != NULL);
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        plane_t *p = &pic->p[i];
+
+        for (int y = 0; y < p->i_lines; y++)
+            for (int x = 0; x < p->i_pitch; x++)
+            {
+                seed = seed * 1103515245 + 12345;
+                p->p_pixels[y * p->i_pitch + x] = seed >> 16;
+            }
+    }
+    return pic;
+}
+
+static size_t PictureBytes(const picture_t *pic)
+{
+    size_t bytes = 0;
+
+    for (int i = 0; i < pic->i_planes; i++)
+        bytes += (size_t)pic->p[i].i_visible_pitch * pic->p[i].i_visible_lines;
+    return bytes;
+}
+
+static uint32_t Checksum(const picture_t *pic)
+{
+    uint32_t sum = 0;
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        const plane_t *p = &pic->p[i];
+
+        for (int y = 0; y < p->i_visible_lines; y++)
+            for (int x = 0; x < p->i_visible_pitch; x++)
+                sum = sum * 33 + p->p_pixels[y * p->i_pitch + x];
+    }
+    return sum;
+}
+
+static filter_t *CreateConverter(vlc_object_t *obj, const video_format_t *in,
+                                 vlc_fourcc_t chroma, const char *name)
+{
+    filter_t *filter = vlc_object_create(obj, sizeof (*filter));
+    assert(filter != NULL);
+
+    es_format_InitFromVideo(&filter->fmt_in, in);
+    es_format_InitFromVideo(&filter->fmt_out, in);
+    filter->fmt_out.i_codec = filter->fmt_out.video.i_chroma = chroma;
+
+    if (vlc_filter_LoadModule(filter, "video converter", name, true) == NULL)
+    {
+        es_format_Clean(&filter->fmt_out);
+        es_format_Clean(&filter->fmt_in);
+        vlc_object_delete(filter);
+        return NULL;
+    }
+    return filter;
+}
+
+static void DeleteConverter(filter_t *filter)
+{
+    vlc_filter_UnloadModule(filter);
+    es_format_Clean(&filter->fmt_out);
+    es_format_Clean(&filter->fmt_in);
+    vlc_object_delete(filter);
+}
+
+/* Returns false if the module is not available on this system */
+static bool Run(vlc_object_t *obj, const struct conv *conv, const char *name,
+                picture_t *src, uint32_t *sum)
+{
+    filter_t *filter = CreateConverter(obj, &src->format, conv->out, name);
+    if (filter == NULL)
+    {
+        test_log("%4.4s -> %4.4s, %s: not available\n",
+                 (const char *)&conv->in, (const char *)&conv->out, name);
+        return false;
+    }
+
+    size_t bytes = 0;
+    vlc_tick_t total = 0;
+
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        vlc_tick_t start = vlc_tick_now();
+        picture_t *out = filter->ops->filter_video(filter, picture_Hold(src));
+        total += vlc_tick_now() - start;
+
+        assert(out != NULL);
+        bytes += PictureBytes(src) + PictureBytes(out);
+        if (i == FRAMES - 1)
+            *sum = Checksum(out);
+        picture_Release(out);
+    }
+    DeleteConverter(filter);
+
+    test_log("%4.4s -> %4.4s, %ux%u, %s: %.2f GB/s\n",
+             (const char *)&conv->in, (const char *)&conv->out,
+             src->format.i_visible_width, src->format.i_visible_height, name,
+             (total > 0) ? bytes / 1e9 / secf_from_vlc_tick(total) : 0.);
+    return true;
+}
+
+/* The intermediate NV12 pictures come from the pool of the chain */
+static void TestChain(vlc_object_t *obj)
+{
+    es_format_t fmt, fmt_mid;
+    picture_t *in[FRAMES], *out[FRAMES];
+
+    es_format_Init(&fmt, VIDEO_ES, VLC_CODEC_I420);
+    video_format_Setup(&fmt.video, VLC_CODEC_I420, 1920, 1080, 1920, 1080,
+                       1, 1);
+    es_format_Copy(&fmt_mid, &fmt);
+    fmt_mid.i_codec = fmt_mid.video.i_chroma = VLC_CODEC_NV12;
+
+    filter_chain_t *chain = filter_chain_NewVideo(obj, false, NULL);
+    assert(chain != NULL);
+    filter_chain_Reset(chain, &fmt, NULL, &fmt);
+    assert(filter_chain_AppendConverter(chain, &fmt_mid) == VLC_SUCCESS);
+    assert(filter_chain_AppendConverter(chain, &fmt) == VLC_SUCCESS);
+
+    vlc_tick_t total = 0;
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        in[i] = NewPicture(&fmt.video, i);
+
+        vlc_tick_t start = vlc_tick_now();
+        out[i] = filter_chain_VideoFilter(chain, picture_Hold(in[i]));
+        total += vlc_tick_now() - start;
+        assert(out[i] != NULL);
+    }
+
+    /* Outputs are kept until the end, and must not be recycled */
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        assert(Checksum(in[i]) == Checksum(out[i]));
+        picture_Release(out[i]);
+        picture_Release(in[i]);
+    }
+
+    test_log("I420 -> NV12 -> I420, 1920x1080: %.1f fps\n",
+             (total > 0) ? FRAMES / secf_from_vlc_tick(total) : 0.);
+
+    filter_chain_Delete(chain);
+    es_format_Clean(&fmt_mid);
+    es_format_Clean(&fmt);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    for (size_t i = 0; i < ARRAY_SIZE(convs); i++)
+    {
+        const struct conv *conv = &convs[i];
+
+        for (size_t j = 0; j < ARRAY_SIZE(sizes); j++)
+        {
+            video_format_t fmt;
+            video_format_Init(&fmt, conv->in);
+            video_format_Setup(&fmt, conv->in,
+                               sizes[j].width, sizes[j].height,
+                               sizes[j].width, sizes[j].height, 1, 1);
+
+            picture_t *src = NewPicture(&fmt, 0x1234567);
+            uint32_t plain, simd;
+
+            bool has_plain = Run(obj, conv, conv->plain, src, &plain);
+            if (conv->simd != NULL
+             && Run(obj, conv, conv->simd, src, &simd)
+             && has_plain && conv->exact)
+                assert(plain == simd);
+
+            picture_Release(src);
+            video_format_Clean(&fmt);
+        }
+    }
+
+    TestChain(obj);
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*****************************************************************************
+ * slices.c: slice-threaded video filters test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#define WIDTH   1920
+#define HEIGHT  1080
+#define FRAMES  8
+
+static const char *const filters[] = {
+    "sharpen",
+    "adjust{contrast=1.2,hue=20,saturation=1.5,gamma=1.1}",
+    "hqdn3d",
+    "gradfun",
+    "deinterlace{mode=x}",
+};
+#define FILTERS ARRAY_SIZE(filters)
+
+static picture_t *NewPicture(const video_format_t *fmt, unsigned frame)
+{
+    picture_t *pic = picture_NewFromFormat(fmt);
+    uint32_t seed = 0x1234567 + frame;
+
+    assert(pic != NULL);
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        plane_t *p = &pic->p[i];
+
+        for (int y = 0; y < p->i_lines; y++)
+            for (int x = 0; x < p->i_pitch; x++)
+            {
+                /* Smooth gradients with some noise and interlaced combing */
+                seed = seed * 1103515245 + 12345;
+                p->p_pixels[y * p->i_pitch + x] =
+                    (x + y + ((y & 1) ? 40 : 0) + ((seed >> 16) & 7)) & 0xff;
+            }
+    }
+    pic->date = VLC_TICK_0 + frame * VLC_TICK_FROM_MS(40);
+    pic->b_progressive = false;
+    pic->b_top_field_first = true;
+    return pic;
+}
+
+static uint32_t Checksum(const picture_t *pic)
+{
+    uint32_t sum = 0;
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        const plane_t *p = &pic->p[i];
+
+        for (int y = 0; y < p->i_visible_lines; y++)
+            for (int x = 0; x < p->i_visible_pitch; x++)
+                sum = sum * 33 + p->p_pixels[y * p->i_pitch + x];
+    }
+    return sum;
+}
+
+static void run(const char *threads, uint32_t sums[FILTERS][FRAMES])
+{
+    const char *argv[test_defaults_nargs + 2];
+
+    for (int i = 0; i < test_defaults_nargs; i++)
+        argv[i] = test_defaults_args[i];
+    argv[test_defaults_nargs] = "--filter-threads";
+    argv[test_defaults_nargs + 1] = threads;
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs + 2, argv);
+    assert(vlc != NULL);
+
+    es_format_t fmt;
+    es_format_Init(&fmt, VIDEO_ES, VLC_CODEC_I420);
+    video_format_Setup(&fmt.video, VLC_CODEC_I420, WIDTH, HEIGHT,
+                       WIDTH, HEIGHT, 1, 1);
+
+    for (size_t f = 0; f < FILTERS; f++)
+    {
+        filter_chain_t *chain =
+            filter_chain_NewVideo(vlc->p_libvlc_int, false, NULL);
+        assert(chain != NULL);
+        filter_chain_Reset(chain, &fmt, NULL, &fmt);
+        assert(filter_chain_AppendFromString(chain, filters[f]) == 1);
+
+        vlc_tick_t total = 0;
+        for (unsigned i = 0; i < FRAMES; i++)
+        {
+            picture_t *pic = NewPicture(&fmt.video, i);
+
+            vlc_tick_t start = vlc_tick_now();
+            pic = filter_chain_VideoFilter(chain, pic);
+            total += vlc_tick_now() - start;
+
+            assert(pic != NULL);
+            sums[f][i] = Checksum(pic);
+            picture_Release(pic);
+        }
+
+        filter_chain_Delete(chain);
+        test_log("%s, %s thread(s): %.1f fps\n", filters[f], threads,
+                 (total > 0) ? FRAMES / secf_from_vlc_tick(total) : 0.);
+    }
+
+    es_format_Clean(&fmt);
+    libvlc_release(vlc);
+}
+
+int main(void)
+{
+    static uint32_t single[FILTERS][FRAMES], sliced[FILTERS][FRAMES];
+
+    test_init();
+
+    run("1", single);
+    run("4", sliced);
+
+    /* Slices must not change the output */
+    for (size_t f = 0; f < FILTERS; f++)
+        for (unsigned i = 0; i < FRAMES; i++)
+            assert(single[f][i] == sliced[f][i]);
+
+    return 0;
+}
@@ -0,0 +1,267 @@
+/*****************************************************************************
+ * yadif.c: yadif deinterlacer test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#include "../../../modules/video_filter/deinterlace/common.h"
+#include "../../../modules/video_filter/deinterlace/yadif.h"
+
+#define WIDTH   1920
+#define HEIGHT  1080
+#define FRAMES  6
+
+static uint32_t seed;
+
+static unsigned Random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+#if defined(CAN_COMPILE_AVX2)
+/* The AVX2 line filters must match the C ones */
+static void test_lines(void)
+{
+    uint8_t prev[8][512], cur[8][512], next[8][512], ref[8][512], out[8][512];
+
+    for (unsigned i = 0; i < 10000; i++)
+    {
+        const bool hbd = i & 1;
+        const unsigned max = hbd ? ((i & 2) ? 0xffff : 0x3ff) : 0xff;
+        const int w = 1 + Random() % 200;
+        const int parity = Random() & 1, mode = (Random() & 1) * 2;
+        const int stride = sizeof (cur[0]);
+
+        for (unsigned y = 0; y < 8; y++)
+            for (unsigned x = 0; x < 512; x += 2)
+            {
+                unsigned p = Random() % (max + 1), c = Random() % (max + 1);
+                unsigned n = (Random() & 1) ? p : Random() % (max + 1);
+
+                if (hbd)
+                {
+                    SetWLE(&prev[y][x], p); SetWLE(&cur[y][x], c);
+                    SetWLE(&next[y][x], n);
+                }
+                else
+                {
+                    prev[y][x] = prev[y][x + 1] = p;
+                    cur[y][x] = cur[y][x + 1] = c;
+                    next[y][x] = next[y][x + 1] = n;
+                }
+            }
+        memset(ref, 0, sizeof (ref));
+        memset(out, 0, sizeof (out));
+
+        if (hbd)
+        {
+            yadif_filter_line_c_16bit(&ref[4][8], &prev[4][8], &cur[4][8],
+                                      &next[4][8], w, stride, -stride,
+                                      parity, mode);
+            yadif_filter_line_avx2_16bit(&out[4][8], &prev[4][8], &cur[4][8],
+                                         &next[4][8], w, stride, -stride,
+                                         parity, mode);
+        }
+        else
+        {
+            yadif_filter_line_c(&ref[4][8], &prev[4][8], &cur[4][8],
+                                &next[4][8], w, stride, -stride, parity, mode);
+            yadif_filter_line_avx2(&out[4][8], &prev[4][8], &cur[4][8],
+                                   &next[4][8], w, stride, -stride,
+                                   parity, mode);
+        }
+        assert(!memcmp(ref, out, sizeof (ref)));
+    }
+    test_log("AVX2 line filters match the C ones\n");
+}
+#endif
+
+static picture_t *NewPicture(const video_format_t *fmt, unsigned frame,
+                             unsigned max)
+{
+    picture_t *pic = picture_NewFromFormat(fmt);
+
+    assert(pic != NULL);
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        plane_t *p = &pic->p[i];
+        const int w = p->i_visible_pitch / p->i_pixel_pitch;
+
+        for (int y = 0; y < p->i_lines; y++)
+            for (int x = 0; x < w; x++)
+            {
+                /* Moving combed edges, with noise */
+                unsigned v = ((x + 8 * frame * ((y & 1) ? 2 : 1)) & 64)
+                           ? max * 3 / 4 : max / 4;
+                v += Random() % 16;
+                if (p->i_pixel_pitch == 2)
+                    ((uint16_t *)&p->p_pixels[y * p->i_pitch])[x] = v;
+                else
+                    p->p_pixels[y * p->i_pitch + x] = v;
+            }
+    }
+    pic->date = VLC_TICK_0 + frame * VLC_TICK_FROM_MS(40);
+    pic->b_progressive = false;
+    pic->b_top_field_first = true;
+    return pic;
+}
+
+static uint32_t Checksum(const picture_t *pic)
+{
+    uint32_t sum = 0;
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        const plane_t *p = &pic->p[i];
+
+        for (int y = 0; y < p->i_visible_lines; y++)
+            for (int x = 0; x < p->i_visible_pitch; x++)
+                sum = sum * 33 + p->p_pixels[y * p->i_pitch + x];
+    }
+    return sum;
+}
+
+/* Single-field yadif with the C line filters, as rendered before slices */
+static uint32_t Reference(picture_t *prev, picture_t *cur, picture_t *next)
+{
+    picture_t *dst = picture_NewFromFormat(&cur->format);
+    const int parity = 1, field = 0;
+
+    assert(dst != NULL);
+    for (int n = 0; n < dst->i_planes; n++)
+    {
+        const plane_t *prevp = &prev->p[n], *curp = &cur->p[n];
+        const plane_t *nextp = &next->p[n];
+        plane_t *dstp = &dst->p[n];
+        const int lines = dstp->i_visible_lines;
+
+        for (int y = 1; y < lines - 1; y++)
+        {
+            if ((y % 2) == field)
+                memcpy(&dstp->p_pixels[y * dstp->i_pitch],
+                       &curp->p_pixels[y * curp->i_pitch],
+                       dstp->i_visible_pitch);
+            else
+                (dstp->i_pixel_pitch == 2 ? yadif_filter_line_c_16bit
+                                          : yadif_filter_line_c)(
+                    &dstp->p_pixels[y * dstp->i_pitch],
+                    &prevp->p_pixels[y * prevp->i_pitch],
+                    &curp->p_pixels[y * curp->i_pitch],
+                    &nextp->p_pixels[y * nextp->i_pitch],
+                    dstp->i_visible_pitch / dstp->i_pixel_pitch,
+                    y < lines - 2 ? curp->i_pitch : -curp->i_pitch,
+                    y - 1 ? -curp->i_pitch : curp->i_pitch,
+                    parity, (y >= 2 && y < lines - 2) ? 0 : 2);
+        }
+        memcpy(&dstp->p_pixels[0], &dstp->p_pixels[dstp->i_pitch],
+               dstp->i_pitch);
+        memcpy(&dstp->p_pixels[(lines - 1) * dstp->i_pitch],
+               &dstp->p_pixels[(lines - 2) * dstp->i_pitch], dstp->i_pitch);
+    }
+
+    uint32_t sum = Checksum(dst);
+    picture_Release(dst);
+    return sum;
+}
+
+static void test_frames(vlc_fourcc_t chroma, unsigned max, const char *threads)
+{
+    const char *argv[test_defaults_nargs + 2];
+
+    for (int i = 0; i < test_defaults_nargs; i++)
+        argv[i] = test_defaults_args[i];
+    argv[test_defaults_nargs] = "--filter-threads";
+    argv[test_defaults_nargs + 1] = threads;
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs + 2, argv);
+    assert(vlc != NULL);
+
+    es_format_t fmt;
+    es_format_Init(&fmt, VIDEO_ES, chroma);
+    video_format_Setup(&fmt.video, chroma, WIDTH, HEIGHT, WIDTH, HEIGHT, 1, 1);
+
+    filter_chain_t *chain =
+        filter_chain_NewVideo(vlc->p_libvlc_int, false, NULL);
+    assert(chain != NULL);
+    filter_chain_Reset(chain, &fmt, NULL, &fmt);
+    assert(filter_chain_AppendFromString(chain, "deinterlace{mode=yadif}") == 1);
+
+    picture_t *in[FRAMES];
+    vlc_tick_t total = 0;
+
+    seed = 0x1234567;
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        in[i] = NewPicture(&fmt.video, i, max);
+
+        vlc_tick_t start = vlc_tick_now();
+        picture_t *out = filter_chain_VideoFilter(chain, picture_Hold(in[i]));
+        vlc_tick_t end = vlc_tick_now();
+
+        /* The second frame is dropped, yadif starts at the third one */
+        if (i == 1)
+        {
+            assert(out == NULL);
+            continue;
+        }
+        assert(out != NULL);
+        if (i >= 2)
+        {
+            total += end - start;
+            assert(Checksum(out) == Reference(in[i - 2], in[i - 1], in[i]));
+        }
+        picture_Release(out);
+    }
+
+    test_log("%4.4s, %s thread(s): %.1f fps\n", (const char *)&chroma,
+             threads, (FRAMES - 2) / secf_from_vlc_tick(total));
+
+    for (unsigned i = 0; i < FRAMES; i++)
+        picture_Release(in[i]);
+    filter_chain_Delete(chain);
+    es_format_Clean(&fmt);
+    libvlc_release(vlc);
+}
+
+int main(void)
+{
+    test_init();
+
+#if defined(CAN_COMPILE_AVX2)
+    if (vlc_CPU_AVX2())
+        test_lines();
+#endif
+
+    test_frames(VLC_CODEC_I420, 0xff, "1");
+    test_frames(VLC_CODEC_I420, 0xff, "4");
+    test_frames(VLC_CODEC_I420_10L, 0x3ff, "1");
+    test_frames(VLC_CODEC_I420_10L, 0x3ff, "4");
+    return 0;
+}
@@ -759,6 +759,48 @@ struct input_decoder_scenario input_decoder_scenarios[] =
     .display_prepare = display_prepare_noop,
     .text_renderer_render = cc_text_renderer_render_608_02,
 },
+{
+    .name = "decoder is flushed with the packetizer thread",
+    .source = source_800_600 ";video_packetized=false",
+    .item_option = ":dec-packetizer-thread",
+    .decoder_setup = decoder_i420_800_600,
+    .decoder_flush = decoder_flush_signal,
+    .decoder_decode = decoder_decode_check_cc,
+    .interface_setup = interface_setup_select_cc,
+},
+{
+    .name = "video output is flushed with the packetizer thread",
+    .source = source_800_600 ";video_packetized=false",
+    .item_option = ":dec-packetizer-thread",
+    .decoder_setup = decoder_i420_800_600,
+    .decoder_decode = decoder_decode_check_flush_video,
+    .decoder_flush = decoder_flush_signal,
+    .display_prepare = display_prepare_signal,
+    .interface_setup = interface_setup_check_flush,
+},
+{
+    .name = "reloading a decoder with the packetizer thread",
+    .source = source_800_600 ";video_packetized=false",
+    .item_option = ":dec-packetizer-thread",
+    .decoder_setup = decoder_i420_800_600,
+    .decoder_decode = decoder_decode_trigger_reload,
+},
+{
+    /* The CC are extracted on the packetizer thread, cf. the packetizer CC
+     * scenario above */
+    .name = "CC coming from the packetizer thread is decoded and rendered",
+    .source = source_800_600 ";video_packetized=false",
+    .item_option = ":dec-packetizer-thread",
+    .subpicture_chromas = subpicture_chromas,
+    .packetizer_getcc = packetizer_getcc,
+    .decoder_setup = decoder_i420_800_600_update,
+    .decoder_decode = decoder_decode,
+    .cc_decoder_setup = cc_decoder_setup_01,
+    .cc_decoder_decode = cc_decoder_decode,
+    .display_prepare = display_prepare_noop,
+    .text_renderer_render = cc_text_renderer_render,
+    .player_setup_before_start = player_setup_select_cc,
+},
 };
 
 size_t input_decoder_scenarios_count = ARRAY_SIZE(input_decoder_scenarios);
@@ -0,0 +1,229 @@
+/*****************************************************************************
+ * executor.c: test and benchmark for vlc_executor_t
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_threads.h>
+#include <vlc_executor.h>
+#include <vlc_tick.h>
+
+#define BENCH_TASKS 200000
+#define BENCH_FANOUT 64
+
+struct blocker
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    bool started;
+    bool released;
+    struct vlc_runnable runnable;
+};
+
+static void BlockerRun(void *data)
+{
+    struct blocker *b = data;
+
+    vlc_mutex_lock(&b->lock);
+    b->started = true;
+    vlc_cond_signal(&b->wait);
+    while (!b->released)
+        vlc_cond_wait(&b->wait, &b->lock);
+    vlc_mutex_unlock(&b->lock);
+}
+
+static void BlockerStart(vlc_executor_t *executor, struct blocker *b)
+{
+    vlc_mutex_init(&b->lock);
+    vlc_cond_init(&b->wait);
+    b->started = b->released = false;
+    b->runnable.run = BlockerRun;
+    b->runnable.userdata = b;
+    vlc_executor_Submit(executor, &b->runnable);
+
+    vlc_mutex_lock(&b->lock);
+    while (!b->started)
+        vlc_cond_wait(&b->wait, &b->lock);
+    vlc_mutex_unlock(&b->lock);
+}
+
+static void BlockerRelease(struct blocker *b)
+{
+    vlc_mutex_lock(&b->lock);
+    b->released = true;
+    vlc_cond_signal(&b->wait);
+    vlc_mutex_unlock(&b->lock);
+}
+
+struct order_task
+{
+    char name;
+    char *log;
+    struct vlc_runnable runnable;
+};
+
+static void OrderRun(void *data)
+{
+    struct order_task *task = data;
+    char *end = task->log + strlen(task->log);
+
+    /* Only one thread, no need to lock */
+    end[0] = task->name;
+    end[1] = '\0';
+}
+
+static void test_priority(void)
+{
+    vlc_executor_t *executor = vlc_executor_New(1);
+    assert(executor != NULL);
+
+    struct blocker blocker;
+    BlockerStart(executor, &blocker);
+
+    char log[8] = "";
+    static const struct
+    {
+        char name;
+        enum vlc_executor_priority priority;
+    } specs[] = {
+        { 'a', VLC_EXECUTOR_PRIORITY_LOW },
+        { 'b', VLC_EXECUTOR_PRIORITY_NORMAL },
+        { 'c', VLC_EXECUTOR_PRIORITY_HIGH },
+        { 'd', VLC_EXECUTOR_PRIORITY_NORMAL },
+        { 'e', VLC_EXECUTOR_PRIORITY_LOW },
+        { 'f', VLC_EXECUTOR_PRIORITY_HIGH },
+    };
+    struct order_task tasks[ARRAY_SIZE(specs)];
+
+    for (size_t i = 0; i < ARRAY_SIZE(specs); i++)
+    {
+        tasks[i].name = specs[i].name;
+        tasks[i].log = log;
+        tasks[i].runnable.run = OrderRun;
+        tasks[i].runnable.userdata = &tasks[i];
+        vlc_executor_SubmitWithPriority(executor, &tasks[i].runnable,
+                                        specs[i].priority);
+    }
+
+    /* 'd' is canceled while pending */
+    assert(vlc_executor_Cancel(executor, &tasks[3].runnable));
+
+    BlockerRelease(&blocker);
+    vlc_executor_WaitIdle(executor);
+
+    assert(!strcmp(log, "cfbae"));
+    assert(!vlc_executor_Cancel(executor, &tasks[0].runnable));
+    assert(!vlc_executor_Cancel(executor, &blocker.runnable));
+
+    vlc_executor_Delete(executor);
+}
+
+struct bench
+{
+    vlc_executor_t *executor;
+    atomic_uint done;
+};
+
+struct bench_task
+{
+    struct bench *bench;
+    struct bench_task *children;
+    struct vlc_runnable runnable;
+};
+
+static void BenchRun(void *data)
+{
+    struct bench_task *task = data;
+
+    atomic_fetch_add_explicit(&task->bench->done, 1, memory_order_relaxed);
+
+    /* Submit child tasks from the executor thread */
+    if (task->children != NULL)
+        for (unsigned i = 0; i < BENCH_FANOUT; i++)
+            vlc_executor_Submit(task->bench->executor,
+                                &task->children[i].runnable);
+}
+
+static void bench(unsigned nthreads, bool fanout)
+{
+    struct bench bench;
+    struct bench_task *tasks = calloc(BENCH_TASKS, sizeof (*tasks));
+    assert(tasks != NULL);
+
+    bench.executor = vlc_executor_New(nthreads);
+    assert(bench.executor != NULL);
+    atomic_init(&bench.done, 0);
+
+    for (unsigned i = 0; i < BENCH_TASKS; i++)
+    {
+        tasks[i].bench = &bench;
+        tasks[i].runnable.run = BenchRun;
+        tasks[i].runnable.userdata = &tasks[i];
+    }
+
+    unsigned roots = BENCH_TASKS;
+    if (fanout)
+    {
+        roots = BENCH_TASKS / (BENCH_FANOUT + 1);
+        for (unsigned i = 0; i < roots; i++)
+            tasks[i].children = &tasks[roots + i * BENCH_FANOUT];
+    }
+
+    vlc_tick_t start = vlc_tick_now();
+
+    for (unsigned i = 0; i < roots; i++)
+        vlc_executor_Submit(bench.executor, &tasks[i].runnable);
+    vlc_executor_WaitIdle(bench.executor);
+
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    unsigned done = atomic_load(&bench.done);
+
+    assert(done == (fanout ? roots * (BENCH_FANOUT + 1) : BENCH_TASKS));
+    printf("%u thread(s), %s: %u tasks in %"PRId64" us (%.0f tasks/s)\n",
+           nthreads, fanout ? "nested submission" : "external submission",
+           done, US_FROM_VLC_TICK(elapsed),
+           done / secf_from_vlc_tick(elapsed));
+
+    vlc_executor_Delete(bench.executor);
+    free(tasks);
+}
+
+int main(void)
+{
+    test_priority();
+
+    static const unsigned threads[] = { 1, 4, 16 };
+
+    for (size_t i = 0; i < ARRAY_SIZE(threads); i++)
+    {
+        bench(threads[i], false);
+        bench(threads[i], true);
+    }
+    return 0;
+}
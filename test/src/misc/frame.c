@@ -0,0 +1,219 @@
+/*****************************************************************************
+ * frame.c: test for the frame allocator cache
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_frame.h>
+
+#include "../../../src/misc/frame.h"
+
+#define BATCH 65
+
+static struct vlc_frame_cache_stats stats;
+
+/** Returns the number of heap allocations since the previous call */
+static uint64_t HeapAllocs(uint64_t *allocs)
+{
+    struct vlc_frame_cache_stats prev = stats;
+
+    vlc_frame_cache_GetStats(&stats);
+    if (allocs != NULL)
+        *allocs = stats.allocs - prev.allocs;
+    return stats.heap_allocs - prev.heap_allocs;
+}
+
+static vlc_frame_t *Alloc(size_t size)
+{
+    vlc_frame_t *frame = vlc_frame_Alloc(size);
+
+    assert(frame != NULL);
+    assert(frame->i_buffer == size);
+    memset(frame->p_buffer, 0xA5, size);
+    return frame;
+}
+
+static void test_classes(void)
+{
+    static const struct
+    {
+        size_t size;
+        size_t same; /* size served by the same class */
+        size_t other; /* size served by the next class */
+    } classes[] = {
+        { 256, 1, 257 },
+        { 65536, 32769, 65537 },
+    };
+    uint64_t allocs;
+
+    HeapAllocs(NULL);
+    for (size_t i = 0; i < ARRAY_SIZE(classes); i++)
+    {
+        vlc_frame_t *frame = Alloc(classes[i].size);
+        vlc_frame_Release(frame);
+        HeapAllocs(NULL);
+
+        /* A released frame is given back to the next allocation of its class */
+        vlc_frame_t *same = Alloc(classes[i].same);
+        assert(same == frame);
+        assert(HeapAllocs(&allocs) == 0);
+        assert(allocs == 1);
+
+        vlc_frame_t *other = Alloc(classes[i].other);
+        assert(other != same);
+        assert(HeapAllocs(&allocs) == 1);
+        assert(allocs == 1);
+
+        vlc_frame_Release(other);
+        vlc_frame_Release(same);
+    }
+
+    /* Frames larger than the largest class always come from the heap */
+    for (int i = 0; i < 2; i++)
+    {
+        vlc_frame_Release(Alloc(65537));
+        assert(HeapAllocs(&allocs) == 1);
+        assert(allocs == 1);
+    }
+}
+
+struct thread_data
+{
+    vlc_frame_t *frames[BATCH];
+    size_t count;
+    size_t size;
+    bool release;
+    uint64_t heap_allocs;
+};
+
+static void *AllocThread(void *opaque)
+{
+    struct thread_data *data = opaque;
+
+    for (size_t i = 0; i < data->count; i++)
+        data->frames[i] = Alloc(data->size);
+    if (data->release)
+        for (size_t i = 0; i < data->count; i++)
+            vlc_frame_Release(data->frames[i]);
+    return NULL;
+}
+
+static void RunThread(struct thread_data *data)
+{
+    vlc_thread_t th;
+
+    int ret = vlc_clone(&th, AllocThread, data);
+    assert(ret == 0);
+    vlc_join(th, NULL);
+    /* The counters of a thread are published when it exits */
+    data->heap_allocs = HeapAllocs(NULL);
+}
+
+static void test_cross_thread(void)
+{
+    struct thread_data producer = { .count = BATCH, .size = 2048 };
+    struct thread_data consumer = { .count = BATCH / 4, .size = 2048 };
+    uint64_t allocs;
+
+    HeapAllocs(NULL);
+
+    /* Frames allocated by a thread and released by another one overflow
+     * the list of the latter, which gives some to the global list... */
+    RunThread(&producer);
+    assert(producer.heap_allocs == BATCH);
+    for (size_t i = 0; i < producer.count; i++)
+        vlc_frame_Release(producer.frames[i]);
+
+    /* ...from which the allocations of a third thread are served */
+    RunThread(&consumer);
+    assert(consumer.heap_allocs == 0);
+    for (size_t i = 0; i < consumer.count; i++)
+        vlc_frame_Release(consumer.frames[i]);
+    HeapAllocs(&allocs);
+    assert(allocs == 0);
+}
+
+static void test_thread_exit(void)
+{
+    struct thread_data worker = { .count = 8, .size = 8192, .release = true };
+    vlc_frame_t *frames[8];
+    uint64_t allocs;
+
+    /* The lists of an exiting thread are handed to the global lists */
+    HeapAllocs(NULL);
+    RunThread(&worker);
+    assert(worker.heap_allocs == 8);
+
+    for (size_t i = 0; i < ARRAY_SIZE(frames); i++)
+        frames[i] = Alloc(8192);
+    assert(HeapAllocs(&allocs) == 0);
+    assert(allocs == ARRAY_SIZE(frames));
+    for (size_t i = 0; i < ARRAY_SIZE(frames); i++)
+        vlc_frame_Release(frames[i]);
+}
+
+static void test_teardown(void)
+{
+    uint64_t allocs;
+
+    vlc_frame_t *kept = Alloc(1000);
+
+    vlc_frame_Release(Alloc(300));
+    vlc_frame_cache_Drop();
+
+    /* Without the cache, frames come from the heap... */
+    HeapAllocs(NULL);
+    for (int i = 0; i < 2; i++)
+    {
+        vlc_frame_Release(Alloc(300));
+        assert(HeapAllocs(&allocs) == 1);
+        assert(allocs == 1);
+    }
+
+    /* ...and cached frames still alive are freed on release */
+    vlc_frame_Release(kept);
+
+    /* The cache can be enabled again */
+    vlc_frame_cache_Hold();
+    vlc_frame_Release(Alloc(300));
+    vlc_frame_Release(Alloc(300));
+    assert(HeapAllocs(&allocs) == 1);
+    assert(allocs == 2);
+    vlc_frame_cache_Drop();
+}
+
+int main(void)
+{
+#ifdef __SANITIZE_ADDRESS__
+    /* The cache is disabled in address sanitizer builds */
+    return 77;
+#endif
+    vlc_frame_cache_Hold();
+    test_classes();
+    test_cross_thread();
+    test_thread_exit();
+    test_teardown();
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*****************************************************************************
+ * messages.c: test for the asynchronous message log
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define EMITTERS 4
+#define MESSAGES 20000
+#define LONG_MESSAGE_SIZE 1000
+
+struct log_sink {
+    unsigned long received;
+    unsigned long dropped;
+    unsigned long next[EMITTERS];
+};
+
+static void log_cb(void *data, int level, const libvlc_log_t *ctx,
+                   const char *fmt, va_list ap)
+{
+    struct log_sink *sink = data;
+    const char *module, *header;
+    char buf[LONG_MESSAGE_SIZE + 1];
+    unsigned emitter;
+    unsigned long seq;
+
+    vsnprintf(buf, sizeof (buf), fmt, ap);
+    libvlc_log_get_context(ctx, &module, NULL, NULL);
+
+    if (!strcmp(module, "core")
+     && sscanf(buf, "%lu log message(s) dropped", &seq) == 1)
+    {
+        sink->dropped += seq;
+        return;
+    }
+
+    if (strcmp(module, "test"))
+        return; /* not ours */
+
+    libvlc_log_get_object(ctx, NULL, &header, NULL);
+    if (header != NULL)
+    {
+        assert(!strcmp(header, "long"));
+        assert(strlen(buf) == LONG_MESSAGE_SIZE);
+        sink->received++;
+        return;
+    }
+
+    assert(sscanf(buf, "emitter %u message %lu", &emitter, &seq) == 2);
+    assert(emitter < EMITTERS);
+    /* Messages from one thread keep their order */
+    assert(seq >= sink->next[emitter]);
+    sink->next[emitter] = seq + 1;
+    sink->received++;
+    (void) level;
+}
+
+struct emitter {
+    vlc_thread_t thread;
+    struct vlc_logger *logger;
+    unsigned index;
+};
+
+static void *emit(void *data)
+{
+    struct emitter *e = data;
+
+    for (unsigned long i = 0; i < MESSAGES; i++)
+        vlc_Log(&e->logger, (i & 7) ? VLC_MSG_DBG : VLC_MSG_WARN, "generic",
+                "test", __FILE__, __LINE__, __func__,
+                "emitter %u message %lu", e->index, i);
+    return NULL;
+}
+
+static void test_async(libvlc_instance_t *vlc)
+{
+    struct vlc_logger *logger = vlc->p_libvlc_int->obj.logger;
+    struct log_sink sink = { 0 };
+    struct emitter emitters[EMITTERS];
+
+    libvlc_log_set(vlc, log_cb, &sink);
+
+    vlc_tick_t start = vlc_tick_now();
+    for (unsigned i = 0; i < EMITTERS; i++)
+    {
+        emitters[i].logger = logger;
+        emitters[i].index = i;
+        assert(vlc_clone(&emitters[i].thread, emit, &emitters[i]) == 0);
+    }
+
+    /* Messages longer than the queue slots, with a header */
+    struct vlc_logger *header = vlc_LogHeaderCreate(logger, "long");
+    char text[LONG_MESSAGE_SIZE + 1];
+
+    assert(header != NULL);
+    memset(text, 'x', LONG_MESSAGE_SIZE);
+    text[LONG_MESSAGE_SIZE] = '\0';
+    for (unsigned i = 0; i < 10; i++)
+        vlc_Log(&header, VLC_MSG_ERR, "generic", "test", __FILE__, __LINE__,
+                __func__, "%s", text);
+
+    for (unsigned i = 0; i < EMITTERS; i++)
+        vlc_join(emitters[i].thread, NULL);
+    vlc_tick_t end = vlc_tick_now();
+
+    vlc_LogDestroy(header);
+    /* Drains the queue */
+    libvlc_log_unset(vlc);
+
+    test_log("%lu messages logged, %lu dropped, %"PRId64" ns per message\n",
+             sink.received, sink.dropped,
+             (int64_t)NS_FROM_VLC_TICK(end - start) / (EMITTERS * MESSAGES));
+    assert(sink.received + sink.dropped == EMITTERS * MESSAGES + 10);
+}
+
+int main(void)
+{
+    libvlc_instance_t *vlc;
+
+    test_init();
+
+    test_log("Testing the asynchronous message log\n");
+    vlc = libvlc_new(test_defaults_nargs, test_defaults_args);
+    assert(vlc != NULL);
+
+    test_async(vlc);
+
+    libvlc_release(vlc);
+    return 0;
+}
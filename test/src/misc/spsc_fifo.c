@@ -0,0 +1,158 @@
+/*****************************************************************************
+ * spsc_fifo.c: test for the single-producer single-consumer frame FIFO
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_frame.h>
+
+#define STRESS_COUNT 20000
+
+static vlc_frame_t *frame_New(size_t size, vlc_tick_t seq)
+{
+    vlc_frame_t *frame = vlc_frame_Alloc(size);
+    assert(frame != NULL);
+    frame->i_dts = seq;
+    return frame;
+}
+
+static void test_basic(void)
+{
+    vlc_spsc_fifo_t *fifo = vlc_spsc_fifo_New(3);
+    assert(fifo != NULL);
+    assert(vlc_spsc_fifo_Pop(fifo) == NULL);
+    assert(vlc_spsc_fifo_GetCount(fifo) == 0);
+    assert(vlc_spsc_fifo_GetBytes(fifo) == 0);
+
+    /* Capacity is rounded up to 4 */
+    for (int i = 0; i < 4; i++)
+        assert(vlc_spsc_fifo_Push(fifo, frame_New(10, i)));
+    assert(vlc_spsc_fifo_GetCount(fifo) == 4);
+    assert(vlc_spsc_fifo_GetBytes(fifo) == 40);
+
+    vlc_frame_t *extra = frame_New(5, 4);
+    assert(!vlc_spsc_fifo_Push(fifo, extra));
+
+    for (int i = 0; i < 4; i++)
+    {
+        vlc_frame_t *frame = vlc_spsc_fifo_Pop(fifo);
+        assert(frame != NULL && frame->i_dts == i);
+        assert(frame->p_next == NULL);
+        vlc_frame_Release(frame);
+    }
+    assert(vlc_spsc_fifo_Pop(fifo) == NULL);
+    assert(vlc_spsc_fifo_GetBytes(fifo) == 0);
+
+    /* Chains are queued entirely or not at all */
+    vlc_frame_t *chain = NULL;
+    for (int i = 2; i >= 0; i--)
+    {
+        vlc_frame_t *frame = frame_New(1, 5 + i);
+        frame->p_next = chain;
+        chain = frame;
+    }
+    assert(vlc_spsc_fifo_Push(fifo, extra));
+    assert(vlc_spsc_fifo_Push(fifo, chain));
+    assert(vlc_spsc_fifo_GetCount(fifo) == 4);
+    assert(vlc_spsc_fifo_GetBytes(fifo) == 8);
+
+    vlc_frame_t *frame = vlc_spsc_fifo_Pop(fifo);
+    assert(frame == extra);
+    vlc_frame_Release(frame);
+
+    chain = frame_New(1, 8);
+    chain->p_next = frame_New(1, 9);
+    assert(!vlc_spsc_fifo_Push(fifo, chain));
+    assert(vlc_spsc_fifo_GetCount(fifo) == 3);
+
+    /* Dequeue up to a mark, leaving later frames */
+    size_t mark = vlc_spsc_fifo_Mark(fifo);
+    vlc_frame_t *next = chain->p_next;
+    chain->p_next = NULL;
+    assert(vlc_spsc_fifo_Push(fifo, chain));
+
+    vlc_frame_t *flushed = vlc_spsc_fifo_DequeueUntil(fifo, mark);
+    unsigned count = 0;
+    for (vlc_frame_t *f = flushed; f != NULL; f = f->p_next)
+        assert(f->i_dts == 5 + count++);
+    assert(count == 3);
+    vlc_frame_ChainRelease(flushed);
+
+    assert(vlc_spsc_fifo_DequeueUntil(fifo, mark) == NULL);
+    assert(vlc_spsc_fifo_GetCount(fifo) == 1);
+    assert(vlc_spsc_fifo_GetBytes(fifo) == 1);
+
+    /* Queued frames are released with the FIFO */
+    assert(vlc_spsc_fifo_Push(fifo, next));
+    vlc_spsc_fifo_Delete(fifo);
+}
+
+static void *consumer(void *data)
+{
+    vlc_spsc_fifo_t *fifo = data;
+
+    for (vlc_tick_t seq = 0; seq < STRESS_COUNT;)
+    {
+        vlc_frame_t *frame = vlc_spsc_fifo_Pop(fifo);
+        if (frame == NULL)
+            continue;
+
+        assert(frame->i_dts == seq);
+        assert(frame->i_buffer == (size_t)(seq % 64));
+        vlc_frame_Release(frame);
+        seq++;
+    }
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    vlc_spsc_fifo_t *fifo = vlc_spsc_fifo_New(256);
+    assert(fifo != NULL);
+
+    vlc_thread_t th;
+    int ret = vlc_clone(&th, consumer, fifo);
+    assert(ret == 0);
+
+    for (vlc_tick_t seq = 0; seq < STRESS_COUNT; seq++)
+    {
+        vlc_frame_t *frame = frame_New(seq % 64, seq);
+
+        while (!vlc_spsc_fifo_Push(fifo, frame))
+            ; /* busy loop until the consumer catches up */
+    }
+
+    vlc_join(th, NULL);
+    assert(vlc_spsc_fifo_GetCount(fifo) == 0);
+    assert(vlc_spsc_fifo_GetBytes(fifo) == 0);
+    vlc_spsc_fifo_Delete(fifo);
+}
+
+int main(void)
+{
+    test_basic();
+    test_threads();
+    return 0;
+}
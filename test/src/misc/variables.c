@@ -444,6 +444,99 @@ static void test_creation_and_type( libvlc_int_t *p_libvlc )
     assert( var_Get( p_libvlc, "bla", &val ) == VLC_ENOENT );
 }
 
+static void test_table( libvlc_int_t *p_libvlc )
+{
+    char name[16];
+
+    /* Grow the table, then remove entries from within probe sequences */
+    for( unsigned i = 0; i < 300; i++ )
+    {
+        snprintf( name, sizeof (name), "table-%u", i );
+        assert( var_Create( p_libvlc, name, VLC_VAR_INTEGER ) == VLC_SUCCESS );
+        var_SetInteger( p_libvlc, name, i );
+    }
+
+    for( unsigned i = 1; i < 300; i += 2 )
+    {
+        snprintf( name, sizeof (name), "table-%u", i );
+        var_Destroy( p_libvlc, name );
+    }
+
+    for( unsigned i = 0; i < 300; i++ )
+    {
+        snprintf( name, sizeof (name), "table-%u", i );
+        if( i & 1 )
+            assert( var_Type( p_libvlc, name ) == 0 );
+        else
+            assert( var_GetInteger( p_libvlc, name ) == i );
+    }
+
+    for( unsigned i = 0; i < 300; i += 2 )
+    {
+        snprintf( name, sizeof (name), "table-%u", i );
+        var_Destroy( p_libvlc, name );
+    }
+}
+
+#define BENCH_VARS 64
+#define BENCH_LOOPS 1000000
+
+static void test_throughput( libvlc_int_t *p_libvlc )
+{
+    char names[BENCH_VARS][16];
+
+    for( unsigned i = 0; i < BENCH_VARS; i++ )
+    {
+        snprintf( names[i], sizeof (names[i]), "bench-%u", i );
+        var_Create( p_libvlc, names[i], VLC_VAR_INTEGER );
+        var_SetInteger( p_libvlc, names[i], i );
+    }
+
+    int64_t sum = 0;
+    vlc_tick_t start = vlc_tick_now();
+
+    for( unsigned i = 0; i < BENCH_LOOPS; i++ )
+        sum += var_GetInteger( p_libvlc, names[i % BENCH_VARS] );
+
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    assert( sum == (int64_t)BENCH_LOOPS / BENCH_VARS
+                   * (BENCH_VARS * (BENCH_VARS - 1) / 2) );
+    test_log( "var_GetInteger() by name: %.1f ns per call\n",
+              (double)NS_FROM_VLC_TICK(elapsed) / BENCH_LOOPS );
+
+    const vlc_var_name_t *handles[BENCH_VARS];
+
+    for( unsigned i = 0; i < BENCH_VARS; i++ )
+    {
+        handles[i] = var_Lookup( names[i] );
+        assert( handles[i] == var_Lookup( names[i] ) );
+    }
+
+    sum = 0;
+    start = vlc_tick_now();
+
+    for( unsigned i = 0; i < BENCH_LOOPS; i++ )
+        sum += var_GetIntegerByHandle( p_libvlc, handles[i % BENCH_VARS] );
+
+    elapsed = vlc_tick_now() - start;
+
+    assert( sum == (int64_t)BENCH_LOOPS / BENCH_VARS
+                   * (BENCH_VARS * (BENCH_VARS - 1) / 2) );
+    test_log( "var_GetInteger() by handle: %.1f ns per call\n",
+              (double)NS_FROM_VLC_TICK(elapsed) / BENCH_LOOPS );
+
+    /* Handles designate names, not variables */
+    var_SetIntegerByHandle( p_libvlc, handles[0], 42 );
+    assert( var_GetInteger( p_libvlc, names[0] ) == 42 );
+
+    for( unsigned i = 0; i < BENCH_VARS; i++ )
+        var_Destroy( p_libvlc, names[i] );
+
+    assert( var_GetIntegerByHandle( p_libvlc, handles[0] ) == 0 );
+    assert( var_Type( p_libvlc, names[BENCH_VARS - 1] ) == 0 );
+}
+
 static void test_variables( libvlc_instance_t *p_vlc )
 {
     libvlc_int_t *p_libvlc = p_vlc->p_libvlc_int;
@@ -481,6 +574,12 @@ static void test_variables( libvlc_instance_t *p_vlc )
 
     test_log( "Testing type at creation\n" );
     test_creation_and_type( p_libvlc );
+
+    test_log( "Testing the variables table\n" );
+    test_table( p_libvlc );
+
+    test_log( "Testing lookup throughput\n" );
+    test_throughput( p_libvlc );
 }
 
 
@@ -0,0 +1,521 @@
+/*****************************************************************************
+ * cache.c: test for the plugins cache file
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../../src/modules/cache.c"
+
+const char vlc_module_name[] = "test_src_modules_cache";
+
+/*
+ * Core functions used by the cache loader, which libvlccore does not export
+ */
+int vlc_param_SetString(struct vlc_param *param, const char *value)
+{
+    char *str = NULL;
+
+    if (value != NULL && value[0] != '\0')
+    {
+        str = strdup(value);
+        assert(str != NULL);
+    }
+    free(atomic_load_explicit(&param->value.str, memory_order_relaxed));
+    atomic_store_explicit(&param->value.str, str, memory_order_relaxed);
+    param->item.value.psz = str;
+    return 0;
+}
+
+void vlc_plugin_destroy(vlc_plugin_t *plugin)
+{
+    /* Only cached plugins are ever destroyed here */
+    assert(plugin->cached);
+    for (size_t i = 0; i < plugin->conf.size; i++)
+    {
+        struct vlc_param *param = plugin->conf.params + i;
+
+        if (IsConfigStringType(param->item.i_type))
+            free(atomic_load_explicit(&param->value.str,
+                                      memory_order_relaxed));
+    }
+    free(plugin->abspath);
+}
+
+int vlc_bindtextdomain(const char *domain)
+{
+    (void) domain;
+    return 0;
+}
+
+/*
+ * Plugins descriptors written to the cache
+ */
+static const char *const foo_shortcuts[] = { "foo", "foo-alias" };
+static const char *const bar_shortcuts[] = { "bar" };
+
+static const char *const string_values[] = { "auto", "", "fast" };
+static const char *const string_texts[] = { "Automatic", NULL, "Fast" };
+static const int int_values[] = { -1, 0, 4 };
+static const char *const int_texts[] = { "Off", "Default", "Four" };
+
+static vlc_plugin_t plugins[2];
+static module_t modules[3];
+static struct vlc_param params[5];
+
+static void CreateBank(void)
+{
+    /* Plugin with two modules and a few configuration items */
+    plugins[0] = (vlc_plugin_t) {
+        .module = &modules[0],
+        .modules_count = 2,
+        .textdomain = "vlc-foo",
+        .conf = { .params = params, .size = ARRAY_SIZE(params),
+                  .count = 4, .booleans = 1 },
+        .unloadable = true,
+        .path = (char *)"codec" DIR_SEP "libfoo_plugin.so",
+        .mtime = 1234567890,
+        .size = 98765,
+    };
+    modules[0] = (module_t) {
+        .plugin = &plugins[0], .next = &modules[1],
+        .i_shortcuts = ARRAY_SIZE(foo_shortcuts),
+        .pp_shortcuts = (const char **)foo_shortcuts,
+        .psz_shortname = "Foo", .psz_longname = "Foo decoder",
+        .psz_help = "Decodes foo", .psz_help_html = NULL,
+        .psz_capability = "video decoder", .i_score = 100,
+        .activate_name = "OpenDecoder", .deactivate_name = "CloseDecoder",
+    };
+    modules[1] = (module_t) {
+        .plugin = &plugins[0], .next = NULL,
+        .i_shortcuts = ARRAY_SIZE(bar_shortcuts),
+        .pp_shortcuts = (const char **)bar_shortcuts,
+        .psz_shortname = NULL, .psz_longname = "Foo packetizer",
+        .psz_capability = "packetizer", .i_score = -5,
+        .activate_name = "OpenPacketizer", .deactivate_name = NULL,
+    };
+
+    params[0] = (struct vlc_param) {
+        .item = { .i_type = CONFIG_SECTION, .psz_text = "Foo" },
+    };
+    params[1] = (struct vlc_param) {
+        .shortname = 'f', .safe = true,
+        .item = {
+            .i_type = CONFIG_ITEM_STRING, .psz_name = "foo-mode",
+            .psz_text = "Mode", .psz_longtext = "Decoding mode",
+            .orig.psz = (char *)"auto",
+            .list_count = ARRAY_SIZE(string_values),
+            .list.psz = (const char **)string_values,
+            .list_text = (const char **)string_texts,
+        },
+    };
+    params[2] = (struct vlc_param) {
+        .internal = true, .unsaved = true,
+        .item = {
+            .i_type = CONFIG_ITEM_INTEGER, .psz_name = "foo-level",
+            .psz_text = "Level",
+            .orig.i = 0, .min.i = -1, .max.i = INT64_C(1) << 40,
+            .list_count = ARRAY_SIZE(int_values),
+            .list.i = int_values,
+            .list_text = (const char **)int_texts,
+        },
+    };
+    params[3] = (struct vlc_param) {
+        .obsolete = true,
+        .item = {
+            .i_type = CONFIG_ITEM_FLOAT, .psz_name = "foo-gain",
+            .orig.f = 1.5f, .min.f = -2.f, .max.f = 2.f,
+        },
+    };
+    params[4] = (struct vlc_param) {
+        .item = {
+            .i_type = CONFIG_ITEM_BOOL, .psz_name = "foo-fast",
+            .psz_text = "Fast", .orig.i = 1,
+        },
+    };
+
+    /* Plugin with a single module and no configuration */
+    plugins[1] = (vlc_plugin_t) {
+        .module = &modules[2],
+        .modules_count = 1,
+        .unloadable = false,
+        .path = (char *)"libbaz_plugin.so",
+        .mtime = -1,
+        .size = 0,
+    };
+    modules[2] = (module_t) {
+        .plugin = &plugins[1],
+        .i_shortcuts = ARRAY_SIZE(bar_shortcuts),
+        .pp_shortcuts = (const char **)bar_shortcuts,
+        .psz_shortname = "Baz", .psz_longname = "Baz",
+        .psz_capability = "none", .i_score = 0,
+        .activate_name = "Open", .deactivate_name = "Close",
+    };
+}
+
+static libvlc_int_t *obj;
+static char dir[] = "/tmp/vlc.test.cache.XXXXXX";
+static char *path;
+
+static bool StrEq(const char *a, const char *b)
+{
+    return (a == NULL) ? b == NULL : b != NULL && !strcmp(a, b);
+}
+
+static void CheckModule(const module_t *m, const module_t *ref,
+                        const vlc_plugin_t *plugin)
+{
+    assert(m->plugin == plugin);
+    assert(m->i_shortcuts == ref->i_shortcuts);
+    for (unsigned i = 0; i < ref->i_shortcuts; i++)
+        assert(StrEq(m->pp_shortcuts[i], ref->pp_shortcuts[i]));
+    assert(StrEq(m->psz_shortname, ref->psz_shortname));
+    assert(StrEq(m->psz_longname, ref->psz_longname));
+    assert(StrEq(m->psz_help, ref->psz_help));
+    assert(StrEq(m->psz_help_html, ref->psz_help_html));
+    assert(StrEq(m->psz_capability, ref->psz_capability));
+    assert(m->i_score == ref->i_score);
+    assert(StrEq(m->activate_name, ref->activate_name));
+    assert(StrEq(m->deactivate_name, ref->deactivate_name));
+    assert(m->pf_activate == NULL && m->deactivate == NULL);
+}
+
+static void CheckParam(const struct vlc_param *p, const struct vlc_param *ref,
+                       const vlc_plugin_t *plugin)
+{
+    const module_config_t *c = &p->item, *rc = &ref->item;
+
+    assert(p->owner == plugin);
+    assert(p->shortname == ref->shortname);
+    assert(p->internal == ref->internal && p->unsaved == ref->unsaved);
+    assert(p->safe == ref->safe && p->obsolete == ref->obsolete);
+    assert(c->i_type == rc->i_type);
+    assert(StrEq(c->psz_type, rc->psz_type));
+    assert(StrEq(c->psz_name, rc->psz_name));
+    assert(StrEq(c->psz_text, rc->psz_text));
+    assert(StrEq(c->psz_longtext, rc->psz_longtext));
+    assert(c->list_count == rc->list_count);
+
+    if (IsConfigStringType(c->i_type))
+    {
+        assert(StrEq(c->orig.psz, rc->orig.psz));
+        assert(StrEq(atomic_load(&p->value.str), rc->orig.psz));
+        for (unsigned i = 0; i < c->list_count; i++)
+            assert(StrEq(c->list.psz[i],
+                         rc->list.psz[i] ? rc->list.psz[i] : ""));
+    }
+    else if (IsConfigFloatType(c->i_type))
+    {
+        assert(c->orig.f == rc->orig.f && atomic_load(&p->value.f) == rc->orig.f);
+        assert(c->min.f == rc->min.f && c->max.f == rc->max.f);
+    }
+    else
+    {
+        assert(c->orig.i == rc->orig.i && atomic_load(&p->value.i) == rc->orig.i);
+        assert(c->min.i == rc->min.i && c->max.i == rc->max.i);
+        for (unsigned i = 0; i < c->list_count; i++)
+            assert(c->list.i[i] == rc->list.i[i]);
+    }
+
+    /* NULL choice texts are loaded as empty strings */
+    for (unsigned i = 0; i < c->list_count; i++)
+        assert(StrEq(c->list_text[i],
+                     rc->list_text[i] ? rc->list_text[i] : ""));
+}
+
+static void CheckPlugin(vlc_plugin_t **cache, const vlc_plugin_t *ref)
+{
+    vlc_plugin_t *plugin = vlc_cache_lookup(cache, ref->path);
+
+    assert(plugin != NULL);
+    assert(plugin->cached);
+    assert(plugin->unloadable == ref->unloadable);
+    assert(plugin->mtime == ref->mtime && plugin->size == ref->size);
+    assert(StrEq(plugin->textdomain, ref->textdomain));
+
+    char *abspath;
+    assert(asprintf(&abspath, "%s" DIR_SEP "%s", dir, ref->path) >= 0);
+    assert(!strcmp(plugin->abspath, abspath));
+    free(abspath);
+
+    assert(plugin->modules_count == ref->modules_count);
+    const module_t *m = plugin->module, *rm = ref->module;
+    for (; rm != NULL; m = m->next, rm = rm->next)
+    {
+        assert(m != NULL);
+        CheckModule(m, rm, plugin);
+    }
+    assert(m == NULL);
+
+    assert(plugin->conf.size == ref->conf.size);
+    assert(plugin->conf.count == ref->conf.count);
+    assert(plugin->conf.booleans == ref->conf.booleans);
+    for (size_t i = 0; i < ref->conf.size; i++)
+        CheckParam(plugin->conf.params + i, ref->conf.params + i, plugin);
+
+    vlc_plugin_destroy(plugin);
+}
+
+static void ReleaseCache(vlc_plugin_t *cache, block_t *backing)
+{
+    while (cache != NULL)
+    {
+        vlc_plugin_t *next = cache->next;
+
+        vlc_plugin_destroy(cache);
+        cache = next;
+    }
+    block_ChainRelease(backing);
+}
+
+static void WriteFile(const uint8_t *data, size_t size)
+{
+    FILE *file = vlc_fopen(path, "wb");
+
+    assert(file != NULL);
+    assert(fwrite(data, 1, size, file) == size);
+    assert(fclose(file) == 0);
+}
+
+/** Loads a cache file, returning whether it was accepted */
+static bool LoadFile(const uint8_t *data, size_t size)
+{
+    block_t *backing = NULL;
+
+    WriteFile(data, size);
+
+    vlc_plugin_t *cache = vlc_cache_load(obj, dir, &backing);
+    assert((cache != NULL) == (backing != NULL));
+    ReleaseCache(cache, backing);
+    return cache != NULL;
+}
+
+static block_t *test_roundtrip(void)
+{
+    vlc_plugin_t *const entries[] = { &plugins[0], &plugins[1] };
+    block_t *backing = NULL;
+
+    CacheSave(obj, dir, entries, ARRAY_SIZE(entries));
+
+    vlc_plugin_t *cache = vlc_cache_load(obj, dir, &backing);
+    assert(cache != NULL);
+
+    CheckPlugin(&cache, &plugins[0]);
+    CheckPlugin(&cache, &plugins[1]);
+    assert(cache == NULL);
+    block_ChainRelease(backing);
+
+    /* Keep a copy of the file, the tests below overwrite it */
+    block_t *file = block_FilePath(path, false);
+    assert(file != NULL);
+
+    block_t *copy = block_Alloc(file->i_buffer);
+    assert(copy != NULL);
+    memcpy(copy->p_buffer, file->p_buffer, file->i_buffer);
+    block_Release(file);
+    return copy;
+}
+
+/* Patches a 32-bits value of a copy of the cache and tries to load it */
+static bool LoadPatched(const block_t *file, size_t offset, uint32_t value)
+{
+    uint8_t *data = malloc(file->i_buffer);
+
+    assert(data != NULL);
+    assert(offset + sizeof (value) <= file->i_buffer);
+    memcpy(data, file->p_buffer, file->i_buffer);
+    memcpy(data + offset, &value, sizeof (value));
+
+    bool ok = LoadFile(data, file->i_buffer);
+    free(data);
+    return ok;
+}
+
+#define OFFSET_OF_SECTION(name) \
+    (toc_offset + offsetof(struct vlc_cache_toc, name))
+
+static void test_corrupted(const block_t *file)
+{
+    size_t header = sizeof (CACHE_STRING) - 1;
+#ifdef DISTRO_VERSION
+    header += sizeof (DISTRO_VERSION) - 1;
+#endif
+    const size_t toc_offset = (header + 2 * sizeof (uint32_t)
+                               + alignof (struct vlc_cache_toc) - 1)
+                            & ~(alignof (struct vlc_cache_toc) - 1);
+    struct vlc_cache_toc toc;
+    struct vlc_cache_plugin plugin;
+    struct vlc_cache_module module;
+    struct vlc_cache_param param;
+
+    memcpy(&toc, file->p_buffer + toc_offset, sizeof (toc));
+    memcpy(&plugin, file->p_buffer + toc.plugins.offset, sizeof (plugin));
+    memcpy(&module, file->p_buffer + toc.modules.offset, sizeof (module));
+
+    /* The file is accepted as is */
+    assert(LoadFile(file->p_buffer, file->i_buffer));
+
+    /* Wrong sub-version and header marker */
+    assert(!LoadPatched(file, header, CACHE_SUBVERSION_NUM - 1));
+    assert(!LoadPatched(file, header + 4, header + 4 + 1));
+
+    /* Truncated files */
+    for (size_t size = 0; size < file->i_buffer; size++)
+        assert(!LoadFile(file->p_buffer, size));
+
+    /* Sections out of the file, too large or misaligned */
+    const struct
+    {
+        size_t offset;
+        const struct vlc_cache_section *section;
+        size_t entry_size;
+    } sections[] = {
+        { OFFSET_OF_SECTION(plugins), &toc.plugins, sizeof (plugin) },
+        { OFFSET_OF_SECTION(modules), &toc.modules, sizeof (module) },
+        { OFFSET_OF_SECTION(params), &toc.params, sizeof (param) },
+        { OFFSET_OF_SECTION(refs), &toc.refs, sizeof (uint32_t) },
+        { OFFSET_OF_SECTION(integers), &toc.integers, sizeof (int) },
+        { OFFSET_OF_SECTION(strings), &toc.strings, 1 },
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(sections); i++)
+    {
+        const size_t offset = sections[i].offset;
+        const struct vlc_cache_section *s = sections[i].section;
+        const size_t count = offsetof(struct vlc_cache_section, count);
+
+        assert(!LoadPatched(file, offset, file->i_buffer));
+        assert(!LoadPatched(file, offset, UINT32_MAX));
+        assert(!LoadPatched(file, offset + count, UINT32_MAX));
+        assert(!LoadPatched(file, offset + count,
+                            (file->i_buffer - s->offset)
+                            / sections[i].entry_size + 1));
+        if (sections[i].entry_size > 1)
+            assert(!LoadPatched(file, offset, s->offset + 1));
+    }
+
+    /* Fewer records than referenced by the plugins */
+    assert(!LoadPatched(file, OFFSET_OF_SECTION(modules.count),
+                        toc.modules.count - 1));
+    assert(!LoadPatched(file, OFFSET_OF_SECTION(params.count),
+                        toc.params.count - 1));
+    assert(!LoadPatched(file, OFFSET_OF_SECTION(refs.count),
+                        toc.refs.count - 1));
+    assert(!LoadPatched(file, OFFSET_OF_SECTION(integers.count),
+                        toc.integers.count - 1));
+
+    /* Records not matching the tables */
+    const size_t plugin_offset = toc.plugins.offset;
+    assert(!LoadPatched(file, plugin_offset
+                        + offsetof(struct vlc_cache_plugin, modules),
+                        plugin.modules + 1));
+    assert(!LoadPatched(file, plugin_offset
+                        + offsetof(struct vlc_cache_plugin, modules),
+                        plugin.modules - 1));
+    assert(!LoadPatched(file, plugin_offset
+                        + offsetof(struct vlc_cache_plugin, modules),
+                        UINT32_MAX));
+    assert(!LoadPatched(file, toc.modules.offset
+                        + offsetof(struct vlc_cache_module, shortcuts),
+                        MODULE_SHORTCUT_MAX + 1));
+
+    /* Out of range and NULL string offsets */
+    assert(!LoadPatched(file, plugin_offset
+                        + offsetof(struct vlc_cache_plugin, path),
+                        toc.strings.count));
+    assert(!LoadPatched(file, plugin_offset
+                        + offsetof(struct vlc_cache_plugin, path), 0));
+    assert(!LoadPatched(file, plugin_offset
+                        + offsetof(struct vlc_cache_plugin, textdomain),
+                        UINT32_MAX));
+    assert(!LoadPatched(file, toc.modules.offset
+                        + offsetof(struct vlc_cache_module, capability),
+                        toc.strings.count));
+    assert(!LoadPatched(file, toc.refs.offset, toc.strings.count));
+    assert(!LoadPatched(file, toc.refs.offset, 0)); /* NULL shortcut */
+
+    for (size_t i = 0; i < toc.params.count; i++)
+    {
+        const size_t offset = toc.params.offset + i * sizeof (param);
+
+        memcpy(&param, file->p_buffer + offset, sizeof (param));
+        assert(!LoadPatched(file, offset
+                            + offsetof(struct vlc_cache_param, text),
+                            toc.strings.count));
+        if (IsConfigStringType(param.i_type))
+            assert(!LoadPatched(file, offset
+                                + offsetof(struct vlc_cache_param, orig),
+                                toc.strings.count));
+    }
+
+    /* String pool not nul-terminated */
+    {
+        uint8_t *data = malloc(file->i_buffer);
+
+        assert(data != NULL);
+        memcpy(data, file->p_buffer, file->i_buffer);
+        data[toc.strings.offset + toc.strings.count - 1] = 'x';
+        assert(!LoadFile(data, file->i_buffer));
+        free(data);
+    }
+
+    /* Any corrupted byte is either rejected or loaded within bounds */
+    for (size_t i = 0; i < file->i_buffer; i++)
+    {
+        uint8_t *data = malloc(file->i_buffer);
+
+        assert(data != NULL);
+        memcpy(data, file->p_buffer, file->i_buffer);
+        data[i] ^= 0xff;
+        LoadFile(data, file->i_buffer);
+        free(data);
+    }
+}
+
+int main(void)
+{
+    test_init();
+
+    const char *argv[test_defaults_nargs + 1];
+    for (int i = 0; i < test_defaults_nargs; i++)
+        argv[i] = test_defaults_args[i];
+    argv[test_defaults_nargs] = "--quiet";
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs + 1, argv);
+    assert(vlc != NULL);
+    obj = vlc->p_libvlc_int;
+
+    assert(mkdtemp(dir) != NULL);
+    assert(asprintf(&path, "%s" DIR_SEP CACHE_NAME, dir) >= 0);
+
+    CreateBank();
+    block_t *file = test_roundtrip();
+    test_corrupted(file);
+    block_Release(file);
+
+    vlc_unlink(path);
+    rmdir(dir);
+    free(path);
+    libvlc_release(vlc);
+    return 0;
+}